@@ -237,6 +237,47 @@ Event = {
 --   stable
 --
 
+--
+-- Event: onGameSaved
+--
+-- Triggered when a save started with <Game.SaveGameAsync> has been written.
+--
+-- > local onGameSaved = function (filename, path) ... end
+-- > Event.Register("onGameSaved", onGameSaved)
+--
+-- filename is the name the game was saved under, and path the full path to
+-- the file (so it can be displayed).
+--
+-- Availability:
+--
+--   October 2026
+--
+-- Status:
+--
+--   experimental
+--
+
+--
+-- Event: onGameSaveFailed
+--
+-- Triggered when a save started with <Game.SaveGameAsync> could not be
+-- written.
+--
+-- > local onGameSaveFailed = function (filename, message) ... end
+-- > Event.Register("onGameSaveFailed", onGameSaveFailed)
+--
+-- message describes what went wrong. Any file previously saved under
+-- filename is left as it was.
+--
+-- Availability:
+--
+--   October 2026
+--
+-- Status:
+--
+--   experimental
+--
+
 --
 -- Event: onEnterSystem
 --
@@ -33,21 +33,29 @@ local function PickNextAutosave()
 	return '_autosave' .. next_save_number
 end
 
-local function CheckedSave(filename)
+local function CheckedSave(filename, save)
 	if not Engine.GetAutosaveEnabled() then
 		return
 	end
 
-	local ok, err = pcall(Game.SaveGame, filename)
+	local ok, err = pcall(save or Game.SaveGame, filename)
 	if not ok then
 		print('Error making autosave:')
 		print(err)
 	end
 end
 
-local f = function (ship) if ship:IsPlayer() then CheckedSave(PickNextAutosave()); end; end
+-- written in the background, so docking and undocking never stall
+local f = function (ship) if ship:IsPlayer() then CheckedSave(PickNextAutosave(), Game.SaveGameAsync); end; end
 Event.Register('onShipDocked', f)
 Event.Register('onShipLanded', f)
 Event.Register('onShipUndocked', f)
 Event.Register('onShipTakeOff', f)
+Event.Register('onGameSaveFailed', function (filename, err)
+	if string.match(filename, '^_autosave%d+$') then
+		print('Error making autosave:')
+		print(err)
+	end
+end)
+-- the game is about to go away, so this one has to be written now
 Event.Register('onGameEnd', function() CheckedSave('_exit'); end)
@@ -209,13 +209,12 @@ local function showJumpRoute()
 
 		mainButton(icons.hyperspace, lui.AUTO_ROUTE,
 		function()
+			-- the route is searched for in the background, and picked up
+			-- by checkAutoRoute once found
 			local result = sectorView:AutoRoute()
 			if result == "NO_DRIVE" then
 				mb.OK(lui.NO_DRIVE)
-			elseif result == "NO_VALID_ROUTE" then
-				mb.OK(lui.NO_VALID_ROUTE)
 			end
-			updateHyperspaceTarget()
 		end)
 		ui.sameLine()
 
@@ -263,6 +262,16 @@ function hyperJumpPlanner.updateInRoute(path)
 	selected_jump = nil;
 end
 
+local function checkAutoRoute()
+	local result = sectorView:GetAutoRouteResult()
+	if result == "NO_VALID_ROUTE" then
+		mb.OK(lui.NO_VALID_ROUTE)
+	end
+	if result then
+		updateHyperspaceTarget()
+	end
+end
+
 local function showHyperJumpPlannerWindow()
 	textIcon(icons.route)
 	ui.sameLine()
@@ -317,6 +326,7 @@ function hyperJumpPlanner.display()
 	current_path = Game.system and current_system.path -- will be nil during the hyperjump
 	current_fuel = player:CountEquip(fuel_type,"cargo")
 	map_selected_path = sectorView:GetSelectedSystemPath()
+	checkAutoRoute()
 	route_jumps = sectorView:GetRouteSize()
 	showHyperJumpPlannerWindow()
 end -- hyperJumpPlanner.display
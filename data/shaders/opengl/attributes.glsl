@@ -15,7 +15,17 @@ struct Light {
 	vec4 specular;
 	vec4 position;
 };
-uniform Light uLight[4];
+
+//scene uniform parameters
+struct Scene {
+	vec4 ambient;
+};
+
+// set by the renderer when the lights change, shared by every program
+layout(std140) uniform LightData {
+	Light uLight[4];
+	Scene scene;
+};
 
 struct Material {
 	vec4 emission;
@@ -25,6 +35,11 @@ struct Material {
 	float shininess;
 };
 
+// set by each material when it's applied
+layout(std140) uniform MaterialData {
+	Material material;
+};
+
 #ifdef VERTEX_SHADER
 
 layout (location = 0) in vec4 a_vertex;
@@ -35,7 +50,12 @@ layout (location = 4) in vec4 a_uv1;
 layout (location = 5) in vec3 a_tangent;
 layout (location = 6) in mat4 a_transform;
 // a_transform @ 6 shadows (uses) 7, 8, and 9
-// next available is layout (location = 10)
+// per-instance pattern colours: primary (alpha 1.0 for a smooth pattern),
+// secondary and trim
+layout (location = 10) in vec4 a_patternColor0;
+layout (location = 11) in vec4 a_patternColor1;
+layout (location = 12) in vec4 a_patternColor2;
+// next available is layout (location = 13)
 
 // shorthand to abstract away instancing
 vec4 matrixTransform()
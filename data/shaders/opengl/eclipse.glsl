@@ -3,12 +3,15 @@
 
 #ifdef ECLIPSE
 
-uniform vec3 shadowCentreX;
-uniform vec3 shadowCentreY;
-uniform vec3 shadowCentreZ;
-uniform vec3 srad;
-uniform vec3 lrad;
-uniform vec3 sdivlrad;
+// set by the planet's material, up to three shadows, one per component
+layout(std140) uniform EclipseData {
+	vec3 shadowCentreX;
+	vec3 shadowCentreY;
+	vec3 shadowCentreZ;
+	vec3 srad;
+	vec3 lrad;
+	vec3 sdivlrad;
+};
 
 #define PI 3.141592653589793
 
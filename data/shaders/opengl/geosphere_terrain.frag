@@ -23,9 +23,6 @@ in float dist;
 uniform float detailScaleHi;
 uniform float detailScaleLo;
 
-uniform Material material;
-uniform Scene scene;
-
 in vec3 varyingEyepos;
 in vec3 varyingNormal;
 in vec4 vertexColor;
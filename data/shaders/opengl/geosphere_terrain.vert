@@ -16,7 +16,6 @@ out float dist;
 
 #ifdef TERRAIN_WITH_LAVA
 out vec4 varyingEmission;
-uniform Material material;
 #endif
 
 void main(void)
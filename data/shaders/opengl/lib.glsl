@@ -2,11 +2,6 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #ifdef FRAGMENT_SHADER
-//scene uniform parameters
-struct Scene {
-	vec4 ambient;
-};
-
 //Currently used by: planet ring shader, geosphere shaders
 float findSphereEyeRayEntryDistance(in vec3 sphereCenter, in vec3 eyeTo, in float radius)
 {
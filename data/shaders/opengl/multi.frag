@@ -18,6 +18,27 @@ in vec2 texCoord0;
 #ifdef VERTEXCOLOR
 in vec4 vertexColor;
 #endif
+#if defined(MAP_COLOR) && defined(USE_INSTANCING)
+flat in vec4 patternColor[3];
+
+// instances have their own colours rather than a colour map, so look them
+// up the way the colour map texture would be sampled: 16 texels, four each
+// of white and the three colours, sampled nearest or linearly
+vec3 patternTexel(int i)
+{
+	int c = clamp(i, 0, 15) / 4;
+	return c == 0 ? vec3(1.0) : patternColor[c - 1].rgb;
+}
+
+vec4 instancePatternColor(float u)
+{
+	if (patternColor[0].a < 0.5)
+		return vec4(patternTexel(int(floor(u * 16.0))), 1.0);
+	float x = u * 16.0 - 0.5;
+	float i0 = floor(x);
+	return vec4(mix(patternTexel(int(i0)), patternTexel(int(i0) + 1), x - i0), 1.0);
+}
+#endif
 #if (NUM_LIGHTS > 0)
 in vec3 eyePos;
 in vec3 normal;
@@ -32,9 +53,6 @@ in vec3 normal;
 #endif // HEAT_COLOURING
 #endif // (NUM_LIGHTS > 0)
 
-uniform Scene scene;
-uniform Material material;
-
 out vec4 frag_color;
 
 #if (NUM_LIGHTS > 0)
@@ -69,7 +87,11 @@ void main(void)
 //patterns - simple lookup
 #ifdef MAP_COLOR
 	vec4 pat = texture(texture4, texCoord0);
+#ifdef USE_INSTANCING
+	vec4 mapColor = instancePatternColor(pat.r);
+#else
 	vec4 mapColor = texture(texture5, vec2(pat.r, 0.0));
+#endif
 	vec4 tint = mix(vec4(1.0),mapColor,pat.a);
 	color *= tint;
 #endif
@@ -12,6 +12,9 @@ out vec2 texCoord0;
 #ifdef VERTEXCOLOR
 out vec4 vertexColor;
 #endif
+#if defined(MAP_COLOR) && defined(USE_INSTANCING)
+flat out vec4 patternColor[3];
+#endif
 #if (NUM_LIGHTS > 0)
 out vec3 eyePos;
 out vec3 normal;
@@ -35,6 +38,11 @@ void main(void)
 #ifdef TEXTURE0
 	texCoord0 = a_uv0.xy;
 #endif
+#if defined(MAP_COLOR) && defined(USE_INSTANCING)
+	patternColor[0] = a_patternColor0;
+	patternColor[1] = a_patternColor1;
+	patternColor[2] = a_patternColor2;
+#endif
 #if (NUM_LIGHTS > 0)
 #ifdef USE_INSTANCING
 	eyePos = vec3(uViewMatrix * (a_transform * a_vertex));
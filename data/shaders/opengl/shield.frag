@@ -8,8 +8,6 @@ in vec3 varyingEyepos;
 in vec3 varyingNormal;
 in vec3 varyingVertex;
 
-uniform Scene scene;
-uniform Material material;
 uniform float shieldStrength;
 uniform float shieldCooldown;
 
@@ -11,6 +11,7 @@
 #include "Player.h"
 #include "Space.h"
 #include "StringF.h"
+#include "galaxy/Galaxy.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Graphics.h"
 #include "graphics/RenderState.h"
@@ -192,136 +193,130 @@ namespace Background {
 		}
 	}
 
-	Starfield::Starfield(Graphics::Renderer *renderer, Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy)
-	{
-		m_renderer = renderer;
-		Init();
-		Fill(rand, space, galaxy);
-	}
-
-	void Starfield::Init()
-	{
-		Graphics::MaterialDescriptor desc;
-		desc.effect = Graphics::EFFECT_STARFIELD;
-		desc.textures = 1;
-		desc.vertexColors = true;
-		m_material.Reset(m_renderer->CreateMaterial(desc));
-		m_material->emissive = Color::WHITE;
-		m_material->texture0 = Graphics::TextureBuilder::Billboard("textures/star_point_2.png").GetOrCreateTexture(m_renderer, "billboard");
-
-		Graphics::MaterialDescriptor descStreaks;
-		descStreaks.effect = Graphics::EFFECT_VTXCOLOR;
-		descStreaks.vertexColors = true;
-		m_materialStreaks.Reset(m_renderer->CreateMaterial(descStreaks));
-		m_materialStreaks->emissive = Color::WHITE;
+	// everything needed to draw one starfield, including in hyperspace
+	struct Starfield::StarData {
+		std::vector<vector3f> stars;
+		std::vector<Color> colors;
+		std::vector<float> sizes;
+		// where each star starts, and its colour, for the hyperspace streaks
+		std::vector<vector3f> hyperVtx;
+		std::vector<Color> hyperCol;
+	};
 
-		IniConfig cfg;
-		cfg.Read(FileSystem::gameDataFiles, "configs/Starfield.ini");
-		// NB: limit the ranges of all values loaded from the file
-		m_rMin = Clamp(cfg.Float("rMin", 0.6), 0.2f, 1.0f);
-		m_rMax = Clamp(cfg.Float("rMax", 1.0), 0.2f, 1.0f);
-		m_gMin = Clamp(cfg.Float("gMin", 0.6), 0.2f, 1.0f);
-		m_gMax = Clamp(cfg.Float("gMax", 1.0), 0.2f, 1.0f);
-		m_bMin = Clamp(cfg.Float("bMin", 0.6), 0.2f, 1.0f);
-		m_bMax = Clamp(cfg.Float("bMax", 1.0), 0.2f, 1.0f);
-		m_visibleRadiusLy = std::max(cfg.Float("visibleRadiusLy", 180.0f), 0.0f);
-		m_medianPosition = Clamp(cfg.Float("medianPosition", 0.7f), 0.0f, 1.0f);
-		m_brightnessPower = cfg.Float("brightnessPower", 2.1f);
-		m_brightnessApparentSizeFactor = std::max(cfg.Float("brightnessApparentSizeFactor", 0.8f), 0.0f);
-		m_brightnessApparentSizeOffset = cfg.Float("brightnessApparentSizeOffset", 0.0);
-		m_brightnessColorFactor = cfg.Float("brightnessColorFactor", 0.8);
-		m_brightnessColorOffset = cfg.Float("brightnessColorOffset", 0.1);
-	}
+	std::shared_ptr<const Starfield::StarData> Starfield::s_lastStars;
+
+	// works out the stars from the sectors around the current system (if
+	// any), then fills the sky with random ones. RUNS IN ANOTHER THREAD
+	// when queued, so it only reads the sectors it was given. they are
+	// released with the job, back on the main thread, since freeing a
+	// sector takes it out of the galaxy's cache
+	class Starfield::BuildJob : public Job {
+	public:
+		BuildJob(Starfield *starfield, const SystemPath &current, std::vector<RefCountedPtr<const Sector>> &&sectors) :
+			m_starfield(starfield),
+			m_current(current),
+			m_sectors(std::move(sectors)),
+			m_seed(starfield->m_seed),
+			m_numStars(MathUtil::mix(BG_STAR_MIN, BG_STAR_MAX, Pi::GetAmountBackgroundStars())),
+			m_visibleRadius(MathUtil::mix(BG_STAR_RADIUS_MIN, Clamp(starfield->m_visibleRadiusLy, BG_STAR_RADIUS_MIN, BG_STAR_RADIUS_MAX), Pi::GetAmountBackgroundStars())),
+			m_rMin(starfield->m_rMin),
+			m_rMax(starfield->m_rMax),
+			m_gMin(starfield->m_gMin),
+			m_gMax(starfield->m_gMax),
+			m_bMin(starfield->m_bMin),
+			m_bMax(starfield->m_bMax),
+			m_medianPosition(starfield->m_medianPosition),
+			m_brightnessPower(starfield->m_brightnessPower),
+			m_brightnessApparentSizeFactor(starfield->m_brightnessApparentSizeFactor),
+			m_brightnessApparentSizeOffset(starfield->m_brightnessApparentSizeOffset),
+			m_brightnessColorFactor(starfield->m_brightnessColorFactor),
+			m_brightnessColorOffset(starfield->m_brightnessColorOffset)
+		{
+		}
 
-	void Starfield::Fill(Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy)
-	{
-		PROFILE_SCOPED()
-		const Uint32 NUM_BG_STARS = MathUtil::mix(BG_STAR_MIN, BG_STAR_MAX, Pi::GetAmountBackgroundStars());
-		m_hyperVtx.reset(new vector3f[BG_STAR_MAX * 3]);
-		m_hyperCol.reset(new Color[BG_STAR_MAX * 3]);
+		virtual void OnRun() override;
 
-		// setup the animated stars buffer (streaks in Hyperspace)
+		virtual void OnFinish() override
 		{
-			Graphics::VertexBufferDesc vbd;
-			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-			vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-			vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
-			vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_UBYTE4;
-			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
-			vbd.numVertices = NUM_BG_STARS * 2;
-			m_animBuffer.reset(m_renderer->CreateVertexBuffer(vbd));
+			m_starfield->SetStars(std::move(m_data));
 		}
 
-		m_pointSprites.reset(new Graphics::Drawables::PointSprites);
+	private:
+		Starfield *m_starfield;
+		const SystemPath m_current;
+		std::vector<RefCountedPtr<const Sector>> m_sectors;
+		const Uint32 m_seed;
+		const Uint32 m_numStars;
+		const Sint32 m_visibleRadius; // lyrs
+		const float m_rMin, m_rMax, m_gMin, m_gMax, m_bMin, m_bMax;
+		const float m_medianPosition;
+		const float m_brightnessPower;
+		const float m_brightnessApparentSizeFactor;
+		const float m_brightnessApparentSizeOffset;
+		const float m_brightnessColorFactor;
+		const float m_brightnessColorOffset;
+		std::shared_ptr<StarData> m_data;
+	};
 
-		assert(sizeof(StarVert) == 16);
-		std::unique_ptr<vector3f[]> stars(new vector3f[NUM_BG_STARS]);
-		std::unique_ptr<Color[]> colors(new Color[NUM_BG_STARS]);
-		std::unique_ptr<float[]> sizes(new float[NUM_BG_STARS]);
+	void Starfield::BuildJob::OnRun()
+	{
+		PROFILE_SCOPED()
+		const Uint32 NUM_BG_STARS = m_numStars;
+		m_data.reset(new StarData);
+		std::vector<vector3f> &stars = m_data->stars;
+		std::vector<Color> &colors = m_data->colors;
+		std::vector<float> &sizes = m_data->sizes;
+		std::vector<vector3f> &hyperVtx = m_data->hyperVtx;
+		std::vector<Color> &hyperCol = m_data->hyperCol;
+		stars.resize(NUM_BG_STARS);
+		colors.resize(NUM_BG_STARS);
+		sizes.resize(NUM_BG_STARS);
+		hyperVtx.resize(NUM_BG_STARS);
+		hyperCol.resize(NUM_BG_STARS);
 		std::unique_ptr<float[]> brightness(new float[NUM_BG_STARS]);
 		//fill the array
 		Uint32 num = 0;
-		if (space != nullptr && galaxy.Valid() && space->GetStarSystem() != nullptr) {
-			const SystemPath current = space->GetStarSystem()->GetPath();
-
+		{
 			const double size = 1.0;
-			const Sint32 visibleRadius = MathUtil::mix(BG_STAR_RADIUS_MIN, Clamp(m_visibleRadiusLy, BG_STAR_RADIUS_MIN, BG_STAR_RADIUS_MAX), Pi::GetAmountBackgroundStars()); // lyrs
-			const Sint32 visibleRadiusSqr = (visibleRadius * visibleRadius);
-			const Sint32 sectorMin = -(visibleRadius / Sector::SIZE); // lyrs_radius / sector_size_in_lyrs
-			const Sint32 sectorMax = visibleRadius / Sector::SIZE;	  // lyrs_radius / sector_size_in_lyrs
-			for (Sint32 x = sectorMin; x < sectorMax; x++) {
-				for (Sint32 y = sectorMin; y < sectorMax; y++) {
-					for (Sint32 z = sectorMin; z < sectorMax; z++) {
-						SystemPath sys(current.sectorX + x, current.sectorY + y, current.sectorZ + z);
-						if (SystemPath::SectorDistanceSqr(sys, current) * Sector::SIZE >= visibleRadiusSqr)
-							continue; // early out
-
-						// this is fairly expensive
-						RefCountedPtr<const Sector> sec = galaxy->GetSector(sys);
-
-						// add as many systems as we can
-						const size_t numSystems = std::min(sec->m_systems.size(), (size_t)(NUM_BG_STARS - num));
-						for (size_t systemIndex = 0; systemIndex < numSystems; systemIndex++) {
-							const Sector::System *ss = &(sec->m_systems[systemIndex]);
-							const vector3f distance = Sector::SIZE * vector3f(current.sectorX, current.sectorY, current.sectorZ) - ss->GetFullPosition();
-							if (distance.LengthSqr() >= visibleRadiusSqr)
-								continue; // too far
-
-							// add the colors and luminosities of all stars in a system together
-							float luminositySystemSum = 0.0f;
-							vector3f colorSystemSum(0.0f, 0.0f, 0.0f);
-							for (size_t i = 0; i < ss->GetNumStars(); ++i) {
-								luminositySystemSum += StarSystem::starLuminosities[ss->GetStarType(i)];
-								Color col = StarSystem::starRealColors[ss->GetStarType(i)];
-								colorSystemSum += vector3f(col.r, col.g, col.b) * luminositySystemSum;
-							}
-							colorSystemSum /= luminositySystemSum;
-
-							Color col(colorSystemSum.x, colorSystemSum.y, colorSystemSum.z);
-							col.r = Clamp(col.r, (Uint8)(m_rMin * 255), (Uint8)(m_rMax * 255));
-							col.g = Clamp(col.g, (Uint8)(m_gMin * 255), (Uint8)(m_gMax * 255));
-							col.b = Clamp(col.b, (Uint8)(m_bMin * 255), (Uint8)(m_bMax * 255));
-							//const Color col(Color::PINK); // debug pink
-
-							// copy the data
-							sizes[num] = size;
-							stars[num] = distance.Normalized() * 1000.0f;
-							colors[num] = col;
-							brightness[num] = luminositySystemSum / (4 * M_PI * distance.Length() * distance.Length());
-
-							//need to keep data around for HS anim - this is stupid
-							m_hyperVtx[NUM_BG_STARS * 2 + num] = stars[num];
-							m_hyperCol[NUM_BG_STARS * 2 + num] = col * 0.8f;
-							num++;
-						}
-						if (num >= NUM_BG_STARS) {
-							x = sectorMax;
-							y = sectorMax;
-							z = sectorMax;
-							break;
-						}
+			const Sint32 visibleRadiusSqr = (m_visibleRadius * m_visibleRadius);
+			for (const RefCountedPtr<const Sector> &sec : m_sectors) {
+				// add as many systems as we can
+				const size_t numSystems = std::min(sec->m_systems.size(), (size_t)(NUM_BG_STARS - num));
+				for (size_t systemIndex = 0; systemIndex < numSystems; systemIndex++) {
+					const Sector::System *ss = &(sec->m_systems[systemIndex]);
+					const vector3f distance = Sector::SIZE * vector3f(m_current.sectorX, m_current.sectorY, m_current.sectorZ) - ss->GetFullPosition();
+					if (distance.LengthSqr() >= visibleRadiusSqr)
+						continue; // too far
+
+					// add the colors and luminosities of all stars in a system together
+					float luminositySystemSum = 0.0f;
+					vector3f colorSystemSum(0.0f, 0.0f, 0.0f);
+					for (size_t i = 0; i < ss->GetNumStars(); ++i) {
+						luminositySystemSum += StarSystem::starLuminosities[ss->GetStarType(i)];
+						Color col = StarSystem::starRealColors[ss->GetStarType(i)];
+						colorSystemSum += vector3f(col.r, col.g, col.b) * luminositySystemSum;
 					}
+					colorSystemSum /= luminositySystemSum;
+
+					Color col(colorSystemSum.x, colorSystemSum.y, colorSystemSum.z);
+					col.r = Clamp(col.r, (Uint8)(m_rMin * 255), (Uint8)(m_rMax * 255));
+					col.g = Clamp(col.g, (Uint8)(m_gMin * 255), (Uint8)(m_gMax * 255));
+					col.b = Clamp(col.b, (Uint8)(m_bMin * 255), (Uint8)(m_bMax * 255));
+					//const Color col(Color::PINK); // debug pink
+
+					// copy the data
+					sizes[num] = size;
+					stars[num] = distance.Normalized() * 1000.0f;
+					colors[num] = col;
+					brightness[num] = luminositySystemSum / (4 * M_PI * distance.Length() * distance.Length());
+
+					//need to keep data around for HS anim - this is stupid
+					hyperVtx[num] = stars[num];
+					hyperCol[num] = col * 0.8f;
+					num++;
 				}
+				if (num >= NUM_BG_STARS)
+					break;
 			}
 		}
 		Output("Stars picked from galaxy: %d\n", num);
@@ -374,6 +369,7 @@ namespace Background {
 
 		// fill out the remaining target count with generated points
 		if (num < NUM_BG_STARS) {
+			Random rand(m_seed);
 			for (Uint32 i = num; i < NUM_BG_STARS; i++) {
 				const double size = rand.Double(0.2, 0.9);
 				const Uint8 colScale = size * 255;
@@ -394,25 +390,154 @@ namespace Background {
 				colors[i] = col;
 
 				//need to keep data around for HS anim - this is stupid
-				m_hyperVtx[NUM_BG_STARS * 2 + i] = stars[i];
-				m_hyperCol[NUM_BG_STARS * 2 + i] = col;
+				hyperVtx[i] = stars[i];
+				hyperCol[i] = col;
 
 				num++;
 			}
 		}
 		Output("Final stars number: %d\n", num);
+	}
 
-		m_pointSprites->SetData(NUM_BG_STARS, stars.get(), colors.get(), sizes.get(), m_material.Get());
+	Starfield::Starfield(Graphics::Renderer *renderer, Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy) :
+		m_seed(0),
+		m_renderState(nullptr)
+	{
+		m_renderer = renderer;
+		Init();
+		Fill(rand, space, galaxy);
+	}
 
-		Graphics::RenderStateDesc rsd;
-		rsd.depthTest = false;
-		rsd.depthWrite = false;
-		rsd.blendMode = Graphics::BLEND_ALPHA;
-		m_renderState = m_renderer->CreateRenderState(rsd);
+	void Starfield::Init()
+	{
+		Graphics::MaterialDescriptor desc;
+		desc.effect = Graphics::EFFECT_STARFIELD;
+		desc.textures = 1;
+		desc.vertexColors = true;
+		m_material.Reset(m_renderer->CreateMaterial(desc));
+		m_material->emissive = Color::WHITE;
+		m_material->texture0 = Graphics::TextureBuilder::Billboard("textures/star_point_2.png").GetOrCreateTexture(m_renderer, "billboard");
+
+		Graphics::MaterialDescriptor descStreaks;
+		descStreaks.effect = Graphics::EFFECT_VTXCOLOR;
+		descStreaks.vertexColors = true;
+		m_materialStreaks.Reset(m_renderer->CreateMaterial(descStreaks));
+		m_materialStreaks->emissive = Color::WHITE;
+
+		IniConfig cfg;
+		cfg.Read(FileSystem::gameDataFiles, "configs/Starfield.ini");
+		// NB: limit the ranges of all values loaded from the file
+		m_rMin = Clamp(cfg.Float("rMin", 0.6), 0.2f, 1.0f);
+		m_rMax = Clamp(cfg.Float("rMax", 1.0), 0.2f, 1.0f);
+		m_gMin = Clamp(cfg.Float("gMin", 0.6), 0.2f, 1.0f);
+		m_gMax = Clamp(cfg.Float("gMax", 1.0), 0.2f, 1.0f);
+		m_bMin = Clamp(cfg.Float("bMin", 0.6), 0.2f, 1.0f);
+		m_bMax = Clamp(cfg.Float("bMax", 1.0), 0.2f, 1.0f);
+		m_visibleRadiusLy = std::max(cfg.Float("visibleRadiusLy", 180.0f), 0.0f);
+		m_medianPosition = Clamp(cfg.Float("medianPosition", 0.7f), 0.0f, 1.0f);
+		m_brightnessPower = cfg.Float("brightnessPower", 2.1f);
+		m_brightnessApparentSizeFactor = std::max(cfg.Float("brightnessApparentSizeFactor", 0.8f), 0.0f);
+		m_brightnessApparentSizeOffset = cfg.Float("brightnessApparentSizeOffset", 0.0);
+		m_brightnessColorFactor = cfg.Float("brightnessColorFactor", 0.8);
+		m_brightnessColorOffset = cfg.Float("brightnessColorOffset", 0.1);
+	}
+
+	void Starfield::Fill(Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy)
+	{
+		PROFILE_SCOPED()
+		// drop any build still going for the last fill
+		m_buildJob = Job::Handle();
+		m_sectorCache.Reset();
+		m_sectorPaths.clear();
+		m_seed = rand.Int32();
+
+		if (space == nullptr || !galaxy.Valid() || space->GetStarSystem() == nullptr) {
+			// only random stars, which are quick enough to make here and now
+			BuildJob job(this, SystemPath(), std::vector<RefCountedPtr<const Sector>>());
+			job.OnRun();
+			job.OnFinish();
+			return;
+		}
+
+		m_current = space->GetStarSystem()->GetPath();
+		const Sint32 visibleRadius = MathUtil::mix(BG_STAR_RADIUS_MIN, Clamp(m_visibleRadiusLy, BG_STAR_RADIUS_MIN, BG_STAR_RADIUS_MAX), Pi::GetAmountBackgroundStars()); // lyrs
+		const Sint32 visibleRadiusSqr = (visibleRadius * visibleRadius);
+		const Sint32 sectorMin = -(visibleRadius / Sector::SIZE); // lyrs_radius / sector_size_in_lyrs
+		const Sint32 sectorMax = visibleRadius / Sector::SIZE;	  // lyrs_radius / sector_size_in_lyrs
+		for (Sint32 x = sectorMin; x < sectorMax; x++) {
+			for (Sint32 y = sectorMin; y < sectorMax; y++) {
+				for (Sint32 z = sectorMin; z < sectorMax; z++) {
+					SystemPath sys(m_current.sectorX + x, m_current.sectorY + y, m_current.sectorZ + z);
+					if (SystemPath::SectorDistanceSqr(sys, m_current) * Sector::SIZE >= visibleRadiusSqr)
+						continue; // early out
+					m_sectorPaths.push_back(sys);
+				}
+			}
+		}
+
+		// keep showing what we have, or failing that the last sky built
+		if (!m_pointSprites && s_lastStars)
+			SetStars(s_lastStars);
+
+		// generating the sectors is fairly expensive, so it's done in batches
+		// on the job queue, and the stars are built once they are all there
+		m_sectorCache = galaxy->NewSectorSlaveCache();
+		m_sectorCache->FillCache(m_sectorPaths, [this]() { OnSectorsCached(); });
+	}
+
+	void Starfield::OnSectorsCached()
+	{
+		PROFILE_SCOPED()
+		std::vector<RefCountedPtr<const Sector>> sectors;
+		sectors.reserve(m_sectorPaths.size());
+		for (const SystemPath &path : m_sectorPaths)
+			sectors.push_back(m_sectorCache->GetCached(path));
+		m_buildJob = Pi::GetAsyncJobQueue()->Queue(new BuildJob(this, m_current, std::move(sectors)));
+	}
+
+	void Starfield::SetStars(std::shared_ptr<const StarData> data)
+	{
+		PROFILE_SCOPED()
+		const Uint32 NUM_BG_STARS = data->stars.size();
+		m_hyperVtx.reset(new vector3f[NUM_BG_STARS * 3]);
+		m_hyperCol.reset(new Color[NUM_BG_STARS * 3]);
+		std::copy(data->hyperVtx.begin(), data->hyperVtx.end(), &m_hyperVtx[NUM_BG_STARS * 2]);
+		std::copy(data->hyperCol.begin(), data->hyperCol.end(), &m_hyperCol[NUM_BG_STARS * 2]);
+
+		// setup the animated stars buffer (streaks in Hyperspace)
+		{
+			Graphics::VertexBufferDesc vbd;
+			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+			vbd.attrib[0].format = Graphics::ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
+			vbd.attrib[1].format = Graphics::ATTRIB_FORMAT_UBYTE4;
+			vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
+			vbd.numVertices = NUM_BG_STARS * 2;
+			m_animBuffer.reset(m_renderer->CreateVertexBuffer(vbd));
+		}
+
+		m_pointSprites.reset(new Graphics::Drawables::PointSprites);
+		m_pointSprites->SetData(NUM_BG_STARS, data->stars.data(), data->colors.data(), data->sizes.data(), m_material.Get());
+
+		if (!m_renderState) {
+			Graphics::RenderStateDesc rsd;
+			rsd.depthTest = false;
+			rsd.depthWrite = false;
+			rsd.blendMode = Graphics::BLEND_ALPHA;
+			m_renderState = m_renderer->CreateRenderState(rsd);
+		}
+
+		s_lastStars = std::move(data);
+
+		// the sectors have been used, so don't keep them
+		m_sectorCache.Reset();
 	}
 
 	void Starfield::Draw(Graphics::RenderState *rs)
 	{
+		if (!m_pointSprites)
+			return;
+
 		// XXX would be nice to get rid of the Pi:: stuff here
 		if (!Pi::game || Pi::player->GetFlightState() != Ship::HYPERSPACE) {
 			m_pointSprites->Draw(m_renderer, m_renderState);
@@ -4,7 +4,10 @@
 #ifndef _BACKGROUND_H
 #define _BACKGROUND_H
 
+#include "JobQueue.h"
+#include "galaxy/GalaxyCache.h"
 #include "graphics/Drawables.h"
+#include <memory>
 
 class Random;
 class Galaxy;
@@ -59,14 +62,29 @@ namespace Background {
 
 	class Starfield : public BackgroundElement {
 	public:
-		//does not Fill the starfield
 		Starfield(Graphics::Renderer *r, Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy);
 		void Draw(Graphics::RenderState *);
-		//create or recreate the starfield
+		//create or recreate the starfield. the stars around a system are
+		//built in the background, and whatever was there before (or the
+		//last starfield built) is drawn until they are ready
 		void Fill(Random &rand, const Space *space, RefCountedPtr<Galaxy> galaxy);
 
 	private:
+		struct StarData;
+		class BuildJob;
+
 		void Init();
+		void OnSectorsCached();
+		void SetStars(std::shared_ptr<const StarData> data);
+
+		// the last stars built by any starfield, to show while the next are built
+		static std::shared_ptr<const StarData> s_lastStars;
+
+		RefCountedPtr<SectorCache::Slave> m_sectorCache;
+		std::vector<SystemPath> m_sectorPaths;
+		SystemPath m_current;
+		Uint32 m_seed;
+		Job::Handle m_buildJob;
 
 		std::unique_ptr<Graphics::Drawables::PointSprites> m_pointSprites;
 		Graphics::RenderState *m_renderState; // NB: we don't own RenderState pointers, just borrow them
@@ -121,6 +121,7 @@ Beam::Beam(Body *parent, const ProjectileData &prData, const vector3d &pos, cons
 	m_flags |= FLAG_DRAW_LAST;
 
 	m_parent = parent;
+	AddBodyRef(m_parent);
 	m_dir = dir;
 	m_baseDam = prData.damage;
 	m_length = prData.length;
@@ -182,6 +183,7 @@ void Beam::PostLoadFixup(Space *space)
 {
 	Body::PostLoadFixup(space);
 	m_parent = space->GetBodyByIndex(m_parentIndex);
+	AddBodyRef(m_parent);
 }
 
 void Beam::UpdateInterpTransform(double alpha)
@@ -17,6 +17,16 @@
 #include "Star.h"
 #include "lua/LuaEvent.h"
 
+#include <algorithm>
+
+namespace {
+	template <typename T>
+	void EraseAll(std::vector<T> &v, T value)
+	{
+		v.erase(std::remove(v.begin(), v.end(), value), v.end());
+	}
+} // namespace
+
 Body::Body() :
 	PropertiedObject(Lua::manager),
 	m_flags(0),
@@ -59,6 +69,60 @@ Body::Body(const Json &jsonObj, Space *space) :
 
 Body::~Body()
 {
+	// unlink from both sides so nobody is left holding a stale entry
+	for (const Body *target : m_bodyRefs)
+		if (target != this)
+			EraseAll(target->m_bodyReferrers, static_cast<Body *>(this));
+	for (Body *referrer : m_bodyReferrers)
+		if (referrer != this)
+			EraseAll(referrer->m_bodyRefs, static_cast<const Body *>(this));
+}
+
+void Body::AddBodyRef(const Body *target)
+{
+	if (!target) return;
+	m_bodyRefs.push_back(target);
+	target->m_bodyReferrers.push_back(this);
+}
+
+void Body::RemoveBodyRef(const Body *target)
+{
+	// only look at the target if we still hold a reference to it; it may
+	// already have been dropped by NotifyReferrersRemoved() or ~Body()
+	auto ref = std::find(m_bodyRefs.begin(), m_bodyRefs.end(), target);
+	if (ref == m_bodyRefs.end()) return;
+	m_bodyRefs.erase(ref);
+
+	std::vector<Body *> &referrers = target->m_bodyReferrers;
+	auto referrer = std::find(referrers.begin(), referrers.end(), this);
+	assert(referrer != referrers.end());
+	if (referrer != referrers.end())
+		referrers.erase(referrer);
+}
+
+void Body::ReplaceBodyRef(const Body *oldTarget, const Body *newTarget)
+{
+	if (oldTarget == newTarget) return;
+	if (oldTarget) RemoveBodyRef(oldTarget);
+	if (newTarget) AddBodyRef(newTarget);
+}
+
+void Body::NotifyReferrersRemoved()
+{
+	// take the list, NotifyRemoved() may change references as it goes
+	std::vector<Body *> referrers;
+	std::swap(referrers, m_bodyReferrers);
+
+	for (Body *referrer : referrers)
+		EraseAll(referrer->m_bodyRefs, static_cast<const Body *>(this));
+
+	// a body holding several references only needs telling once. keep the
+	// registration order so the notifications are deterministic
+	for (auto it = referrers.begin(); it != referrers.end(); ++it) {
+		if (*it == this || std::find(referrers.begin(), it, *it) != it)
+			continue;
+		(*it)->NotifyRemoved(this);
+	}
 }
 
 void Body::SaveToJson(Json &jsonObj, Space *space)
@@ -10,6 +10,7 @@
 #include "matrix3x3.h"
 #include "vector3.h"
 #include <string>
+#include <vector>
 
 class Space;
 class Camera;
@@ -87,6 +88,17 @@ public:
 	// Override to clear any pointers you hold to the body
 	virtual void NotifyRemoved(const Body *const removedBody) {}
 
+	// Bodies holding a pointer to another body register it here, so that
+	// when the target is removed only its referrers get NotifyRemoved().
+	// References are counted: add one per pointer held and remove it when the
+	// pointer changes. They aren't saved; PostLoadFixup() re-adds them.
+	void AddBodyRef(const Body *target);
+	void RemoveBodyRef(const Body *target);
+	void ReplaceBodyRef(const Body *oldTarget, const Body *newTarget);
+	// Call NotifyRemoved() once on each body referencing this one. Their
+	// references are dropped first, so they don't need to remove them.
+	void NotifyReferrersRemoved();
+
 	// before all bodies have had TimeStepUpdate (their moving step),
 	// StaticUpdate() is called. Good for special collision testing (Projectiles)
 	// as you can't test for collisions if different objects are on different 'steps'
@@ -173,6 +185,9 @@ private:
 	bool m_dead; // Checked in destructor to make sure body has been marked dead.
 	double m_clipRadius;
 	double m_physRadius;
+
+	std::vector<const Body *> m_bodyRefs; // bodies we hold pointers to
+	mutable std::vector<Body *> m_bodyReferrers; // bodies holding pointers to us
 };
 
 #endif /* _BODY_H */
@@ -281,6 +281,12 @@ void Camera::Draw(const Body *excludeBody)
 		if (attrs->body == excludeBody)
 			continue;
 
+		// model bodies that follow each other are held back, to be drawn
+		// together before anything else is
+		if (!attrs->billboard && m_modelBatches.Add(attrs->body, attrs->viewCoords, attrs->viewTransform))
+			continue;
+		m_modelBatches.Flush(m_renderer, this);
+
 		// draw something!
 		if (attrs->billboard) {
 			Graphics::Renderer::MatrixTicket mt(m_renderer, matrix4x4f::Identity());
@@ -289,6 +295,7 @@ void Camera::Draw(const Body *excludeBody)
 		} else
 			attrs->body->Render(m_renderer, this, attrs->viewCoords, attrs->viewTransform);
 	}
+	m_modelBatches.Flush(m_renderer, this);
 
 	SfxManager::RenderAll(m_renderer, rootFrameId, camFrameId);
 }
@@ -6,6 +6,7 @@
 
 #include "Color.h"
 #include "FrameId.h"
+#include "ModelBatches.h"
 #include "graphics/Frustum.h"
 #include "graphics/Light.h"
 #include "matrix4x4.h"
@@ -151,6 +152,9 @@ private:
 
 	std::list<BodyAttrs> m_sortedBodies;
 	std::vector<LightSource> m_lightSources;
+
+	// runs of model bodies, drawn instanced
+	ModelBatches m_modelBatches;
 };
 
 #endif
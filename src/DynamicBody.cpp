@@ -259,7 +259,7 @@ void DynamicBody::CalcExternalForce()
 	}
 }
 
-void DynamicBody::TimeStepUpdate(const float timeStep)
+void DynamicBody::Integrate(const float timeStep)
 {
 	m_oldPos = GetPosition();
 	if (m_isMoving) {
@@ -291,7 +291,10 @@ void DynamicBody::TimeStepUpdate(const float timeStep)
 	} else {
 		m_oldAngDisplacement = vector3d(0.0);
 	}
+}
 
+void DynamicBody::TimeStepUpdate(const float timeStep)
+{
 	ModelBody::TimeStepUpdate(timeStep);
 }
 
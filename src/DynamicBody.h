@@ -35,6 +35,12 @@ public:
 	void SetMoving(bool isMoving) { m_isMoving = isMoving; }
 	bool IsMoving() const { return m_isMoving; }
 	virtual double GetMass() const override { return m_mass; } // XXX don't override this
+	// Applies this step's forces and moves the body. Space calls this just
+	// before TimeStepUpdate(), or with parallel physics for every dynamic
+	// body before any TimeStepUpdate(). It must only touch the body's own
+	// state: with parallel physics it runs on the job runners.
+	// Subclasses add their own forces and then call the base version.
+	virtual void Integrate(const float timeStep);
 	virtual void TimeStepUpdate(const float timeStep) override;
 	double CalcAtmosphericDrag(double velSqr, double area, double coeff) const;
 	void CalcExternalForce();
@@ -229,13 +229,18 @@ namespace FileSystem {
 		bool MakeDirectory(const std::string &path);
 
 		enum WriteFlags {
-			WRITE_TEXT = 1
+			WRITE_TEXT = 1,
+			WRITE_APPEND = 2
 		};
 
 		// similar to fopen(path, "rb")
 		FILE *OpenReadStream(const std::string &path);
-		// similar to fopen(path, "wb")
+		// similar to fopen(path, "wb"), or "ab" with WRITE_APPEND
 		FILE *OpenWriteStream(const std::string &path, int flags = 0);
+		// moves from over to, replacing to if it exists. on the same volume
+		// readers see either the old file or the new one, never a partial one
+		bool RenameFile(const std::string &from, const std::string &to);
+		bool RemoveFile(const std::string &path);
 	};
 
 	class FileSourceUnion : public FileSource {
@@ -11,9 +11,11 @@
 #include "GameLog.h"
 #include "GameSaveError.h"
 #include "HyperspaceCloud.h"
+#include "JobQueue.h"
+#include "Lang.h"
 #include "MathUtil.h"
 #include "collider/CollisionSpace.h"
-#include "core/GZipFormat.h"
+#include "core/SaveFileFormat.h"
 #include "galaxy/Economy.h"
 #include "lua/LuaEvent.h"
 #include "lua/LuaSerializer.h"
@@ -26,12 +28,14 @@
 #include "Sfx.h"
 #include "Space.h"
 #include "SpaceStation.h"
+#include "StringF.h"
 #include "SystemInfoView.h"
 #include "SystemView.h"
 #include "WorldView.h"
 #include "galaxy/GalaxyGenerator.h"
 #include "pigui/PiGuiView.h"
 #include "ship/PlayerShipController.h"
+#include <map>
 
 static const int s_saveVersion = 87;
 
@@ -181,92 +185,126 @@ Game::Game(const Json &jsonObj) :
 }
 
 void Game::ToJson(Json &jsonObj)
+{
+	ToJsonSections([&jsonObj](const std::string &, Json &section) {
+		jsonObj.update(section);
+	});
+}
+
+void Game::ToJsonSections(const SectionWriter &write)
 {
 	PROFILE_SCOPED()
 	// preparing the lua serializer
 	Pi::luaSerializer->InitTableRefs();
 
-	// version
-	jsonObj["version"] = s_saveVersion;
-
-	// galaxy generator
-	m_galaxy->ToJson(jsonObj);
-
-	GalacticEconomy::SaveToJson(jsonObj);
-
-	// game state
-	jsonObj["time"] = m_time;
-	jsonObj["state"] = Uint32(m_state);
-
-	jsonObj["want_hyperspace"] = m_wantHyperspace;
-	jsonObj["hyperspace_progress"] = m_hyperspaceProgress;
-	jsonObj["hyperspace_duration"] = m_hyperspaceDuration;
-	jsonObj["hyperspace_end_time"] = m_hyperspaceEndTime;
-
 	// Delete camera frame from frame structure:
 	bool have_cam_frame = m_gameViews->m_worldView->GetCameraContext()->GetTempFrame().valid();
 	if (have_cam_frame) m_gameViews->m_worldView->EndCameraFrame();
 
-	// space, all the bodies and things
-	m_space->ToJson(jsonObj);
-	jsonObj["player"] = m_space->GetIndexForBody(m_player.get());
+	try {
+		{
+			// galaxy generator
+			Json galaxyObj = Json::object();
+			m_galaxy->ToJson(galaxyObj);
+			GalacticEconomy::SaveToJson(galaxyObj);
+			write("galaxy", galaxyObj);
+		}
 
-	// hyperspace clouds being brought over from the previous system
-	Json hyperspaceCloudArray = Json::array(); // Create JSON array to contain hyperspace cloud data.
-	for (std::list<HyperspaceCloud *>::const_iterator i = m_hyperspaceClouds.begin(); i != m_hyperspaceClouds.end(); ++i) {
-		Json hyperspaceCloudArrayEl = Json::object(); // Create JSON object to contain hyperspace cloud.
-		(*i)->ToJson(hyperspaceCloudArrayEl, m_space.get());
-		hyperspaceCloudArray.push_back(hyperspaceCloudArrayEl); // Append hyperspace cloud object to array.
-	}
-	jsonObj["hyperspace_clouds"] = hyperspaceCloudArray; // Add hyperspace cloud array to supplied object.
+		{
+			// game state
+			Json gameObj = Json::object();
+			gameObj["time"] = m_time;
+			gameObj["state"] = Uint32(m_state);
+
+			gameObj["want_hyperspace"] = m_wantHyperspace;
+			gameObj["hyperspace_progress"] = m_hyperspaceProgress;
+			gameObj["hyperspace_duration"] = m_hyperspaceDuration;
+			gameObj["hyperspace_end_time"] = m_hyperspaceEndTime;
+			write("game", gameObj);
+		}
 
-	// views. must be saved in init order
-	m_gameViews->m_sectorView->SaveToJson(jsonObj);
-	m_gameViews->m_worldView->SaveToJson(jsonObj);
+		{
+			// space, all the bodies and things
+			Json spaceObj = Json::object();
+			m_space->ToJson(spaceObj);
+			spaceObj["player"] = m_space->GetIndexForBody(m_player.get());
+
+			// hyperspace clouds being brought over from the previous system
+			Json hyperspaceCloudArray = Json::array(); // Create JSON array to contain hyperspace cloud data.
+			for (std::list<HyperspaceCloud *>::const_iterator i = m_hyperspaceClouds.begin(); i != m_hyperspaceClouds.end(); ++i) {
+				Json hyperspaceCloudArrayEl = Json::object(); // Create JSON object to contain hyperspace cloud.
+				(*i)->ToJson(hyperspaceCloudArrayEl, m_space.get());
+				hyperspaceCloudArray.push_back(hyperspaceCloudArrayEl); // Append hyperspace cloud object to array.
+			}
+			spaceObj["hyperspace_clouds"] = hyperspaceCloudArray; // Add hyperspace cloud array to supplied object.
+			write("space", spaceObj);
+		}
 
-	// lua
-	Pi::luaSerializer->ToJson(jsonObj);
-
-	// Stuff to show in the preview in load game window
-	// some may be redundant, but this won't require loading up a game to get it all
-	Json gameInfo = Json::object();
-	float credits = LuaObject<Player>::CallMethod<float>(Pi::player, "GetMoney");
-
-	gameInfo["system"] = Pi::game->GetSpace()->GetStarSystem()->GetName();
-	gameInfo["credits"] = credits;
-	gameInfo["ship"] = Pi::player->GetShipType()->modelName;
-	if (Pi::player->IsDocked()) {
-		gameInfo["docked_at"] = Pi::player->GetDockedWith()->GetSystemBody()->GetName();
-	}
+		{
+			// views. must be saved in init order
+			Json viewsObj = Json::object();
+			m_gameViews->m_sectorView->SaveToJson(viewsObj);
+			m_gameViews->m_worldView->SaveToJson(viewsObj);
+			write("views", viewsObj);
+		}
 
-	switch (Pi::player->GetFlightState()) {
-	case Ship::FlightState::DOCKED:
-		gameInfo["flight_state"] = "docked";
-		break;
-	case Ship::FlightState::DOCKING:
-		gameInfo["flight_state"] = "docking";
-		break;
-	case Ship::FlightState::FLYING:
-		gameInfo["flight_state"] = "flying";
-		break;
-	case Ship::FlightState::HYPERSPACE:
-		gameInfo["flight_state"] = "hyperspace";
-		break;
-	case Ship::FlightState::JUMPING:
-		gameInfo["flight_state"] = "jumping";
-		break;
-	case Ship::FlightState::LANDED:
-		gameInfo["flight_state"] = "landed";
-		break;
-	case Ship::FlightState::UNDOCKING:
-		gameInfo["flight_state"] = "undocking";
-		break;
-	default:
-		gameInfo["flight_state"] = "unknown";
-		break;
-	}
+		{
+			// lua
+			Json luaObj = Json::object();
+			Pi::luaSerializer->ToJson(luaObj);
+			write("lua", luaObj);
+		}
+
+		{
+			// Stuff to show in the preview in load game window
+			// some may be redundant, but this won't require loading up a game to get it all
+			Json infoObj = Json::object();
+			infoObj["version"] = s_saveVersion;
+			Json gameInfo = Json::object();
+			float credits = LuaObject<Player>::CallMethod<float>(Pi::player, "GetMoney");
+
+			gameInfo["system"] = Pi::game->GetSpace()->GetStarSystem()->GetName();
+			gameInfo["credits"] = credits;
+			gameInfo["ship"] = Pi::player->GetShipType()->modelName;
+			if (Pi::player->IsDocked()) {
+				gameInfo["docked_at"] = Pi::player->GetDockedWith()->GetSystemBody()->GetName();
+			}
 
-	jsonObj["game_info"] = gameInfo;
+			switch (Pi::player->GetFlightState()) {
+			case Ship::FlightState::DOCKED:
+				gameInfo["flight_state"] = "docked";
+				break;
+			case Ship::FlightState::DOCKING:
+				gameInfo["flight_state"] = "docking";
+				break;
+			case Ship::FlightState::FLYING:
+				gameInfo["flight_state"] = "flying";
+				break;
+			case Ship::FlightState::HYPERSPACE:
+				gameInfo["flight_state"] = "hyperspace";
+				break;
+			case Ship::FlightState::JUMPING:
+				gameInfo["flight_state"] = "jumping";
+				break;
+			case Ship::FlightState::LANDED:
+				gameInfo["flight_state"] = "landed";
+				break;
+			case Ship::FlightState::UNDOCKING:
+				gameInfo["flight_state"] = "undocking";
+				break;
+			default:
+				gameInfo["flight_state"] = "unknown";
+				break;
+			}
+
+			infoObj["game_info"] = gameInfo;
+			write("info", infoObj);
+		}
+	} catch (...) {
+		Pi::luaSerializer->UninitTableRefs();
+		if (have_cam_frame) m_gameViews->m_worldView->BeginCameraFrame();
+		throw;
+	}
 
 	Pi::luaSerializer->UninitTableRefs();
 
@@ -869,9 +907,8 @@ void Game::EmitPauseState(bool paused)
 	LuaEvent::Emit();
 }
 
-Json Game::LoadGameToJson(const std::string &filename)
+static void CheckSaveVersion(const Json &rootNode, const std::string &filename)
 {
-	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles);
 	if (!rootNode.is_object()) {
 		Output("Loading saved game '%s' failed.\n", filename.c_str());
 		throw SavedGameCorruptException();
@@ -880,6 +917,34 @@ Json Game::LoadGameToJson(const std::string &filename)
 		Output("Loading saved game '%s' failed: wrong save file version.\n", filename.c_str());
 		throw SavedGameCorruptException();
 	}
+}
+
+Json Game::LoadGameToJson(const std::string &filename)
+{
+	Json rootNode = JsonUtils::LoadJsonSaveFile(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename), FileSystem::userFiles);
+	CheckSaveVersion(rootNode, filename);
+	return rootNode;
+}
+
+Json Game::LoadGameInfoToJson(const std::string &filename)
+{
+	const std::string path = FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename);
+	auto file = FileSystem::userFiles.ReadFile(path);
+	if (!file) throw CouldNotOpenFileException();
+	if (!savefile::IsSaveFileFormat(file->GetData(), file->GetSize()))
+		return LoadGameToJson(filename);
+
+	// only decode the small sections
+	Json rootNode = Json::object();
+	try {
+		savefile::Reader reader(file->GetData(), file->GetSize());
+		rootNode.update(reader.ReadSection("info"));
+		rootNode.update(reader.ReadSection("game"));
+	} catch (const savefile::FormatError &e) {
+		Output("Loading saved game '%s' failed: %s\n", filename.c_str(), e.what());
+		throw SavedGameCorruptException();
+	}
+	CheckSaveVersion(rootNode, filename);
 	return rootNode;
 }
 
@@ -908,45 +973,209 @@ bool Game::CanLoadGame(const std::string &filename)
 	// file data is freed here
 }
 
-void Game::SaveGame(const std::string &filename, Game *game)
+// saves are written to a temp file which then replaces the real one, so a
+// failed or interrupted save never leaves a broken file behind. background
+// saves of the same file may overlap, so each save is numbered when its
+// snapshot is taken and an older one never replaces a newer one
+static const char s_saveTempDirName[] = "savefiles_tmp";
+static Uint64 s_nextSaveSerial = 0;
+static std::map<std::string, Uint64> s_savedSerials; // guarded by GetSaveLock()
+static int s_savesInFlight = 0; // guarded by GetSaveLock()
+static std::unique_ptr<JobSet> s_saveJobs;
+
+static SDL_mutex *GetSaveLock()
 {
-	PROFILE_SCOPED()
-	assert(game);
+	static SDL_mutex *lock = SDL_CreateMutex();
+	return lock;
+}
+
+// signalled when the last save in flight is done
+static SDL_cond *GetSavesDoneCond()
+{
+	static SDL_cond *cond = SDL_CreateCond();
+	return cond;
+}
 
+static void CheckCanSave(Game *game)
+{
 	if (game->IsHyperspace())
 		throw CannotSaveInHyperspace();
 
 	if (game->GetPlayer()->IsDead())
 		throw CannotSaveDeadPlayer();
 
-	if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME)) {
+	if (!FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME) ||
+		!FileSystem::userFiles.MakeDirectory(s_saveTempDirName)) {
 		throw CouldNotOpenFileException();
 	}
+}
 
-	Json rootNode;
-	game->ToJson(rootNode); // Encode the game data as JSON and give to the root value.
-	std::vector<uint8_t> jsonData;
-	{
-		PROFILE_SCOPED_DESC("json.to_cbor");
-		jsonData = Json::to_cbor(rootNode); // Convert the JSON data to CBOR.
-	}
-
-	FileSystem::userFiles.MakeDirectory(Pi::SAVE_DIR_NAME);
-	FILE *f = FileSystem::userFiles.OpenWriteStream(FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
+// safe to call from any thread, as long as writeSections is
+static void WriteSaveFile(const std::string &filename, Uint64 serial, const std::function<void(savefile::Writer &)> &writeSections)
+{
+	const std::string tempPath = FileSystem::JoinPathBelow(s_saveTempDirName, filename + "." + std::to_string(serial));
+	FILE *f = FileSystem::userFiles.OpenWriteStream(tempPath);
 	if (!f) throw CouldNotOpenFileException();
 
+	bool written = true;
 	try {
-		// Compress the CBOR data.
-		const std::string comressed_data = gzip::CompressGZip(
-			std::string(reinterpret_cast<const char *>(jsonData.data()), jsonData.size()),
-			filename + ".json");
-		size_t nwritten = fwrite(comressed_data.data(), comressed_data.size(), 1, f);
-		fclose(f);
-		if (nwritten != 1) throw CouldNotWriteToFileException();
-	} catch (gzip::CompressionFailedException) {
+		savefile::Writer writer(f);
+		writeSections(writer);
+		writer.Finish();
+	} catch (const savefile::WriteFailedException &) {
+		written = false;
+	} catch (...) {
 		fclose(f);
-		throw CouldNotWriteToFileException();
+		FileSystem::userFiles.RemoveFile(tempPath);
+		throw;
+	}
+	if (fclose(f) != 0) written = false;
+
+	bool replaced = false;
+	if (written) {
+		SDL_LockMutex(GetSaveLock());
+		Uint64 &savedSerial = s_savedSerials[filename];
+		if (serial > savedSerial) {
+			written = FileSystem::userFiles.RenameFile(tempPath, FileSystem::JoinPathBelow(Pi::SAVE_DIR_NAME, filename));
+			replaced = written;
+			if (replaced) savedSerial = serial;
+		}
+		SDL_UnlockMutex(GetSaveLock());
 	}
 
+	if (!replaced) FileSystem::userFiles.RemoveFile(tempPath);
+	if (!written) throw CouldNotWriteToFileException();
+}
+
+void Game::SaveGame(const std::string &filename, Game *game)
+{
+	PROFILE_SCOPED()
+	assert(game);
+	CheckCanSave(game);
+
+	// each section is encoded and compressed straight to the file as soon
+	// as it's built, so the whole game is never in memory at once
+	WriteSaveFile(filename, ++s_nextSaveSerial, [game](savefile::Writer &writer) {
+		game->ToJsonSections([&writer](const std::string &name, Json &section) {
+			writer.WriteSection(name, section);
+		});
+	});
+
 	Pi::RequestProfileFrame("SaveGame");
 }
+
+namespace {
+	class SaveGameJob : public Job {
+	public:
+		typedef std::vector<std::pair<std::string, Json>> Snapshot;
+
+		SaveGameJob(const std::string &filename, Uint64 serial, Snapshot &&snapshot) :
+			m_filename(filename),
+			m_serial(serial),
+			m_snapshot(std::move(snapshot)),
+			m_result(Result::SAVED),
+			m_inFlight(true)
+		{
+			SDL_LockMutex(GetSaveLock());
+			s_savesInFlight++;
+			SDL_UnlockMutex(GetSaveLock());
+		}
+
+		// a job cancelled before it ran is only deleted
+		virtual ~SaveGameJob()
+		{
+			if (m_inFlight) Done();
+		}
+
+		virtual void OnRun() override
+		{
+			PROFILE_SCOPED()
+			try {
+				WriteSaveFile(m_filename, m_serial, [this](savefile::Writer &writer) {
+					for (const auto &section : m_snapshot)
+						writer.WriteSection(section.first, section.second);
+				});
+			} catch (CouldNotOpenFileException) {
+				m_result = Result::COULD_NOT_OPEN;
+			} catch (CouldNotWriteToFileException) {
+				m_result = Result::COULD_NOT_WRITE;
+			} catch (const std::exception &e) {
+				Output("Background save of %s failed: %s\n", m_filename.c_str(), e.what());
+				m_result = Result::COULD_NOT_WRITE;
+			} catch (...) {
+				Output("Background save of %s failed\n", m_filename.c_str());
+				m_result = Result::COULD_NOT_WRITE;
+			}
+			Snapshot().swap(m_snapshot);
+			// the job itself is only deleted once the main thread finishes
+			// it, which FinishSaves can't wait for
+			Done();
+		}
+
+		virtual void OnFinish() override
+		{
+			const std::string path = FileSystem::JoinPath(Pi::GetSaveDir(), m_filename);
+			switch (m_result) {
+			case Result::SAVED:
+				LuaEvent::Queue("onGameSaved", m_filename, path);
+				break;
+			case Result::COULD_NOT_OPEN:
+				LuaEvent::Queue("onGameSaveFailed", m_filename, stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path)));
+				break;
+			case Result::COULD_NOT_WRITE:
+				LuaEvent::Queue("onGameSaveFailed", m_filename, std::string(Lang::GAME_SAVE_CANNOT_WRITE));
+				break;
+			}
+		}
+
+	private:
+		enum class Result {
+			SAVED,
+			COULD_NOT_OPEN,
+			COULD_NOT_WRITE
+		};
+
+		void Done()
+		{
+			m_inFlight = false;
+			SDL_LockMutex(GetSaveLock());
+			if (--s_savesInFlight == 0)
+				SDL_CondBroadcast(GetSavesDoneCond());
+			SDL_UnlockMutex(GetSaveLock());
+		}
+
+		std::string m_filename;
+		Uint64 m_serial;
+		Snapshot m_snapshot;
+		Result m_result;
+		bool m_inFlight;
+	};
+} // namespace
+
+void Game::SaveGameAsync(const std::string &filename, Game *game)
+{
+	PROFILE_SCOPED()
+	assert(game);
+	CheckCanSave(game);
+
+	// the sections are only built here. they don't refer back to the game,
+	// so it can carry on while the worker encodes them
+	SaveGameJob::Snapshot snapshot;
+	game->ToJsonSections([&snapshot](const std::string &name, Json &section) {
+		snapshot.emplace_back(name, std::move(section));
+	});
+
+	if (!s_saveJobs) s_saveJobs.reset(new JobSet(Pi::GetAsyncJobQueue()));
+	s_saveJobs->Order(new SaveGameJob(filename, ++s_nextSaveSerial, std::move(snapshot)));
+}
+
+void Game::FinishSaves()
+{
+	PROFILE_SCOPED()
+	// the jobs only need the workers, not the main loop, to get written
+	SDL_LockMutex(GetSaveLock());
+	while (s_savesInFlight > 0)
+		SDL_CondWait(GetSavesDoneCond(), GetSaveLock());
+	SDL_UnlockMutex(GetSaveLock());
+	s_saveJobs.reset();
+}
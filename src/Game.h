@@ -8,6 +8,7 @@
 #include "galaxy/Galaxy.h"
 #include "galaxy/SystemPath.h"
 #include "gameconsts.h"
+#include <functional>
 #include <string>
 
 class GameLog;
@@ -39,12 +40,21 @@ class ObjectViewerView;
 class Game {
 public:
 	static Json LoadGameToJson(const std::string &filename);
+	// just the version, time and game_info of a saved game, for previews.
+	// older saves are read whole
+	static Json LoadGameInfoToJson(const std::string &filename);
 	// LoadGame and SaveGame throw exceptions on failure
 	static Game *LoadGame(const std::string &filename);
 	static bool CanLoadGame(const std::string &filename);
 	// XXX game arg should be const, and this should probably be a member function
 	// (or LoadGame/SaveGame should be somewhere else entirely)
 	static void SaveGame(const std::string &filename, Game *game);
+	// takes a snapshot of the game now, and leaves encoding and writing it
+	// to a worker. onGameSaved or onGameSaveFailed is queued once it's
+	// written. throws like SaveGame if the game can't be saved right now
+	static void SaveGameAsync(const std::string &filename, Game *game);
+	// blocks until every background save has been written
+	static void FinishSaves();
 
 	// start docked in station referenced by path or nearby to body if it is no station
 	Game(const SystemPath &path, const double startDateTime = 0.0);
@@ -56,6 +66,10 @@ public:
 
 	// save game
 	void ToJson(Json &jsonObj);
+	// save game, one section per subsystem, each handed to write and freed
+	// before the next is built (so write may move it away)
+	typedef std::function<void(const std::string &name, Json &section)> SectionWriter;
+	void ToJsonSections(const SectionWriter &write);
 
 	// various game states
 	bool IsNormalSpace() const { return m_state == State::NORMAL; }
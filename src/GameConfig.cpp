@@ -39,6 +39,11 @@ GameConfig::GameConfig(const map_string &override_)
 	map["VSync"] = "1";
 	map["UseTextureCompression"] = "1";
 	map["WorkerThreads"] = "0";
+	map["ParallelPhysics"] = "0";
+	map["SectorCacheMemoryMB"] = "16";
+	map["SectorDiskCache"] = "1";
+	map["StarSystemCacheMemoryMB"] = "64";
+	map["TerrainDiskCacheMB"] = "256";
 	map["SpeedLines"] = "0";
 	map["EnableCockpit"] = "0";
 	map["HudTrails"] = "0";
@@ -36,14 +36,12 @@ GeoPatch::GeoPatch(const RefCountedPtr<GeoPatchContext> &ctx_, GeoSphere *gs,
 	m_v1(v1_),
 	m_v2(v2_),
 	m_v3(v3_),
-	m_heights(nullptr),
-	m_normals(nullptr),
-	m_colors(nullptr),
 	m_parent(nullptr),
 	m_geosphere(gs),
 	m_depth(depth),
 	m_PatchID(ID_),
-	m_HasJobRequest(false)
+	m_HasJobRequest(false),
+	m_splitWaiting(false)
 {
 
 	m_clipCentroid = (m_v0 + m_v1 + m_v2 + m_v3) * 0.25;
@@ -313,17 +311,12 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 
 void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustum)
 {
-	// there should be no LOD update when we have active split requests
-	if (m_HasJobRequest)
-		return;
-
 	bool canSplit = true;
 	bool canMerge = bool(m_kids[0]);
 
 	// always split at first level
-	double centroidDist = DBL_MAX;
+	const double centroidDist = (campos - m_centroid).Length(); // distance from camera to centre of the patch
 	if (m_parent) {
-		centroidDist = (campos - m_centroid).Length();		 // distance from camera to centre of the patch
 		const bool tooFar = (centroidDist >= m_roughLength); // check if the distance is greater than the rough length, which is how far it should be before it can split
 		if (m_depth >= std::min(GEOPATCH_MAX_DEPTH, m_geosphere->GetMaxDepth()) || tooFar) {
 			canSplit = false; // we're too deep in the quadtree or too far away so cannot split
@@ -333,8 +326,10 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 	if (canSplit) {
 		if (!m_kids[0]) {
 			// Test if this patch is visible
-			if (!frustum.TestPoint(m_clipCentroid, m_clipRadius))
+			if (!frustum.TestPoint(m_clipCentroid, m_clipRadius)) {
+				CancelSplit(); // the camera has moved on before the kids arrived
 				return; // nothing below this patch is visible
+			}
 
 			// only want to horizon cull patches that can actually be over the horizon!
 			const vector3d camDir(campos - m_clipCentroid);
@@ -348,45 +343,89 @@ void GeoPatch::LODUpdate(const vector3d &campos, const Graphics::Frustum &frustu
 				obj.m_radius = m_clipRadius;
 
 				if (!s_sph.HorizonCulling(campos, obj)) {
+					CancelSplit();
 					return; // nothing below this patch is visible
 				}
 			}
 
-			// we can see this patch so submit the jobs!
-			assert(!m_HasJobRequest);
-			m_HasJobRequest = true;
-
-			SQuadSplitRequest *ssrd = new SQuadSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
-				m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2,
-				m_ctx->GetFrac(), m_geosphere->GetTerrain());
-
-			// add to the GeoSphere to be processed at end of all LODUpdate requests
-			m_geosphere->AddQuadSplitRequest(centroidDist, ssrd, this);
+			// we can see this patch so it wants splitting (still, if it
+			// already did). the GeoSphere decides which of the patches that
+			// want splitting get jobs, the ones with the most missing detail
+			// first: how many times closer than the split distance the camera
+			// is, which is how much bigger than it should be the patch looks
+			if (!m_HasJobRequest) {
+				m_HasJobRequest = true;
+				m_splitWaiting = true;
+			}
+			m_geosphere->AddQuadSplitRequest(m_roughLength / std::max(centroidDist, DBL_EPSILON), centroidDist, this);
 		} else {
 			for (int i = 0; i < NUM_KIDS; i++) {
 				m_kids[i]->LODUpdate(campos, frustum);
 			}
 		}
-	} else if (canMerge) {
-		for (int i = 0; i < NUM_KIDS; i++) {
-			canMerge &= m_kids[i]->canBeMerged();
-		}
+	} else {
+		CancelSplit();
 		if (canMerge) {
+			// nothing below here is wanted any more
 			for (int i = 0; i < NUM_KIDS; i++) {
-				m_kids[i].reset();
+				m_kids[i]->CancelSplits();
+				canMerge &= m_kids[i]->canBeMerged();
+			}
+			if (canMerge) {
+				for (int i = 0; i < NUM_KIDS; i++) {
+					m_kids[i].reset();
+				}
 			}
 		}
 	}
 }
 
+void GeoPatch::QueueSplitJob()
+{
+	assert(m_splitWaiting && !m_job.HasJob());
+	m_splitWaiting = false;
+
+	SQuadSplitRequest *ssrd = new SQuadSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
+		m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2,
+		m_ctx->GetFrac(), m_geosphere->GetTerrain(), m_geosphere->GetDiskCache());
+	QuadPatchJob *job = new QuadPatchJob(ssrd);
+	job->SetPriority(Job::PRIORITY_HIGH);
+	m_job = Pi::GetAsyncJobQueue()->Queue(job);
+}
+
+// forgets the split if its job hasn't been queued and cancels the job if it
+// has. if the job has already finished, its results are dropped when they
+// get here
+void GeoPatch::CancelSplit()
+{
+	if (!m_HasJobRequest)
+		return;
+	m_job = Job::Handle();
+	m_HasJobRequest = false;
+	m_splitWaiting = false;
+}
+
+void GeoPatch::CancelSplits()
+{
+	CancelSplit();
+	if (m_kids[0]) {
+		for (int i = 0; i < NUM_KIDS; i++) {
+			m_kids[i]->CancelSplits();
+		}
+	}
+}
+
 void GeoPatch::RequestSinglePatch()
 {
 	if (!m_heights) {
 		assert(!m_HasJobRequest);
 		m_HasJobRequest = true;
 		SSingleSplitRequest *ssrd = new SSingleSplitRequest(m_v0, m_v1, m_v2, m_v3, m_centroid.Normalized(), m_depth,
-			m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2, m_ctx->GetFrac(), m_geosphere->GetTerrain());
-		m_job = Pi::GetAsyncJobQueue()->Queue(new SinglePatchJob(ssrd));
+			m_geosphere->GetSystemBody()->GetPath(), m_PatchID, m_ctx->GetEdgeLen() - 2, m_ctx->GetFrac(), m_geosphere->GetTerrain(),
+			m_geosphere->GetDiskCache());
+		SinglePatchJob *job = new SinglePatchJob(ssrd);
+		job->SetPriority(Job::PRIORITY_HIGH);
+		m_job = Pi::GetAsyncJobQueue()->Queue(job);
 	}
 }
 
@@ -402,8 +441,10 @@ void GeoPatch::ReceiveHeightmaps(SQuadSplitResult *psr)
 		} else {
 			psr->OnCancel();
 		}
+	} else if (!m_HasJobRequest || m_kids[0]) {
+		// the split was cancelled after the job had finished
+		psr->OnCancel();
 	} else {
-		assert(m_HasJobRequest);
 		const int newDepth = m_depth + 1;
 		for (int i = 0; i < NUM_KIDS; i++) {
 			assert(!m_kids[i]);
@@ -417,35 +458,33 @@ void GeoPatch::ReceiveHeightmaps(SQuadSplitResult *psr)
 		m_kids[0]->m_parent = m_kids[1]->m_parent = m_kids[2]->m_parent = m_kids[3]->m_parent = this;
 
 		for (int i = 0; i < NUM_KIDS; i++) {
-			const SQuadSplitResult::SSplitResultData &data = psr->data(i);
-			m_kids[i]->m_heights.reset(data.heights);
-			m_kids[i]->m_normals.reset(data.normals);
-			m_kids[i]->m_colors.reset(data.colors);
+			SQuadSplitResult::SSplitResultData &data = psr->data(i);
+			m_kids[i]->m_heights = std::move(data.heights);
+			m_kids[i]->m_normals = std::move(data.normals);
+			m_kids[i]->m_colors = std::move(data.colors);
 		}
 		for (int i = 0; i < NUM_KIDS; i++) {
 			m_kids[i]->NeedToUpdateVBOs();
 		}
+		// (if the split was cancelled and asked for again, these are from
+		// the first job, and the second isn't needed)
+		m_job = Job::Handle();
 		m_HasJobRequest = false;
+		m_splitWaiting = false;
 	}
 }
 
-void GeoPatch::ReceiveHeightmap(const SSingleSplitResult *psr)
+void GeoPatch::ReceiveHeightmap(SSingleSplitResult *psr)
 {
 	PROFILE_SCOPED()
 	assert(nullptr == m_parent);
 	assert(nullptr != psr);
 	assert(m_HasJobRequest);
 	{
-		const SSingleSplitResult::SSplitResultData &data = psr->data();
-		m_heights.reset(data.heights);
-		m_normals.reset(data.normals);
-		m_colors.reset(data.colors);
+		SSingleSplitResult::SSplitResultData &data = psr->data();
+		m_heights = std::move(data.heights);
+		m_normals = std::move(data.normals);
+		m_colors = std::move(data.colors);
 	}
 	m_HasJobRequest = false;
 }
-
-void GeoPatch::ReceiveJobHandle(Job::Handle job)
-{
-	assert(!m_job.HasJob());
-	m_job = static_cast<Job::Handle &&>(job);
-}
@@ -7,6 +7,7 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchBufferPool.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
 #include "RefCounted.h"
@@ -46,7 +47,7 @@ public:
 
 	inline void NeedToUpdateVBOs()
 	{
-		m_needUpdateVBOs = (nullptr != m_heights);
+		m_needUpdateVBOs = bool(m_heights);
 	}
 
 	void UpdateVBOs(Graphics::Renderer *renderer);
@@ -82,20 +83,27 @@ public:
 
 	void LODUpdate(const vector3d &campos, const Graphics::Frustum &frustum);
 
+	// LODUpdate() only asks the GeoSphere to split the patch, which queues
+	// the job when there's room for it
+	bool IsSplitWaiting() const { return m_splitWaiting; }
+	void QueueSplitJob();
+
 	void RequestSinglePatch();
 	void ReceiveHeightmaps(SQuadSplitResult *psr);
-	void ReceiveHeightmap(const SSingleSplitResult *psr);
-	void ReceiveJobHandle(Job::Handle job);
+	void ReceiveHeightmap(SSingleSplitResult *psr);
 
 	inline bool HasHeightData() const { return (m_heights.get() != nullptr); }
 private:
 	static const int NUM_KIDS = 4;
 
+	void CancelSplit();
+	void CancelSplits(); // of this patch and everything below it
+
 	RefCountedPtr<GeoPatchContext> m_ctx;
 	const vector3d m_v0, m_v1, m_v2, m_v3;
-	std::unique_ptr<double[]> m_heights;
-	std::unique_ptr<vector3f[]> m_normals;
-	std::unique_ptr<Color3ub[]> m_colors;
+	GeoPatchBuffer<double> m_heights;
+	GeoPatchBuffer<vector3f> m_normals;
+	GeoPatchBuffer<Color3ub> m_colors;
 	std::unique_ptr<Graphics::VertexBuffer> m_vertexBuffer;
 	std::unique_ptr<GeoPatch> m_kids[NUM_KIDS];
 	GeoPatch *m_parent;
@@ -109,6 +117,7 @@ private:
 	const GeoPatchID m_PatchID;
 	Job::Handle m_job;
 	bool m_HasJobRequest;
+	bool m_splitWaiting; // for the GeoSphere to queue the job
 #ifdef DEBUG_BOUNDING_SPHERES
 	std::unique_ptr<Graphics::Drawables::Sphere3D> m_boundsphere;
 #endif
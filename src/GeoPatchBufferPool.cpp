@@ -0,0 +1,197 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchBufferPool.h"
+
+#include <SDL_mutex.h>
+#include <algorithm>
+
+// blocks are kept a cache line apart so that jobs filling neighbouring blocks
+// don't fight over lines, and slabs hold about this much (though at least one
+// block and at most MAX_BLOCKS_PER_SLAB)
+static const size_t BLOCK_ALIGN = 64;
+static const size_t SLAB_BYTES = 1024 * 1024;
+static const size_t MAX_BLOCKS_PER_SLAB = 64;
+
+GeoPatchBufferPool::GeoPatchBufferPool() :
+	m_edgeLen(0),
+	m_usedBytes(0),
+	m_freeBytes(0),
+	m_highWaterBytes(0),
+	m_lock(SDL_CreateMutex()),
+	m_statBlocksUsed(m_stats.GetOrCreateCounter("Blocks in use", false)),
+	m_statBlocksFree(m_stats.GetOrCreateCounter("Blocks free", false)),
+	m_statUsedKB(m_stats.GetOrCreateCounter("KB in use", false)),
+	m_statFreeKB(m_stats.GetOrCreateCounter("KB free", false)),
+	m_statHighWaterKB(m_stats.GetOrCreateCounter("KB in use at most", false)),
+	m_statSlabs(m_stats.GetOrCreateCounter("Slabs", false)),
+	m_statNewSlabs(m_stats.GetOrCreateCounter("Slabs allocated", false))
+{
+	m_stats.EnableReset(false);
+}
+
+GeoPatchBufferPool::~GeoPatchBufferPool()
+{
+	for (SizeClass &sc : m_classes) {
+		for (Slab &slab : sc.slabs)
+			delete[] slab.memory;
+	}
+	SDL_DestroyMutex(m_lock);
+}
+
+void GeoPatchBufferPool::SetEdgeLen(int edgeLen)
+{
+	SDL_LockMutex(m_lock);
+	if (edgeLen != m_edgeLen) {
+		m_edgeLen = edgeLen;
+		for (SizeClass &sc : m_classes)
+			sc.wanted = false;
+		// anything idle can go now, the rest as it comes back
+		auto it = m_classes.begin();
+		while (it != m_classes.end()) {
+			if (it->used == 0) {
+				TrimClass(*it);
+				it = m_classes.erase(it);
+			} else
+				++it;
+		}
+		UpdateStats();
+	}
+	SDL_UnlockMutex(m_lock);
+}
+
+GeoPatchBufferPool::SizeClass &GeoPatchBufferPool::FindClass(size_t bytes)
+{
+	const size_t blockSize = (bytes + BLOCK_ALIGN - 1) & ~(BLOCK_ALIGN - 1);
+	for (SizeClass &sc : m_classes) {
+		if (sc.blockSize == blockSize)
+			return sc;
+	}
+
+	m_classes.push_back(SizeClass());
+	SizeClass &sc = m_classes.back();
+	sc.blockSize = blockSize;
+	sc.blocksPerSlab = std::max(size_t(1), std::min(MAX_BLOCKS_PER_SLAB, SLAB_BYTES / blockSize));
+	sc.wanted = true;
+	sc.used = 0;
+	return sc;
+}
+
+// static
+GeoPatchBufferPool::Slab &GeoPatchBufferPool::FindSlab(SizeClass &sc, void *block)
+{
+	const char *p = static_cast<const char *>(block);
+	auto it = std::upper_bound(sc.slabs.begin(), sc.slabs.end(), p, [](const char *a, const Slab &s) {
+		return a < s.memory;
+	});
+	assert(it != sc.slabs.begin());
+	--it;
+	assert(p < it->memory + sc.blockSize * sc.blocksPerSlab);
+	return *it;
+}
+
+void GeoPatchBufferPool::AddSlab(SizeClass &sc)
+{
+	Slab slab;
+	slab.memory = new char[sc.blockSize * sc.blocksPerSlab];
+	slab.used = 0;
+	sc.slabs.insert(std::upper_bound(sc.slabs.begin(), sc.slabs.end(), slab.memory, [](const char *a, const Slab &s) {
+		return a < s.memory;
+	}),
+		slab);
+
+	// handed out from the start of the slab first
+	for (size_t i = sc.blocksPerSlab; i > 0; i--)
+		sc.free.push_back(slab.memory + (i - 1) * sc.blockSize);
+	m_freeBytes += sc.blockSize * sc.blocksPerSlab;
+	m_stats.CounterAdd(m_statNewSlabs);
+}
+
+// lets go of the slabs with none of their blocks in use
+void GeoPatchBufferPool::TrimClass(SizeClass &sc)
+{
+	if (sc.free.size() < sc.blocksPerSlab)
+		return;
+
+	auto freeEnd = std::remove_if(sc.free.begin(), sc.free.end(), [&sc](void *block) {
+		return FindSlab(sc, block).used == 0;
+	});
+	m_freeBytes -= (sc.free.end() - freeEnd) * sc.blockSize;
+	sc.free.erase(freeEnd, sc.free.end());
+
+	auto it = sc.slabs.begin();
+	while (it != sc.slabs.end()) {
+		if (it->used == 0) {
+			delete[] it->memory;
+			it = sc.slabs.erase(it);
+		} else
+			++it;
+	}
+}
+
+void GeoPatchBufferPool::Trim()
+{
+	SDL_LockMutex(m_lock);
+	for (SizeClass &sc : m_classes)
+		TrimClass(sc);
+	UpdateStats();
+	SDL_UnlockMutex(m_lock);
+}
+
+void *GeoPatchBufferPool::Allocate(size_t bytes)
+{
+	SDL_LockMutex(m_lock);
+	SizeClass &sc = FindClass(bytes);
+	sc.wanted = true;
+	if (sc.free.empty())
+		AddSlab(sc);
+
+	void *block = sc.free.back();
+	sc.free.pop_back();
+	FindSlab(sc, block).used++;
+	sc.used++;
+
+	m_freeBytes -= sc.blockSize;
+	m_usedBytes += sc.blockSize;
+	m_highWaterBytes = std::max(m_highWaterBytes, m_usedBytes);
+	UpdateStats();
+	SDL_UnlockMutex(m_lock);
+	return block;
+}
+
+void GeoPatchBufferPool::Release(void *block, size_t bytes)
+{
+	SDL_LockMutex(m_lock);
+	SizeClass &sc = FindClass(bytes);
+	assert(sc.used > 0);
+	FindSlab(sc, block).used--;
+	sc.used--;
+	sc.free.push_back(block);
+
+	m_usedBytes -= sc.blockSize;
+	m_freeBytes += sc.blockSize;
+
+	// the last block of a size that isn't asked for any more
+	if (!sc.wanted && sc.used == 0) {
+		TrimClass(sc);
+		m_classes.erase(m_classes.begin() + (&sc - m_classes.data()));
+	}
+	UpdateStats();
+	SDL_UnlockMutex(m_lock);
+}
+
+void GeoPatchBufferPool::UpdateStats()
+{
+	size_t usedBlocks = 0, freeBlocks = 0, slabs = 0;
+	for (const SizeClass &sc : m_classes) {
+		usedBlocks += sc.used;
+		freeBlocks += sc.free.size();
+		slabs += sc.slabs.size();
+	}
+	m_stats.CounterSet(m_statBlocksUsed, uint32_t(usedBlocks));
+	m_stats.CounterSet(m_statBlocksFree, uint32_t(freeBlocks));
+	m_stats.CounterSet(m_statUsedKB, uint32_t(m_usedBytes / 1024));
+	m_stats.CounterSet(m_statFreeKB, uint32_t(m_freeBytes / 1024));
+	m_stats.CounterSet(m_statHighWaterKB, uint32_t(m_highWaterBytes / 1024));
+	m_stats.CounterSet(m_statSlabs, uint32_t(slabs));
+}
@@ -0,0 +1,149 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHBUFFERPOOL_H
+#define _GEOPATCHBUFFERPOOL_H
+
+#include "PerfStats.h"
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+struct SDL_mutex;
+
+// Hands out the height, normal and colour arrays of GeoPatches and the
+// scratch space their jobs generate them in. Every patch with the same edge
+// length wants arrays of the same few sizes, so instead of each being new[]ed
+// and delete[]d the pool carves blocks of each size out of large slabs and
+// keeps the blocks it gets back for the next patch.
+//
+// Thread safe; blocks are taken on the main thread and by the patch jobs, and
+// given back on either.
+class GeoPatchBufferPool {
+public:
+	GeoPatchBufferPool();
+	~GeoPatchBufferPool();
+
+	// the patch edge length blocks are being asked for. when it changes the
+	// sizes asked for so far are no longer wanted, and their slabs are let go
+	// of as soon as all their blocks are back
+	void SetEdgeLen(int edgeLen);
+
+	void *Allocate(size_t bytes);
+	void Release(void *block, size_t bytes);
+
+	// let go of slabs that nothing is using
+	void Trim();
+
+	// blocks and KB in use, free and allocated at most (since the pool was
+	// created), and how often a new slab was needed
+	Perf::Stats &GetStats() { return m_stats; }
+
+private:
+	struct Slab {
+		char *memory;
+		size_t used; // blocks given out
+	};
+
+	struct SizeClass {
+		size_t blockSize;
+		size_t blocksPerSlab;
+		bool wanted; // asked for since the edge length last changed
+		std::vector<Slab> slabs; // by address
+		std::vector<void *> free;
+		size_t used;
+	};
+
+	SizeClass &FindClass(size_t bytes);
+	static Slab &FindSlab(SizeClass &sc, void *block);
+	void AddSlab(SizeClass &sc);
+	void TrimClass(SizeClass &sc);
+	void UpdateStats();
+
+	std::vector<SizeClass> m_classes;
+	int m_edgeLen;
+	size_t m_usedBytes, m_freeBytes, m_highWaterBytes;
+	SDL_mutex *m_lock;
+
+	Perf::Stats m_stats;
+	Perf::Stats::CounterRef m_statBlocksUsed;
+	Perf::Stats::CounterRef m_statBlocksFree;
+	Perf::Stats::CounterRef m_statUsedKB;
+	Perf::Stats::CounterRef m_statFreeKB;
+	Perf::Stats::CounterRef m_statHighWaterKB;
+	Perf::Stats::CounterRef m_statSlabs;
+	Perf::Stats::CounterRef m_statNewSlabs;
+};
+
+// An array of T from a GeoPatchBufferPool, given back to it when the handle
+// is destroyed. Moveable, not copyable, like the unique_ptr<T[]> it replaces.
+template <typename T>
+class GeoPatchBuffer {
+	static_assert(std::is_trivially_destructible<T>::value, "pooled arrays are never destructed");
+
+public:
+	GeoPatchBuffer() :
+		m_pool(nullptr),
+		m_data(nullptr),
+		m_count(0) {}
+	GeoPatchBuffer(GeoPatchBufferPool &pool, size_t count) :
+		m_pool(&pool),
+		m_data(static_cast<T *>(pool.Allocate(count * sizeof(T)))),
+		m_count(count)
+	{
+		for (size_t i = 0; i < count; i++)
+			new (&m_data[i]) T;
+	}
+	GeoPatchBuffer(GeoPatchBuffer &&other) :
+		m_pool(other.m_pool),
+		m_data(other.m_data),
+		m_count(other.m_count)
+	{
+		other.m_pool = nullptr;
+		other.m_data = nullptr;
+		other.m_count = 0;
+	}
+	GeoPatchBuffer &operator=(GeoPatchBuffer &&other)
+	{
+		if (this != &other) {
+			reset();
+			m_pool = other.m_pool;
+			m_data = other.m_data;
+			m_count = other.m_count;
+			other.m_pool = nullptr;
+			other.m_data = nullptr;
+			other.m_count = 0;
+		}
+		return *this;
+	}
+	GeoPatchBuffer(const GeoPatchBuffer &) = delete;
+	GeoPatchBuffer &operator=(const GeoPatchBuffer &) = delete;
+	~GeoPatchBuffer() { reset(); }
+
+	void reset()
+	{
+		if (m_data)
+			m_pool->Release(m_data, m_count * sizeof(T));
+		m_pool = nullptr;
+		m_data = nullptr;
+		m_count = 0;
+	}
+
+	T *get() const { return m_data; }
+	size_t size() const { return m_count; }
+	explicit operator bool() const { return m_data != nullptr; }
+	T &operator[](size_t i) const
+	{
+		assert(i < m_count);
+		return m_data[i];
+	}
+
+private:
+	GeoPatchBufferPool *m_pool;
+	T *m_data;
+	size_t m_count;
+};
+
+#endif /* _GEOPATCHBUFFERPOOL_H */
@@ -19,6 +19,7 @@ int GeoPatchContext::m_numTris = 0;
 double GeoPatchContext::m_frac = 0.0;
 RefCountedPtr<Graphics::IndexBuffer> GeoPatchContext::m_indices;
 int GeoPatchContext::m_prevEdgeLen = 0;
+GeoPatchBufferPool GeoPatchContext::m_bufferPool;
 
 //static
 void GeoPatchContext::GenerateIndices()
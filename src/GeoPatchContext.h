@@ -6,6 +6,7 @@
 
 #include <SDL_stdinc.h>
 
+#include "GeoPatchBufferPool.h"
 #include "vector3.h"
 #include "graphics/VertexBuffer.h"
 
@@ -26,6 +27,7 @@ public:
 	GeoPatchContext(const int _edgeLen)
 	{
 		m_edgeLen = _edgeLen + 2; // +2 for the skirt
+		m_bufferPool.SetEdgeLen(_edgeLen);
 		Init();
 	}
 
@@ -44,6 +46,9 @@ public:
 	static inline int GetNumTris() { return m_numTris; }
 	static inline double GetFrac() { return m_frac; }
 
+	// for the patches' heights, normals and colours, and their jobs' scratch space
+	static inline GeoPatchBufferPool &GetBufferPool() { return m_bufferPool; }
+
 private:
 	static int m_edgeLen;
 	static int m_numTris;
@@ -60,6 +65,8 @@ private:
 	static RefCountedPtr<Graphics::IndexBuffer> m_indices;
 	static int m_prevEdgeLen;
 
+	static GeoPatchBufferPool m_bufferPool;
+
 	static void GenerateIndices();
 
 };
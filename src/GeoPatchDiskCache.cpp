@@ -0,0 +1,626 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GeoPatchDiskCache.h"
+
+#include "FileSystem.h"
+#include "GameConfig.h"
+#include "Pi.h"
+#include "core/LZ4Format.h"
+#include "jenkins/lookup3.h"
+#include "profiler/Profiler.h"
+#include "terrain/Terrain.h"
+#include "utils.h"
+#include <SDL_endian.h>
+#include <SDL_mutex.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+	const char DISK_CACHE_MAGIC[8] = { 'P', 'I', 'O', 'N', 'T', 'E', 'R', 'R' };
+	const Uint32 DISK_CACHE_FORMAT_VERSION = 1;
+	const size_t DISK_CACHE_HEADER_SIZE = sizeof(DISK_CACHE_MAGIC) + 2 * sizeof(Uint32);
+	// each record is Uint32 payloadSize, Uint32 checksum, payload. the
+	// payload is the key followed by the patches, lz4 compressed. a record
+	// with no payload just marks when the planet was last visited
+	const size_t DISK_CACHE_RECORD_HEADER_SIZE = 2 * sizeof(Uint32);
+	const size_t DISK_CACHE_KEY_SIZE = sizeof(Uint64) + 3 * sizeof(Uint16);
+	const std::string DISK_CACHE_DIR_NAME = "cache";
+	const std::string DISK_CACHE_TERRAIN_DIR_NAME = FileSystem::JoinPathBelow(DISK_CACHE_DIR_NAME, "terrain");
+	const std::string DISK_CACHE_EXTENSION = ".bin";
+
+	// bytes of each vertex: height, normal and colour
+	const size_t VERTEX_BYTES = sizeof(double) + 3 * sizeof(float) + 3 * sizeof(Uint8);
+
+	struct DiskCacheStats {
+		DiskCacheStats() :
+			hits(stats.GetOrCreateCounter("Disk cache hits", false)),
+			misses(stats.GetOrCreateCounter("Disk cache misses", false)),
+			failed(stats.GetOrCreateCounter("Disk cache unreadable records", false)),
+			written(stats.GetOrCreateCounter("Disk cache records written", false)),
+			writtenKB(stats.GetOrCreateCounter("Disk cache KB written", false)),
+			compacted(stats.GetOrCreateCounter("Disk cache files compacted", false)),
+			evicted(stats.GetOrCreateCounter("Disk cache planets evicted", false))
+		{
+			stats.EnableReset(false);
+		}
+
+		Perf::Stats stats;
+		Perf::Stats::CounterRef hits, misses, failed, written, writtenKB, compacted, evicted;
+	};
+
+	DiskCacheStats &Stats()
+	{
+		static DiskCacheStats s;
+		return s;
+	}
+
+	// every file that is open, so that a planet whose old GeoSphere still
+	// has jobs running doesn't get a second writer
+	std::mutex s_openLock;
+	std::map<std::string, GeoPatchDiskCache *> s_open;
+
+	void AppendLE16(std::string &out, Uint16 v)
+	{
+		v = SDL_SwapLE16(v);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+
+	void AppendLE32(std::string &out, Uint32 v)
+	{
+		v = SDL_SwapLE32(v);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+
+	void AppendLE64(std::string &out, Uint64 v)
+	{
+		v = SDL_SwapLE64(v);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+
+	Uint16 GetLE16(const char *p)
+	{
+		Uint16 v;
+		memcpy(&v, p, sizeof(v));
+		return SDL_SwapLE16(v);
+	}
+
+	Uint32 GetLE32(const char *p)
+	{
+		Uint32 v;
+		memcpy(&v, p, sizeof(v));
+		return SDL_SwapLE32(v);
+	}
+
+	Uint64 GetLE64(const char *p)
+	{
+		Uint64 v;
+		memcpy(&v, p, sizeof(v));
+		return SDL_SwapLE64(v);
+	}
+
+	void AppendKey(std::string &out, const GeoPatchDiskCache::Key &key)
+	{
+		AppendLE64(out, key.patchID);
+		AppendLE16(out, key.depth);
+		AppendLE16(out, key.edgeLen);
+		AppendLE16(out, key.numPatches);
+	}
+
+	// neighbouring heights (and normals) differ only in their low bytes, so
+	// the bytes are stored a plane at a time (all the first bytes, then all
+	// the second bytes and so on), which compresses much better than the
+	// values do as they are
+	void AppendPlanes(std::string &out, const void *data, size_t count, size_t size)
+	{
+		const size_t start = out.size();
+		out.resize(start + count * size);
+		const char *in = static_cast<const char *>(data);
+		for (size_t b = 0; b < size; b++) {
+			char *plane = &out[start + b * count];
+			for (size_t i = 0; i < count; i++)
+				plane[i] = in[i * size + b];
+		}
+	}
+
+	const char *ReadPlanes(const char *in, void *data, size_t count, size_t size)
+	{
+		char *out = static_cast<char *>(data);
+		for (size_t b = 0; b < size; b++) {
+			const char *plane = in + b * count;
+			for (size_t i = 0; i < count; i++)
+				out[i * size + b] = plane[i];
+		}
+		return in + count * size;
+	}
+
+	long FileSize(FILE *f)
+	{
+		if (fseek(f, 0, SEEK_END) != 0)
+			return -1;
+		return ftell(f);
+	}
+} // namespace
+
+GeoPatchDiskCache::Key::Key(const GeoPatchID &id, int depth_, int edgeLen_, int numPatches_) :
+	patchID(id.GetValue()),
+	depth(Uint16(depth_)),
+	edgeLen(Uint16(edgeLen_)),
+	numPatches(Uint16(numPatches_))
+{
+}
+
+bool GeoPatchDiskCache::Key::operator<(const Key &o) const
+{
+	if (patchID != o.patchID) return patchID < o.patchID;
+	if (depth != o.depth) return depth < o.depth;
+	if (edgeLen != o.edgeLen) return edgeLen < o.edgeLen;
+	return numPatches < o.numPatches;
+}
+
+// static
+Perf::Stats &GeoPatchDiskCache::GetStats()
+{
+	return Stats().stats;
+}
+
+// static
+GeoPatchDiskCache *GeoPatchDiskCache::Open(const SystemPath &path, const Terrain *terrain)
+{
+	PROFILE_SCOPED()
+	const int budgetMB = Pi::config->Int("TerrainDiskCacheMB");
+	if (budgetMB <= 0)
+		return nullptr;
+	const size_t budget = size_t(budgetMB) * 1024 * 1024;
+
+	char name[128];
+	snprintf(name, sizeof(name), "%d_%d_%d_%u_%u%s", path.sectorX, path.sectorY, path.sectorZ,
+		path.systemIndex, path.bodyIndex, DISK_CACHE_EXTENSION.c_str());
+	const std::string fileName = FileSystem::JoinPathBelow(DISK_CACHE_TERRAIN_DIR_NAME, name);
+
+	std::string id;
+	AppendLE32(id, terrain->GetFingerprint());
+	AppendLE32(id, DISK_CACHE_FORMAT_VERSION);
+	AppendLE32(id, SDL_BYTEORDER); // the patches are stored as they are in memory
+	const Uint32 fingerprint = lookup3_hashlittle(id.data(), id.size(), 0);
+
+	std::lock_guard<std::mutex> lock(s_openLock);
+	auto it = s_open.find(fileName);
+	if (it != s_open.end()) {
+		// if the terrain has changed (the detail level has) while jobs for
+		// the old one are still running it isn't cached until the next visit
+		return it->second->m_fingerprint == fingerprint ? it->second : nullptr;
+	}
+
+	// this planet may use up to half, the others share what's left
+	const size_t maxFileSize = budget / 2;
+	GeoPatchDiskCache *cache = new GeoPatchDiskCache(fileName, fingerprint, maxFileSize, budget - maxFileSize);
+	s_open[fileName] = cache;
+	return cache;
+}
+
+GeoPatchDiskCache::GeoPatchDiskCache(const std::string &fileName, Uint32 fingerprint, size_t maxFileSize, size_t othersBudget) :
+	m_fileName(fileName),
+	m_fingerprint(fingerprint),
+	m_maxFileSize(maxFileSize),
+	m_othersBudget(othersBudget),
+	m_lock(SDL_CreateMutex()),
+	m_loaded(false),
+	m_compacting(false),
+	m_reader(nullptr),
+	m_fileSize(0),
+	m_useCount(0)
+{
+}
+
+GeoPatchDiskCache::~GeoPatchDiskCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_openLock);
+		auto it = s_open.find(m_fileName);
+		if (it != s_open.end() && it->second == this)
+			s_open.erase(it);
+	}
+	if (m_reader)
+		fclose(m_reader);
+	SDL_DestroyMutex(m_lock);
+}
+
+// deletes the files of the planets visited longest ago until the rest fit
+// in budget. a visit appends to the file, so its modification time is when
+// the planet was last visited
+// static
+void GeoPatchDiskCache::EvictPlanets(const std::string &keep, size_t budget)
+{
+	std::vector<FileSystem::FileInfo> files;
+	if (!FileSystem::userFiles.ReadDirectory(DISK_CACHE_TERRAIN_DIR_NAME, files))
+		return;
+
+	// nor the files of the other planets still in use
+	std::vector<std::string> open;
+	{
+		std::lock_guard<std::mutex> lock(s_openLock);
+		for (const auto &it : s_open)
+			open.push_back(it.first);
+	}
+
+	struct Planet {
+		Time::DateTime modified;
+		std::string path;
+		size_t size;
+	};
+	std::vector<Planet> planets;
+	size_t total = 0;
+	for (const FileSystem::FileInfo &info : files) {
+		const std::string &path = info.GetPath();
+		if (!info.IsFile() || path == keep || !ends_with_ci(path, DISK_CACHE_EXTENSION) ||
+			std::find(open.begin(), open.end(), path) != open.end())
+			continue;
+		FILE *f = FileSystem::userFiles.OpenReadStream(path);
+		if (!f)
+			continue;
+		const long size = FileSize(f);
+		fclose(f);
+		if (size < 0)
+			continue;
+		planets.push_back({ info.GetModificationTime(), path, size_t(size) });
+		total += size_t(size);
+	}
+
+	std::sort(planets.begin(), planets.end(), [](const Planet &a, const Planet &b) { return a.modified < b.modified; });
+	for (const Planet &planet : planets) {
+		if (total <= budget)
+			break;
+		if (FileSystem::userFiles.RemoveFile(planet.path)) {
+			total -= planet.size;
+			Stats().stats.CounterAdd(Stats().evicted);
+		}
+	}
+}
+
+// the first job to use the cache reads the file, while the others wait for
+// it. m_lock must be held
+void GeoPatchDiskCache::EnsureLoaded()
+{
+	if (m_loaded)
+		return;
+	m_loaded = true;
+	EvictPlanets(m_fileName, m_othersBudget);
+	Load();
+}
+
+// reads the index of the records in the file, or starts the file over if
+// it's stale
+void GeoPatchDiskCache::Load()
+{
+	PROFILE_SCOPED()
+	m_reader = FileSystem::userFiles.OpenReadStream(m_fileName);
+	if (!m_reader) {
+		StartFile();
+		return;
+	}
+
+	const long size = FileSize(m_reader);
+	char header[DISK_CACHE_HEADER_SIZE];
+	if (size < long(DISK_CACHE_HEADER_SIZE) || fseek(m_reader, 0, SEEK_SET) != 0 ||
+		fread(header, sizeof(header), 1, m_reader) != 1 ||
+		memcmp(header, DISK_CACHE_MAGIC, sizeof(DISK_CACHE_MAGIC)) != 0 ||
+		GetLE32(header + sizeof(DISK_CACHE_MAGIC)) != DISK_CACHE_FORMAT_VERSION ||
+		GetLE32(header + sizeof(DISK_CACHE_MAGIC) + sizeof(Uint32)) != m_fingerprint) {
+		// another format, or another terrain: start over
+		StartFile();
+		return;
+	}
+
+	// only the record headers and keys are read, the patches are left until
+	// they are wanted (and their checksums checked then)
+	Uint64 pos = DISK_CACHE_HEADER_SIZE;
+	char buf[DISK_CACHE_RECORD_HEADER_SIZE + DISK_CACHE_KEY_SIZE];
+	while (pos + DISK_CACHE_RECORD_HEADER_SIZE <= Uint64(size)) {
+		if (fseek(m_reader, long(pos), SEEK_SET) != 0 || fread(buf, DISK_CACHE_RECORD_HEADER_SIZE, 1, m_reader) != 1)
+			break;
+		const Uint32 payloadSize = GetLE32(buf);
+		if (payloadSize == 0) {
+			pos += DISK_CACHE_RECORD_HEADER_SIZE;
+			continue;
+		}
+		if (payloadSize < DISK_CACHE_KEY_SIZE || pos + DISK_CACHE_RECORD_HEADER_SIZE + payloadSize > Uint64(size) ||
+			fread(buf + DISK_CACHE_RECORD_HEADER_SIZE, DISK_CACHE_KEY_SIZE, 1, m_reader) != 1)
+			break;
+
+		const char *k = buf + DISK_CACHE_RECORD_HEADER_SIZE;
+		Key key(GeoPatchID(GetLE64(k)), GetLE16(k + 8), GetLE16(k + 10), GetLE16(k + 12));
+		Entry entry;
+		entry.offset = pos;
+		entry.size = Uint32(DISK_CACHE_RECORD_HEADER_SIZE + payloadSize);
+		entry.lastUse = 0;
+		m_index[key] = entry;
+		pos += entry.size;
+	}
+	m_fileSize = pos;
+
+	// a write was cut short: drop the damaged tail
+	if (pos != Uint64(size)) {
+		EntryList entries(m_index.begin(), m_index.end());
+		std::map<Key, Entry> index;
+		Uint64 compactedSize;
+		if (WriteCompacted(entries, m_maxFileSize, index, compactedSize))
+			ReplaceWithCompacted(index, compactedSize);
+	}
+
+	// mark the visit
+	FILE *f = FileSystem::userFiles.OpenWriteStream(m_fileName, FileSystem::FileSourceFS::WRITE_APPEND);
+	if (f) {
+		const char touch[DISK_CACHE_RECORD_HEADER_SIZE] = {};
+		if (fwrite(touch, sizeof(touch), 1, f) == 1)
+			m_fileSize += sizeof(touch);
+		fclose(f);
+	}
+}
+
+// an empty file with just the header
+void GeoPatchDiskCache::StartFile()
+{
+	if (m_reader) {
+		fclose(m_reader);
+		m_reader = nullptr;
+	}
+	m_index.clear();
+	m_fileSize = 0;
+
+	if (!FileSystem::userFiles.MakeDirectory(DISK_CACHE_DIR_NAME) || !FileSystem::userFiles.MakeDirectory(DISK_CACHE_TERRAIN_DIR_NAME))
+		return;
+	FILE *f = FileSystem::userFiles.OpenWriteStream(m_fileName);
+	if (!f)
+		return;
+	std::string header(DISK_CACHE_MAGIC, sizeof(DISK_CACHE_MAGIC));
+	AppendLE32(header, DISK_CACHE_FORMAT_VERSION);
+	AppendLE32(header, m_fingerprint);
+	const bool written = fwrite(header.data(), header.size(), 1, f) == 1;
+	fclose(f);
+
+	// if it can't be written (or read) the cache just stays empty
+	if (written) {
+		m_reader = FileSystem::userFiles.OpenReadStream(m_fileName);
+		m_fileSize = header.size();
+	}
+}
+
+// static
+bool GeoPatchDiskCache::ReadRecord(FILE *reader, const Entry &entry, std::string &record)
+{
+	record.resize(entry.size);
+	return reader && fseek(reader, long(entry.offset), SEEK_SET) == 0 &&
+		fread(&record[0], entry.size, 1, reader) == 1;
+}
+
+// cuts the file down to three quarters of its size, from a job that has
+// just written to it. the records are copied without holding m_lock, so the
+// other jobs only wait for the new file to replace the old one
+void GeoPatchDiskCache::Compact(EntryList &entries)
+{
+	PROFILE_SCOPED()
+	std::map<Key, Entry> index;
+	Uint64 size;
+	const bool written = WriteCompacted(entries, m_maxFileSize * 3 / 4, index, size);
+
+	SDL_LockMutex(m_lock);
+	if (written) {
+		// records found to be unreadable meanwhile stay dropped, and the
+		// others keep when they were last used
+		for (auto it = index.begin(); it != index.end();) {
+			auto cur = m_index.find(it->first);
+			if (cur == m_index.end()) {
+				it = index.erase(it);
+			} else {
+				it->second.lastUse = cur->second.lastUse;
+				++it;
+			}
+		}
+		ReplaceWithCompacted(index, size);
+	}
+	m_compacting = false;
+	SDL_UnlockMutex(m_lock);
+}
+
+// writes the records used most recently, up to targetSize, to a temp file
+// and gives their index in it. the file is read with a handle of its own
+// and nothing is written to it meanwhile, so this needs no lock
+bool GeoPatchDiskCache::WriteCompacted(EntryList &entries, size_t targetSize, std::map<Key, Entry> &index, Uint64 &size) const
+{
+	PROFILE_SCOPED()
+	std::sort(entries.begin(), entries.end(), [](const std::pair<Key, Entry> &a, const std::pair<Key, Entry> &b) {
+		// the most recently used first, then (of those not used this run)
+		// the newest
+		if (a.second.lastUse != b.second.lastUse) return a.second.lastUse > b.second.lastUse;
+		return a.second.offset > b.second.offset;
+	});
+
+	FILE *reader = FileSystem::userFiles.OpenReadStream(m_fileName);
+	if (!reader)
+		return false;
+	const std::string tempName = m_fileName + ".tmp";
+	FILE *f = FileSystem::userFiles.OpenWriteStream(tempName);
+	if (!f) {
+		fclose(reader);
+		return false;
+	}
+
+	std::string header(DISK_CACHE_MAGIC, sizeof(DISK_CACHE_MAGIC));
+	AppendLE32(header, DISK_CACHE_FORMAT_VERSION);
+	AppendLE32(header, m_fingerprint);
+	bool ok = fwrite(header.data(), header.size(), 1, f) == 1;
+
+	index.clear();
+	size = header.size();
+	std::string record;
+	for (const std::pair<Key, Entry> &e : entries) {
+		if (!ok || size + e.second.size > targetSize)
+			break;
+		if (!ReadRecord(reader, e.second, record))
+			continue;
+		ok = fwrite(record.data(), record.size(), 1, f) == 1;
+		Entry entry = e.second;
+		entry.offset = size;
+		index[e.first] = entry;
+		size += entry.size;
+	}
+	fclose(f);
+	fclose(reader);
+
+	if (!ok)
+		FileSystem::userFiles.RemoveFile(tempName);
+	return ok;
+}
+
+// m_lock must be held
+void GeoPatchDiskCache::ReplaceWithCompacted(std::map<Key, Entry> &index, Uint64 size)
+{
+	const std::string tempName = m_fileName + ".tmp";
+	if (m_reader)
+		fclose(m_reader);
+	if (FileSystem::userFiles.RenameFile(tempName, m_fileName)) {
+		m_index.swap(index);
+		m_fileSize = size;
+		m_reader = FileSystem::userFiles.OpenReadStream(m_fileName);
+		Stats().stats.CounterAdd(Stats().compacted);
+	} else {
+		FileSystem::userFiles.RemoveFile(tempName);
+		m_reader = FileSystem::userFiles.OpenReadStream(m_fileName);
+	}
+}
+
+bool GeoPatchDiskCache::Read(const Key &key, GeoPatchBuffer<double> *heights, GeoPatchBuffer<vector3f> *normals, GeoPatchBuffer<Color3ub> *colors)
+{
+	PROFILE_SCOPED()
+	std::string record;
+	Entry entry;
+	SDL_LockMutex(m_lock);
+	EnsureLoaded();
+	auto it = m_index.find(key);
+	bool found = it != m_index.end();
+	if (found) {
+		it->second.lastUse = ++m_useCount;
+		entry = it->second;
+		found = ReadRecord(m_reader, entry, record);
+	}
+	SDL_UnlockMutex(m_lock);
+	if (!found) {
+		Stats().stats.CounterAdd(Stats().misses);
+		return false;
+	}
+
+	// check it's whole and what was asked for, and unpack it outside the lock
+	const size_t numVerts = size_t(key.edgeLen) * key.edgeLen;
+	const char *payload = record.data() + DISK_CACHE_RECORD_HEADER_SIZE;
+	const size_t payloadSize = record.size() - DISK_CACHE_RECORD_HEADER_SIZE;
+	bool ok = GetLE32(record.data()) == payloadSize &&
+		GetLE32(record.data() + sizeof(Uint32)) == lookup3_hashlittle(payload, payloadSize, 0);
+	if (ok) {
+		std::string k;
+		AppendKey(k, key);
+		ok = memcmp(payload, k.data(), k.size()) == 0;
+	}
+	std::string raw;
+	if (ok) {
+		try {
+			raw = lz4::DecompressLZ4(lz4::string_view(payload + DISK_CACHE_KEY_SIZE, payloadSize - DISK_CACHE_KEY_SIZE));
+			ok = raw.size() == key.numPatches * numVerts * VERTEX_BYTES;
+		} catch (lz4::DecompressionFailedException &) {
+			ok = false;
+		}
+	}
+
+	if (!ok) {
+		SDL_LockMutex(m_lock);
+		it = m_index.find(key);
+		if (it != m_index.end() && it->second.offset == entry.offset)
+			m_index.erase(it);
+		SDL_UnlockMutex(m_lock);
+		Stats().stats.CounterAdd(Stats().failed);
+		return false;
+	}
+
+	const char *in = raw.data();
+	for (int i = 0; i < key.numPatches; i++) {
+		assert(heights[i].size() == numVerts && normals[i].size() == numVerts && colors[i].size() == numVerts);
+		in = ReadPlanes(in, heights[i].get(), numVerts, sizeof(double));
+		in = ReadPlanes(in, normals[i].get(), numVerts * 3, sizeof(float));
+		in = ReadPlanes(in, colors[i].get(), numVerts * 3, sizeof(Uint8));
+	}
+	Stats().stats.CounterAdd(Stats().hits);
+	return true;
+}
+
+void GeoPatchDiskCache::Write(const Key &key, const GeoPatchBuffer<double> *heights, const GeoPatchBuffer<vector3f> *normals, const GeoPatchBuffer<Color3ub> *colors)
+{
+	PROFILE_SCOPED()
+	static_assert(sizeof(vector3f) == 3 * sizeof(float) && sizeof(Color3ub) == 3 * sizeof(Uint8), "vertices are stored unpadded");
+
+	// pack and compress outside the lock
+	const size_t numVerts = size_t(key.edgeLen) * key.edgeLen;
+	std::string raw;
+	raw.reserve(key.numPatches * numVerts * VERTEX_BYTES);
+	for (int i = 0; i < key.numPatches; i++) {
+		assert(heights[i].size() == numVerts && normals[i].size() == numVerts && colors[i].size() == numVerts);
+		AppendPlanes(raw, heights[i].get(), numVerts, sizeof(double));
+		AppendPlanes(raw, normals[i].get(), numVerts * 3, sizeof(float));
+		AppendPlanes(raw, colors[i].get(), numVerts * 3, sizeof(Uint8));
+	}
+
+	std::string record;
+	AppendLE32(record, 0); // payload size and checksum, set below
+	AppendLE32(record, 0);
+	AppendKey(record, key);
+	try {
+		record += lz4::CompressLZ4(raw, 0);
+	} catch (lz4::CompressionFailedException &) {
+		return;
+	}
+	const size_t payloadSize = record.size() - DISK_CACHE_RECORD_HEADER_SIZE;
+	const Uint32 checksum = lookup3_hashlittle(record.data() + DISK_CACHE_RECORD_HEADER_SIZE, payloadSize, 0);
+	std::string sizes;
+	AppendLE32(sizes, Uint32(payloadSize));
+	AppendLE32(sizes, checksum);
+	record.replace(0, sizes.size(), sizes);
+
+	EntryList toCompact;
+	SDL_LockMutex(m_lock);
+	EnsureLoaded();
+	// another job may have got there first, and if the file can't be read
+	// there's no point writing to it. while it's being compacted the
+	// record is left out (and generated again next time)
+	if (m_reader && !m_compacting && m_index.find(key) == m_index.end()) {
+		FILE *f = FileSystem::userFiles.OpenWriteStream(m_fileName, FileSystem::FileSourceFS::WRITE_APPEND);
+		const bool written = f && fwrite(record.data(), record.size(), 1, f) == 1;
+		if (f)
+			fclose(f);
+		if (written) {
+			Entry entry;
+			entry.offset = m_fileSize;
+			entry.size = Uint32(record.size());
+			entry.lastUse = ++m_useCount;
+			m_index[key] = entry;
+			m_fileSize += record.size();
+			Stats().stats.CounterAdd(Stats().written);
+			Stats().stats.CounterAdd(Stats().writtenKB, Uint32(record.size() / 1024));
+			if (m_fileSize > m_maxFileSize) {
+				m_compacting = true;
+				toCompact.assign(m_index.begin(), m_index.end());
+			}
+		} else {
+			// the disk is full, say. what is there can still be read, but
+			// where the next record would start is anyone's guess. the next
+			// visit drops the damaged tail
+			fclose(m_reader);
+			m_reader = nullptr;
+			m_index.clear();
+		}
+	}
+	SDL_UnlockMutex(m_lock);
+
+	if (!toCompact.empty())
+		Compact(toCompact);
+}
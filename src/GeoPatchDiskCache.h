@@ -0,0 +1,96 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHDISKCACHE_H
+#define _GEOPATCHDISKCACHE_H
+
+#include "Color.h"
+#include "GeoPatchBufferPool.h"
+#include "GeoPatchID.h"
+#include "PerfStats.h"
+#include "RefCounted.h"
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+struct SDL_mutex;
+class Terrain;
+
+// Keeps the heights, normals and colours the patch jobs generate for a
+// planet in a file in the cache dir under the user dir, so that coming back
+// to the planet (in this run or a later one) reads them back rather than
+// generating them again.
+//
+// Each planet has its own file, which starts over whenever the terrain's
+// fingerprint changes. A file is kept to half of TerrainDiskCacheMB by
+// dropping the records that were used least recently, and when a planet is
+// opened the files of the planets visited least recently are deleted to
+// keep the whole cache within TerrainDiskCacheMB.
+//
+// Safe to use from the patch jobs' threads, though only opened (and let go
+// of) on the main thread. Opening doesn't touch the disk: the file is read
+// (and the other planets evicted) by the first job to use the cache, and
+// only the jobs ever wait on its lock.
+class GeoPatchDiskCache : public RefCounted {
+public:
+	// null if the cache is turned off
+	static GeoPatchDiskCache *Open(const SystemPath &path, const Terrain *terrain);
+	~GeoPatchDiskCache();
+
+	// the results of a job: a single patch, or the four kids of a split
+	struct Key {
+		Key(const GeoPatchID &id, int depth, int edgeLen, int numPatches);
+		uint64_t patchID;
+		Uint16 depth;
+		Uint16 edgeLen;
+		Uint16 numPatches;
+		bool operator<(const Key &o) const;
+	};
+
+	// fill (or keep) key.numPatches patches of edgeLen * edgeLen vertices.
+	// Read() returns false if they aren't in the file or couldn't be read
+	bool Read(const Key &key, GeoPatchBuffer<double> *heights, GeoPatchBuffer<vector3f> *normals, GeoPatchBuffer<Color3ub> *colors);
+	void Write(const Key &key, const GeoPatchBuffer<double> *heights, const GeoPatchBuffer<vector3f> *normals, const GeoPatchBuffer<Color3ub> *colors);
+
+	// hits, misses and so on, for every planet since the start
+	static Perf::Stats &GetStats();
+
+private:
+	GeoPatchDiskCache(const std::string &fileName, Uint32 fingerprint, size_t maxFileSize, size_t othersBudget);
+
+	struct Entry {
+		Uint64 offset; // of the record in the file
+		Uint32 size; // of the whole record
+		Uint32 lastUse;
+	};
+
+	typedef std::vector<std::pair<Key, Entry>> EntryList;
+
+	static void EvictPlanets(const std::string &keep, size_t budget);
+	void EnsureLoaded();
+	void Load();
+	void Compact(EntryList &entries);
+	bool WriteCompacted(EntryList &entries, size_t targetSize, std::map<Key, Entry> &index, Uint64 &size) const;
+	void ReplaceWithCompacted(std::map<Key, Entry> &index, Uint64 size);
+	void StartFile();
+	static bool ReadRecord(FILE *reader, const Entry &entry, std::string &record);
+
+	const std::string m_fileName;
+	const Uint32 m_fingerprint;
+	const size_t m_maxFileSize;
+	const size_t m_othersBudget; // for the other planets' files
+	SDL_mutex *m_lock;
+
+	// everything below is guarded by m_lock
+	bool m_loaded;
+	bool m_compacting; // nothing is written while it is
+	FILE *m_reader;
+	std::map<Key, Entry> m_index;
+	Uint64 m_fileSize;
+	Uint32 m_useCount;
+};
+
+#endif /* _GEOPATCHDISKCACHE_H */
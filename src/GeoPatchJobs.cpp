@@ -25,39 +25,41 @@ inline vector3d GetSpherePoint(const vector3d &v0, const vector3d &v1, const vec
 // ********************************************************************************
 
 // Generates full-detail vertices, and also non-edge normals and colors
-void SSingleSplitRequest::GenerateMesh() const
+void SSingleSplitRequest::GenerateMesh()
 {
 	const int borderedEdgeLen = edgeLen + (BORDER_SIZE * 2);
-#ifndef NDEBUG
 	const int numBorderedVerts = borderedEdgeLen * borderedEdgeLen;
-#endif
+	borderHeights = GeoPatchBuffer<double>(GeoPatchContext::GetBufferPool(), numBorderedVerts);
+	borderVertexs = GeoPatchBuffer<vector3d>(GeoPatchContext::GetBufferPool(), numBorderedVerts);
 
-	// generate heights plus a 1 unit border
-	double *bhts = borderHeights.get();
+	// generate heights plus a 1 unit border, all at once
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
 		const double yfrac = double(y) * fracStep;
 		for (int x = -BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			const double xfrac = double(x) * fracStep;
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
-			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
 		}
 	}
-	assert(bhts == &borderHeights.get()[numBorderedVerts]);
+	vrts = borderVertexs.get();
+	pTerrain->GetHeights(vrts, borderHeights.get(), numBorderedVerts);
+	for (int i = 0; i < numBorderedVerts; i++) {
+		assert(borderHeights[i] >= 0.0f && borderHeights[i] <= 1.0f);
+		vrts[i] = vrts[i] * (borderHeights[i] + 1.0);
+	}
 
 	// Generate normals & colors for non-edge vertices since they never change
-	Color3ub *col = colors;
-	vector3f *nrm = normals;
-	double *hts = heights;
-	vrts = borderVertexs.get();
+	// (the colors a row at a time)
+	std::vector<vector3d> rowPoints(edgeLen), rowNormals(edgeLen), rowColors(edgeLen);
+	Color3ub *col = colors.get();
+	vector3f *nrm = normals.get();
+	double *hts = heights.get();
 	for (int y = BORDER_SIZE; y < borderedEdgeLen - BORDER_SIZE; y++) {
+		const double *rowHeights = hts;
 		for (int x = BORDER_SIZE; x < borderedEdgeLen - BORDER_SIZE; x++) {
 			// height
 			const double height = borderHeights[x + y * borderedEdgeLen];
-			assert(hts != &heights[edgeLen * edgeLen]);
+			assert(hts != heights.get() + edgeLen * edgeLen);
 			*(hts++) = height;
 
 			// normal
@@ -66,19 +68,23 @@ void SSingleSplitRequest::GenerateMesh() const
 			const vector3d &y1 = vrts[x + (y - 1) * borderedEdgeLen];
 			const vector3d &y2 = vrts[x + (y + 1) * borderedEdgeLen];
 			const vector3d n = ((x2 - x1).Cross(y2 - y1)).Normalized();
-			assert(nrm != &normals[edgeLen * edgeLen]);
+			assert(nrm != normals.get() + edgeLen * edgeLen);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
-			assert(col != &colors[edgeLen * edgeLen]);
-			++col;
+			rowNormals[x - BORDER_SIZE] = n;
+			rowPoints[x - BORDER_SIZE] = GetSpherePoint(v0, v1, v2, v3, (x - BORDER_SIZE) * fracStep, (y - BORDER_SIZE) * fracStep);
+		}
+
+		// color
+		pTerrain->GetColors(rowPoints.data(), rowHeights, rowNormals.data(), rowColors.data(), edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
+			assert(col != colors.get() + edgeLen * edgeLen);
+			setColour(*(col++), rowColors[x]);
 		}
 	}
-	assert(hts == &heights[edgeLen * edgeLen]);
-	assert(nrm == &normals[edgeLen * edgeLen]);
-	assert(col == &colors[edgeLen * edgeLen]);
+	assert(hts == heights.get() + edgeLen * edgeLen);
+	assert(nrm == normals.get() + edgeLen * edgeLen);
+	assert(col == colors.get() + edgeLen * edgeLen);
 }
 
 // ********************************************************************************
@@ -97,12 +103,18 @@ void SinglePatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 
 	const SSingleSplitRequest &srd = *mData;
 
-	// fill out the data
-	mData->GenerateMesh();
+	// read back what was generated on an earlier visit, or generate it (and
+	// keep it for the next one)
+	const GeoPatchDiskCache::Key key = srd.DiskCacheKey(1);
+	if (!srd.diskCache || !srd.diskCache->Read(key, &mData->heights, &mData->normals, &mData->colors)) {
+		mData->GenerateMesh();
+		if (srd.diskCache)
+			srd.diskCache->Write(key, &srd.heights, &srd.normals, &srd.colors);
+	}
 
 	// add this patches data
 	SSingleSplitResult *sr = new SSingleSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
-	sr->addResult(srd.heights, srd.normals, srd.colors,
+	sr->addResult(std::move(mData->heights), std::move(mData->normals), std::move(mData->colors),
 		srd.v0, srd.v1, srd.v2, srd.v3,
 		srd.patchID.NextPatchID(srd.depth + 1, 0));
 	// store the result
@@ -134,8 +146,6 @@ void QuadPatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 
 	const SQuadSplitRequest &srd = *mData;
 
-	mData->GenerateBorderedData();
-
 	const vector3d v01 = (srd.v0 + srd.v1).Normalized();
 	const vector3d v12 = (srd.v1 + srd.v2).Normalized();
 	const vector3d v23 = (srd.v2 + srd.v3).Normalized();
@@ -156,16 +166,26 @@ void QuadPatchJob::OnRun() // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 		{ 0, srd.edgeLen - 1 }
 	};
 
+	// read back what was generated on an earlier visit, or generate it (and
+	// keep it for the next one)
+	const GeoPatchDiskCache::Key key = srd.DiskCacheKey(4);
+	if (!srd.diskCache || !srd.diskCache->Read(key, mData->heights, mData->normals, mData->colors)) {
+		mData->GenerateBorderedData();
+		for (int i = 0; i < 4; i++) {
+			// fill out the data
+			mData->GenerateSubPatchData(i,
+				vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
+				srd.edgeLen, offxy[i][0], offxy[i][1],
+				borderedEdgeLen);
+		}
+		if (srd.diskCache)
+			srd.diskCache->Write(key, srd.heights, srd.normals, srd.colors);
+	}
+
 	SQuadSplitResult *sr = new SQuadSplitResult(srd.patchID.GetPatchFaceIdx(), srd.depth);
 	for (int i = 0; i < 4; i++) {
-		// fill out the data
-		mData->GenerateSubPatchData(i,
-			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
-			srd.edgeLen, offxy[i][0], offxy[i][1],
-			borderedEdgeLen);
-
 		// add this patches data
-		sr->addResult(i, srd.heights[i], srd.normals[i], srd.colors[i],
+		sr->addResult(i, std::move(mData->heights[i]), std::move(mData->normals[i]), std::move(mData->colors[i]),
 			vecs[i][0], vecs[i][1], vecs[i][2], vecs[i][3],
 			srd.patchID.NextPatchID(srd.depth + 1, i));
 	}
@@ -182,28 +202,28 @@ QuadPatchJob::~QuadPatchJob()
 }
 
 // Generates full-detail vertices, and also non-edge normals and colors
-void SQuadSplitRequest::GenerateBorderedData() const
+void SQuadSplitRequest::GenerateBorderedData()
 {
 	const int borderedEdgeLen = (edgeLen * 2) + (BORDER_SIZE * 2) - 1;
-#ifndef NDEBUG
 	const int numBorderedVerts = borderedEdgeLen * borderedEdgeLen;
-#endif
+	borderHeights = GeoPatchBuffer<double>(GeoPatchContext::GetBufferPool(), numBorderedVerts);
+	borderVertexs = GeoPatchBuffer<vector3d>(GeoPatchContext::GetBufferPool(), numBorderedVerts);
 
-	// generate heights plus a N=BORDER_SIZE unit border
-	double *bhts = borderHeights.get();
+	// generate heights plus a N=BORDER_SIZE unit border, all at once
 	vector3d *vrts = borderVertexs.get();
 	for (int y = -BORDER_SIZE; y < (borderedEdgeLen - BORDER_SIZE); y++) {
 		const double yfrac = double(y) * (fracStep * 0.5);
 		for (int x = -BORDER_SIZE; x < (borderedEdgeLen - BORDER_SIZE); x++) {
 			const double xfrac = double(x) * (fracStep * 0.5);
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
-			const double height = pTerrain->GetHeight(p);
-			assert(height >= 0.0f && height <= 1.0f);
-			*(bhts++) = height;
-			*(vrts++) = p * (height + 1.0);
+			*(vrts++) = GetSpherePoint(v0, v1, v2, v3, xfrac, yfrac);
 		}
 	}
-	assert(bhts == &borderHeights[numBorderedVerts]);
+	vrts = borderVertexs.get();
+	pTerrain->GetHeights(vrts, borderHeights.get(), numBorderedVerts);
+	for (int i = 0; i < numBorderedVerts; i++) {
+		assert(borderHeights[i] >= 0.0f && borderHeights[i] <= 1.0f);
+		vrts[i] = vrts[i] * (borderHeights[i] + 1.0);
+	}
 }
 
 void SQuadSplitRequest::GenerateSubPatchData(
@@ -217,21 +237,23 @@ void SQuadSplitRequest::GenerateSubPatchData(
 	const int yoff,
 	const int borderedEdgeLen) const
 {
-	// Generate normals & colors for vertices
+	// Generate normals & colors for vertices (the colors a row at a time)
 	vector3d *vrts = borderVertexs.get();
-	Color3ub *col = colors[quadrantIndex];
-	vector3f *nrm = normals[quadrantIndex];
-	double *hts = heights[quadrantIndex];
+	Color3ub *col = colors[quadrantIndex].get();
+	vector3f *nrm = normals[quadrantIndex].get();
+	double *hts = heights[quadrantIndex].get();
+	std::vector<vector3d> rowPoints(edgeLen), rowNormals(edgeLen), rowColors(edgeLen);
 
 	// step over the small square
 	for (int y = 0; y < edgeLen; y++) {
 		const int by = (y + BORDER_SIZE) + yoff;
+		const double *rowHeights = hts;
 		for (int x = 0; x < edgeLen; x++) {
 			const int bx = (x + BORDER_SIZE) + xoff;
 
 			// height
 			const double height = borderHeights[bx + (by * borderedEdgeLen)];
-			assert(hts != &heights[quadrantIndex][edgeLen * edgeLen]);
+			assert(hts != heights[quadrantIndex].get() + edgeLen * edgeLen);
 			*(hts++) = height;
 
 			// normal
@@ -240,17 +262,21 @@ void SQuadSplitRequest::GenerateSubPatchData(
 			const vector3d &y1 = vrts[bx + ((by - 1) * borderedEdgeLen)];
 			const vector3d &y2 = vrts[bx + ((by + 1) * borderedEdgeLen)];
 			const vector3d n = ((x2 - x1).Cross(y2 - y1)).Normalized();
-			assert(nrm != &normals[quadrantIndex][edgeLen * edgeLen]);
+			assert(nrm != normals[quadrantIndex].get() + edgeLen * edgeLen);
 			*(nrm++) = vector3f(n);
 
-			// color
-			const vector3d p = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
-			setColour(*col, pTerrain->GetColor(p, height, n));
-			assert(col != &colors[quadrantIndex][edgeLen * edgeLen]);
-			++col;
+			rowNormals[x] = n;
+			rowPoints[x] = GetSpherePoint(v0, v1, v2, v3, x * fracStep, y * fracStep);
+		}
+
+		// color
+		pTerrain->GetColors(rowPoints.data(), rowHeights, rowNormals.data(), rowColors.data(), edgeLen);
+		for (int x = 0; x < edgeLen; x++) {
+			assert(col != colors[quadrantIndex].get() + edgeLen * edgeLen);
+			setColour(*(col++), rowColors[x]);
 		}
 	}
-	assert(hts == &heights[quadrantIndex][edgeLen * edgeLen]);
-	assert(nrm == &normals[quadrantIndex][edgeLen * edgeLen]);
-	assert(col == &colors[quadrantIndex][edgeLen * edgeLen]);
+	assert(hts == heights[quadrantIndex].get() + edgeLen * edgeLen);
+	assert(nrm == normals[quadrantIndex].get() + edgeLen * edgeLen);
+	assert(col == colors[quadrantIndex].get() + edgeLen * edgeLen);
 }
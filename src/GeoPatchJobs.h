@@ -7,6 +7,9 @@
 #include <SDL_stdinc.h>
 
 #include "Color.h"
+#include "GeoPatchBufferPool.h"
+#include "GeoPatchContext.h"
+#include "GeoPatchDiskCache.h"
 #include "GeoPatchID.h"
 #include "JobQueue.h"
 #include "vector3.h"
@@ -20,7 +23,7 @@ class SBaseRequest {
 public:
 	SBaseRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
+		Terrain *pTerrain_, GeoPatchDiskCache *diskCache_) :
 		v0(v0_),
 		v1(v1_),
 		v2(v2_),
@@ -31,12 +34,15 @@ public:
 		patchID(patchID_),
 		edgeLen(edgeLen_),
 		fracStep(fracStep_),
-		pTerrain(pTerrain_)
+		pTerrain(pTerrain_),
+		diskCache(diskCache_)
 	{
 	}
 
 	inline int NUMVERTICES(const int el) const { return el * el; }
 
+	inline GeoPatchDiskCache::Key DiskCacheKey(const int numPatches) const { return GeoPatchDiskCache::Key(patchID, depth, edgeLen, numPatches); }
+
 	const vector3d v0, v1, v2, v3;
 	const vector3d centroid;
 	const uint32_t depth;
@@ -46,6 +52,10 @@ public:
 	const double fracStep;
 	RefCountedPtr<Terrain> pTerrain;
 
+	// null if there isn't one. the job looks there first, so the main
+	// thread never waits on it
+	RefCountedPtr<GeoPatchDiskCache> diskCache;
+
 protected:
 	// deliberately prevent copy constructor access
 	SBaseRequest(const SBaseRequest &r) = delete;
@@ -55,35 +65,34 @@ class SQuadSplitRequest : public SBaseRequest {
 public:
 	SQuadSplitRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
-		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
+		Terrain *pTerrain_, GeoPatchDiskCache *diskCache_) :
+		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_, diskCache_)
 	{
+		GeoPatchBufferPool &pool = GeoPatchContext::GetBufferPool();
 		const int numVerts = NUMVERTICES(edgeLen_);
 		for (int i = 0; i < 4; ++i) {
-			heights[i] = new double[numVerts];
-			normals[i] = new vector3f[numVerts];
-			colors[i] = new Color3ub[numVerts];
+			heights[i] = GeoPatchBuffer<double>(pool, numVerts);
+			normals[i] = GeoPatchBuffer<vector3f>(pool, numVerts);
+			colors[i] = GeoPatchBuffer<Color3ub>(pool, numVerts);
 		}
-		const int numBorderedVerts = NUMVERTICES((edgeLen_ * 2) + (BORDER_SIZE * 2) - 1);
-		borderHeights.reset(new double[numBorderedVerts]);
-		borderVertexs.reset(new vector3d[numBorderedVerts]);
 	}
 
 	// Generates full-detail vertices, and also non-edge normals and colors
-	void GenerateBorderedData() const;
+	void GenerateBorderedData();
 
 	void GenerateSubPatchData(const int quadrantIndex,
 		const vector3d &v0, const vector3d &v1, const vector3d &v2, const vector3d &v3,
 		const int edgeLen, const int xoff, const int yoff, const int borderedEdgeLen) const;
 
 	// these are created with the request and are given to the resulting patches
-	vector3f *normals[4];
-	Color3ub *colors[4];
-	double *heights[4];
+	GeoPatchBuffer<vector3f> normals[4];
+	GeoPatchBuffer<Color3ub> colors[4];
+	GeoPatchBuffer<double> heights[4];
 
-	// these are created with the request but are destroyed when the request is finished
-	std::unique_ptr<double[]> borderHeights;
-	std::unique_ptr<vector3d[]> borderVertexs;
+	// these are created when the data is generated (it usually isn't if it's
+	// in the disk cache) and are destroyed when the request is finished
+	GeoPatchBuffer<double> borderHeights;
+	GeoPatchBuffer<vector3d> borderVertexs;
 
 protected:
 	// deliberately prevent copy constructor access
@@ -94,30 +103,28 @@ class SSingleSplitRequest : public SBaseRequest {
 public:
 	SSingleSplitRequest(const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const vector3d &cn,
 		const uint32_t depth_, const SystemPath &sysPath_, const GeoPatchID &patchID_, const int edgeLen_, const double fracStep_,
-		Terrain *pTerrain_) :
-		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_)
+		Terrain *pTerrain_, GeoPatchDiskCache *diskCache_) :
+		SBaseRequest(v0_, v1_, v2_, v3_, cn, depth_, sysPath_, patchID_, edgeLen_, fracStep_, pTerrain_, diskCache_)
 	{
+		GeoPatchBufferPool &pool = GeoPatchContext::GetBufferPool();
 		const int numVerts = NUMVERTICES(edgeLen_);
-		heights = new double[numVerts];
-		normals = new vector3f[numVerts];
-		colors = new Color3ub[numVerts];
-
-		const int numBorderedVerts = NUMVERTICES(edgeLen_ + (BORDER_SIZE * 2));
-		borderHeights.reset(new double[numBorderedVerts]);
-		borderVertexs.reset(new vector3d[numBorderedVerts]);
+		heights = GeoPatchBuffer<double>(pool, numVerts);
+		normals = GeoPatchBuffer<vector3f>(pool, numVerts);
+		colors = GeoPatchBuffer<Color3ub>(pool, numVerts);
 	}
 
 	// Generates full-detail vertices, and also non-edge normals and colors
-	void GenerateMesh() const;
+	void GenerateMesh();
 
 	// these are created with the request and are given to the resulting patches
-	vector3f *normals;
-	Color3ub *colors;
-	double *heights;
+	GeoPatchBuffer<vector3f> normals;
+	GeoPatchBuffer<Color3ub> colors;
+	GeoPatchBuffer<double> heights;
 
-	// these are created with the request but are destroyed when the request is finished
-	std::unique_ptr<double[]> borderHeights;
-	std::unique_ptr<vector3d[]> borderVertexs;
+	// these are created when the data is generated (it usually isn't if it's
+	// in the disk cache) and are destroyed when the request is finished
+	GeoPatchBuffer<double> borderHeights;
+	GeoPatchBuffer<vector3d> borderVertexs;
 
 protected:
 	// deliberately prevent copy constructor access
@@ -129,10 +136,10 @@ public:
 	struct SSplitResultData {
 		SSplitResultData() :
 			patchID(0) {}
-		SSplitResultData(double *heights_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
-			heights(heights_),
-			normals(n_),
-			colors(c_),
+		SSplitResultData(GeoPatchBuffer<double> &&heights_, GeoPatchBuffer<vector3f> &&n_, GeoPatchBuffer<Color3ub> &&c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_) :
+			heights(std::move(heights_)),
+			normals(std::move(n_)),
+			colors(std::move(c_)),
 			v0(v0_),
 			v1(v1_),
 			v2(v2_),
@@ -140,9 +147,10 @@ public:
 			patchID(patchID_)
 		{}
 
-		double *heights;
-		vector3f *normals;
-		Color3ub *colors;
+		// mutable so the patches can take them from a const result
+		GeoPatchBuffer<double> heights;
+		GeoPatchBuffer<vector3f> normals;
+		GeoPatchBuffer<Color3ub> colors;
 		vector3d v0, v1, v2, v3;
 		GeoPatchID patchID;
 	};
@@ -176,29 +184,21 @@ public:
 	{
 	}
 
-	void addResult(const int kidIdx, double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(const int kidIdx, GeoPatchBuffer<double> &&h_, GeoPatchBuffer<vector3f> &&n_, GeoPatchBuffer<Color3ub> &&c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
 		assert(kidIdx >= 0 && kidIdx < NUM_RESULT_DATA);
-		mData[kidIdx] = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData[kidIdx] = (SSplitResultData(std::move(h_), std::move(n_), std::move(c_), v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data(const int32_t idx) const { return mData[idx]; }
+	inline SSplitResultData &data(const int32_t idx) { return mData[idx]; }
 
 	virtual void OnCancel()
 	{
 		for (int i = 0; i < NUM_RESULT_DATA; ++i) {
-			if (mData[i].heights) {
-				delete[] mData[i].heights;
-				mData[i].heights = NULL;
-			}
-			if (mData[i].normals) {
-				delete[] mData[i].normals;
-				mData[i].normals = NULL;
-			}
-			if (mData[i].colors) {
-				delete[] mData[i].colors;
-				mData[i].colors = NULL;
-			}
+			mData[i].heights.reset();
+			mData[i].normals.reset();
+			mData[i].colors.reset();
 		}
 	}
 
@@ -217,29 +217,19 @@ public:
 	{
 	}
 
-	void addResult(double *h_, vector3f *n_, Color3ub *c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
+	void addResult(GeoPatchBuffer<double> &&h_, GeoPatchBuffer<vector3f> &&n_, GeoPatchBuffer<Color3ub> &&c_, const vector3d &v0_, const vector3d &v1_, const vector3d &v2_, const vector3d &v3_, const GeoPatchID &patchID_)
 	{
-		mData = (SSplitResultData(h_, n_, c_, v0_, v1_, v2_, v3_, patchID_));
+		mData = (SSplitResultData(std::move(h_), std::move(n_), std::move(c_), v0_, v1_, v2_, v3_, patchID_));
 	}
 
 	inline const SSplitResultData &data() const { return mData; }
+	inline SSplitResultData &data() { return mData; }
 
 	virtual void OnCancel()
 	{
-		{
-			if (mData.heights) {
-				delete[] mData.heights;
-				mData.heights = NULL;
-			}
-			if (mData.normals) {
-				delete[] mData.normals;
-				mData.normals = NULL;
-			}
-			if (mData.colors) {
-				delete[] mData.colors;
-				mData.colors = NULL;
-			}
-		}
+		mData.heights.reset();
+		mData.normals.reset();
+		mData.colors.reset();
 	}
 
 protected:
@@ -6,6 +6,7 @@
 #include "GameConfig.h"
 #include "GeoPatch.h"
 #include "GeoPatchContext.h"
+#include "GeoPatchDiskCache.h"
 #include "GeoPatchJobs.h"
 #include "Pi.h"
 #include "RefCounted.h"
@@ -38,6 +39,9 @@ static const int detail_edgeLen[5] = {
 };
 
 static const double gs_targetPatchTriLength(100.0);
+// split jobs queued at once for each GeoSphere
+static const Uint32 SPLIT_JOBS_PER_RUNNER = 2;
+static const Uint32 MIN_SPLIT_JOBS = 4;
 static std::vector<GeoSphere *> s_allGeospheres;
 
 void GeoSphere::Init()
@@ -83,7 +87,14 @@ void GeoSphere::OnChangeDetailLevel()
 		// reinit the terrain with the new settings
 		(*i)->m_terrain.Reset(Terrain::InstanceTerrain((*i)->GetSystemBody()));
 		print_info((*i)->GetSystemBody(), (*i)->m_terrain.Get());
+
+		// which changes what the patches come out as
+		(*i)->m_diskCache.Reset();
+		(*i)->m_diskCache.Reset(GeoPatchDiskCache::Open((*i)->GetSystemBody()->GetPath(), (*i)->m_terrain.Get()));
 	}
+
+	// the old patches' buffers are back (or will be when their jobs finish)
+	GeoPatchContext::GetBufferPool().Trim();
 }
 
 //static
@@ -182,6 +193,8 @@ GeoSphere::GeoSphere(const SystemBody *body) :
 {
 	print_info(body, m_terrain.Get());
 
+	m_diskCache.Reset(GeoPatchDiskCache::Open(body->GetPath(), m_terrain.Get()));
+
 	s_allGeospheres.push_back(this);
 
 	CalculateMaxPatchDepth();
@@ -194,6 +207,14 @@ GeoSphere::~GeoSphere()
 	// update thread should not be able to access us now, so we can safely continue to delete
 	assert(std::count(s_allGeospheres.begin(), s_allGeospheres.end(), this) == 1);
 	s_allGeospheres.erase(std::find(s_allGeospheres.begin(), s_allGeospheres.end(), this));
+
+	// the pool keeps what it has grown to while there's terrain to reuse it
+	// for, but there's no telling when the next planet will be
+	if (s_allGeospheres.empty()) {
+		for (int p = 0; p < NUM_PATCHES; p++)
+			m_patches[p].reset();
+		GeoPatchContext::GetBufferPool().Trim();
+	}
 }
 
 bool GeoSphere::AddQuadSplitResult(SQuadSplitResult *res)
@@ -351,18 +372,34 @@ void GeoSphere::Update()
 	}
 }
 
-void GeoSphere::AddQuadSplitRequest(double dist, SQuadSplitRequest *pReq, GeoPatch *pPatch)
+void GeoSphere::AddQuadSplitRequest(double error, double dist, GeoPatch *pPatch)
 {
-	mQuadSplitRequests.push_back(TDistanceRequest(dist, pReq, pPatch));
+	mQuadSplitRequests.push_back(TSplitRequest(error, dist, pPatch));
 }
 
 void GeoSphere::ProcessQuadSplitRequests()
 {
-	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](TDistanceRequest &a, TDistanceRequest &b) { return a.mDistance < b.mDistance; });
-
-	for (auto iter : mQuadSplitRequests) {
-		SQuadSplitRequest *ssrd = iter.mpRequest;
-		iter.mpRequester->ReceiveJobHandle(Pi::GetAsyncJobQueue()->Queue(new QuadPatchJob(ssrd)));
+	// the most missing detail first, and of the same, the nearest
+	std::sort(mQuadSplitRequests.begin(), mQuadSplitRequests.end(), [](const TSplitRequest &a, const TSplitRequest &b) {
+		return a.mError != b.mError ? a.mError > b.mError : a.mDistance < b.mDistance;
+	});
+
+	// only a few jobs are queued at a time, so that what the camera gets
+	// close to next doesn't wait behind what it has flown past. the rest
+	// wait, and are sorted again next frame
+	const Uint32 maxJobs = std::max(MIN_SPLIT_JOBS, SPLIT_JOBS_PER_RUNNER * Pi::GetAsyncJobQueue()->GetNumRunners());
+	Uint32 numJobs = 0;
+	for (const TSplitRequest &req : mQuadSplitRequests) {
+		if (!req.mpRequester->IsSplitWaiting())
+			++numJobs;
+	}
+	for (const TSplitRequest &req : mQuadSplitRequests) {
+		if (numJobs >= maxJobs)
+			break;
+		if (req.mpRequester->IsSplitWaiting()) {
+			req.mpRequester->QueueSplitJob();
+			++numJobs;
+		}
 	}
 	mQuadSplitRequests.clear();
 }
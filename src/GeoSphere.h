@@ -11,6 +11,7 @@
 #include "vector3.h"
 
 #include <deque>
+#include <vector>
 
 namespace Graphics {
 	class Renderer;
@@ -23,6 +24,7 @@ class GeoPatchContext;
 class SQuadSplitRequest;
 class SQuadSplitResult;
 class SSingleSplitResult;
+class GeoPatchDiskCache;
 
 #define NUM_PATCHES 6
 
@@ -67,7 +69,11 @@ public:
 
 	inline Sint32 GetMaxDepth() const { return m_maxDepth; }
 
-	void AddQuadSplitRequest(double, SQuadSplitRequest *, GeoPatch *);
+	// error is how many times too big the patch looks
+	void AddQuadSplitRequest(double error, double dist, GeoPatch *pPatch);
+
+	// null if patches aren't being cached
+	GeoPatchDiskCache *GetDiskCache() const { return m_diskCache.Get(); }
 
 private:
 	void BuildFirstPatches();
@@ -79,16 +85,19 @@ private:
 	void ProcessQuadSplitRequests();
 
 	std::unique_ptr<GeoPatch> m_patches[6];
-	struct TDistanceRequest {
-		TDistanceRequest(double dist, SQuadSplitRequest *pRequest, GeoPatch *pRequester) :
+	RefCountedPtr<GeoPatchDiskCache> m_diskCache;
+	// every patch that wants splitting this frame, whether or not its job
+	// has been queued yet
+	struct TSplitRequest {
+		TSplitRequest(double error, double dist, GeoPatch *pRequester) :
+			mError(error),
 			mDistance(dist),
-			mpRequest(pRequest),
 			mpRequester(pRequester) {}
+		double mError;
 		double mDistance;
-		SQuadSplitRequest *mpRequest;
 		GeoPatch *mpRequester;
 	};
-	std::deque<TDistanceRequest> mQuadSplitRequests;
+	std::vector<TSplitRequest> mQuadSplitRequests;
 
 	static const uint32_t MAX_SPLIT_OPERATIONS = 128;
 	std::deque<SQuadSplitResult *> mQuadSplitResults;
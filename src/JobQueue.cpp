@@ -89,24 +89,175 @@ Job::Handle::~Handle()
 	}
 }
 
+JobQueue::JobQueue() :
+	m_statQueued(nullptr),
+	m_statRun(nullptr),
+	m_statStolen(nullptr),
+	m_statWaitTime(nullptr),
+	m_statRunTime(nullptr),
+	m_statPending(nullptr)
+{
+	m_statQueued = m_stats.GetOrCreateCounter("Jobs Queued");
+	m_statRun = m_stats.GetOrCreateCounter("Jobs Run");
+	m_statStolen = m_stats.GetOrCreateCounter("Jobs Stolen");
+	m_statWaitTime = m_stats.GetOrCreateCounter("Job Wait Time (us)");
+	m_statRunTime = m_stats.GetOrCreateCounter("Job Run Time (us)");
+	m_statPending = m_stats.GetOrCreateCounter("Jobs Pending", false);
+}
+
+void JobQueue::StatJobQueued(Job *job)
+{
+	job->m_queuedTime = std::chrono::steady_clock::now();
+	m_stats.CounterAdd(m_statQueued);
+}
+
+void JobQueue::StatJobStarted(Job *job)
+{
+	const auto waited = std::chrono::steady_clock::now() - job->m_queuedTime;
+	m_stats.CounterAdd(m_statRun);
+	m_stats.CounterAdd(m_statWaitTime, std::chrono::duration_cast<std::chrono::microseconds>(waited).count());
+}
+
+void JobQueue::StatJobFinished(Job *job, std::chrono::steady_clock::time_point started)
+{
+	const auto ran = std::chrono::steady_clock::now() - started;
+	m_stats.CounterAdd(m_statRunTime, std::chrono::duration_cast<std::chrono::microseconds>(ran).count());
+}
+
+void JobQueue::QueueTask(TaskGroup *group, std::function<void()> task)
+{
+	group->RunTask(task);
+}
+
+TaskGroup::TaskGroup(JobQueue *queue) :
+	m_queue(queue),
+	m_pending(0)
+{
+	m_lock = SDL_CreateMutex();
+	m_doneCond = SDL_CreateCond();
+}
+
+TaskGroup::~TaskGroup()
+{
+	// not Wait(): an exception nobody asked for can't be thrown from here
+	WaitForTasks();
+	SDL_DestroyCond(m_doneCond);
+	SDL_DestroyMutex(m_lock);
+}
+
+void TaskGroup::Run(std::function<void()> task)
+{
+	if (!m_queue) {
+		task();
+		return;
+	}
+
+	SDL_LockMutex(m_lock);
+	++m_pending;
+	SDL_UnlockMutex(m_lock);
+	m_queue->QueueTask(this, std::move(task));
+}
+
+void TaskGroup::RunTask(const std::function<void()> &task)
+{
+	std::exception_ptr exception;
+	try {
+		task();
+	} catch (...) {
+		exception = std::current_exception();
+	}
+
+	// the group may be gone as soon as the lock is released
+	SDL_LockMutex(m_lock);
+	if (exception && !m_exception)
+		m_exception = exception;
+	if (--m_pending == 0)
+		SDL_CondBroadcast(m_doneCond);
+	SDL_UnlockMutex(m_lock);
+}
+
+void TaskGroup::WaitForTasks()
+{
+	PROFILE_SCOPED()
+	// help out while there's something queued, then sleep until the tasks
+	// running on other threads are done. anything those queue meanwhile is
+	// picked up by the runners
+	while (m_pending > 0) {
+		if (m_queue->RunTask())
+			continue;
+		SDL_LockMutex(m_lock);
+		if (m_pending > 0)
+			SDL_CondWait(m_doneCond, m_lock);
+		SDL_UnlockMutex(m_lock);
+	}
+}
+
+void TaskGroup::Wait()
+{
+	WaitForTasks();
+
+	SDL_LockMutex(m_lock);
+	std::exception_ptr exception;
+	std::swap(exception, m_exception);
+	SDL_UnlockMutex(m_lock);
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+void ParallelFor(JobQueue *queue, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)> &fn)
+{
+	if (begin >= end)
+		return;
+
+	// a few chunks per thread, so a slow chunk doesn't hold everyone up,
+	// but never smaller than the grain size
+	const size_t count = end - begin;
+	const size_t numThreads = (queue ? queue->GetNumRunners() : 0) + 1;
+	const size_t chunkSize = std::max(std::max(grainSize, size_t(1)), (count + numThreads * 4 - 1) / (numThreads * 4));
+	if (numThreads == 1 || count <= chunkSize) {
+		fn(begin, end);
+		return;
+	}
+
+	TaskGroup group(queue);
+	// keep the first chunk for ourselves, we'd only be waiting otherwise
+	for (size_t chunk = begin + chunkSize; chunk < end; chunk += chunkSize) {
+		const size_t chunkEnd = std::min(chunk + chunkSize, end);
+		group.Run([&fn, chunk, chunkEnd]() { fn(chunk, chunkEnd); });
+	}
+	fn(begin, std::min(begin + chunkSize, end));
+	group.Wait();
+}
+
 AsyncJobQueue::AsyncJobQueue(Uint32 numRunners) :
+	// Want to limit this for now to the maximum number of threads defined in the class
+	m_numRunners(std::min(numRunners, MAX_THREADS)),
+	m_nextQueue(0),
+	m_numQueued(0),
+	m_numTasks(0),
+	m_numSleeping(0),
 	m_shutdown(false)
 {
-	// Want to limit this for now to the maximum number of threads defined in the class
-	numRunners = std::min(numRunners, MAX_THREADS);
-
 	m_queueLock = SDL_CreateMutex();
 	m_queueWaitCond = SDL_CreateCond();
+	m_taskLock = SDL_CreateMutex();
 
-	for (Uint32 i = 0; i < numRunners; i++) {
+	// the queues must all exist before any runner starts looking for work to steal
+	for (Uint32 i = 0; i < m_numRunners; i++) {
+		m_queues[i].lock = SDL_CreateMutex();
+		for (int p = 0; p < Job::NUM_PRIORITIES; p++)
+			m_queues[i].count[p] = 0;
 		m_finishedLock[i] = SDL_CreateMutex();
-		m_runners.push_back(new JobRunner(this, i));
 	}
+
+	for (Uint32 i = 0; i < m_numRunners; i++)
+		m_runners.push_back(new JobRunner(this, i));
 }
 
 AsyncJobQueue::~AsyncJobQueue()
 {
-	// flag shutdown. protected by the queue lock for convenience in GetJob
+	// flag shutdown. protected by the queue lock so no runner can miss it
+	// between checking for work and going to sleep
 	SDL_LockMutex(m_queueLock);
 	m_shutdown = true;
 	SDL_UnlockMutex(m_queueLock);
@@ -131,9 +282,11 @@ AsyncJobQueue::~AsyncJobQueue()
 		delete (*i);
 
 	// delete any remaining jobs
-	for (std::deque<Job *>::iterator i = m_queue.begin(); i != m_queue.end(); ++i)
-		delete (*i);
 	for (uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++) {
+		for (int p = 0; p < Job::NUM_PRIORITIES; p++) {
+			for (std::deque<Job *>::iterator i = m_queues[threadIdx].jobs[p].begin(); i != m_queues[threadIdx].jobs[p].end(); ++i)
+				delete (*i);
+		}
 		for (std::deque<Job *>::iterator i = m_finished[threadIdx].begin(); i != m_finished[threadIdx].end(); ++i) {
 			delete (*i);
 		}
@@ -141,8 +294,10 @@ AsyncJobQueue::~AsyncJobQueue()
 
 	// only us left now, we can clean up and get out of here
 	for (uint32_t threadIdx = 0; threadIdx < numThreads; threadIdx++) {
+		SDL_DestroyMutex(m_queues[threadIdx].lock);
 		SDL_DestroyMutex(m_finishedLock[threadIdx]);
 	}
+	SDL_DestroyMutex(m_taskLock);
 	SDL_DestroyCond(m_queueWaitCond);
 	SDL_DestroyMutex(m_queueLock);
 }
@@ -150,45 +305,124 @@ AsyncJobQueue::~AsyncJobQueue()
 Job::Handle AsyncJobQueue::Queue(Job *job, JobClient *client)
 {
 	Job::Handle handle(job, this, client);
+	StatJobQueued(job);
+
+	// hand the job to the next runner in turn. if it's busy, one of the
+	// others will steal it
+	RunnerQueue &queue = m_queues[m_nextQueue];
+	m_nextQueue = (m_nextQueue + 1) % m_numRunners;
+
+	const int priority = job->GetPriority();
+	SDL_LockMutex(queue.lock);
+	queue.jobs[priority].push_back(job);
+	++queue.count[priority];
+	const Uint32 numQueued = ++m_numQueued;
+	SDL_UnlockMutex(queue.lock);
+
+	StatSetPending(numQueued);
+
+	// and tell a waiting runner that there's one available. the lock makes
+	// sure a runner that's just about to sleep sees the new job first
+	if (m_numSleeping > 0) {
+		SDL_LockMutex(m_queueLock);
+		SDL_CondSignal(m_queueWaitCond);
+		SDL_UnlockMutex(m_queueLock);
+	}
+	return handle;
+}
 
-	// push the job onto the queue
-	SDL_LockMutex(m_queueLock);
-	m_queue.push_back(job);
-	SDL_UnlockMutex(m_queueLock);
+void AsyncJobQueue::QueueTask(TaskGroup *group, std::function<void()> task)
+{
+	SDL_LockMutex(m_taskLock);
+	m_tasks.push_back({ group, std::move(task) });
+	++m_numTasks;
+	SDL_UnlockMutex(m_taskLock);
+
+	if (m_numSleeping > 0) {
+		SDL_LockMutex(m_queueLock);
+		SDL_CondSignal(m_queueWaitCond);
+		SDL_UnlockMutex(m_queueLock);
+	}
+}
 
-	// and tell a waiting runner that there's one available
-	SDL_CondSignal(m_queueWaitCond);
-	return handle;
+bool AsyncJobQueue::RunTask()
+{
+	if (m_numTasks == 0)
+		return false;
+
+	SDL_LockMutex(m_taskLock);
+	if (m_tasks.empty()) {
+		SDL_UnlockMutex(m_taskLock);
+		return false;
+	}
+	Task task = std::move(m_tasks.front());
+	m_tasks.pop_front();
+	--m_numTasks;
+	SDL_UnlockMutex(m_taskLock);
+
+	task.group->RunTask(task.fn);
+	return true;
 }
 
-// called by the runner to get a new job
-Job *AsyncJobQueue::GetJob()
+// pop the oldest job of the given priority from a runner's queue, if there is one
+Job *AsyncJobQueue::TakeJob(const uint8_t threadIdx, const uint8_t victimIdx, const int priority)
 {
-	SDL_LockMutex(m_queueLock);
+	RunnerQueue &queue = m_queues[victimIdx];
+	if (queue.count[priority] == 0)
+		return nullptr;
+
+	Job *job = nullptr;
+	Uint32 numQueued = 0;
+	SDL_LockMutex(queue.lock);
+	if (!queue.jobs[priority].empty()) {
+		job = queue.jobs[priority].front();
+		queue.jobs[priority].pop_front();
+		--queue.count[priority];
+		numQueued = --m_numQueued;
+	}
+	SDL_UnlockMutex(queue.lock);
+
+	if (job) {
+		StatSetPending(numQueued);
+		if (threadIdx != victimIdx)
+			StatJobStolen();
+	}
+	return job;
+}
+
+// called by the runner to get a new job. any tasks are run along the way
+Job *AsyncJobQueue::GetJob(const uint8_t threadIdx)
+{
+	const uint32_t numRunners = m_numRunners;
 
 	// loop until a new job is available
-	Job *job = 0;
-	while (!job) {
+	while (true) {
 		// we're shutting down, so just get out of here
-		if (m_shutdown) {
-			SDL_UnlockMutex(m_queueLock);
-			return 0;
-		}
+		if (m_shutdown)
+			return nullptr;
 
-		if (!m_queue.size())
-			// no jobs, go to sleep until one arrives
-			SDL_CondWait(m_queueWaitCond, m_queueLock);
+		// someone's blocked waiting on tasks, so they always go first
+		if (RunTask())
+			continue;
 
-		else {
-			// got one, pop it and return it
-			job = m_queue.front();
-			m_queue.pop_front();
+		// highest priority first. look in our own queue, then try to steal
+		// from the other runners, starting with our neighbour
+		for (int priority = Job::NUM_PRIORITIES - 1; priority >= 0; priority--) {
+			for (uint32_t i = 0; i < numRunners; i++) {
+				Job *job = TakeJob(threadIdx, (threadIdx + i) % numRunners, priority);
+				if (job)
+					return job;
+			}
 		}
-	}
-
-	SDL_UnlockMutex(m_queueLock);
 
-	return job;
+		// no jobs, go to sleep until one arrives
+		SDL_LockMutex(m_queueLock);
+		++m_numSleeping;
+		if (m_numQueued == 0 && m_numTasks == 0 && !m_shutdown)
+			SDL_CondWait(m_queueWaitCond, m_queueLock);
+		--m_numSleeping;
+		SDL_UnlockMutex(m_queueLock);
+	}
 }
 
 // called by the runner when a job completes
@@ -233,19 +467,26 @@ Uint32 AsyncJobQueue::FinishJobs()
 
 void AsyncJobQueue::Cancel(Job *job)
 {
-	// lock both queues, so we know that all jobs will stay put
-	SDL_LockMutex(m_queueLock);
+	// lock all the queues, so we know that all jobs will stay put
 	const uint32_t numRunners = m_runners.size();
 	for (uint32_t i = 0; i < numRunners; ++i) {
+		SDL_LockMutex(m_queues[i].lock);
 		SDL_LockMutex(m_finishedLock[i]);
 	}
 
-	// check the waiting list. if its there then it hasn't run yet. just forget about it
-	for (std::deque<Job *>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
-		if (*i == job) {
-			i = m_queue.erase(i);
-			delete job;
-			goto unlock;
+	// check the waiting lists. if its there then it hasn't run yet. just forget about it
+	for (uint32_t iRunner = 0; iRunner < numRunners; ++iRunner) {
+		RunnerQueue &queue = m_queues[iRunner];
+		for (int priority = 0; priority < Job::NUM_PRIORITIES; priority++) {
+			for (std::deque<Job *>::iterator i = queue.jobs[priority].begin(); i != queue.jobs[priority].end(); ++i) {
+				if (*i == job) {
+					i = queue.jobs[priority].erase(i);
+					--queue.count[priority];
+					StatSetPending(--m_numQueued);
+					delete job;
+					goto unlock;
+				}
+			}
 		}
 	}
 
@@ -269,8 +510,8 @@ void AsyncJobQueue::Cancel(Job *job)
 unlock:
 	for (uint32_t i = 0; i < numRunners; ++i) {
 		SDL_UnlockMutex(m_finishedLock[i]);
+		SDL_UnlockMutex(m_queues[i].lock);
 	}
-	SDL_UnlockMutex(m_queueLock);
 }
 
 AsyncJobQueue::JobRunner::JobRunner(AsyncJobQueue *jq, const uint8_t idx) :
@@ -320,7 +561,7 @@ void AsyncJobQueue::JobRunner::Main()
 		SDL_UnlockMutex(m_queueDestroyingLock);
 		return;
 	}
-	job = m_jobQueue->GetJob();
+	job = m_jobQueue->GetJob(m_threadIdx);
 	SDL_UnlockMutex(m_queueDestroyingLock);
 
 	while (job) {
@@ -330,7 +571,10 @@ void AsyncJobQueue::JobRunner::Main()
 		SDL_UnlockMutex(m_jobLock);
 
 		// run the thing
+		m_jobQueue->StatJobStarted(job);
+		const auto started = std::chrono::steady_clock::now();
 		job->OnRun();
+		m_jobQueue->StatJobFinished(job, started);
 
 		// Lock to prevent destruction of the queue while calling Finish
 		SDL_LockMutex(m_queueDestroyingLock);
@@ -353,7 +597,7 @@ void AsyncJobQueue::JobRunner::Main()
 			SDL_UnlockMutex(m_queueDestroyingLock);
 			return;
 		}
-		job = m_jobQueue->GetJob();
+		job = m_jobQueue->GetJob(m_threadIdx);
 		SDL_UnlockMutex(m_queueDestroyingLock);
 	}
 }
@@ -380,7 +624,9 @@ SyncJobQueue::~SyncJobQueue()
 Job::Handle SyncJobQueue::Queue(Job *job, JobClient *client)
 {
 	Job::Handle handle(job, this, client);
+	StatJobQueued(job);
 	m_queue.push_back(job);
+	StatSetPending(m_queue.size());
 	return handle;
 }
 
@@ -412,6 +658,7 @@ void SyncJobQueue::Cancel(Job *job)
 	for (std::deque<Job *>::iterator i = m_queue.begin(); i != m_queue.end(); ++i) {
 		if (*i == job) {
 			i = m_queue.erase(i);
+			StatSetPending(m_queue.size());
 			delete job;
 			return;
 		}
@@ -443,7 +690,11 @@ Uint32 SyncJobQueue::RunJobs(Uint32 count)
 
 		Job *job = m_queue.front();
 		m_queue.pop_front();
+		StatSetPending(m_queue.size());
+		StatJobStarted(job);
+		const auto started = std::chrono::steady_clock::now();
 		job->OnRun();
+		StatJobFinished(job, started);
 		executed++;
 		m_finished.push_back(job);
 	}
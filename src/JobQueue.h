@@ -4,9 +4,14 @@
 #ifndef JOBQUEUE_H
 #define JOBQUEUE_H
 
+#include "PerfStats.h"
 #include "SDL_thread.h"
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <deque>
+#include <exception>
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -15,6 +20,7 @@ static const Uint32 MAX_THREADS = 64;
 
 class JobClient;
 class JobQueue;
+class TaskGroup;
 
 // represents a single unit of work that you want done
 // subclass and implement:
@@ -28,8 +34,19 @@ class JobQueue;
 // OnCancel: optional. called from the main thread to tell the job that its
 //           results are not wanted. it should arrange for OnRun to return
 //           as quickly as possible. OnFinish will not be called for the job
+//
+// Jobs can be given a priority before they are queued. Runners always take
+// the highest priority job available, either from their own queue or by
+// stealing from another runner.
 class Job {
 public:
+	enum Priority {
+		PRIORITY_LOW, // speculative work, e.g. prefetching sectors
+		PRIORITY_NORMAL,
+		PRIORITY_HIGH, // work the player is waiting on, e.g. nearby terrain
+		NUM_PRIORITIES
+	};
+
 	// This is the RAII handle for a queued Job. A job is cancelled when the
 	// Job::Handle is destroyed. There is at most one Job::Handle for each Job
 	// (non-queued Jobs have no handle). Job::Handle is not copyable only
@@ -72,6 +89,7 @@ public:
 public:
 	Job() :
 		cancelled(false),
+		m_priority(PRIORITY_NORMAL),
 		m_handle(nullptr) {}
 	virtual ~Job();
 
@@ -82,7 +100,12 @@ public:
 	virtual void OnFinish() = 0;
 	virtual void OnCancel() {}
 
+	// only takes effect if called before the job is queued
+	void SetPriority(Priority priority) { m_priority = priority; }
+	Priority GetPriority() const { return m_priority; }
+
 private:
+	friend class JobQueue;
 	friend class AsyncJobQueue;
 	friend class SyncJobQueue;
 	friend class JobRunner;
@@ -93,6 +116,8 @@ private:
 	void ClearHandle() { m_handle = nullptr; }
 
 	bool cancelled;
+	Priority m_priority;
+	std::chrono::steady_clock::time_point m_queuedTime;
 	Handle *m_handle;
 };
 
@@ -100,7 +125,7 @@ private:
 // jobs do it. it will take care of the rest
 class JobQueue {
 public:
-	JobQueue() = default;
+	JobQueue();
 	JobQueue(const JobQueue &) = delete;
 	JobQueue &operator=(const JobQueue &) = delete;
 
@@ -128,10 +153,52 @@ public:
 	// and then delete all finished and cancelled jobs. returns the number of
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() = 0;
+
+	// per-queue performance counters: jobs queued, run and stolen this
+	// frame, time spent waiting in the queue and running (in microseconds)
+	// and the number of jobs still waiting. call FlushFrame() on the stats
+	// from the main thread once per frame
+	Perf::Stats &GetStats() { return m_stats; }
+	const Perf::Stats &GetStats() const { return m_stats; }
+
+	// number of threads that can pick up tasks besides the caller
+	virtual Uint32 GetNumRunners() const { return 0; }
+
+protected:
+	friend class TaskGroup;
+
+	// queue a task for a TaskGroup. the default implementation has no
+	// threads of its own, so it just runs the task on the calling thread
+	virtual void QueueTask(TaskGroup *group, std::function<void()> task);
+
+	// run one queued task (from any group) on the calling thread. returns
+	// false if there was nothing to run
+	virtual bool RunTask() { return false; }
+
+	// helpers for implementations to keep the counters up to date. these
+	// are safe to call from any thread
+	void StatJobQueued(Job *job);
+	void StatJobStarted(Job *job);
+	void StatJobFinished(Job *job, std::chrono::steady_clock::time_point started);
+	void StatJobStolen() const { m_stats.CounterAdd(m_statStolen); }
+	void StatSetPending(Uint32 pending) const { m_stats.CounterSet(m_statPending, pending); }
+
+private:
+	Perf::Stats m_stats;
+	Perf::Stats::CounterRef m_statQueued;
+	Perf::Stats::CounterRef m_statRun;
+	Perf::Stats::CounterRef m_statStolen;
+	Perf::Stats::CounterRef m_statWaitTime;
+	Perf::Stats::CounterRef m_statRunTime;
+	Perf::Stats::CounterRef m_statPending;
 };
 
 // the queue management class. create one from the main thread, and feed your
 // jobs do it. it will take care of the rest
+//
+// each runner has its own set of queues (one per priority). new jobs are
+// handed out round-robin, and a runner that runs dry steals from the others,
+// so the runners don't all contend on a single lock.
 class AsyncJobQueue : public JobQueue {
 public:
 	// numRunners is the number of jobs to run in parallel. right now its the
@@ -160,6 +227,12 @@ public:
 	// finished jobs (not cancelled)
 	virtual Uint32 FinishJobs() override;
 
+	virtual Uint32 GetNumRunners() const override { return m_numRunners; }
+
+protected:
+	virtual void QueueTask(TaskGroup *group, std::function<void()> task) override;
+	virtual bool RunTask() override;
+
 private:
 	// a runner wraps a single thread, and calls into the queue when its ready for
 	// a new job. no user-servicable parts inside!
@@ -187,10 +260,39 @@ private:
 		bool m_queueDestroyed;
 	};
 
-	Job *GetJob();
+	// the jobs waiting to be run by a single runner
+	struct RunnerQueue {
+		std::deque<Job *> jobs[Job::NUM_PRIORITIES];
+		// number of jobs in each deque, so other runners can skip empty
+		// queues without taking the lock
+		std::atomic<Uint32> count[Job::NUM_PRIORITIES];
+		SDL_mutex *lock;
+	};
+
+	Job *GetJob(const uint8_t threadIdx);
+	Job *TakeJob(const uint8_t threadIdx, const uint8_t victimIdx, const int priority);
 	void Finish(Job *job, const uint8_t threadIdx);
 
-	std::deque<Job *> m_queue;
+	// fixed at construction, so runners can use it while the others are still starting
+	const Uint32 m_numRunners;
+	RunnerQueue m_queues[MAX_THREADS];
+	Uint32 m_nextQueue;
+
+	// total number of queued jobs across all runners
+	std::atomic<Uint32> m_numQueued;
+
+	// fork/join tasks. these always go before jobs, as someone is blocked
+	// waiting for them to complete
+	struct Task {
+		TaskGroup *group;
+		std::function<void()> fn;
+	};
+	std::deque<Task> m_tasks;
+	std::atomic<Uint32> m_numTasks;
+	SDL_mutex *m_taskLock;
+
+	// idle runners sleep on this until there's work or we're shutting down
+	std::atomic<Uint32> m_numSleeping;
 	SDL_mutex *m_queueLock;
 	SDL_cond *m_queueWaitCond;
 
@@ -199,7 +301,7 @@ private:
 
 	std::vector<JobRunner *> m_runners;
 
-	bool m_shutdown;
+	std::atomic<bool> m_shutdown;
 };
 
 class SyncJobQueue : public JobQueue {
@@ -235,6 +337,51 @@ private:
 	std::deque<Job *> m_finished;
 };
 
+// a batch of short tasks to be run in parallel within the current frame.
+// unlike jobs, tasks have no handle and can't be cancelled: Wait() blocks
+// until every task added to the group has run, running queued tasks on the
+// calling thread while it waits. tasks may be added from any thread,
+// including from inside another task. if a task throws, the rest still
+// run and Wait() rethrows the first exception.
+//
+//   TaskGroup group(Pi::GetAsyncJobQueue());
+//   group.Run([&]() { DoSomething(); });
+//   group.Run([&]() { DoSomethingElse(); });
+//   group.Wait();
+class TaskGroup {
+public:
+	// queue may be null, in which case tasks are run immediately
+	explicit TaskGroup(JobQueue *queue);
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup &) = delete;
+	TaskGroup &operator=(const TaskGroup &) = delete;
+
+	void Run(std::function<void()> task);
+	void Wait();
+
+private:
+	friend class JobQueue;
+	friend class AsyncJobQueue;
+
+	void RunTask(const std::function<void()> &task);
+	void WaitForTasks();
+
+	JobQueue *m_queue;
+	// changed under m_lock, so that the last task can't finish between a
+	// waiter checking it and going to sleep
+	std::atomic<Uint32> m_pending;
+	SDL_mutex *m_lock;
+	SDL_cond *m_doneCond;
+	std::exception_ptr m_exception;
+};
+
+// call fn(chunkBegin, chunkEnd) over [begin, end) split into chunks of at
+// least grainSize items, using the queue's runners and the calling thread.
+// returns once every chunk has been processed. fn must be safe to call
+// concurrently on disjoint ranges
+void ParallelFor(JobQueue *queue, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)> &fn);
+
 class JobClient {
 public:
 	virtual void Order(Job *job) = 0;
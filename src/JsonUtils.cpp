@@ -9,6 +9,7 @@
 #include "FileSystem.h"
 #include "base64/base64.hpp"
 #include "core/GZipFormat.h"
+#include "core/SaveFileFormat.h"
 #include "utils.h"
 #include <cmath>
 
@@ -79,6 +80,14 @@ namespace JsonUtils {
 	{
 		auto file = source.ReadFile(filename);
 		if (!file) return nullptr;
+		if (savefile::IsSaveFileFormat(file->GetData(), file->GetSize())) {
+			try {
+				return savefile::Reader(file->GetData(), file->GetSize()).ReadAll();
+			} catch (const savefile::FormatError &e) {
+				Output("error in save file '%s': %s\n", file->GetInfo().GetPath().c_str(), e.what());
+				return nullptr;
+			}
+		}
 		const auto file_data = std::string(file->GetData(), file->GetSize());
 		const unsigned char *dataPtr = reinterpret_cast<const unsigned char *>(&file_data[0]);
 		try {
@@ -27,7 +27,8 @@ namespace JsonUtils {
 	// Load a JSON file from the game's data sources, optionally applying all
 	// files with the the name <filename>.patch as Json Merge Patch (RFC 7386) files
 	Json LoadJsonDataFile(const std::string &filename, bool with_merge = true);
-	// Loads an optionally-gzipped, optionally-CBOR encoded JSON file from the specified source.
+	// Loads a sectioned save file, or an optionally-gzipped, optionally-CBOR
+	// encoded JSON file, from the specified source.
 	Json LoadJsonSaveFile(const std::string &filename, FileSystem::FileSource &source);
 } // namespace JsonUtils
 
@@ -26,6 +26,7 @@ Missile::Missile(const ShipType::Id &shipId, Body *owner, int power)
 		m_power = power;
 
 	m_owner = owner;
+	AddBodyRef(m_owner);
 	m_type = &ShipType::types[shipId];
 
 	SetMass(m_type->hullMass * 1000);
@@ -93,6 +94,7 @@ void Missile::PostLoadFixup(Space *space)
 {
 	DynamicBody::PostLoadFixup(space);
 	m_owner = space->GetBodyByIndex(m_ownerIndex);
+	AddBodyRef(m_owner);
 	if (m_curAICmd) m_curAICmd->PostLoadFixup(space);
 }
 
@@ -131,13 +133,17 @@ void Missile::StaticUpdate(const float timeStep)
 	}
 }
 
-void Missile::TimeStepUpdate(const float timeStep)
+void Missile::Integrate(const float timeStep)
 {
-
 	const vector3d thrust = GetPropulsion()->GetActualLinThrust();
 	AddRelForce(thrust);
 	AddRelTorque(GetPropulsion()->GetActualAngThrust());
 
+	DynamicBody::Integrate(timeStep);
+}
+
+void Missile::TimeStepUpdate(const float timeStep)
+{
 	DynamicBody::TimeStepUpdate(timeStep);
 	GetPropulsion()->UpdateFuel(timeStep);
 
@@ -249,10 +255,15 @@ void Missile::Render(Graphics::Renderer *renderer, const Camera *camera, const v
 {
 	if (IsDead()) return;
 
-	GetPropulsion()->Render(renderer, camera, viewCoords, viewTransform);
+	PrepareModelRender(viewTransform);
 	RenderModel(renderer, camera, viewCoords, viewTransform);
 }
 
+void Missile::PrepareModelRender(const matrix4x4d &viewTransform)
+{
+	GetPropulsion()->SetModelThrust();
+}
+
 void Missile::AIKamikaze(Body *target)
 {
 	//AIClearInstructions();
@@ -17,12 +17,14 @@ public:
 	Missile(const Json &jsonObj, Space *space);
 	virtual ~Missile();
 	void StaticUpdate(const float timeStep) override;
+	void Integrate(const float timeStep) override;
 	void TimeStepUpdate(const float timeStep) override;
 	virtual bool OnCollision(Body *o, Uint32 flags, double relVel) override;
 	virtual bool OnDamage(Body *attacker, float kgDamage, const CollisionContact &contactData) override;
 	virtual void NotifyRemoved(const Body *const removedBody) override;
 	virtual void PostLoadFixup(Space *space) override;
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	virtual void PrepareModelRender(const matrix4x4d &viewTransform) override;
 	void ECMAttack(int power_val);
 	Body *GetOwner() const { return m_owner; }
 	bool IsArmed() const { return m_armed; }
@@ -0,0 +1,125 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ModelBatches.h"
+
+#include "Camera.h"
+#include "ModelBody.h"
+#include "graphics/Renderer.h"
+#include "profiler/Profiler.h"
+#include "scenegraph/Model.h"
+
+static bool SameLights(const std::vector<Graphics::Light> &a, const std::vector<Graphics::Light> &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].GetType() != b[i].GetType() || !(a[i].GetPosition() == b[i].GetPosition()) ||
+			a[i].GetDiffuse() != b[i].GetDiffuse() || a[i].GetSpecular() != b[i].GetSpecular())
+			return false;
+	}
+	return true;
+}
+
+bool ModelBatches::Add(Body *body, const vector3d &viewCoords, const matrix4x4d &viewTransform)
+{
+	if (!body->IsType(ObjectType::MODELBODY))
+		return false;
+	ModelBody *modelBody = static_cast<ModelBody *>(body);
+	if (!modelBody->GetModel() || !modelBody->CanBatchModel())
+		return false;
+
+	m_entries.push_back({ modelBody, viewCoords, viewTransform, modelBody->CalcModelTransform(viewCoords, viewTransform), 0 });
+	return true;
+}
+
+void ModelBatches::Flush(Graphics::Renderer *r, const Camera *camera)
+{
+	if (m_entries.empty())
+		return;
+	PROFILE_SCOPED()
+
+	// group the bodies by model and lighting. there are only ever a few
+	// kinds of model in view, so a search is fine
+	m_numBatches = 0;
+	if (m_entries.size() > 1) {
+		for (size_t i = 0; i < m_entries.size(); i++) {
+			Color ambient;
+			m_entries[i].body->CalcModelLights(camera, m_lights, ambient);
+			const SceneGraph::Model *model = m_entries[i].body->GetModel();
+
+			size_t b = 0;
+			for (; b < m_numBatches; b++) {
+				const Batch &batch = m_batches[b];
+				if (batch.ambient == ambient && SameLights(batch.lights, m_lights) &&
+					model->CanBatchWith(m_entries[batch.entries[0]].body->GetModel()))
+					break;
+			}
+			if (b == m_numBatches) {
+				if (m_numBatches == m_batches.size())
+					m_batches.emplace_back();
+				m_batches[b].lights = m_lights;
+				m_batches[b].ambient = ambient;
+				m_batches[b].entries.clear();
+				m_numBatches++;
+			}
+			m_batches[b].entries.push_back(i);
+			m_entries[i].batch = b;
+		}
+	}
+
+	for (size_t b = 0; b < m_numBatches; b++) {
+		if (m_batches[b].entries.size() > 1)
+			DrawBatch(r, camera, m_batches[b]);
+	}
+
+	// now the rest of each body, in the order they were added; a body
+	// that wasn't batched draws its model here too, with the lights it was
+	// grouped by rather than working them out again
+	for (Entry &e : m_entries) {
+		if (m_numBatches > 0)
+			e.body->SetModelLights(&m_batches[e.batch].lights, m_batches[e.batch].ambient);
+		e.body->Render(r, camera, e.viewCoords, e.viewTransform);
+		e.body->SetModelBatched(false);
+		e.body->SetModelLights(nullptr, Color());
+	}
+	m_entries.clear();
+}
+
+void ModelBatches::DrawBatch(Graphics::Renderer *r, const Camera *camera, const Batch &batch)
+{
+	PROFILE_SCOPED()
+	const Color oldAmbient = r->GetAmbientColor();
+	r->SetAmbientColor(batch.ambient);
+	r->SetLights(batch.lights.size(), &batch.lights[0]);
+
+	// as Model::Render, solids first
+	const unsigned int passes[] = { SceneGraph::NODE_SOLID, SceneGraph::NODE_TRANSPARENT };
+	for (unsigned int pass : passes) {
+		m_instanceBatch.Begin();
+		for (size_t i : batch.entries) {
+			const Entry &e = m_entries[i];
+			e.body->PrepareModelRender(e.viewTransform);
+			e.body->GetModel()->RenderBatched(e.modelTransform, pass, &m_instanceBatch);
+		}
+		m_instanceBatch.Draw();
+
+		// labels, thrusters and submodels, one instance at a time
+		for (size_t i : batch.entries) {
+			const Entry &e = m_entries[i];
+			e.body->GetModel()->RenderBatched(e.modelTransform, pass, &m_instanceBatch);
+		}
+	}
+
+	for (size_t i : batch.entries)
+		m_entries[i].body->SetModelBatched(true);
+
+	// back to the camera's lights, as ModelBody::ResetLighting
+	std::vector<Graphics::Light> &lights = m_lights;
+	lights.clear();
+	for (const Camera::LightSource &light : camera->GetLightSources())
+		lights.push_back(light.GetLight());
+	if (!lights.empty())
+		r->SetLights(lights.size(), &lights[0]);
+	r->SetAmbientColor(oldAmbient);
+}
@@ -0,0 +1,59 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _MODELBATCHES_H
+#define _MODELBATCHES_H
+
+#include "graphics/Light.h"
+#include "scenegraph/InstanceBatch.h"
+#include "vector3.h"
+#include <vector>
+
+class Body;
+class Camera;
+class ModelBody;
+
+namespace Graphics {
+	class Renderer;
+}
+
+// Draws the models of bodies that Camera::Draw() goes through one after
+// the other together: those with the same model (and pattern and decals),
+// lit the same, are drawn instanced, one draw per mesh for the lot. The
+// bodies are then rendered as usual for everything but their model.
+//
+// Bodies are only held until the next Flush(), which the camera does
+// before drawing anything that isn't added, so the order things are drawn
+// in only changes among the added bodies.
+class ModelBatches {
+public:
+	// false if the body has to be drawn on its own
+	bool Add(Body *body, const vector3d &viewCoords, const matrix4x4d &viewTransform);
+	void Flush(Graphics::Renderer *r, const Camera *camera);
+
+private:
+	struct Entry {
+		ModelBody *body;
+		vector3d viewCoords;
+		matrix4x4d viewTransform;
+		matrix4x4f modelTransform;
+		size_t batch; // only set when there's more than one entry
+	};
+
+	struct Batch {
+		std::vector<Graphics::Light> lights;
+		Color ambient;
+		std::vector<size_t> entries;
+	};
+
+	void DrawBatch(Graphics::Renderer *r, const Camera *camera, const Batch &batch);
+
+	std::vector<Entry> m_entries;
+	// kept between flushes so the vectors are reused
+	std::vector<Batch> m_batches;
+	size_t m_numBatches = 0;
+	std::vector<Graphics::Light> m_lights;
+	SceneGraph::InstanceBatch m_instanceBatch;
+};
+
+#endif
@@ -67,14 +67,18 @@ ModelBody::ModelBody() :
 	m_isStatic(false),
 	m_colliding(true),
 	m_geom(nullptr),
-	m_model(nullptr)
+	m_model(nullptr),
+	m_modelBatched(false),
+	m_modelLights(nullptr)
 {
 }
 
 ModelBody::ModelBody(const Json &jsonObj, Space *space) :
 	Body(jsonObj, space),
 	m_geom(nullptr),
-	m_model(nullptr)
+	m_model(nullptr),
+	m_modelBatched(false),
+	m_modelLights(nullptr)
 {
 	Json modelBodyObj = jsonObj["model_body"];
 
@@ -272,15 +276,15 @@ void ModelBody::MoveGeoms(const matrix4x4d &m, const vector3d &p)
 
 	for (auto it = m_dynGeoms.begin(); it != m_dynGeoms.end(); ++it) {
 		//combine orient & pos
-		static matrix4x4d s_tempMat;
+		matrix4x4d tempMat;
 		for (unsigned int i = 0; i < 12; i++)
-			s_tempMat[i] = m[i];
-		s_tempMat[12] = p.x;
-		s_tempMat[13] = p.y;
-		s_tempMat[14] = p.z;
-		s_tempMat[15] = m[15];
+			tempMat[i] = m[i];
+		tempMat[12] = p.x;
+		tempMat[13] = p.y;
+		tempMat[14] = p.z;
+		tempMat[15] = m[15];
 
-		(*it)->MoveTo(s_tempMat * (*it)->m_animTransform);
+		(*it)->MoveTo(tempMat * (*it)->m_animTransform);
 	}
 }
 
@@ -389,17 +393,35 @@ void ModelBody::CalcLighting(double &ambient, double &direct, const Camera *came
 // should be reset after rendering with ModelBody::ResetLighting.
 void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::vector<Graphics::Light> &oldLights, Color &oldAmbient)
 {
+	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
+	oldLights.reserve(lightSources.size());
+	for (size_t i = 0; i < lightSources.size(); i++)
+		oldLights.push_back(lightSources[i].GetLight());
+
+	const std::vector<Graphics::Light> *lights = m_modelLights;
+	Color ambient = m_modelAmbient;
 	std::vector<Graphics::Light> newLights;
+	if (!lights) {
+		CalcModelLights(camera, newLights, ambient);
+		lights = &newLights;
+	}
+
+	oldAmbient = r->GetAmbientColor();
+	r->SetAmbientColor(ambient);
+	r->SetLights(lights->size(), &(*lights)[0]);
+}
+
+// the lights (and ambient light) the model is lit by, for SetLighting
+void ModelBody::CalcModelLights(const Camera *camera, std::vector<Graphics::Light> &newLights, Color &ambientColor)
+{
 	double ambient, direct;
 	CalcLighting(ambient, direct, camera);
 	const std::vector<Camera::LightSource> &lightSources = camera->GetLightSources();
+	newLights.clear();
 	newLights.reserve(lightSources.size());
-	oldLights.reserve(lightSources.size());
 	for (size_t i = 0; i < lightSources.size(); i++) {
 		Graphics::Light light(lightSources[i].GetLight());
 
-		oldLights.push_back(light);
-
 		const float intensity = direct * camera->ShadowedIntensity(i, this);
 
 		Color c = light.GetDiffuse();
@@ -421,9 +443,7 @@ void ModelBody::SetLighting(Graphics::Renderer *r, const Camera *camera, std::ve
 		newLights.push_back(Graphics::Light(Graphics::Light::LIGHT_DIRECTIONAL, vector3f(0.f), Color::WHITE, Color::WHITE));
 	}
 
-	oldAmbient = r->GetAmbientColor();
-	r->SetAmbientColor(Color(ambient * 255, ambient * 255, ambient * 255));
-	r->SetLights(newLights.size(), &newLights[0]);
+	ambientColor = Color(ambient * 255, ambient * 255, ambient * 255);
 }
 
 void ModelBody::ResetLighting(Graphics::Renderer *r, const std::vector<Graphics::Light> &oldLights, const Color &oldAmbient)
@@ -434,13 +454,8 @@ void ModelBody::ResetLighting(Graphics::Renderer *r, const std::vector<Graphics:
 	r->SetAmbientColor(oldAmbient);
 }
 
-void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting)
+matrix4x4f ModelBody::CalcModelTransform(const vector3d &viewCoords, const matrix4x4d &viewTransform) const
 {
-	std::vector<Graphics::Light> oldLights;
-	Color oldAmbient;
-	if (setLighting)
-		SetLighting(r, camera, oldLights, oldAmbient);
-
 	matrix4x4d m2 = GetInterpOrient();
 	m2.SetTranslate(GetInterpPosition());
 	matrix4x4d t = viewTransform * m2;
@@ -453,8 +468,21 @@ void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const v
 	trans[13] = viewCoords.y;
 	trans[14] = viewCoords.z;
 	trans[15] = 1.0f;
+	return trans;
+}
+
+void ModelBody::RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting)
+{
+	// already drawn with others of its kind
+	if (m_modelBatched)
+		return;
+
+	std::vector<Graphics::Light> oldLights;
+	Color oldAmbient;
+	if (setLighting)
+		SetLighting(r, camera, oldLights, oldAmbient);
 
-	m_model->Render(trans);
+	m_model->Render(CalcModelTransform(viewCoords, viewTransform));
 
 	if (setLighting)
 		ResetLighting(r, oldLights, oldAmbient);
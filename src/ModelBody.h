@@ -46,6 +46,23 @@ public:
 
 	void RenderModel(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform, const bool setLighting = true);
 
+	// for drawing the models of several bodies together (see ModelBatches).
+	// a body can be batched if its model doesn't depend on anything set up
+	// per body but the lights, and PrepareModelRender() sets up the rest
+	virtual bool CanBatchModel() const { return !IsDead(); }
+	virtual void PrepareModelRender(const matrix4x4d &viewTransform) {}
+	matrix4x4f CalcModelTransform(const vector3d &viewCoords, const matrix4x4d &viewTransform) const;
+	void CalcModelLights(const Camera *camera, std::vector<Graphics::Light> &lights, Color &ambient);
+	// set while the model has been drawn in a batch, so RenderModel() skips it
+	void SetModelBatched(bool batched) { m_modelBatched = batched; }
+	// lights already worked out by CalcModelLights() for the next
+	// RenderModel(), or null for it to work them out itself
+	void SetModelLights(const std::vector<Graphics::Light> *lights, const Color &ambient)
+	{
+		m_modelLights = lights;
+		m_modelAmbient = ambient;
+	}
+
 	virtual void TimeStepUpdate(const float timeStep) override;
 
 protected:
@@ -74,6 +91,9 @@ private:
 	std::vector<Geom *> m_dynGeoms;
 	SceneGraph::Animation *m_idleAnimation;
 	std::unique_ptr<Shields> m_shields;
+	bool m_modelBatched;
+	const std::vector<Graphics::Light> *m_modelLights;
+	Color m_modelAmbient;
 };
 
 #endif /* _MODELBODY_H */
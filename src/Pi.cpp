@@ -17,6 +17,8 @@
 #include "GameConfig.h"
 #include "GameLog.h"
 #include "GameSaveError.h"
+#include "GeoPatchContext.h"
+#include "GeoPatchDiskCache.h"
 #include "Intro.h"
 #include "Lang.h"
 #include "Missile.h"
@@ -62,6 +64,7 @@
 #include "ship/ShipViewController.h"
 #include "sound/Sound.h"
 #include "sound/SoundMusic.h"
+#include "terrain/TerrainHeightCache.h"
 
 #include "graphics/Renderer.h"
 
@@ -421,6 +424,9 @@ void Pi::App::Shutdown()
 
 	// This function should only be called at the very end of the shutdown procedure.
 	assert(Pi::game == nullptr);
+	// let any background save finish writing before the workers go away
+	Game::FinishSaves();
+
 	if (Pi::ffmpegFile != nullptr) {
 		_pclose(Pi::ffmpegFile);
 	}
@@ -870,6 +876,13 @@ void Pi::App::RunJobs()
 	Pi::syncJobQueue->RunJobs(SYNC_JOBS_PER_LOOP);
 	Pi::asyncJobQueue->FinishJobs();
 	Pi::syncJobQueue->FinishJobs();
+	Pi::asyncJobQueue->GetStats().FlushFrame();
+	Pi::syncJobQueue->GetStats().FlushFrame();
+	GeoPatchContext::GetBufferPool().GetStats().FlushFrame();
+	GeoPatchDiskCache::GetStats().FlushFrame();
+	TerrainHeightCache::GetStats().FlushFrame();
+	if (Pi::game)
+		Pi::game->GetGalaxy()->GetStats().FlushFrame();
 }
 
 // FIXME: delete/move this function out of Pi.cpp
@@ -111,12 +111,14 @@ void Projectile::FreeModel()
 }
 
 Projectile::Projectile(Body *parent, const ProjectileData &prData, const vector3d &pos, const vector3d &baseVel, const vector3d &dirVel) :
-	Body()
+	Body(),
+	m_contactValid(false)
 {
 	if (!s_sideMat) BuildModel();
 	m_flags |= FLAG_DRAW_LAST;
 
 	m_parent = parent;
+	AddBodyRef(m_parent);
 	m_lifespan = prData.lifespan;
 	m_baseDam = prData.damage;
 	m_length = prData.length;
@@ -136,7 +138,8 @@ Projectile::Projectile(Body *parent, const ProjectileData &prData, const vector3
 }
 
 Projectile::Projectile(const Json &jsonObj, Space *space) :
-	Body(jsonObj, space)
+	Body(jsonObj, space),
+	m_contactValid(false)
 {
 	if (!s_sideMat) BuildModel();
 
@@ -186,6 +189,7 @@ void Projectile::PostLoadFixup(Space *space)
 {
 	Body::PostLoadFixup(space);
 	m_parent = space->GetBodyByIndex(m_parentIndex);
+	AddBodyRef(m_parent);
 }
 
 void Projectile::UpdateInterpTransform(double alpha)
@@ -253,14 +257,57 @@ void MiningLaserSpawnTastyStuff(FrameId fId, const SystemBody *asteroid, const v
 	Pi::game->GetSpace()->AddBody(cargo);
 }
 
+void Projectile::TraceRays(const std::vector<Projectile *> &projectiles, float timeStep)
+{
+	PROFILE_SCOPED()
+	if (projectiles.empty()) return;
+
+	// group them by frame, as each frame has its own collision space
+	std::vector<Projectile *> sorted(projectiles);
+	std::sort(sorted.begin(), sorted.end(), [](const Projectile *a, const Projectile *b) {
+		return a->GetFrame().id() < b->GetFrame().id();
+	});
+
+	std::vector<CollisionRay> rays;
+	std::vector<CollisionContact> contacts;
+	for (size_t first = 0; first < sorted.size();) {
+		const FrameId frameId = sorted[first]->GetFrame();
+		size_t end = first;
+		rays.clear();
+		for (; end < sorted.size() && sorted[end]->GetFrame() == frameId; end++) {
+			// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
+			const vector3d vel = sorted[end]->m_dirVel * timeStep;
+			CollisionRay ray;
+			ray.start = sorted[end]->GetPosition();
+			ray.dir = vel.Normalized();
+			ray.len = vel.Length();
+			ray.ignore = nullptr;
+			rays.push_back(ray);
+		}
+
+		contacts.resize(rays.size());
+		Frame::GetFrame(frameId)->GetCollisionSpace()->TraceRays(rays.size(), &rays[0], &contacts[0]);
+		for (size_t i = first; i < end; i++) {
+			sorted[i]->m_contact = contacts[i - first];
+			sorted[i]->m_contactValid = true;
+		}
+		first = end;
+	}
+}
+
 void Projectile::StaticUpdate(const float timeStep)
 {
 	PROFILE_SCOPED()
 	CollisionContact c;
-	// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
-	vector3d vel = m_dirVel * timeStep;
 	Frame *frame = Frame::GetFrame(GetFrame());
-	frame->GetCollisionSpace()->TraceRay(GetPosition(), vel.Normalized(), vel.Length(), &c);
+	if (m_contactValid) {
+		c = m_contact;
+		m_contactValid = false;
+	} else {
+		// Collision spaces don't store velocity, so dirvel-only is still wrong but less awful than dirvel+basevel
+		vector3d vel = m_dirVel * timeStep;
+		frame->GetCollisionSpace()->TraceRay(GetPosition(), vel.Normalized(), vel.Length(), &c);
+	}
 
 	if (c.userData1) {
 		Body *hit = static_cast<Body *>(c.userData1);
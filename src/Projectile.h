@@ -5,6 +5,7 @@
 #define _PROJECTILE_H
 
 #include "Body.h"
+#include "collider/CollisionContact.h"
 
 struct ProjectileData {
 	ProjectileData() :
@@ -55,6 +56,10 @@ public:
 
 	static void FreeModel();
 
+	// trace the paths the projectiles will take this step together, one
+	// batch per collision space. their StaticUpdate() then uses the result
+	static void TraceRays(const std::vector<Projectile *> &projectiles, float timeStep);
+
 protected:
 	virtual void SaveToJson(Json &jsonObj, Space *space) override final;
 
@@ -74,6 +79,10 @@ private:
 
 	int m_parentIndex; // deserialisation
 
+	// from TraceRays(), used and cleared by the next StaticUpdate()
+	CollisionContact m_contact;
+	bool m_contactValid;
+
 	static void BuildModel();
 
 	static std::unique_ptr<Graphics::VertexArray> s_sideVerts;
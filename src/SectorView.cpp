@@ -15,6 +15,8 @@
 #include "StringF.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/GalaxyCache.h"
+#include "galaxy/GalaxyPrefetcher.h"
+#include "galaxy/RoutePlanner.h"
 #include "galaxy/Sector.h"
 #include "galaxy/StarSystem.h"
 #include "graphics/Graphics.h"
@@ -27,7 +29,7 @@
 #include "utils.h"
 #include <algorithm>
 #include <sstream>
-#include <unordered_set>
+#include <memory>
 
 using namespace Graphics;
 
@@ -46,6 +48,8 @@ enum DetailSelection {
 
 static const float ZOOM_SPEED = 15;
 static const float WHEEL_SENSITIVITY = .03f; // Should be a variable in user settings.
+static const float PREFETCH_LOOKAHEAD = 1.0f; // seconds
+static const size_t PREFETCH_ROUTE_SYSTEMS = 3;
 
 REGISTER_INPUT_BINDING(SectorView)
 {
@@ -119,6 +123,7 @@ SectorView::SectorView(Game *game) :
 
 	GotoSystem(m_current);
 	m_pos = m_posMovingTo;
+	m_prefetchLastPos = m_pos;
 
 	m_automaticSystemSelection = true;
 	m_detailBoxVisible = DETAILBOX_INFO;
@@ -180,10 +185,13 @@ void SectorView::InitDefaults()
 	m_cacheYMax = 0;
 
 	m_sectorCache = m_galaxy->NewSectorSlaveCache();
+	m_prefetcher.reset(new GalaxyPrefetcher(m_galaxy));
 	InputBindings.RegisterBindings();
 
 	m_drawRouteLines = true; // where should this go?!
 	m_route = std::vector<SystemPath>();
+	m_prefetchRouteChanged = true;
+	m_prefetchJumpRadius = 0.0f;
 }
 
 void SectorView::InitObject()
@@ -635,6 +643,7 @@ bool SectorView::MoveRouteItemUp(const std::vector<SystemPath>::size_type elemen
 	std::swap(m_route[element - 1], m_route[element]);
 
 	m_setupRouteLines = true;
+	m_prefetchRouteChanged = true;
 	return true;
 }
 
@@ -645,6 +654,7 @@ bool SectorView::MoveRouteItemDown(const std::vector<SystemPath>::size_type elem
 	std::swap(m_route[element + 1], m_route[element]);
 
 	m_setupRouteLines = true;
+	m_prefetchRouteChanged = true;
 	return true;
 }
 
@@ -652,12 +662,14 @@ void SectorView::UpdateRouteItem(const std::vector<SystemPath>::size_type elemen
 {
 	m_route[element] = path;
 	m_setupRouteLines = true;
+	m_prefetchRouteChanged = true;
 }
 
 void SectorView::AddToRoute(const SystemPath &path)
 {
 	m_route.push_back(path);
 	m_setupRouteLines = true;
+	m_prefetchRouteChanged = true;
 }
 
 bool SectorView::RemoveRouteItem(const std::vector<SystemPath>::size_type element)
@@ -665,6 +677,7 @@ bool SectorView::RemoveRouteItem(const std::vector<SystemPath>::size_type elemen
 	if (element < m_route.size()) {
 		m_route.erase(m_route.begin() + element);
 		m_setupRouteLines = true;
+		m_prefetchRouteChanged = true;
 		return true;
 	} else {
 		return false;
@@ -675,6 +688,7 @@ void SectorView::ClearRoute()
 {
 	m_route.clear();
 	m_setupRouteLines = true;
+	m_prefetchRouteChanged = true;
 }
 
 std::vector<SystemPath> SectorView::GetRoute()
@@ -682,7 +696,34 @@ std::vector<SystemPath> SectorView::GetRoute()
 	return m_route;
 }
 
-const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPath &target, std::vector<SystemPath> &outRoute) const
+// runs the search on a job thread, with everything it needs from the galaxy
+// and Lua collected beforehand
+class SectorView::AutoRouteJob : public Job {
+public:
+	AutoRouteJob(SectorView *view, RoutePlanner *planner) :
+		m_view(view),
+		m_planner(planner),
+		m_found(false) {}
+
+	virtual void OnRun() override
+	{
+		m_found = m_planner->FindRoute(m_route);
+	}
+
+	virtual void OnFinish() override
+	{
+		Output("SectorView::AutoRoute, systems visited = %lu\n", m_planner->GetNumVisited());
+		m_view->OnAutoRouteFinished(m_found, m_route);
+	}
+
+private:
+	SectorView *m_view;
+	std::unique_ptr<RoutePlanner> m_planner;
+	bool m_found;
+	std::vector<SystemPath> m_route;
+};
+
+const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPath &target)
 {
 	const RefCountedPtr<const Sector> start_sec = m_galaxy->GetSector(start);
 	const RefCountedPtr<const Sector> target_sec = m_galaxy->GetSector(target);
@@ -690,11 +731,13 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 	LuaRef try_hdrive = LuaObject<Player>::CallMethod<LuaRef>(Pi::player, "GetEquip", "engine", 1);
 	if (try_hdrive.IsNil())
 		return "NO_DRIVE";
-	// Get the player's hyperdrive from Lua, later used to calculate the duration between systems
+	// Get the player's hyperdrive from Lua, to find its range and how long jumps take
 	const ScopedTable hyperdrive = ScopedTable(try_hdrive);
-	// Cache max range so it doesn't get recalculated every time we call GetDuration
 	const float max_range = hyperdrive.CallMethod<float>("GetMaximumRange", Pi::player);
-	const float max_range_sqr = max_range * max_range;
+	// the duration of a jump goes with the square of its length, so one call
+	// gives the cost of every jump rather than calling into Lua for each
+	const float max_range_duration = hyperdrive.CallMethod<float>("GetDuration", Pi::player, max_range, max_range);
+	const float cost_scale = max_range > 0.f ? max_range_duration / (max_range * max_range) : 0.f;
 
 	// use the square of the distance to avoid doing a sqrt for each sector
 	const float distSqr = Sector::DistanceBetweenSqr(start_sec, start.systemIndex, target_sec, target.systemIndex) * 1.10;
@@ -702,8 +745,11 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 	// the maximum distance that anything can be from the direct line between the start and target systems
 	const float max_dist_from_straight_line = (Sector::SIZE * 3);
 
-	// nodes[0] is always start
-	std::vector<SystemPath> nodes;
+	const vector3f start_pos = start_sec->m_systems[start.systemIndex].GetFullPosition();
+	const vector3f target_pos = target_sec->m_systems[target.systemIndex].GetFullPosition();
+
+	// nodes[0] is always start, and the target is added like any other system
+	std::vector<RoutePlanner::Node> nodes;
 	{
 		// calculate an approximate initial number of nodes
 		const float dist = sqrt(distSqr);
@@ -712,20 +758,19 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 		const size_t num_systems_per_sector = 6; // total guess
 		nodes.reserve(num_sectors_covered * num_systems_per_sector);
 	}
-	nodes.push_back(start);
+	nodes.push_back(RoutePlanner::Node(start, start_pos));
+	size_t target_index = start.IsSameSystem(target) ? 0 : SIZE_MAX;
 
 	const Sint32 minX = std::min(start.sectorX, target.sectorX) - 2, maxX = std::max(start.sectorX, target.sectorX) + 2;
 	const Sint32 minY = std::min(start.sectorY, target.sectorY) - 2, maxY = std::max(start.sectorY, target.sectorY) + 2;
 	const Sint32 minZ = std::min(start.sectorZ, target.sectorZ) - 2, maxZ = std::max(start.sectorZ, target.sectorZ) + 2;
-	const vector3f start_pos = start_sec->m_systems[start.systemIndex].GetFullPosition();
-	const vector3f target_pos = target_sec->m_systems[target.systemIndex].GetFullPosition();
 
 	// go sector by sector for the minimum cube of sectors and add systems
 	// if they are within 110% of dist of both start and target
 	size_t secLineToFar = 0u;
 	for (Sint32 sx = minX; sx <= maxX; sx++) {
 		for (Sint32 sy = minY; sy <= maxY; sy++) {
-			for (Sint32 sz = minZ; sz < maxZ; sz++) {
+			for (Sint32 sz = minZ; sz <= maxZ; sz++) {
 				const SystemPath sec_path = SystemPath(sx, sy, sz);
 
 				// early out here if the sector is too far from the direct line
@@ -740,15 +785,18 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 				// GetSector is very expensive if it's not in the cache
 				RefCountedPtr<const Sector> sec = m_galaxy->GetSector(sec_path);
 				for (std::vector<Sector::System>::size_type s = 0; s < sec->m_systems.size(); s++) {
-					if (start.IsSameSystem(sec->m_systems[s].GetPath()))
+					const Sector::System &sys = sec->m_systems[s];
+					if (start.IsSameSystem(sys.GetPath()))
 						continue; // start is already nodes[0]
 
-					const float lineDist = MathUtil::DistanceFromLine(start_pos, target_pos, sec->m_systems[s].GetFullPosition());
+					const float lineDist = MathUtil::DistanceFromLine(start_pos, target_pos, sys.GetFullPosition());
 
-					if (Sector::DistanceBetweenSqr(start_sec, start.systemIndex, sec, sec->m_systems[s].idx) <= distSqr &&
-						Sector::DistanceBetweenSqr(target_sec, target.systemIndex, sec, sec->m_systems[s].idx) <= distSqr &&
+					if (Sector::DistanceBetweenSqr(start_sec, start.systemIndex, sec, sys.idx) <= distSqr &&
+						Sector::DistanceBetweenSqr(target_sec, target.systemIndex, sec, sys.idx) <= distSqr &&
 						lineDist < max_dist_from_straight_line) {
-						nodes.push_back(sec->m_systems[s].GetPath());
+						if (target.IsSameSystem(sys.GetPath()))
+							target_index = nodes.size();
+						nodes.push_back(RoutePlanner::Node(sys.GetPath(), sys.GetFullPosition()));
 					}
 				}
 			}
@@ -756,96 +804,37 @@ const std::string SectorView::AutoRoute(const SystemPath &start, const SystemPat
 	}
 	Output("SectorView::AutoRoute, nodes to search = %lu, earlied out sector distance from line: %lu times.\n", nodes.size(), secLineToFar);
 
-	// setup inital values and set everything as unvisited
-	std::vector<float> path_dist;							   // distance from source to node
-	std::vector<std::vector<SystemPath>::size_type> path_prev; // previous node in optimal path
-	std::unordered_set<std::vector<SystemPath>::size_type> unvisited;
-	// we know how big these need to be, to reserve space up front
-	path_dist.reserve(nodes.size());
-	path_prev.reserve(nodes.size());
-	unvisited.reserve(nodes.size());
-	// initialise them
-	for (std::vector<SystemPath>::size_type i = 0; i < nodes.size(); i++) {
-		path_dist.push_back(INFINITY);
-		path_prev.push_back(0);
-		unvisited.insert(i);
+	// the target is always within the volume searched, but be safe
+	if (target_index == SIZE_MAX) {
+		target_index = nodes.size();
+		nodes.push_back(RoutePlanner::Node(target, target_pos));
 	}
 
-	// distance to the start is 0
-	path_dist[0] = 0.f;
-
-	size_t totalSkipped = 0u;
-	while (unvisited.size() > 0) {
-		// find the closest node (for the first loop this will be start)
-		std::vector<SystemPath>::size_type closest_i = *unvisited.begin();
-		for (auto it : unvisited) {
-			if (path_dist[it] < path_dist[closest_i])
-				closest_i = it;
-		}
-
-		// mark it as visited
-		unvisited.erase(closest_i);
-
-		// if this is the target then we have found the route
-		const SystemPath &closest = nodes[closest_i];
-		if (closest.IsSameSystem(target))
-			break;
-
-		RefCountedPtr<const Sector> closest_sec = m_galaxy->GetSector(closest);
-
-		// if not, loop through all unvisited nodes
-		// since every system is technically reachable from every other system
-		// everything is a neighbor :)
-		for (auto it : unvisited) {
-			const SystemPath &v = nodes[it];
-			// everything is a neighbor isn't quite true as the ship has a max_range for each jump!
-			if ((SystemPath::SectorDistanceSqr(closest, v) * Sector::SIZE) > max_range_sqr) {
-				++totalSkipped;
-				continue;
-			}
-
-			RefCountedPtr<const Sector> v_sec = m_galaxy->GetSector(v); // this causes it to generate a sector (slooooooow)
-
-			const float v_dist_ly = Sector::DistanceBetween(closest_sec, closest.systemIndex, v_sec, v.systemIndex);
-
-			// in this case, duration is used for the distance since that's what we are optimizing
-			float v_dist = hyperdrive.CallMethod<float>("GetDuration", Pi::player, v_dist_ly, max_range);
+	// replaces (and so cancels) any search still running
+	RoutePlanner *planner = new RoutePlanner(std::move(nodes), 0, target_index, max_range, cost_scale);
+	m_autoRouteResult.clear();
+	m_autoRouteJob = Pi::GetAsyncJobQueue()->Queue(new AutoRouteJob(this, planner));
+	return "SEARCHING";
+}
 
-			v_dist += path_dist[closest_i]; // we want the total duration from start to this node
-			if (v_dist < path_dist[it]) {
-				// if our calculated duration is less than a previous value, this path is more efficent
-				// so store/override it
-				path_dist[it] = v_dist;
-				path_prev[it] = closest_i;
-			}
-		}
+void SectorView::OnAutoRouteFinished(bool found, const std::vector<SystemPath> &route)
+{
+	if (!found) {
+		m_autoRouteResult = "NO_VALID_ROUTE";
+		return;
 	}
-	Output("SectorView::AutoRoute, total times that nodes were skipped = %lu\n", totalSkipped);
-
-	bool foundRoute = false;
-	std::vector<SystemPath>::size_type u = 0;
 
-	// find the index of our target
-	for (std::vector<SystemPath>::size_type i = 0, numNodes = nodes.size(); i < numNodes; i++) {
-		if (target.IsSameSystem(nodes[i])) {
-			u = i;
-			foundRoute = true;
-			break;
-		}
-	}
+	ClearRoute();
+	for (const SystemPath &path : route)
+		AddToRoute(m_galaxy->GetStarSystem(path)->GetStars()[0]->GetPath());
+	m_autoRouteResult = "OKAY";
+}
 
-	// It's posible that there is no valid route
-	if (foundRoute) {
-		outRoute.reserve(nodes.size());
-		// Build the route, in reverse starting with the target
-		while (u != 0) {
-			outRoute.push_back(m_galaxy->GetStarSystem(nodes[u])->GetStars()[0]->GetPath());
-			u = path_prev[u];
-		}
-		std::reverse(std::begin(outRoute), std::end(outRoute));
-		return "OKAY";
-	}
-	return "NO_VALID_ROUTE";
+std::string SectorView::TakeAutoRouteResult()
+{
+	std::string result;
+	result.swap(m_autoRouteResult);
+	return result;
 }
 
 void SectorView::DrawRouteLines(const matrix4x4f &trans)
@@ -1283,6 +1272,8 @@ void SectorView::Update()
 
 	m_playerHyperspaceRange = LuaObject<Player>::CallMethod<float>(Pi::player, "GetHyperspaceRange");
 
+	Prefetch(frameTime);
+
 	if (!m_jumpSphere) {
 		Graphics::RenderStateDesc rsd;
 		rsd.blendMode = Graphics::BLEND_ALPHA;
@@ -1350,6 +1341,60 @@ void SectorView::ShrinkCache()
 	}
 }
 
+// asks for the sectors the view is about to need before it needs them, so
+// panning and zooming don't stop to generate them: around where the camera
+// is heading, where it will be shortly at its current speed, and in jump
+// range of the next few stops on the route, whose systems are generated
+// too, for arriving in them
+void SectorView::Prefetch(float frameTime)
+{
+	PROFILE_SCOPED()
+	const vector3f velocity = frameTime > 0.0f ? (m_pos - m_prefetchLastPos) / frameTime : vector3f(0.0f);
+	m_prefetchLastPos = m_pos;
+	// jumping straight to a far away system looks very fast for a frame,
+	// so don't look further ahead than one view's worth
+	vector3f ahead = velocity * PREFETCH_LOOKAHEAD;
+
+	// when zooming out, what will be drawn once it has
+	const float zoom = Clamp(std::max(m_zoom, m_zoomMovingTo), 1.f, FAR_LIMIT);
+	const float drawRadius = (zoom <= FAR_THRESHOLD) ? DRAW_RAD : ceilf((zoom / FAR_THRESHOLD) * DRAW_RAD);
+	m_prefetcher->WantSectors(m_posMovingTo, drawRadius);
+	if (ahead.LengthSqr() > drawRadius * drawRadius)
+		ahead = ahead.Normalized() * drawRadius;
+	m_prefetcher->WantSectors(m_pos + ahead, drawRadius);
+
+	if (!m_hyperspaceTarget.IsSectorPath())
+		m_prefetcher->WantSystem(m_hyperspaceTarget);
+
+	// the stops are only worked out again when the route, the current system
+	// or the jump range changes. they're still wanted every frame, as the
+	// prefetcher lets go of anything that isn't, but that's a handful of
+	// calls and it does nothing when the wants are the same as last frame
+	const float jumpRadius = m_playerHyperspaceRange / Sector::SIZE + 1.0f;
+	if (m_prefetchRouteChanged || m_current != m_prefetchCurrent || jumpRadius != m_prefetchJumpRadius) {
+		m_prefetchRouteChanged = false;
+		m_prefetchCurrent = m_current;
+		m_prefetchJumpRadius = jumpRadius;
+
+		// if the current system is on the route, only what comes after it
+		size_t first = 0;
+		for (size_t i = 0; i < m_route.size(); i++) {
+			if (m_route[i].IsSameSystem(m_current)) {
+				first = i + 1;
+				break;
+			}
+		}
+		const size_t last = std::min(m_route.size(), first + PREFETCH_ROUTE_SYSTEMS);
+		m_prefetchStops.assign(m_route.begin() + first, m_route.begin() + last);
+	}
+	for (const SystemPath &stop : m_prefetchStops) {
+		m_prefetcher->WantSectors(vector3f(stop.sectorX, stop.sectorY, stop.sectorZ), jumpRadius);
+		m_prefetcher->WantSystem(stop);
+	}
+
+	m_prefetcher->Update();
+}
+
 double SectorView::GetZoomLevel() const
 {
 	return ((m_zoomClamped / FAR_THRESHOLD) * (OUTER_RADIUS)) + 0.5 * Sector::SIZE;
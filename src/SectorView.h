@@ -6,6 +6,7 @@
 
 #include "DeleteEmitter.h"
 #include "Input.h"
+#include "JobQueue.h"
 #include "galaxy/Sector.h"
 #include "galaxy/SystemPath.h"
 #include "graphics/Drawables.h"
@@ -17,6 +18,7 @@
 
 class Game;
 class Galaxy;
+class GalaxyPrefetcher;
 
 namespace Graphics {
 	class RenderState;
@@ -73,7 +75,14 @@ public:
 	bool RemoveRouteItem(const std::vector<SystemPath>::size_type element);
 	void ClearRoute();
 	std::vector<SystemPath> GetRoute();
-	const std::string AutoRoute(const SystemPath &start, const SystemPath &target, std::vector<SystemPath> &outRoute) const;
+	// starts looking for the quickest route in the background, returning
+	// "SEARCHING", or "NO_DRIVE" if the player has no hyperdrive. the route
+	// replaces the current one once found
+	const std::string AutoRoute(const SystemPath &start, const SystemPath &target);
+	bool IsAutoRouting() const { return m_autoRouteJob.HasJob(); }
+	// "OKAY" or "NO_VALID_ROUTE" once a search has finished, then empty
+	// until the next one finishes
+	std::string TakeAutoRouteResult();
 	void SetDrawRouteLines(bool value) { m_drawRouteLines = value; }
 
 protected:
@@ -127,11 +136,15 @@ private:
 	void PutFactionLabels(const vector3f &secPos);
 	void AddStarBillboard(const matrix4x4f &modelview, const vector3f &pos, const Color &col, float size);
 
+	class AutoRouteJob;
+	void OnAutoRouteFinished(bool found, const std::vector<SystemPath> &route);
+
 	void OnClickSystem(const SystemPath &path);
 	const SystemPath &CheckPathInRoute(const SystemPath &path);
 
 	RefCountedPtr<Sector> GetCached(const SystemPath &loc) { return m_sectorCache->GetCached(loc); }
 	void ShrinkCache();
+	void Prefetch(float frameTime);
 	void SetSelected(const SystemPath &path);
 
 	void MouseWheel(bool up);
@@ -184,6 +197,13 @@ private:
 	sigc::connection m_onViewReset;
 
 	RefCountedPtr<SectorCache::Slave> m_sectorCache;
+	std::unique_ptr<GalaxyPrefetcher> m_prefetcher;
+	vector3f m_prefetchLastPos;
+	// the next stops on the route, and what they were worked out from
+	std::vector<SystemPath> m_prefetchStops;
+	bool m_prefetchRouteChanged;
+	SystemPath m_prefetchCurrent;
+	float m_prefetchJumpRadius;
 	std::string m_previousSearch;
 
 	float m_playerHyperspaceRange;
@@ -194,6 +214,8 @@ private:
 	// HyperJump Route Planner Stuff
 	std::vector<SystemPath> m_route;
 	Graphics::Drawables::Lines m_routeLines;
+	Job::Handle m_autoRouteJob;
+	std::string m_autoRouteResult;
 	bool m_drawRouteLines;
 	bool m_setupRouteLines;
 	void DrawRouteLines(const matrix4x4f &trans);
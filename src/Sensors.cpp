@@ -15,7 +15,7 @@ Sensors::RadarContact::RadarContact() :
 	trail(0),
 	distance(0.0),
 	iff(IFF_UNKNOWN),
-	fresh(true)
+	lastSweep(0)
 {
 }
 
@@ -24,7 +24,7 @@ Sensors::RadarContact::RadarContact(Body *b) :
 	trail(0),
 	distance(0.0),
 	iff(IFF_UNKNOWN),
-	fresh(true)
+	lastSweep(0)
 {
 }
 
@@ -51,7 +51,13 @@ bool Sensors::ContactDistanceSort(const RadarContact &a, const RadarContact &b)
 	return a.distance < b.distance;
 }
 
-Sensors::Sensors(Ship *owner)
+// often enough that a ship coming into range shows up at once, as far
+// as the player can tell
+const float Sensors::SWEEP_INTERVAL = 0.25f;
+
+Sensors::Sensors(Ship *owner) :
+	m_sweep(0),
+	m_timeToSweep(0.0f)
 {
 	m_owner = owner;
 }
@@ -100,6 +106,36 @@ void Sensors::Update(float time)
 	PROFILE_SCOPED();
 	if (m_owner != Pi::player) return;
 
+	m_timeToSweep -= time;
+	if (m_timeToSweep <= 0.0f) {
+		Sweep();
+		m_timeToSweep = SWEEP_INTERVAL;
+	}
+
+	//update contacts, dropping the ones that died since the sweep
+	auto it = m_radarContacts.begin();
+	while (it != m_radarContacts.end()) {
+		if (it->body->IsDead()) {
+			it = DropContact(it);
+			continue;
+		}
+		// contacts are only ever made for ships
+		const Ship *ship = static_cast<const Ship *>(it->body);
+		if (Ship::FLYING == ship->GetFlightState()) {
+			it->distance = m_owner->GetPositionRelTo(it->body).Length();
+			it->trail->Update(time);
+		} else {
+			it->trail->Reset(FrameId::Invalid);
+		}
+		++it;
+	}
+}
+
+void Sensors::Sweep()
+{
+	PROFILE_SCOPED();
+	++m_sweep;
+
 	PopulateStaticContacts(); //no need to do all the time
 
 	//Find nearby contacts, same range as radar scanner. It should use these
@@ -109,51 +145,58 @@ void Sensors::Update(float time)
 		if (body == m_owner || !body->IsType(ObjectType::SHIP)) continue;
 		if (body->IsDead()) continue;
 
-		auto cit = m_radarContacts.begin();
-		while (cit != m_radarContacts.end()) {
-			if (cit->body == body) break;
-			++cit;
-		}
-
 		//create new contact or refresh old
-		if (cit == m_radarContacts.end()) {
+		auto cit = m_contactIndex.find(body);
+		if (cit == m_contactIndex.end()) {
 			m_radarContacts.push_back(RadarContact());
 			RadarContact &rc = m_radarContacts.back();
 			rc.body = body;
 			rc.iff = CheckIFF(rc.body);
 			rc.trail = new HudTrail(rc.body, IFFColor(rc.iff));
+			rc.lastSweep = m_sweep;
+			m_contactIndex[body] = std::prev(m_radarContacts.end());
+			// so that it's dropped if the body is removed between sweeps
+			m_owner->AddBodyRef(body);
 		} else {
-			cit->fresh = true;
+			cit->second->lastSweep = m_sweep;
 		}
 	}
 
-	//update contacts and delete stale ones
+	//delete the ones that weren't found
 	auto it = m_radarContacts.begin();
 	while (it != m_radarContacts.end()) {
-		if (!it->fresh) {
-			m_radarContacts.erase(it++);
-		} else {
-			const Ship *ship = dynamic_cast<Ship *>(it->body);
-			if (ship && Ship::FLYING == ship->GetFlightState()) {
-				it->distance = m_owner->GetPositionRelTo(it->body).Length();
-				it->trail->Update(time);
-			} else {
-				it->trail->Reset(FrameId::Invalid);
-			}
-			it->fresh = false;
+		if (it->lastSweep != m_sweep)
+			it = DropContact(it);
+		else
 			++it;
-		}
 	}
 }
 
+Sensors::ContactList::iterator Sensors::DropContact(ContactList::iterator it)
+{
+	m_owner->RemoveBodyRef(it->body);
+	m_contactIndex.erase(it->body);
+	return m_radarContacts.erase(it);
+}
+
+void Sensors::OnBodyRemoved(const Body *b)
+{
+	// a contact's trail follows its body, so it goes with the contact
+	auto it = m_contactIndex.find(b);
+	if (it != m_contactIndex.end())
+		DropContact(it->second);
+
+	m_staticContacts.remove_if([b](const RadarContact &c) { return c.body == b; });
+}
+
 void Sensors::UpdateIFF(Body *b)
 {
 	PROFILE_SCOPED();
-	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it) {
-		if (it->body == b) {
-			it->iff = CheckIFF(b);
-			it->trail->SetColor(IFFColor(it->iff));
-		}
+	auto it = m_contactIndex.find(b);
+	if (it != m_contactIndex.end()) {
+		RadarContact &rc = *it->second;
+		rc.iff = CheckIFF(b);
+		rc.trail->SetColor(IFFColor(rc.iff));
 	}
 }
 
@@ -162,11 +205,15 @@ void Sensors::ResetTrails()
 	PROFILE_SCOPED();
 	for (auto it = m_radarContacts.begin(); it != m_radarContacts.end(); ++it)
 		it->trail->Reset(Pi::player->GetFrame());
+	// new surroundings (or a new space, after a jump): sweep straight away
+	m_timeToSweep = 0.0f;
 }
 
 void Sensors::PopulateStaticContacts()
 {
 	PROFILE_SCOPED();
+	for (const RadarContact &c : m_staticContacts)
+		m_owner->RemoveBodyRef(c.body);
 	m_staticContacts.clear();
 
 	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
@@ -179,7 +226,7 @@ void Sensors::PopulateStaticContacts()
 			continue;
 		}
 		m_staticContacts.push_back(RadarContact(b));
-		RadarContact &rc = m_staticContacts.back();
-		rc.fresh = true;
+		m_staticContacts.back().lastSweep = m_sweep;
+		m_owner->AddBodyRef(b);
 	}
 }
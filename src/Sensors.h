@@ -8,11 +8,17 @@
  * and handles IFF
  * Some ideas:
  *  - targeting should be lost when going out of range
- *  - don't run radar sweep every frame (more of an optimization than simulation)
  *  - allow "pinned" radar contacts (visible at all ranges, for missions)
+ *
+ * The radar sweep (finding the ships in range, and dropping the contacts
+ * that have gone) runs every SWEEP_INTERVAL seconds of game time rather
+ * than every frame; the contacts' distances and trails are kept up to
+ * date every frame. Contacts are found by body through an index, and are
+ * dropped at once when their body is removed from space.
  */
 #include "Body.h"
 #include "libs.h"
+#include <unordered_map>
 
 class Body;
 class HudTrail;
@@ -39,11 +45,13 @@ public:
 		HudTrail *trail;
 		double distance;
 		IFF iff;
-		bool fresh;
+		Uint32 lastSweep; // the sweep that last found it
 	};
 
 	typedef std::list<RadarContact> ContactList;
 
+	static const float SWEEP_INTERVAL;
+
 	static Color IFFColor(IFF);
 	static bool ContactDistanceSort(const RadarContact &a, const RadarContact &b);
 
@@ -55,12 +63,23 @@ public:
 	void Update(float time);
 	void UpdateIFF(Body *);
 	void ResetTrails();
+	// from the owner's NotifyRemoved(). the owner holds a body ref for
+	// each contact, radar and static, so it's told about all of them
+	void OnBodyRemoved(const Body *);
 
 private:
 	Ship *m_owner;
 	ContactList m_radarContacts;
 	ContactList m_staticContacts; //things we know of regardless of range
 
+	// the radar contacts by body. list iterators stay good through
+	// inserts, erases and sorts
+	std::unordered_map<const Body *, ContactList::iterator> m_contactIndex;
+	Uint32 m_sweep;
+	float m_timeToSweep;
+
+	void Sweep();
+	ContactList::iterator DropContact(ContactList::iterator);
 	void PopulateStaticContacts();
 };
 
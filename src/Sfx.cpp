@@ -30,6 +30,9 @@ namespace {
 		const float pixrad = Clamp(Graphics::GetScreenHeight() / trans.Length(), 0.1f, 50.0f);
 		return (size * Graphics::GetFovFactor()) * pixrad;
 	}
+
+	// instances are cheap to update, so only go parallel for big batches
+	const size_t SFX_UPDATE_GRAIN_SIZE = 256;
 } // namespace
 
 std::unique_ptr<Graphics::Material> SfxManager::damageParticle;
@@ -204,11 +207,14 @@ void SfxManager::TimeStepAll(const float timeStep, FrameId fId)
 	Frame *f = Frame::GetFrame(fId);
 
 	if (f->m_sfx) {
+		SfxManager *sfx = f->m_sfx.get();
 		for (size_t t = TYPE_EXPLOSION; t < TYPE_NONE; t++) {
-			for (size_t i = 0; i < f->m_sfx->GetNumberInstances(SFX_TYPE(t)); i++) {
-				Sfx &inst(f->m_sfx->GetInstanceByIndex(SFX_TYPE(t), i));
-				inst.TimeStepUpdate(timeStep);
-			}
+			// each instance only touches itself, so they can be updated in any order
+			ParallelFor(Pi::GetAsyncJobQueue(), 0, sfx->GetNumberInstances(SFX_TYPE(t)), SFX_UPDATE_GRAIN_SIZE,
+				[sfx, t, timeStep](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++)
+						sfx->GetInstanceByIndex(SFX_TYPE(t), i).TimeStepUpdate(timeStep);
+				});
 		}
 		f->m_sfx->Cleanup();
 	}
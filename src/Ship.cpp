@@ -977,7 +977,7 @@ void Ship::SetFrame(FrameId fId)
 	m_sensors->ResetTrails();
 }
 
-void Ship::TimeStepUpdate(const float timeStep)
+void Ship::Integrate(const float timeStep)
 {
 	// If docked, station is responsible for updating position/orient of ship
 	// but we call this crap anyway and hope it doesn't do anything bad
@@ -989,9 +989,14 @@ void Ship::TimeStepUpdate(const float timeStep)
 	//apply extra atmospheric flight forces
 	AddTorque(CalcAtmoTorque());
 
+	m_dragCoeff = DynamicBody::DEFAULT_DRAG_COEFF * (1.0 + 0.25 * m_wheelState);
+	DynamicBody::Integrate(timeStep);
+}
+
+void Ship::TimeStepUpdate(const float timeStep)
+{
 	if (m_landingGearAnimation)
 		m_landingGearAnimation->SetProgress(m_wheelState);
-	m_dragCoeff = DynamicBody::DEFAULT_DRAG_COEFF * (1.0 + 0.25 * m_wheelState);
 	DynamicBody::TimeStepUpdate(timeStep);
 
 	// fuel use decreases mass, so do this as the last thing in the frame
@@ -1421,6 +1426,7 @@ void Ship::StaticUpdate(const float timeStep)
 void Ship::NotifyRemoved(const Body *const removedBody)
 {
 	if (m_curAICmd) m_curAICmd->OnDeleted(removedBody);
+	if (m_sensors.get()) m_sensors->OnBodyRemoved(removedBody);
 }
 
 bool Ship::Undock()
@@ -1465,16 +1471,7 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 {
 	if (IsDead()) return;
 
-	GetPropulsion()->Render(renderer, camera, viewCoords, viewTransform);
-
-	s_heatGradientParams.heatingMatrix = matrix3x3f(viewTransform.Inverse().GetOrient());
-	s_heatGradientParams.heatingNormal = vector3f(GetVelocity().Normalized());
-	s_heatGradientParams.heatingAmount = Clamp(GetHullTemperature(), 0.0, 1.0);
-
-	// This has to be done per-model with a shield and just before it's rendered
-	const bool shieldsVisible = m_shieldCooldown > 0.01f && m_stats.shield_mass_left > (m_stats.shield_mass / 100.0f);
-	GetShields()->SetEnabled(shieldsVisible);
-	GetShields()->Update(m_shieldCooldown, 0.01f * GetPercentShields());
+	PrepareModelRender(viewTransform);
 
 	//strncpy(params.pText[0], GetLabel().c_str(), sizeof(params.pText));
 	RenderModel(renderer, camera, viewCoords, viewTransform);
@@ -1511,6 +1508,30 @@ void Ship::Render(Graphics::Renderer *renderer, const Camera *camera, const vect
 	}
 }
 
+bool Ship::AreShieldsVisible() const
+{
+	return m_shieldCooldown > 0.01f && m_stats.shield_mass_left > (m_stats.shield_mass / 100.0f);
+}
+
+bool Ship::CanBatchModel() const
+{
+	// a hot hull or visible shields need the ship's own shader parameters
+	return !IsDead() && GetHullTemperature() <= 0.0 && !AreShieldsVisible();
+}
+
+void Ship::PrepareModelRender(const matrix4x4d &viewTransform)
+{
+	GetPropulsion()->SetModelThrust();
+
+	s_heatGradientParams.heatingMatrix = matrix3x3f(viewTransform.Inverse().GetOrient());
+	s_heatGradientParams.heatingNormal = vector3f(GetVelocity().Normalized());
+	s_heatGradientParams.heatingAmount = Clamp(GetHullTemperature(), 0.0, 1.0);
+
+	// This has to be done per-model with a shield and just before it's rendered
+	GetShields()->SetEnabled(AreShieldsVisible());
+	GetShields()->Update(m_shieldCooldown, 0.01f * GetPercentShields());
+}
+
 bool Ship::SpawnCargo(CargoBody *c_body) const
 {
 	if (m_flightState != FLYING) return false;
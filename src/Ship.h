@@ -80,6 +80,9 @@ public:
 	virtual void SetLandedOn(Planet *p, float latitude, float longitude);
 
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	// the heat and shield shaders are set up per ship
+	virtual bool CanBatchModel() const override;
+	virtual void PrepareModelRender(const matrix4x4d &viewTransform) override;
 
 	inline void ClearThrusterState()
 	{
@@ -100,6 +103,7 @@ public:
 	virtual bool SetWheelState(bool down); // returns success of state change, NOT state itself
 	void Blastoff();
 	bool Undock();
+	virtual void Integrate(const float timeStep) override;
 	virtual void TimeStepUpdate(const float timeStep) override;
 	virtual void StaticUpdate(const float timeStep) override;
 
@@ -275,6 +279,7 @@ private:
 	void EnterHyperspace();
 	void InitMaterials();
 	void InitEquipSet();
+	bool AreShieldsVisible() const;
 
 	bool m_invulnerable;
 
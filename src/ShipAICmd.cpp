@@ -11,6 +11,7 @@
 #include "Space.h"
 #include "SpaceStation.h"
 #include "perlin.h"
+#include <algorithm>
 
 static const double VICINITY_MIN = 15000.0;
 static const double VICINITY_MUL = 4.0;
@@ -59,6 +60,7 @@ void AICommand::SaveToJson(Json &jsonObj)
 }
 
 AICommand::AICommand(const Json &jsonObj, CmdName name) :
+	m_dBody(nullptr),
 	m_cmdName(name)
 {
 	try {
@@ -72,6 +74,28 @@ AICommand::AICommand(const Json &jsonObj, CmdName name) :
 	}
 }
 
+AICommand::~AICommand()
+{
+	if (!m_dBody) return; // never fixed up after loading
+	for (const Body *body : m_watchedBodies)
+		m_dBody->RemoveBodyRef(body);
+}
+
+void AICommand::WatchBody(const Body *body)
+{
+	if (!body) return;
+	m_dBody->AddBodyRef(body);
+	m_watchedBodies.push_back(body);
+}
+
+void AICommand::OnDeleted(const Body *body)
+{
+	// the reference went with the body. forget it, or a new body given the
+	// same address would have its reference removed by the destructor
+	m_watchedBodies.erase(std::remove(m_watchedBodies.begin(), m_watchedBodies.end(), body), m_watchedBodies.end());
+	if (m_child) m_child->OnDeleted(body);
+}
+
 void AICommand::PostLoadFixup(Space *space)
 {
 	// subsystem should be initializated on each inherited AICommand
@@ -232,6 +256,7 @@ AICmdKamikaze::AICmdKamikaze(DynamicBody *dBody, Body *target) :
 	AICommand(dBody, CMD_KAMIKAZE)
 {
 	m_target = target;
+	WatchBody(m_target);
 	m_prop.Reset(m_dBody->GetPropulsion());
 	assert(m_prop != nullptr);
 }
@@ -256,6 +281,7 @@ void AICmdKamikaze::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_target = space->GetBodyByIndex(m_targetIndex);
+	WatchBody(m_target);
 	// Ensure needed sub-system:
 	m_prop.Reset(m_dBody->GetPropulsion());
 	assert(m_prop != nullptr);
@@ -322,6 +348,7 @@ AICmdKill::AICmdKill(DynamicBody *dBody, Ship *target) :
 	AICommand(dBody, CMD_KILL)
 {
 	m_target = target;
+	WatchBody(m_target);
 	m_leadTime = m_evadeTime = m_closeTime = 0.0;
 	m_lastVel = m_target->GetVelocity();
 	m_prop.Reset(m_dBody->GetPropulsion());
@@ -354,6 +381,7 @@ void AICmdKill::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_target = static_cast<Ship *>(space->GetBodyByIndex(m_targetIndex));
+	WatchBody(m_target);
 	m_leadTime = m_evadeTime = m_closeTime = 0.0;
 	m_lastVel = m_target->GetVelocity();
 	// Ensure needed sub-system:
@@ -857,6 +885,7 @@ void AICmdFlyTo::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_target = space->GetBodyByIndex(m_targetIndex);
+	WatchBody(m_target);
 	m_lockhead = true;
 	m_frameId = m_target ? m_target->GetFrame() : FrameId();
 	// Ensure needed sub-system:
@@ -888,6 +917,7 @@ AICmdFlyTo::AICmdFlyTo(DynamicBody *dBody, Body *target) :
 		m_target = nullptr;
 	} else {
 		m_target = target;
+		WatchBody(m_target);
 		m_targframeId = FrameId::Invalid;
 	}
 
@@ -1155,6 +1185,7 @@ void AICmdDock::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_target = static_cast<SpaceStation *>(space->GetBodyByIndex(m_targetIndex));
+	WatchBody(m_target);
 	// Ensure needed sub-system:
 	m_prop.Reset(m_dBody->GetPropulsion());
 	assert(m_prop != nullptr);
@@ -1165,6 +1196,7 @@ AICmdDock::AICmdDock(DynamicBody *dBody, SpaceStation *target) :
 	m_target(target),
 	m_state(eDockGetDataStart)
 {
+	WatchBody(m_target);
 	Ship *ship = nullptr;
 	if (!dBody->IsType(ObjectType::SHIP)) return;
 	ship = static_cast<Ship *>(dBody);
@@ -1388,6 +1420,7 @@ void AICmdFlyAround::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_obstructor = space->GetBodyByIndex(m_obstructorIndex);
+	WatchBody(m_obstructor);
 	// Ensure needed sub-system:
 	m_prop.Reset(m_dBody->GetPropulsion());
 	assert(m_prop != nullptr);
@@ -1398,6 +1431,7 @@ void AICmdFlyAround::Setup(Body *obstructor, double alt, double vel, int mode)
 	assert(!std::isnan(alt));
 	assert(!std::isnan(vel));
 	m_obstructor = obstructor;
+	WatchBody(m_obstructor);
 	m_alt = alt;
 	m_vel = vel;
 	m_targmode = mode;
@@ -1590,6 +1624,7 @@ AICmdFormation::AICmdFormation(DynamicBody *dBody, DynamicBody *target, const ve
 	m_target(target),
 	m_posoff(posoff)
 {
+	WatchBody(m_target);
 	m_prop.Reset(dBody->GetPropulsion());
 	assert(m_prop != nullptr);
 }
@@ -1621,6 +1656,7 @@ void AICmdFormation::PostLoadFixup(Space *space)
 {
 	AICommand::PostLoadFixup(space);
 	m_target = static_cast<Ship *>(space->GetBodyByIndex(m_targetIndex));
+	WatchBody(m_target);
 	// Ensure needed sub-system:
 	m_prop.Reset(m_dBody->GetPropulsion());
 	assert(m_prop != nullptr);
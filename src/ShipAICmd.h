@@ -36,7 +36,7 @@ public:
 	{
 		m_dBody->AIMessage(DynamicBody::AIERROR_NONE);
 	}
-	virtual ~AICommand() {}
+	virtual ~AICommand();
 
 	virtual bool TimeStepUpdate() = 0;
 	bool ProcessChild(); // returns false if child is active
@@ -55,14 +55,16 @@ public:
 	virtual void PostLoadFixup(Space *space);
 
 	// Signal functions
-	virtual void OnDeleted(const Body *body)
-	{
-		if (m_child) m_child->OnDeleted(body);
-	}
+	virtual void OnDeleted(const Body *body);
 
 	CmdName GetType() const { return m_cmdName; }
 
 protected:
+	// Register m_dBody as a referrer of a body this command points at, so
+	// it gets NotifyRemoved() (and so OnDeleted()) when that body goes away.
+	// Released when the command is deleted.
+	void WatchBody(const Body *body);
+
 	DynamicBody *m_dBody;
 	RefCountedPtr<Propulsion> m_prop;
 	RefCountedPtr<FixedGuns> m_fguns;
@@ -72,6 +74,9 @@ protected:
 	CmdName m_cmdName;
 
 	int m_dBodyIndex; // deserialisation
+
+private:
+	std::vector<const Body *> m_watchedBodies;
 };
 
 class AICmdDock : public AICommand {
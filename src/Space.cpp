@@ -7,6 +7,7 @@
 #include "CityOnPlanet.h"
 #include "Frame.h"
 #include "Game.h"
+#include "GameConfig.h"
 #include "GameSaveError.h"
 #include "HyperspaceCloud.h"
 #include "Lang.h"
@@ -14,6 +15,7 @@
 #include "Pi.h"
 #include "Planet.h"
 #include "Player.h"
+#include "Projectile.h"
 #include "SpaceStation.h"
 #include "Star.h"
 #include "SystemView.h"
@@ -26,16 +28,76 @@
 #include <algorithm>
 #include <functional>
 
+// bodies per task when running physics on the job runners
+static const size_t PARALLEL_PHYSICS_GRAIN_SIZE = 16;
+
 //#define DEBUG_CACHE
 
+// edge length of the body finder grid cells. most proximity queries (sensors,
+// traffic control, alerts) are in the tens to hundreds of km
+static const double BODY_NEAR_CELL_SIZE = 100000.0;
+// keeps absurd (or NaN) positions from overflowing the cell coordinates
+static const double BODY_NEAR_MAX_CELL = 1e15;
+
+Space::BodyNearFinder::Cell Space::BodyNearFinder::GetCell(const vector3d &pos)
+{
+	auto coord = [](double v) -> Sint64 {
+		const double c = std::floor(v / BODY_NEAR_CELL_SIZE);
+		if (!(c > -BODY_NEAR_MAX_CELL)) return Sint64(-BODY_NEAR_MAX_CELL);
+		if (c > BODY_NEAR_MAX_CELL) return Sint64(BODY_NEAR_MAX_CELL);
+		return Sint64(c);
+	};
+	return Cell{ coord(pos.x), coord(pos.y), coord(pos.z) };
+}
+
 void Space::BodyNearFinder::Prepare()
 {
-	m_bodyDist.clear();
+	m_stale = false;
+	m_entries.clear();
+	m_boundsMin = m_boundsMax = vector3d(0.0);
+
+	for (Body *b : m_space->GetBodies()) {
+		const vector3d pos = b->GetPositionRelTo(m_space->GetRootFrame());
+		if (m_entries.empty()) {
+			m_boundsMin = m_boundsMax = pos;
+		} else {
+			m_boundsMin = vector3d(std::min(m_boundsMin.x, pos.x), std::min(m_boundsMin.y, pos.y), std::min(m_boundsMin.z, pos.z));
+			m_boundsMax = vector3d(std::max(m_boundsMax.x, pos.x), std::max(m_boundsMax.y, pos.y), std::max(m_boundsMax.z, pos.z));
+		}
+		m_entries.emplace_back(b, pos, GetCell(pos));
+	}
 
-	for (Body *b : m_space->GetBodies())
-		m_bodyDist.emplace_back(b, b->GetPositionRelTo(m_space->GetRootFrame()).Length());
+	std::sort(m_entries.begin(), m_entries.end());
+}
 
-	std::sort(m_bodyDist.begin(), m_bodyDist.end());
+template <typename Fn>
+void Space::BodyNearFinder::ForEachNear(const vector3d &pos, double dist, Fn fn) const
+{
+	const double distSqr = dist * dist;
+	const Cell lo = GetCell(pos - vector3d(dist));
+	const Cell hi = GetCell(pos + vector3d(dist));
+
+	// a box covering more cells than there are bodies is cheaper to scan
+	const double numCells = (double(hi.x - lo.x) + 1.0) * (double(hi.y - lo.y) + 1.0) * (double(hi.z - lo.z) + 1.0);
+	if (numCells > double(m_entries.size())) {
+		for (const BodyEntry &e : m_entries)
+			if ((e.pos - pos).LengthSqr() <= distSqr)
+				fn(e);
+		return;
+	}
+
+	// entries are sorted by x, y, z, so each row of cells along z is a
+	// contiguous run
+	for (Sint64 x = lo.x; x <= hi.x; x++) {
+		for (Sint64 y = lo.y; y <= hi.y; y++) {
+			const Cell first = { x, y, lo.z };
+			auto it = std::lower_bound(m_entries.begin(), m_entries.end(), first,
+				[](const BodyEntry &e, const Cell &c) { return e.cell < c; });
+			for (; it != m_entries.end() && it->cell.x == x && it->cell.y == y && it->cell.z <= hi.z; ++it)
+				if ((it->pos - pos).LengthSqr() <= distSqr)
+					fn(*it);
+		}
+	}
 }
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, double dist)
@@ -45,21 +107,58 @@ Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const Body *b, dou
 
 Space::BodyNearList Space::BodyNearFinder::GetBodiesMaybeNear(const vector3d &pos, double dist)
 {
-	if (m_bodyDist.empty()) {
-		m_nearBodies.clear();
-		return std::move(m_nearBodies);
-	}
-
-	const double len = pos.Length();
-
-	std::vector<BodyDist>::const_iterator min = std::lower_bound(m_bodyDist.begin(), m_bodyDist.end(), len - dist);
-	std::vector<BodyDist>::const_iterator max = std::upper_bound(min, m_bodyDist.cend(), len + dist);
+	m_nearBodies.clear();
+	ForEachNear(pos, dist, [&](const BodyEntry &e) { m_nearBodies.push_back(e.body); });
+	return std::move(m_nearBodies);
+}
 
+Space::BodyNearList Space::BodyNearFinder::GetNearestBodies(const vector3d &pos, size_t count, double maxDist, const Body *exclude)
+{
 	m_nearBodies.clear();
-	m_nearBodies.reserve(max - min);
+	m_nearDist.clear();
+	if (count == 0)
+		return std::move(m_nearBodies);
+
+	if (m_stale) {
+		// the index has bodies where they were, and not those added since,
+		// so go through them all where they are now
+		const double maxDistSqr = maxDist * maxDist;
+		for (Body *b : m_space->GetBodies()) {
+			if (b == exclude)
+				continue;
+			const double distSqr = (b->GetPositionRelTo(m_space->GetRootFrame()) - pos).LengthSqr();
+			if (distSqr <= maxDistSqr)
+				m_nearDist.emplace_back(distSqr, b);
+		}
+	} else if (!m_entries.empty()) {
+		// no point searching further out than the furthest body
+		const vector3d furthest(
+			std::max(std::abs(pos.x - m_boundsMin.x), std::abs(pos.x - m_boundsMax.x)),
+			std::max(std::abs(pos.y - m_boundsMin.y), std::abs(pos.y - m_boundsMax.y)),
+			std::max(std::abs(pos.z - m_boundsMin.z), std::abs(pos.z - m_boundsMax.z)));
+		maxDist = std::min(maxDist, furthest.Length());
+
+		// widen the search until it has found enough bodies
+		double radius = std::min(BODY_NEAR_CELL_SIZE, maxDist);
+		for (;;) {
+			m_nearDist.clear();
+			ForEachNear(pos, radius, [&](const BodyEntry &e) {
+				if (e.body != exclude)
+					m_nearDist.emplace_back((e.pos - pos).LengthSqr(), e.body);
+			});
+			if (m_nearDist.size() >= count || radius >= maxDist)
+				break;
+			radius = std::min(radius * 4.0, maxDist);
+		}
+	}
 
-	std::for_each(min, max, [&](BodyDist const &bd) { m_nearBodies.push_back(bd.body); });
+	count = std::min(count, m_nearDist.size());
+	std::partial_sort(m_nearDist.begin(), m_nearDist.begin() + count, m_nearDist.end(),
+		[](const std::pair<double, Body *> &a, const std::pair<double, Body *> &b) { return a.first < b.first; });
 
+	m_nearBodies.reserve(count);
+	for (size_t i = 0; i < count; i++)
+		m_nearBodies.push_back(m_nearDist[i].second);
 	return std::move(m_nearBodies);
 }
 
@@ -68,7 +167,8 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, Space *oldSpace) :
 	m_game(game),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
-	m_bodyNearFinder(this)
+	m_bodyNearFinder(this),
+	m_parallelPhysics(Pi::config->Int("ParallelPhysics"))
 #ifndef NDEBUG
 	,
 	m_processingFinalizationQueue(false)
@@ -87,7 +187,8 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const SystemPath &path, S
 	m_game(game),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
-	m_bodyNearFinder(this)
+	m_bodyNearFinder(this),
+	m_parallelPhysics(Pi::config->Int("ParallelPhysics"))
 #ifndef NDEBUG
 	,
 	m_processingFinalizationQueue(false)
@@ -113,7 +214,8 @@ Space::Space(Game *game, RefCountedPtr<Galaxy> galaxy, const Json &jsonObj, doub
 	m_game(game),
 	m_bodyIndexValid(false),
 	m_sbodyIndexValid(false),
-	m_bodyNearFinder(this)
+	m_bodyNearFinder(this),
+	m_parallelPhysics(Pi::config->Int("ParallelPhysics"))
 #ifndef NDEBUG
 	,
 	m_processingFinalizationQueue(false)
@@ -271,6 +373,7 @@ void Space::RebuildSystemBodyIndex()
 void Space::AddBody(Body *b)
 {
 	m_bodies.push_back(b);
+	m_bodyNearFinder.MarkStale();
 }
 
 void Space::RemoveBody(Body *b)
@@ -363,6 +466,11 @@ void Space::GetHyperspaceExitParams(const SystemPath &source, const SystemPath &
 	pos += primary->GetPositionRelTo(GetRootFrame());
 }
 
+Space::BodyNearList Space::GetNearestBodies(const Body *b, size_t count, double maxDist)
+{
+	return m_bodyNearFinder.GetNearestBodies(b->GetPositionRelTo(m_rootFrameId), count, maxDist, b);
+}
+
 Body *Space::FindNearestTo(const Body *b, ObjectType t) const
 {
 	Body *nearest = 0;
@@ -927,32 +1035,117 @@ static void hitCallback(CollisionContact *c)
 }
 
 // temporary one-point version
-static void CollideWithTerrain(Body *body, float timeStep)
+// only reads the bodies and their terrain, so it's safe to call for several
+// runs of bodies at once. contacts[i] is set if bodies[i] hit the ground
+static void FindTerrainContacts(Body *const *bodies, size_t count, float timeStep, CollisionContact *contacts)
 {
-	if (!body->IsType(ObjectType::DYNAMICBODY))
-		return;
-	DynamicBody *dynBody = static_cast<DynamicBody *>(body);
-	if (!dynBody->IsMoving())
-		return;
+	// the bodies low enough to have hit, so their terrain heights can be
+	// asked for a terrain at a time
+	struct Candidate {
+		TerrainBody *terrain;
+		size_t index;
+		double altitude;
+	};
+	std::vector<Candidate> candidates;
+	for (size_t i = 0; i < count; i++) {
+		Body *body = bodies[i];
+		if (!body->IsType(ObjectType::DYNAMICBODY))
+			continue;
+		DynamicBody *dynBody = static_cast<DynamicBody *>(body);
+		if (!dynBody->IsMoving())
+			continue;
+
+		Frame *f = Frame::GetFrame(body->GetFrame());
+		if (!f || !f->GetBody() || f->GetId() != f->GetBody()->GetFrame())
+			continue;
+		if (!f->GetBody()->IsType(ObjectType::TERRAINBODY))
+			continue;
+		TerrainBody *terrain = static_cast<TerrainBody *>(f->GetBody());
+
+		const Aabb &aabb = dynBody->GetAabb();
+		double altitude = body->GetPosition().Length() + aabb.min.y;
+		if (altitude >= (terrain->GetMaxFeatureRadius() * 2.0))
+			continue;
+
+		candidates.push_back({ terrain, i, altitude });
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+		return a.terrain < b.terrain;
+	});
+
+	std::vector<vector3d> dirs;
+	std::vector<double> heights;
+	for (size_t first = 0; first < candidates.size();) {
+		TerrainBody *terrain = candidates[first].terrain;
+		size_t end = first;
+		dirs.clear();
+		for (; end < candidates.size() && candidates[end].terrain == terrain; end++)
+			dirs.push_back(bodies[candidates[end].index]->GetPosition().Normalized());
+		heights.resize(dirs.size());
+		terrain->GetCachedTerrainHeights(dirs.data(), heights.data(), dirs.size());
+
+		for (size_t c = first; c < end; c++) {
+			const double terrHeight = heights[c - first];
+			if (candidates[c].altitude >= terrHeight)
+				continue;
+			Body *body = bodies[candidates[c].index];
+			contacts[candidates[c].index] = CollisionContact(body->GetPosition(), dirs[c - first], terrHeight - candidates[c].altitude, timeStep, static_cast<void *>(body), static_cast<void *>(terrain));
+		}
+		first = end;
+	}
+}
 
-	Frame *f = Frame::GetFrame(body->GetFrame());
-	if (!f || !f->GetBody() || f->GetId() != f->GetBody()->GetFrame())
-		return;
-	if (!f->GetBody()->IsType(ObjectType::TERRAINBODY))
-		return;
-	TerrainBody *terrain = static_cast<TerrainBody *>(f->GetBody());
+void Space::CollideWithTerrain(float step)
+{
+	PROFILE_SCOPED()
 
-	const Aabb &aabb = dynBody->GetAabb();
-	double altitude = body->GetPosition().Length() + aabb.min.y;
-	if (altitude >= (terrain->GetMaxFeatureRadius() * 2.0))
-		return;
+	m_terrainContacts.assign(m_bodies.size(), CollisionContact());
+	if (m_parallelPhysics) {
+		// terrain height lookups are the expensive part, so find the contacts
+		// in parallel
+		ParallelFor(Pi::GetAsyncJobQueue(), 0, m_bodies.size(), PARALLEL_PHYSICS_GRAIN_SIZE, [this, step](size_t begin, size_t end) {
+			FindTerrainContacts(&m_bodies[begin], end - begin, step, &m_terrainContacts[begin]);
+		});
+	} else
+		FindTerrainContacts(m_bodies.data(), m_bodies.size(), step, m_terrainContacts.data());
+
+	// the responses fire collision events and can kill bodies, so they're
+	// applied afterwards, in body order
+	for (CollisionContact &c : m_terrainContacts) {
+		if (c.userData1)
+			hitCallback(&c);
+	}
+}
 
-	double terrHeight = terrain->GetTerrainHeight(body->GetPosition().Normalized());
-	if (altitude >= terrHeight)
+// moves the bodies and runs their TimeStepUpdate(). normally each body is
+// updated right after it has moved, as it always has been. with parallel
+// physics they all move first, so a body's TimeStepUpdate() (sensors,
+// proximity checks) sees the ones after it in the list already moved
+void Space::MoveBodies(float step)
+{
+	PROFILE_SCOPED()
+
+	if (!m_parallelPhysics) {
+		for (Body *b : m_bodies) {
+			if (b->IsType(ObjectType::DYNAMICBODY))
+				static_cast<DynamicBody *>(b)->Integrate(step);
+			b->TimeStepUpdate(step);
+		}
 		return;
+	}
+
+	auto integrate = [this, step](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			Body *b = m_bodies[i];
+			if (b->IsType(ObjectType::DYNAMICBODY))
+				static_cast<DynamicBody *>(b)->Integrate(step);
+		}
+	};
+
+	ParallelFor(Pi::GetAsyncJobQueue(), 0, m_bodies.size(), PARALLEL_PHYSICS_GRAIN_SIZE, integrate);
 
-	CollisionContact c(body->GetPosition(), body->GetPosition().Normalized(), terrHeight - altitude, timeStep, static_cast<void *>(body), static_cast<void *>(f->GetBody()));
-	hitCallback(&c);
+	for (Body *b : m_bodies)
+		b->TimeStepUpdate(step);
 }
 
 void Space::TimeStep(float step)
@@ -963,24 +1156,32 @@ void Space::TimeStep(float step)
 		RefreshBackground();
 
 	m_bodyIndexValid = m_sbodyIndexValid = false;
+	m_bodyNearFinder.MarkStale();
 
 	Frame::CollideFrames(&hitCallback);
 
-	for (Body *b : m_bodies)
-		CollideWithTerrain(b, step);
+	CollideWithTerrain(step);
 
 	// update frames of reference
 	for (Body *b : m_bodies)
 		b->UpdateFrame();
 
+	// projectiles trace their paths for this step in one batch, rather than
+	// each walking the collision trees on its own
+	std::vector<Projectile *> projectiles;
+	for (Body *b : m_bodies) {
+		if (b->IsType(ObjectType::PROJECTILE))
+			projectiles.push_back(static_cast<Projectile *>(b));
+	}
+	Projectile::TraceRays(projectiles, step);
+
 	// AI acts here, then move all bodies and frames
 	for (Body *b : m_bodies)
 		b->StaticUpdate(step);
 
 	Frame::UpdateOrbitRails(m_game->GetTime(), m_game->GetTimeStep());
 
-	for (Body *b : m_bodies)
-		b->TimeStepUpdate(step);
+	MoveBodies(step);
 
 	LuaEvent::Emit();
 	Pi::luaTimer->Tick();
@@ -992,27 +1193,44 @@ void Space::TimeStep(float step)
 
 void Space::UpdateBodies()
 {
+	if (m_assignedBodies.empty())
+		return;
+
 #ifndef NDEBUG
 	m_processingFinalizationQueue = true;
 #endif
 
-	// removing or deleting bodies from space
+	// take the assigned bodies out of the body list in a single pass,
+	// remembering which of them were actually in this space
+	std::vector<Body *> assigned;
+	assigned.reserve(m_assignedBodies.size());
+	for (const auto &b : m_assignedBodies)
+		assigned.push_back(b.first);
+	std::sort(assigned.begin(), assigned.end());
+
+	std::vector<Body *> found;
+	m_bodies.erase(std::remove_if(m_bodies.begin(), m_bodies.end(), [&](Body *body) {
+		if (!std::binary_search(assigned.begin(), assigned.end(), body))
+			return false;
+		found.push_back(body);
+		return true;
+	}),
+		m_bodies.end());
+	std::sort(found.begin(), found.end());
+
+	// removing or deleting bodies from space. only the bodies that hold a
+	// reference to a removed body are told about it
 	for (const auto &b : m_assignedBodies) {
-		auto remove_iterator = m_bodies.end();
-		for (auto it = m_bodies.begin(); it != m_bodies.end(); ++it) {
-			if (*it != b.first)
-				(*it)->NotifyRemoved(b.first);
-			else
-				remove_iterator = it;
-		}
-		if (remove_iterator != m_bodies.end()) {
-			*remove_iterator = m_bodies.back();
-			m_bodies.pop_back();
-			if (b.second == BodyAssignation::KILL)
-				delete b.first;
-			else
-				b.first->SetFrame(FrameId::Invalid);
-		}
+		auto it = std::lower_bound(found.begin(), found.end(), b.first);
+		if (it == found.end() || *it != b.first)
+			continue; // not in this space, or already handled
+		found.erase(it);
+
+		b.first->NotifyReferrersRemoved();
+		if (b.second == BodyAssignation::KILL)
+			delete b.first;
+		else
+			b.first->SetFrame(FrameId::Invalid);
 	}
 
 	m_assignedBodies.clear();
@@ -6,10 +6,12 @@
 
 #include "Background.h"
 #include "FrameId.h"
+#include "collider/CollisionContact.h"
 #include "IterationProxy.h"
 #include "RefCounted.h"
 #include "galaxy/StarSystem.h"
 #include "vector3.h"
+#include <cfloat>
 
 class Body;
 class Frame;
@@ -82,6 +84,12 @@ public:
 	{
 		return m_bodyNearFinder.GetBodiesMaybeNear(pos, dist);
 	}
+	// up to count bodies within maxDist, nearest first. b itself is skipped
+	BodyNearList GetNearestBodies(const Body *b, size_t count, double maxDist = DBL_MAX);
+	BodyNearList GetNearestBodies(const vector3d &pos, size_t count, double maxDist = DBL_MAX)
+	{
+		return m_bodyNearFinder.GetNearestBodies(pos, count, maxDist, nullptr);
+	}
 
 	void DebugDumpFrames(bool details);
 
@@ -93,6 +101,8 @@ private:
 	FrameId GetFrameWithSystemBody(const SystemBody *b) const;
 
 	void UpdateBodies();
+	void CollideWithTerrain(float step);
+	void MoveBodies(float step);
 
 	void CollideFrame(FrameId fId);
 
@@ -129,36 +139,72 @@ private:
 	//e.g. starfield and milky way)
 	std::unique_ptr<Background::Container> m_background;
 
+	// Spatial index over the bodies, rebuilt at the end of each timestep.
+	// Bodies are bucketed by their root frame position into a uniform grid
+	// of cells, kept sorted by cell so a query only looks at the cells
+	// overlapping its bounds.
+	//
+	// GetBodiesMaybeNear() answers from the index as it is, which is what
+	// the per-step callers want. GetNearestBodies() is exact: once bodies
+	// have moved or been added since Prepare() it goes through all of them.
 	class BodyNearFinder {
 	public:
 		BodyNearFinder(const Space *space) :
-			m_space(space) {}
+			m_space(space),
+			m_stale(true) {}
 		void Prepare();
+		// bodies have moved or been added since the last Prepare()
+		void MarkStale() { m_stale = true; }
 
 		BodyNearList GetBodiesMaybeNear(const Body *b, double dist);
 		BodyNearList GetBodiesMaybeNear(const vector3d &pos, double dist);
+		BodyNearList GetNearestBodies(const vector3d &pos, size_t count, double maxDist, const Body *exclude);
 
 	private:
-		struct BodyDist {
-			BodyDist(Body *_body, double _dist) :
+		struct Cell {
+			Sint64 x, y, z;
+
+			bool operator<(const Cell &a) const
+			{
+				if (x != a.x) return x < a.x;
+				if (y != a.y) return y < a.y;
+				return z < a.z;
+			}
+		};
+
+		struct BodyEntry {
+			BodyEntry(Body *_body, const vector3d &_pos, const Cell &_cell) :
 				body(_body),
-				dist(_dist) {}
+				pos(_pos),
+				cell(_cell) {}
 			Body *body;
-			double dist;
+			vector3d pos; // relative to the root frame
+			Cell cell;
 
-			bool operator<(const BodyDist &a) const { return dist < a.dist; }
-
-			friend bool operator<(const BodyDist &a, double d) { return a.dist < d; }
-			friend bool operator<(double d, const BodyDist &a) { return d < a.dist; }
+			bool operator<(const BodyEntry &a) const { return cell < a.cell; }
 		};
 
+		static Cell GetCell(const vector3d &pos);
+		// call fn for each body within dist of pos
+		template <typename Fn>
+		void ForEachNear(const vector3d &pos, double dist, Fn fn) const;
+
 		const Space *m_space;
-		std::vector<BodyDist> m_bodyDist;
+		bool m_stale;
+		std::vector<BodyEntry> m_entries;
+		vector3d m_boundsMin, m_boundsMax;
 		std::vector<Body *> m_nearBodies;
+		std::vector<std::pair<double, Body *>> m_nearDist;
 	};
 
 	BodyNearFinder m_bodyNearFinder;
 
+	// run the per-body physics phases on the job runners (opt-in via the
+	// ParallelPhysics config option). see MoveBodies() for how that changes
+	// the update order
+	bool m_parallelPhysics;
+	std::vector<CollisionContact> m_terrainContacts;
+
 #ifndef NDEBUG
 	//to check RemoveBody and KillBody are not called from within
 	//the NotifyRemoved callback (#735)
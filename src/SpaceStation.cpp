@@ -145,7 +145,7 @@ void SpaceStation::PostLoadFixup(Space *space)
 {
 	ModelBody::PostLoadFixup(space);
 	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
-		m_shipDocking[i].ship = static_cast<Ship *>(space->GetBodyByIndex(m_shipDocking[i].shipIndex));
+		SetPortShip(m_shipDocking[i], static_cast<Ship *>(space->GetBodyByIndex(m_shipDocking[i].shipIndex)));
 	}
 }
 
@@ -230,6 +230,12 @@ void SpaceStation::NotifyRemoved(const Body *const removedBody)
 	}
 }
 
+void SpaceStation::SetPortShip(shipDocking_t &sd, Ship *ship)
+{
+	ReplaceBodyRef(sd.ship, ship);
+	sd.ship = ship;
+}
+
 int SpaceStation::GetMyDockingPort(const Ship *s) const
 {
 	for (Uint32 i = 0; i < m_shipDocking.size(); i++) {
@@ -271,7 +277,7 @@ int SpaceStation::GetFreeDockingPort(const Ship *s) const
 void SpaceStation::SetDocked(Ship *ship, const int port)
 {
 	assert(m_shipDocking.size() > Uint32(port));
-	m_shipDocking[port].ship = ship;
+	SetPortShip(m_shipDocking[port], ship);
 	m_shipDocking[port].stage = m_type->NumDockingStages() + 3;
 
 	// have to do this crap again in case it was called directly (Ship::SetDockWith())
@@ -291,7 +297,7 @@ void SpaceStation::SwapDockedShipsPort(const int oldPort, const int newPort)
 	assert(ship);
 	ship->SetDockedWith(this, newPort);
 
-	m_shipDocking[oldPort].ship = 0;
+	SetPortShip(m_shipDocking[oldPort], nullptr);
 	m_shipDocking[oldPort].stage = 0;
 }
 
@@ -302,7 +308,7 @@ bool SpaceStation::LaunchShip(Ship *ship, const int port)
 	if (IsPortLocked(port)) return false; // another ship docking
 	LockPort(port, true);
 
-	sd.ship = ship;
+	SetPortShip(sd, ship);
 	sd.stage = -1;
 	sd.stagePos = 0.0;
 
@@ -363,7 +369,7 @@ bool SpaceStation::GetDockingClearance(Ship *s)
 
 		if (pPort->minShipSize < bboxRad && bboxRad < pPort->maxShipSize) {
 			shipDocking_t &sd = m_shipDocking[i];
-			sd.ship = s;
+			SetPortShip(sd, s);
 			sd.stage = 1;
 			sd.stagePos = 0;
 			// Note: maxOffset is squared
@@ -426,7 +432,7 @@ bool SpaceStation::OnCollision(Body *b, Uint32 flags, double relVel)
 		// if there is more docking port anim to do, don't set docked yet
 		if (m_type->NumDockingStages() >= 2) {
 			shipDocking_t &sd = m_shipDocking[port];
-			sd.ship = s;
+			SetPortShip(sd, s);
 			sd.stage = 2;
 			sd.stagePos = 0;
 			sd.fromPos = (s->GetPosition() - GetPosition()) * GetOrient(); // station space
@@ -540,7 +546,7 @@ void SpaceStation::DockingUpdate(const double timeStep)
 
 			if (dt.stagePos >= 1.0) {
 				LuaEvent::Queue("onDockingClearanceExpired", this, dt.ship);
-				dt.ship = 0;
+				SetPortShip(dt, nullptr);
 				dt.stage = 0;
 				m_doorAnimationStep = -0.3; // close door
 			}
@@ -577,7 +583,7 @@ void SpaceStation::DockingUpdate(const double timeStep)
 		if (dt.stage < -m_type->NumUndockStages()) {
 			// undock animation finished, clear port
 			dt.stage = 0;
-			dt.ship = nullptr;
+			SetPortShip(dt, nullptr);
 			dt.stagePos = 0;
 			dt.maxOffset = 0;
 			LockPort(i, false);
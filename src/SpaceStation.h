@@ -48,6 +48,8 @@ public:
 	virtual bool OnCollision(Body *b, Uint32 flags, double relVel) override;
 	bool DoShipDamage(Ship *s, Uint32 flags, double relVel);
 	virtual void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform) override;
+	// drawn with the city around it and its own lighting
+	virtual bool CanBatchModel() const override { return false; }
 	virtual void StaticUpdate(const float timeStep) override;
 	virtual void TimeStepUpdate(const float timeStep) override;
 
@@ -125,6 +127,8 @@ private:
 	typedef std::vector<shipDocking_t>::const_iterator constShipDockingIter;
 	typedef std::vector<shipDocking_t>::iterator shipDockingIter;
 	std::vector<shipDocking_t> m_shipDocking;
+	// assign a port's ship, keeping our body references to docking ships in step
+	void SetPortShip(shipDocking_t &sd, Ship *ship);
 
 	SpaceStationType::TPorts m_ports;
 
@@ -11,6 +11,7 @@
 #include "Space.h"
 #include "galaxy/SystemBody.h"
 #include "graphics/Renderer.h"
+#include "terrain/Terrain.h"
 
 TerrainBody::TerrainBody(SystemBody *sbody) :
 	Body(),
@@ -149,6 +150,14 @@ double TerrainBody::GetTerrainHeight(const vector3d &pos_) const
 	}
 }
 
+void TerrainBody::GetCachedTerrainHeights(const vector3d *pos, double *heights, size_t count) const
+{
+	m_baseSphere->GetTerrain()->GetCachedHeights(pos, heights, count);
+	const double radius = m_sbody->GetRadius();
+	for (size_t i = 0; i < count; i++)
+		heights[i] = radius * (1.0 + heights[i]);
+}
+
 //static
 void TerrainBody::OnChangeDetailLevel()
 {
@@ -28,6 +28,11 @@ public:
 	virtual bool OnCollision(Body *b, Uint32 flags, double relVel) override { return true; }
 	virtual double GetMass() const override { return m_mass; }
 	double GetTerrainHeight(const vector3d &pos) const;
+	// the same for several points from the terrain's height cache, for the
+	// per-step terrain collisions: much cheaper, but only to within the
+	// cache's grid. placing, landing and one-off probes want the exact
+	// GetTerrainHeight(). pos are unit vectors
+	void GetCachedTerrainHeights(const vector3d *pos, double *heights, size_t count) const;
 	virtual const SystemBody *GetSystemBody() const override { return m_sbody; }
 
 	// returns value in metres
@@ -7,225 +7,70 @@
 #include "CollisionContact.h"
 #include "Geom.h"
 #include "GeomTree.h"
+#include <algorithm>
 
-/* volnode!!!!!!!!!!! */
-struct BvhNode {
-	Aabb aabb;
-
-	/* if geomStart == 0 then not leaf,
-	 * kids[] valid */
-	int numGeoms;
-	Geom **geomStart;
-
-	BvhNode *kids[2];
-
-	BvhNode()
-	{
-		kids[0] = 0;
-		geomStart = 0;
-	}
-
-	bool CollideRay(const vector3d &start, const vector3d &invDir, isect_t *isect)
+namespace {
+	// the checks on a pair of geoms before colliding their meshes
+	bool ShouldCollide(const Geom *g, const Geom *g2)
 	{
-		PROFILE_SCOPED()
-		double
-			l1 = (aabb.min.x - start.x) * invDir.x,
-			l2 = (aabb.max.x - start.x) * invDir.x,
-			lmin = std::min(l1, l2),
-			lmax = std::max(l1, l2);
-
-		l1 = (aabb.min.y - start.y) * invDir.y;
-		l2 = (aabb.max.y - start.y) * invDir.y;
-		lmin = std::max(std::min(l1, l2), lmin);
-		lmax = std::min(std::max(l1, l2), lmax);
-
-		l1 = (aabb.min.z - start.z) * invDir.z;
-		l2 = (aabb.max.z - start.z) * invDir.z;
-		lmin = std::max(std::min(l1, l2), lmin);
-		lmax = std::min(std::max(l1, l2), lmax);
-
-		return ((lmax >= 0.f) & (lmax >= lmin) & (lmin < isect->dist));
+		if (!g2->IsEnabled()) return false;
+		if (g2 == g) return false;
+		if (g->GetGroup() && g2->GetGroup() == g->GetGroup()) return false;
+		const double radius = g->GetGeomTree()->GetRadius();
+		const double radius2 = g2->GetGeomTree()->GetRadius();
+		return (g->GetPosition() - g2->GetPosition()).Length() <= (radius + radius2);
 	}
-};
 
-/*
- * Tree of objects in collision space (one tree for static objects, one for
- * dynamic)
- */
-class BvhTree {
-public:
-	Geom **m_geoms;
-	BvhNode *m_root;
-	BvhNode *m_nodesAlloc;
-	int m_nodesAllocPos;
-	int m_nodesAllocMax;
-
-	BvhNode *AllocNode()
+	void SetGeomContact(const Geom *g, const vector3d &start, const vector3d &dir, double len, const isect_t &isect, CollisionContact *c)
 	{
-		assert(m_nodesAllocPos < m_nodesAllocMax);
-		return &m_nodesAlloc[m_nodesAllocPos++];
+		c->pos = start + dir * double(isect.dist);
+
+		vector3f n = g->GetGeomTree()->GetTriNormal(isect.triIdx);
+		c->normal = vector3d(n.x, n.y, n.z);
+		c->normal = g->GetTransform().ApplyRotationOnly(c->normal);
+
+		c->depth = len - isect.dist;
+		c->triIdx = isect.triIdx;
+		c->userData1 = g->GetUserData();
+		c->userData2 = 0;
+		c->geomFlag = g->GetGeomTree()->GetTriFlag(isect.triIdx);
+		c->distance = isect.dist;
 	}
 
-	// Avoid re-allocation of memory when m_geoms are less than before,
-	void Refresh(const std::list<Geom *> &m_geoms);
+	struct RayBatch {
+		std::vector<Uint32> rays;
+		std::vector<vector3f> starts;
+		std::vector<vector3f> dirs;
+		std::vector<isect_t> isects;
+	};
 
-	BvhTree(const std::list<Geom *> &geoms);
-	~BvhTree()
+	// trace the rays in batch.rays against one geom, in model space
+	void TraceGeomBatch(const Geom *g, RayBatch &batch, const CollisionRay *rays, CollisionContact *contacts)
 	{
-		FreeAll();
-	}
-	void CollideGeom(Geom *, const Aabb &, int minMailboxValue, void (*callback)(CollisionContact *));
-
-private:
-	void BuildNode(BvhNode *node, const std::list<Geom *> &a_geoms, int &outGeomPos);
-
-	void FreeAll() {
-		if (m_geoms) delete[] m_geoms;
-		m_geoms = nullptr;
-		if (m_nodesAlloc) delete[] m_nodesAlloc;
-		m_nodesAlloc = nullptr;
-	}
-};
-
-BvhTree::BvhTree(const std::list<Geom *> &geoms)
-{
-	PROFILE_SCOPED()
-	m_geoms = nullptr;
-	m_nodesAlloc = nullptr;
-	int numGeoms = geoms.size();
-	if (numGeoms == 0) {
-		m_root = nullptr;
-		return;
-	}
-	m_geoms = new Geom *[numGeoms];
-	int geomPos = 0;
-	m_nodesAllocPos = 0;
-	m_nodesAllocMax = numGeoms * 2;
-	m_nodesAlloc = new BvhNode[m_nodesAllocMax];
-	m_root = AllocNode();
-	BuildNode(m_root, geoms, geomPos);
-	assert(geomPos == numGeoms);
-}
-
-void BvhTree::Refresh(const std::list<Geom *> &geoms)
-{
-	PROFILE_SCOPED()
-	int numGeoms = geoms.size();
-	if (numGeoms == 0) {
-		m_root = nullptr;
-		FreeAll();
-		return;
-	}
-	int geomPos = 0;
-	m_nodesAllocPos = 0;
-	m_root = AllocNode();
-	BuildNode(m_root, geoms, geomPos);
-	assert(geomPos == numGeoms);
-}
-
-void BvhTree::CollideGeom(Geom *g, const Aabb &geomAabb, int minMailboxValue, void (*callback)(CollisionContact *))
-{
-	PROFILE_SCOPED()
-	if (!m_root) return;
-
-	// our big aabb
-	vector3d pos = g->GetPosition();
-	double radius = g->GetGeomTree()->GetRadius();
-
-	int stackPos = -1;
-	BvhNode *stack[16];
-	BvhNode *node = m_root;
-
-	for (;;) {
-		if (geomAabb.Intersects(node->aabb)) {
-			if (node->geomStart) {
-				for (int i = 0; i < node->numGeoms; i++) {
-					Geom *g2 = node->geomStart[i];
-					if (!g2->IsEnabled()) continue;
-					if (g2->GetMailboxIndex() < minMailboxValue) continue;
-					if (g2 == g) continue;
-					if (g->GetGroup() && g2->GetGroup() == g->GetGroup()) continue;
-					double radius2 = g2->GetGeomTree()->GetRadius();
-					vector3d pos2 = g2->GetPosition();
-					if ((pos - pos2).Length() <= (radius + radius2)) {
-						g->Collide(g2, callback);
-					}
-				}
-			} else if (node->kids[0]) {
-				stack[++stackPos] = node->kids[0];
-				node = node->kids[1];
-				continue;
-			}
-		}
-
-		if (stackPos < 0) break;
-		node = stack[stackPos--];
-	}
-}
-
-void BvhTree::BuildNode(BvhNode *node, const std::list<Geom *> &a_geoms, int &outGeomPos)
-{
-	PROFILE_SCOPED()
-	const int numGeoms = a_geoms.size();
-	// make aabb from spheres
-	// XXX suboptimal for static objects, as they have fixed rotation so
-	// we can use a precise rotated aabb rather than worst case XXX
-	Aabb aabb;
-	aabb.min = vector3d(FLT_MAX, FLT_MAX, FLT_MAX);
-	aabb.max = vector3d(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-
-	for (std::list<Geom *>::const_iterator i = a_geoms.begin();
-		 i != a_geoms.end(); ++i) {
-		vector3d p = (*i)->GetPosition();
-		double rad = (*i)->GetGeomTree()->GetRadius();
-		aabb.Update(p + vector3d(rad, rad, rad));
-		aabb.Update(p - vector3d(rad, rad, rad));
-	}
-
-	// divide by longest axis
-	int axis;
-	const vector3d axislen = aabb.max - aabb.min;
-	if ((axislen.x > axislen.y) && (axislen.x > axislen.z))
-		axis = 0;
-	else if (axislen.y > axislen.z)
-		axis = 1;
-	else
-		axis = 2;
-	const double pivot = 0.5 * (aabb.max[axis] + aabb.min[axis]);
-
-	std::list<Geom *> side[2];
-
-	for (std::list<Geom *>::const_iterator i = a_geoms.begin();
-		 i != a_geoms.end(); ++i) {
-		if ((*i)->GetPosition()[axis] < pivot) {
-			side[0].push_back(*i);
-		} else {
-			side[1].push_back(*i);
+		const size_t count = batch.rays.size();
+		const matrix4x4d &invTrans = g->GetInvTransform();
+		batch.starts.resize(count);
+		batch.dirs.resize(count);
+		batch.isects.resize(count);
+		for (size_t i = 0; i < count; i++) {
+			const CollisionRay &ray = rays[batch.rays[i]];
+			const vector3d ms = invTrans * ray.start;
+			const vector3d md = invTrans.ApplyRotationOnly(ray.dir);
+			batch.starts[i] = vector3f(ms.x, ms.y, ms.z);
+			batch.dirs[i] = vector3f(md.x, md.y, md.z);
+			batch.isects[i].dist = float(contacts[batch.rays[i]].distance);
+			batch.isects[i].triIdx = -1;
 		}
-	}
 
-	node->numGeoms = numGeoms;
-	node->aabb = aabb;
+		g->GetGeomTree()->TraceRays(int(count), &batch.starts[0], &batch.dirs[0], &batch.isects[0]);
 
-	// side 1 has all nodes. just make a fucking child
-	if ((side[0].size() == 0) || (side[1].size() == 0)) {
-		node->geomStart = &m_geoms[outGeomPos];
-
-		// copy geoms to the stinking flat array
-		for (std::list<Geom *>::const_iterator i = a_geoms.begin();
-			 i != a_geoms.end(); ++i) {
-			m_geoms[outGeomPos++] = *i;
+		for (size_t i = 0; i < count; i++) {
+			if (batch.isects[i].triIdx == -1) continue;
+			const CollisionRay &ray = rays[batch.rays[i]];
+			SetGeomContact(g, ray.start, ray.dir, ray.len, batch.isects[i], &contacts[batch.rays[i]]);
 		}
-	} else {
-		// recurse!
-		node->geomStart = 0;
-		node->kids[0] = AllocNode();
-		node->kids[1] = AllocNode();
-
-		BuildNode(node->kids[0], side[0], outGeomPos);
-		BuildNode(node->kids[1], side[1], outGeomPos);
 	}
-}
+} // namespace
 
 ///////////////////////////////////////////////////////////////////////
 
@@ -236,28 +81,27 @@ CollisionSpace::CollisionSpace()
 	PROFILE_SCOPED()
 	sphere.radius = 0;
 	m_needStaticGeomRebuild = true;
-	m_oldGeomsNumber = 0;
-	m_staticObjectTree = nullptr;
-	m_dynamicObjectTree = nullptr;
+	m_needDynamicGeomRebuild = true;
+	m_sphereChanged = true;
+	m_collideStamp = 0;
 }
 
 CollisionSpace::~CollisionSpace()
 {
-	PROFILE_SCOPED()
-	if (m_staticObjectTree) delete m_staticObjectTree;
-	if (m_dynamicObjectTree) delete m_dynamicObjectTree;
 }
 
 void CollisionSpace::AddGeom(Geom *geom)
 {
 	PROFILE_SCOPED()
 	m_geoms.push_back(geom);
+	m_needDynamicGeomRebuild = true;
 }
 
 void CollisionSpace::RemoveGeom(Geom *geom)
 {
 	PROFILE_SCOPED()
 	m_geoms.remove(geom);
+	m_needDynamicGeomRebuild = true;
 }
 
 void CollisionSpace::AddStaticGeom(Geom *geom)
@@ -311,59 +155,24 @@ void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double
 	vector3d invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
 	c->distance = len;
 
-	BvhNode *vn_stack[16];
-	BvhNode *node = m_staticObjectTree->m_root;
-	int stackPos = -1;
+	m_staticObjectTree.QueryRay(start, invDir, c->distance, [&](Uint32 index, double &maxDist) {
+		Geom *g = m_staticTreeGeoms[index];
 
-	for (; node;) {
-		// do we hit it?
-		{
-			isect_t isect;
-			isect.dist = float(c->distance);
-			isect.triIdx = -1;
-			if (!node->CollideRay(start, invDir, &isect)) goto pop_jizz;
-		}
+		const matrix4x4d &invTrans = g->GetInvTransform();
+		vector3d ms = invTrans * start;
+		vector3d md = invTrans.ApplyRotationOnly(dir);
+		vector3f modelStart = vector3f(ms.x, ms.y, ms.z);
+		vector3f modelDir = vector3f(md.x, md.y, md.z);
 
-		if (node->geomStart) {
-			// it is a leaf node
-			// collide with all geoms
-			for (int i = 0; i < node->numGeoms; i++) {
-				Geom *g = node->geomStart[i];
-
-				const matrix4x4d &invTrans = g->GetInvTransform();
-				vector3d ms = invTrans * start;
-				vector3d md = invTrans.ApplyRotationOnly(dir);
-				vector3f modelStart = vector3f(ms.x, ms.y, ms.z);
-				vector3f modelDir = vector3f(md.x, md.y, md.z);
-
-				isect_t isect;
-				isect.dist = float(c->distance);
-				isect.triIdx = -1;
-				g->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
-				if (isect.triIdx != -1) {
-					c->pos = start + dir * double(isect.dist);
-
-					vector3f n = g->GetGeomTree()->GetTriNormal(isect.triIdx);
-					c->normal = vector3d(n.x, n.y, n.z);
-					c->normal = g->GetTransform().ApplyRotationOnly(c->normal);
-
-					c->depth = len - isect.dist;
-					c->triIdx = isect.triIdx;
-					c->userData1 = g->GetUserData();
-					c->userData2 = 0;
-					c->geomFlag = g->GetGeomTree()->GetTriFlag(isect.triIdx);
-					c->distance = isect.dist;
-				}
-			}
-		} else if (node->kids[0]) {
-			vn_stack[++stackPos] = node->kids[0];
-			node = node->kids[1];
-			continue;
+		isect_t isect;
+		isect.dist = float(c->distance);
+		isect.triIdx = -1;
+		g->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
+		if (isect.triIdx != -1) {
+			SetGeomContact(g, start, dir, len, isect, c);
+			maxDist = c->distance;
 		}
-	pop_jizz:
-		if (stackPos < 0) break;
-		node = vn_stack[stackPos--];
-	}
+	});
 
 	for (std::list<Geom *>::iterator i = m_geoms.begin(); i != m_geoms.end(); ++i) {
 		if ((*i) == ignore) continue;
@@ -378,47 +187,95 @@ void CollisionSpace::TraceRay(const vector3d &start, const vector3d &dir, double
 			isect.dist = float(c->distance);
 			isect.triIdx = -1;
 			(*i)->GetGeomTree()->TraceRay(modelStart, modelDir, &isect);
-			if (isect.triIdx != -1) {
-				c->pos = start + dir * double(isect.dist);
-
-				vector3f n = (*i)->GetGeomTree()->GetTriNormal(isect.triIdx);
-				c->normal = vector3d(n.x, n.y, n.z);
-				c->normal = (*i)->GetTransform().ApplyRotationOnly(c->normal);
-
-				c->depth = len - isect.dist;
-				c->triIdx = isect.triIdx;
-				c->userData1 = (*i)->GetUserData();
-				c->userData2 = 0;
-				c->geomFlag = (*i)->GetGeomTree()->GetTriFlag(isect.triIdx);
-				c->distance = isect.dist;
-			}
+			if (isect.triIdx != -1)
+				SetGeomContact(*i, start, dir, len, isect, c);
 		}
 	}
-	{
-		isect_t isect;
-		isect.dist = float(c->distance);
-		isect.triIdx = -1;
-		CollideRaySphere(start, dir, &isect);
-		if (isect.triIdx != -1) {
-			c->pos = start + dir * double(isect.dist);
-			c->normal = vector3d(0.0);
-			c->depth = len - isect.dist;
-			c->triIdx = -1;
-			c->userData1 = sphere.userData;
-			c->userData2 = 0;
-			c->geomFlag = 0;
-			c->distance = isect.dist;
+
+	TraceRaySphere(start, dir, len, c);
+}
+
+void CollisionSpace::TraceRays(size_t numRays, const CollisionRay *rays, CollisionContact *contacts)
+{
+	PROFILE_SCOPED()
+	if (!numRays) return;
+
+	// bin the rays by the static geoms they might hit, so each geom's
+	// triangle tree is walked once for all of them
+	std::vector<std::pair<Uint32, Uint32>> candidates; // (geom, ray)
+	for (size_t r = 0; r < numRays; r++) {
+		const CollisionRay &ray = rays[r];
+		contacts[r] = CollisionContact();
+		contacts[r].distance = ray.len;
+		const vector3d invDir(1.0 / ray.dir.x, 1.0 / ray.dir.y, 1.0 / ray.dir.z);
+		m_staticObjectTree.QueryRay(ray.start, invDir, ray.len, [&](Uint32 index, double &) {
+			candidates.push_back(std::make_pair(index, Uint32(r)));
+		});
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	RayBatch batch;
+	for (size_t c = 0; c < candidates.size();) {
+		const Uint32 geomIndex = candidates[c].first;
+		batch.rays.clear();
+		for (; c < candidates.size() && candidates[c].first == geomIndex; c++)
+			batch.rays.push_back(candidates[c].second);
+		TraceGeomBatch(m_staticTreeGeoms[geomIndex], batch, rays, contacts);
+	}
+
+	// dynamic geoms, with the rays that pass within their bounding sphere
+	for (Geom *g : m_geoms) {
+		if (!g->IsEnabled()) continue;
+		const vector3d pos = g->GetPosition();
+		const double radius = g->GetGeomTree()->GetRadius();
+		batch.rays.clear();
+		for (size_t r = 0; r < numRays; r++) {
+			const CollisionRay &ray = rays[r];
+			if (ray.ignore == g) continue;
+			const vector3d v = pos - ray.start;
+			const double along = Clamp(v.Dot(ray.dir), 0.0, contacts[r].distance);
+			if ((v - ray.dir * along).LengthSqr() <= radius * radius)
+				batch.rays.push_back(Uint32(r));
 		}
+		if (!batch.rays.empty())
+			TraceGeomBatch(g, batch, rays, contacts);
+	}
+
+	for (size_t r = 0; r < numRays; r++)
+		TraceRaySphere(rays[r].start, rays[r].dir, rays[r].len, &contacts[r]);
+}
+
+void CollisionSpace::TraceRaySphere(const vector3d &start, const vector3d &dir, double len, CollisionContact *c)
+{
+	isect_t isect;
+	isect.dist = float(c->distance);
+	isect.triIdx = -1;
+	CollideRaySphere(start, dir, &isect);
+	if (isect.triIdx != -1) {
+		c->pos = start + dir * double(isect.dist);
+		c->normal = vector3d(0.0);
+		c->depth = len - isect.dist;
+		c->triIdx = -1;
+		c->userData1 = sphere.userData;
+		c->userData2 = 0;
+		c->geomFlag = 0;
+		c->distance = isect.dist;
 	}
 }
 
 /*
- * Do not collide objects with mailbox value < minMailboxValue
+ * Do not collide objects with mailbox value < minMailboxValue, unless
+ * they're asleep
  */
 void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, void (*callback)(CollisionContact *))
 {
 	PROFILE_SCOPED()
+	GeomRestState &state = m_restStates[a->GetMailboxIndex()];
+	state.contacts.clear();
+	state.stamp = 0;
 	if (!a->IsEnabled()) return;
+	state.stamp = m_collideStamp;
+
 	// our big aabb
 	vector3d pos = a->GetPosition();
 	double radius = a->GetGeomTree()->GetRadius();
@@ -426,44 +283,123 @@ void CollisionSpace::CollideGeoms(Geom *a, int minMailboxValue, void (*callback)
 	ourAabb.min = pos - vector3d(radius, radius, radius);
 	ourAabb.max = pos + vector3d(radius, radius, radius);
 
-	if (m_staticObjectTree) m_staticObjectTree->CollideGeom(a, ourAabb, 0, callback);
-	if (m_dynamicObjectTree) m_dynamicObjectTree->CollideGeom(a, ourAabb, minMailboxValue, callback);
+	// keep a copy of each contact, in case the geom goes to sleep
+	const Geom *other = nullptr;
+	bool otherIsDynamic = false;
+	const Geom::ContactCallback record = [&](CollisionContact *c) {
+		RestingContact rc;
+		rc.other = other;
+		rc.otherIsDynamic = otherIsDynamic;
+		rc.contact = *c;
+		state.contacts.push_back(rc);
+		callback(c);
+	};
+
+	m_staticObjectTree.QueryAabb(ourAabb, [&](Uint32 index) {
+		Geom *g2 = m_staticTreeGeoms[index];
+		if (!ShouldCollide(a, g2)) return;
+		other = g2;
+		otherIsDynamic = false;
+		a->Collide(g2, record);
+	});
+	m_dynamicObjectTree.QueryAabb(ourAabb, [&](Uint32 index) {
+		Geom *g2 = m_dynamicTreeGeoms[index];
+		// sleeping geoms don't look for contacts themselves, so whatever
+		// is awake collides with them
+		if (g2->GetMailboxIndex() < minMailboxValue && !m_restStates[g2->GetMailboxIndex()].asleep) return;
+		if (!ShouldCollide(a, g2)) return;
+		other = g2;
+		otherIsDynamic = true;
+		a->Collide(g2, record);
+	});
 
 	/* test the fucker against the planet sphere thing */
 	if (sphere.radius > 0.0) {
-		a->CollideSphere(sphere, callback);
+		other = nullptr;
+		otherIsDynamic = false;
+		a->CollideSphere(sphere, record);
 	}
 }
 
-void CollisionSpace::RebuildObjectTrees()
+// a sleeping geom hasn't moved, and nor has anything it was touching, so
+// the contacts it found when it was last awake still hold
+void CollisionSpace::ReplayRestingContacts(const GeomRestState &state, void (*callback)(CollisionContact *))
 {
 	PROFILE_SCOPED()
-	if (m_needStaticGeomRebuild) {
-		if (m_staticObjectTree) delete m_staticObjectTree;
-		m_staticObjectTree = new BvhTree(m_staticGeoms);
+	for (const RestingContact &rc : state.contacts) {
+		if (rc.otherIsDynamic) {
+			// the pair is collided by the other geom if it's awake, and
+			// is in its contacts instead if it has been awake since
+			const GeomRestState &other = m_restStates[rc.other->GetMailboxIndex()];
+			if (!other.asleep || other.stamp > state.stamp) continue;
+		}
+		CollisionContact c = rc.contact;
+		callback(&c);
 	}
-	if (m_oldGeomsNumber < m_geoms.size()) {
-		// Have more geoms: rebuild completely (ask more memory)
-		if (m_dynamicObjectTree) delete m_dynamicObjectTree;
-		m_dynamicObjectTree = new BvhTree(m_geoms);
-	} else {
-		// Same number or less (no needs for more memory)
-		if (m_dynamicObjectTree) m_dynamicObjectTree->Refresh(m_geoms);
-		else m_dynamicObjectTree = new BvhTree(m_geoms);
+}
+
+// bounds from the geoms' bounding spheres
+// XXX suboptimal for static objects, as they have fixed rotation so
+// we can use a precise rotated aabb rather than worst case XXX
+void CollisionSpace::GetGeomBounds(const std::vector<Geom *> &geoms, std::vector<Aabb> &bounds)
+{
+	bounds.resize(geoms.size());
+	for (size_t i = 0; i < geoms.size(); i++) {
+		const vector3d p = geoms[i]->GetPosition();
+		const double rad = geoms[i]->GetGeomTree()->GetRadius();
+		bounds[i].min = p - vector3d(rad, rad, rad);
+		bounds[i].max = p + vector3d(rad, rad, rad);
 	}
+}
 
-	m_oldGeomsNumber = m_geoms.size();
+void CollisionSpace::RebuildObjectTrees()
+{
+	PROFILE_SCOPED()
+	if (m_needStaticGeomRebuild) {
+		m_staticTreeGeoms.assign(m_staticGeoms.begin(), m_staticGeoms.end());
+		GetGeomBounds(m_staticTreeGeoms, m_geomBounds);
+		m_staticObjectTree.Build(m_geomBounds);
+		m_needStaticGeomRebuild = false;
+	}
 
-	m_needStaticGeomRebuild = false;
+	// dynamic geoms have moved since last time. while they're the same set
+	// the tree only needs its bounds updating
+	if (m_needDynamicGeomRebuild)
+		m_dynamicTreeGeoms.assign(m_geoms.begin(), m_geoms.end());
+	GetGeomBounds(m_dynamicTreeGeoms, m_geomBounds);
+	if (m_needDynamicGeomRebuild || !m_dynamicObjectTree.Refit(m_geomBounds))
+		m_dynamicObjectTree.Build(m_geomBounds);
+	m_needDynamicGeomRebuild = false;
 }
 
 void CollisionSpace::Collide(void (*callback)(CollisionContact *))
 {
 	PROFILE_SCOPED()
+	// resting contacts hold only while nothing but dynamic geoms moves
+	bool wakeAll = m_needStaticGeomRebuild || m_needDynamicGeomRebuild || m_sphereChanged;
+	for (Geom *g : m_staticGeoms) {
+		wakeAll |= g->HasMoved();
+		g->ClearMoved();
+	}
+	m_sphereChanged = false;
+
 	RebuildObjectTrees();
 
+	if (++m_collideStamp == 0) {
+		wakeAll = true;
+		m_collideStamp = 1;
+	}
+	if (wakeAll)
+		m_restStates.clear();
+	m_restStates.resize(m_geoms.size());
+
+	// a geom sleeps when it hasn't moved since it last found its contacts.
+	// m_restStates is by mailbox index, which only changes with the geoms
 	int mailboxMin = 0;
 	for (std::list<Geom *>::iterator i = m_geoms.begin(); i != m_geoms.end(); ++i) {
+		GeomRestState &state = m_restStates[mailboxMin];
+		state.asleep = (state.stamp != 0) && (*i)->IsEnabled() && !(*i)->HasMoved();
+		(*i)->ClearMoved();
 		(*i)->SetMailboxIndex(mailboxMin++);
 	}
 
@@ -471,6 +407,10 @@ void CollisionSpace::Collide(void (*callback)(CollisionContact *))
 	 * attempt collision(b,a) */
 	mailboxMin = 1;
 	for (std::list<Geom *>::iterator i = m_geoms.begin(); i != m_geoms.end(); ++i, mailboxMin++) {
-		CollideGeoms(*i, mailboxMin, callback);
+		const GeomRestState &state = m_restStates[mailboxMin - 1];
+		if (state.asleep)
+			ReplayRestingContacts(state, callback);
+		else
+			CollideGeoms(*i, mailboxMin, callback);
 	}
 }
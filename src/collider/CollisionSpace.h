@@ -5,11 +5,13 @@
 #define _COLLISION_SPACE
 
 #include "../vector3.h"
+#include "CollisionContact.h"
+#include "ObjectTree.h"
 #include <list>
+#include <vector>
 
 class Geom;
 struct isect_t;
-struct CollisionContact;
 
 struct Sphere {
 	vector3d pos;
@@ -17,13 +19,20 @@ struct Sphere {
 	void *userData;
 };
 
-class BvhTree;
+struct CollisionRay {
+	vector3d start;
+	vector3d dir; // unit length
+	double len;
+	const Geom *ignore;
+};
 
 /*
  * Collision spaces have a bunch of geoms and at most one sphere (for a planet).
+ *
+ * Dynamic geoms that haven't moved since they were last collided are
+ * asleep: they skip the broadphase and narrowphase and replay the contacts
+ * they found then, until they (or any static geom or the sphere) move.
  */
-// FIXME: CollisionSpace is NOT MOVE/COPY CONSTRUCTIBLE once RebuildObjectTrees
-// has been called. It will cause a double-free due to owning pointers being moved-by-copy.
 class CollisionSpace {
 public:
 	CollisionSpace();
@@ -33,9 +42,13 @@ public:
 	void AddStaticGeom(Geom *);
 	void RemoveStaticGeom(Geom *);
 	void TraceRay(const vector3d &start, const vector3d &dir, double len, CollisionContact *c, const Geom *ignore = nullptr);
+	// TraceRay for numRays rays at once, leaving the nearest hit for
+	// rays[i] in contacts[i]. cheaper than tracing them one by one
+	void TraceRays(size_t numRays, const CollisionRay *rays, CollisionContact *contacts);
 	void Collide(void (*callback)(CollisionContact *));
 	void SetSphere(const vector3d &pos, double radius, void *user_data)
 	{
+		m_sphereChanged = true;
 		sphere.pos = pos;
 		sphere.radius = radius;
 		sphere.userData = user_data;
@@ -54,17 +67,44 @@ public:
 	}
 
 private:
+	struct RestingContact {
+		const Geom *other; // nullptr for the sphere
+		bool otherIsDynamic;
+		CollisionContact contact;
+	};
+	struct GeomRestState {
+		GeomRestState() :
+			stamp(0),
+			asleep(false) {}
+		// contacts from the narrowphase tests this geom made
+		std::vector<RestingContact> contacts;
+		// the Collide() they were found in, zero if none
+		Uint32 stamp;
+		bool asleep;
+	};
+
 	void CollideGeoms(Geom *a, int minMailboxValue, void (*callback)(CollisionContact *));
+	void ReplayRestingContacts(const GeomRestState &state, void (*callback)(CollisionContact *));
 	void CollideRaySphere(const vector3d &start, const vector3d &dir, isect_t *isect);
+	void TraceRaySphere(const vector3d &start, const vector3d &dir, double len, CollisionContact *c);
+	static void GetGeomBounds(const std::vector<Geom *> &geoms, std::vector<Aabb> &bounds);
 	std::list<Geom *> m_geoms;
 	std::list<Geom *> m_staticGeoms;
 	bool m_needStaticGeomRebuild;
-	BvhTree *m_staticObjectTree;
-	BvhTree *m_dynamicObjectTree;
+	// the dynamic tree is refit while the set of geoms stays the same
+	bool m_needDynamicGeomRebuild;
+	ObjectTree m_staticObjectTree;
+	ObjectTree m_dynamicObjectTree;
+	// the geoms in each tree, by the tree's object index
+	std::vector<Geom *> m_staticTreeGeoms;
+	std::vector<Geom *> m_dynamicTreeGeoms;
+	std::vector<Aabb> m_geomBounds;
+	// by geom mailbox index
+	std::vector<GeomRestState> m_restStates;
+	Uint32 m_collideStamp;
+	bool m_sphereChanged;
 	Sphere sphere;
 
-	uint32_t m_oldGeomsNumber;
-
 	static int s_nextHandle;
 };
 
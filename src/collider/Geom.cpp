@@ -19,10 +19,12 @@ Geom::Geom(const GeomTree *geomtree, const matrix4x4d &m, const vector3d &pos, v
 	m_data(data),
 	m_group(0),
 	m_mailboxIndex(0),
-	m_active(true)
+	m_active(true),
+	m_moved(true)
 {
 	m_orient.SetTranslate(pos);
 	m_invOrient = m_orient.Inverse();
+	m_restOrient = m_orient;
 }
 
 /*matrix4x4d Geom::GetRotation() const
@@ -33,9 +35,26 @@ Geom::Geom(const GeomTree *geomtree, const matrix4x4d &m, const vector3d &pos, v
 	return m;
 }*/
 
+// how far a geom can wander before it counts as having moved. rotation
+// is compared per matrix element, position in metres
+static const double MOVE_ROTATION_EPSILON = 1e-7;
+static const double MOVE_POSITION_EPSILON = 1e-4;
+
+static bool IsNearTransform(const matrix4x4d &a, const matrix4x4d &b)
+{
+	for (int i = 0; i < 12; i++) {
+		if (fabs(a[i] - b[i]) > MOVE_ROTATION_EPSILON) return false;
+	}
+	for (int i = 12; i < 15; i++) {
+		if (fabs(a[i] - b[i]) > MOVE_POSITION_EPSILON) return false;
+	}
+	return true;
+}
+
 void Geom::MoveTo(const matrix4x4d &m)
 {
 	PROFILE_SCOPED()
+	if (!IsNearTransform(m, m_restOrient)) m_moved = true;
 	m_orient = m;
 	m_pos = m_orient.GetTranslate();
 	m_invOrient = m.Inverse();
@@ -44,13 +63,15 @@ void Geom::MoveTo(const matrix4x4d &m)
 void Geom::MoveTo(const matrix4x4d &m, const vector3d &pos)
 {
 	PROFILE_SCOPED()
-	m_orient = m;
+	matrix4x4d orient = m;
+	orient.SetTranslate(pos);
+	if (!IsNearTransform(orient, m_restOrient)) m_moved = true;
+	m_orient = orient;
 	m_pos = pos;
-	m_orient.SetTranslate(pos);
 	m_invOrient = m_orient.Inverse();
 }
 
-void Geom::CollideSphere(Sphere &sphere, void (*callback)(CollisionContact *)) const
+void Geom::CollideSphere(Sphere &sphere, const ContactCallback &callback) const
 {
 	PROFILE_SCOPED()
 	/* if the geom is actually within the sphere, create a contact so
@@ -75,7 +96,7 @@ void Geom::CollideSphere(Sphere &sphere, void (*callback)(CollisionContact *)) c
  * This geom has moved, causing a possible collision with geom b.
  * Collide meshes to see.
  */
-void Geom::Collide(Geom *b, void (*callback)(CollisionContact *)) const
+void Geom::Collide(Geom *b, const ContactCallback &callback) const
 {
 	PROFILE_SCOPED()
 	int max_contacts = MAX_CONTACTS;
@@ -119,7 +140,7 @@ static bool rotatedAabbIsectsNormalOne(Aabb &a, const matrix4x4d &transA, Aabb &
  * Intersect this Geom's edge BVH tree with geom b's triangle BVH tree.
  * Generate collision contacts.
  */
-void Geom::CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact *)) const
+void Geom::CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, const ContactCallback &callback) const
 {
 	PROFILE_SCOPED()
 	struct stackobj {
@@ -181,7 +202,7 @@ void Geom::CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4
  * BVH of another geom (b), starting from btriNode.
  */
 void Geom::CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-	const Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact *)) const
+	const Geom *b, const BVHNode *btriNode, const ContactCallback &callback) const
 {
 	PROFILE_SCOPED()
 	if (maxContacts <= 0) return;
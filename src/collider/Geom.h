@@ -6,6 +6,7 @@
 
 #include "../matrix4x4.h"
 #include "../vector3.h"
+#include <functional>
 
 struct CollisionContact;
 class GeomTree;
@@ -15,6 +16,10 @@ struct BVHNode;
 
 class Geom {
 public:
+	// called with each contact found. may carry state, so the caller's
+	// bookkeeping stays per collision pass
+	typedef std::function<void(CollisionContact *)> ContactCallback;
+
 	Geom(const GeomTree *geomtree, const matrix4x4d &m, const vector3d &pos, void *data);
 	void MoveTo(const matrix4x4d &m);
 	void MoveTo(const matrix4x4d &m, const vector3d &pos);
@@ -26,29 +31,42 @@ public:
 	inline void Disable() { m_active = false; }
 	inline bool IsEnabled() const { return m_active; }
 	inline const GeomTree *GetGeomTree() const { return m_geomtree; }
-	void Collide(Geom *b, void (*callback)(CollisionContact *)) const;
-	void CollideSphere(Sphere &sphere, void (*callback)(CollisionContact *)) const;
+	void Collide(Geom *b, const ContactCallback &callback) const;
+	void CollideSphere(Sphere &sphere, const ContactCallback &callback) const;
 	inline void *GetUserData() const { return m_data; }
 	inline void SetMailboxIndex(int idx) { m_mailboxIndex = idx; }
 	inline int GetMailboxIndex() const { return m_mailboxIndex; }
 	inline void SetGroup(int g) { m_group = g; }
 	inline int GetGroup() const { return m_group; }
+	// set when MoveTo() takes the transform further than a small tolerance
+	// from where it was when the collision space last saw it move, so
+	// jitter doesn't count but slow drift eventually does
+	inline bool HasMoved() const { return m_moved; }
+	inline void ClearMoved()
+	{
+		if (!m_moved) return;
+		m_restOrient = m_orient;
+		m_moved = false;
+	}
 
 	matrix4x4d m_animTransform;
 
 private:
-	void CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, void (*callback)(CollisionContact *)) const;
+	void CollideEdgesWithTrisOf(int &maxContacts, const Geom *b, const matrix4x4d &transTo, const ContactCallback &callback) const;
 	void CollideEdgesTris(int &maxContacts, const BVHNode *edgeNode, const matrix4x4d &transToB,
-		const Geom *b, const BVHNode *btriNode, void (*callback)(CollisionContact *)) const;
+		const Geom *b, const BVHNode *btriNode, const ContactCallback &callback) const;
 
 	// double-buffer position so we can keep previous position
 	matrix4x4d m_orient, m_invOrient;
+	// transform as of the last move that counted, see HasMoved()
+	matrix4x4d m_restOrient;
 	vector3d m_pos;
 	const GeomTree *m_geomtree;
 	void *m_data;
 	int m_group;
 	int m_mailboxIndex; // used to avoid duplicate collisions
 	bool m_active;
+	bool m_moved;
 };
 
 #endif /* _GEOM_H */
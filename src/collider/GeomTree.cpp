@@ -281,6 +281,64 @@ void GeomTree::TraceRay(const BVHNode *currnode, const vector3f &a_origin, const
 	}
 }
 
+void GeomTree::TraceRays(int numRays, const vector3f *starts, const vector3f *dirs, isect_t *isects) const
+{
+	PROFILE_SCOPED()
+	for (int first = 0; first < numRays; first += MAX_PACKET_RAYS)
+		TracePacket(std::min(int(MAX_PACKET_RAYS), numRays - first), starts + first, dirs + first, isects + first);
+}
+
+void GeomTree::TracePacket(int numRays, const vector3f *starts, const vector3f *dirs, isect_t *isects) const
+{
+	PROFILE_SCOPED()
+	vector3f invDirs[MAX_PACKET_RAYS];
+	for (int i = 0; i < numRays; i++) {
+		const vector3f &d = dirs[i];
+		invDirs[i] = vector3f( // avoid division by zero please
+			is_zero_exact(d.x) ? 0.0f : (1.0f / d.x),
+			is_zero_exact(d.y) ? 0.0f : (1.0f / d.y),
+			is_zero_exact(d.z) ? 0.0f : (1.0f / d.z));
+	}
+
+	// each node carries the mask of rays that hit its parent
+	const BVHNode *stack[32];
+	Uint32 stackMask[32];
+	int stackpos = -1;
+	const BVHNode *currnode = m_triTree->GetRoot();
+	Uint32 mask = (numRays == MAX_PACKET_RAYS) ? ~Uint32(0) : ((Uint32(1) << numRays) - 1);
+
+	for (;;) {
+		Uint32 hits = 0;
+		for (int i = 0; i < numRays; i++) {
+			if ((mask & (Uint32(1) << i)) && SlabsRayAabbTest(currnode, starts[i], invDirs[i], &isects[i]))
+				hits |= Uint32(1) << i;
+		}
+
+		if (hits) {
+			if (!currnode->IsLeaf()) {
+				assert(stackpos + 1 < 32);
+				stackpos++;
+				stack[stackpos] = currnode->kids[1];
+				stackMask[stackpos] = hits;
+				currnode = currnode->kids[0];
+				mask = hits;
+				continue;
+			}
+			for (int t = 0; t < currnode->numTris; t++) {
+				for (int i = 0; i < numRays; i++) {
+					if (hits & (Uint32(1) << i))
+						RayTriIntersect(1, starts[i], &dirs[i], currnode->triIndicesStart[t], &isects[i]);
+				}
+			}
+		}
+
+		if (stackpos < 0) break;
+		currnode = stack[stackpos];
+		mask = stackMask[stackpos];
+		stackpos--;
+	}
+}
+
 void GeomTree::RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const
 {
 	// PROFILE_SCOPED()
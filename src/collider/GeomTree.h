@@ -34,6 +34,9 @@ public:
 	// isect.triIdx should be -1 unless repeat calls with same isect_t
 	void TraceRay(const vector3f &start, const vector3f &dir, isect_t *isect) const;
 	void TraceRay(const BVHNode *startNode, const vector3f &a_origin, const vector3f &a_dir, isect_t *isect) const;
+	// as TraceRay, for numRays rays at once. the rays are traced in packets
+	// that walk the tree together, so each node is fetched once per packet
+	void TraceRays(int numRays, const vector3f *starts, const vector3f *dirs, isect_t *isects) const;
 	vector3f GetTriNormal(int triIdx) const;
 	Uint32 GetTriFlag(int triIdx) const { return m_triFlags[triIdx]; }
 	double GetRadius() const { return m_radius; }
@@ -65,6 +68,10 @@ public:
 	int GetNumTris() const { return m_numTris; }
 
 private:
+	// rays per packet, one bit each in the traversal masks
+	static const int MAX_PACKET_RAYS = 32;
+
+	void TracePacket(int numRays, const vector3f *starts, const vector3f *dirs, isect_t *isects) const;
 	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const;
 
 	int m_numVertices;
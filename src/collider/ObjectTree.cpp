@@ -0,0 +1,287 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ObjectTree.h"
+
+#include "profiler/Profiler.h"
+#include <float.h>
+
+namespace {
+	const int SAH_BINS = 16;
+	// one object per leaf, so the four-wide test also culls single objects
+	const Uint32 MAX_LEAF_SIZE = 1;
+	// past this depth splits are made at the median, which keeps the depth
+	// (and so the traversal stack) bounded whatever the input
+	const int MAX_SAH_DEPTH = 48;
+	// rebuild once refitting has made the tree this much more expensive
+	const double REBUILD_COST_RATIO = 1.5;
+
+	void Grow(Aabb &a, const Aabb &b)
+	{
+		a.min.x = std::min(a.min.x, b.min.x);
+		a.min.y = std::min(a.min.y, b.min.y);
+		a.min.z = std::min(a.min.z, b.min.z);
+		a.max.x = std::max(a.max.x, b.max.x);
+		a.max.y = std::max(a.max.y, b.max.y);
+		a.max.z = std::max(a.max.z, b.max.z);
+	}
+
+	void Grow(Aabb &a, const vector3d &p)
+	{
+		a.min.x = std::min(a.min.x, p.x);
+		a.min.y = std::min(a.min.y, p.y);
+		a.min.z = std::min(a.min.z, p.z);
+		a.max.x = std::max(a.max.x, p.x);
+		a.max.y = std::max(a.max.y, p.y);
+		a.max.z = std::max(a.max.z, p.z);
+	}
+
+	double SurfaceArea(const Aabb &a)
+	{
+		if (a.max.x < a.min.x) return 0.0; // empty
+		const vector3d d = a.max - a.min;
+		return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+} // namespace
+
+ObjectTree::ObjectTree() :
+	m_buildCost(0.0)
+{
+}
+
+void ObjectTree::Build(const std::vector<Aabb> &bounds)
+{
+	PROFILE_SCOPED()
+	m_nodes.clear();
+	m_objects.resize(bounds.size());
+	m_buildCost = 0.0;
+	if (bounds.empty()) return;
+
+	Range all;
+	all.begin = 0;
+	all.end = Uint32(bounds.size());
+	m_centroids.resize(bounds.size());
+	for (Uint32 i = 0; i < all.end; i++) {
+		m_objects[i] = i;
+		m_centroids[i] = 0.5 * (bounds[i].min + bounds[i].max);
+		Grow(all.bounds, bounds[i]);
+	}
+
+	BuildNode(bounds, all, 0);
+	m_buildCost = GetCost();
+}
+
+Uint32 ObjectTree::BuildNode(const std::vector<Aabb> &bounds, const Range &range, int depth)
+{
+	const Uint32 nodeIndex = Uint32(m_nodes.size());
+	m_nodes.emplace_back();
+
+	// split the largest child until there are four, or none is worth splitting
+	Range children[4];
+	bool isLeaf[4];
+	Uint32 numChildren = 1;
+	children[0] = range;
+	isLeaf[0] = (range.end - range.begin) <= MAX_LEAF_SIZE;
+
+	while (numChildren < 4) {
+		int largest = -1;
+		for (Uint32 i = 0; i < numChildren; i++) {
+			if (isLeaf[i]) continue;
+			if (largest < 0 || SurfaceArea(children[i].bounds) > SurfaceArea(children[largest].bounds))
+				largest = i;
+		}
+		if (largest < 0) break;
+
+		Range left, right;
+		SplitRange(bounds, children[largest], depth, left, right);
+		children[largest] = left;
+		isLeaf[largest] = (left.end - left.begin) <= MAX_LEAF_SIZE;
+		children[numChildren] = right;
+		isLeaf[numChildren] = (right.end - right.begin) <= MAX_LEAF_SIZE;
+		numChildren++;
+	}
+
+	// m_nodes may be reallocated while building the children
+	Uint32 first[4], count[4];
+	for (Uint32 i = 0; i < numChildren; i++) {
+		if (isLeaf[i]) {
+			first[i] = children[i].begin;
+			count[i] = children[i].end - children[i].begin;
+		} else {
+			first[i] = BuildNode(bounds, children[i], depth + 1);
+			count[i] = 0;
+		}
+	}
+
+	Node &node = m_nodes[nodeIndex];
+	node.numChildren = numChildren;
+	for (Uint32 i = 0; i < 4; i++) {
+		if (i < numChildren) {
+			node.first[i] = first[i];
+			node.count[i] = count[i];
+			SetChildBounds(node, i, children[i].bounds);
+		} else {
+			// unused, with empty bounds so it is never hit
+			node.first[i] = 0;
+			node.count[i] = 0;
+			SetChildBounds(node, i, Aabb());
+		}
+	}
+
+	return nodeIndex;
+}
+
+// always splits the range (which has more than one object) in two
+void ObjectTree::SplitRange(const std::vector<Aabb> &bounds, const Range &range, int depth, Range &left, Range &right)
+{
+	Aabb centroidBounds;
+	for (Uint32 i = range.begin; i < range.end; i++)
+		Grow(centroidBounds, m_centroids[m_objects[i]]);
+
+	const vector3d extent = centroidBounds.max - centroidBounds.min;
+	Uint32 mid = range.begin + (range.end - range.begin) / 2;
+
+	int bestAxis = -1;
+	int bestBin = 0;
+	if (depth < MAX_SAH_DEPTH) {
+		// binned SAH: pick the bin boundary minimising
+		// area(left) * count(left) + area(right) * count(right)
+		double bestCost = DBL_MAX;
+		for (int axis = 0; axis < 3; axis++) {
+			if (!(extent[axis] > 0.0)) continue;
+			const double scale = SAH_BINS / extent[axis];
+
+			Aabb binBounds[SAH_BINS];
+			Uint32 binCount[SAH_BINS] = {};
+			for (Uint32 i = range.begin; i < range.end; i++) {
+				const Uint32 o = m_objects[i];
+				const int bin = std::min(SAH_BINS - 1, int((m_centroids[o][axis] - centroidBounds.min[axis]) * scale));
+				binCount[bin]++;
+				Grow(binBounds[bin], bounds[o]);
+			}
+
+			double rightArea[SAH_BINS];
+			Uint32 rightCount[SAH_BINS];
+			Aabb acc;
+			Uint32 n = 0;
+			for (int b = SAH_BINS - 1; b > 0; b--) {
+				Grow(acc, binBounds[b]);
+				n += binCount[b];
+				rightArea[b] = SurfaceArea(acc);
+				rightCount[b] = n;
+			}
+
+			acc = Aabb();
+			n = 0;
+			for (int b = 0; b < SAH_BINS - 1; b++) {
+				Grow(acc, binBounds[b]);
+				n += binCount[b];
+				if (n == 0 || rightCount[b + 1] == 0) continue;
+				const double cost = SurfaceArea(acc) * n + rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+	}
+
+	if (bestAxis >= 0) {
+		const double scale = SAH_BINS / extent[bestAxis];
+		const double minCentroid = centroidBounds.min[bestAxis];
+		const std::vector<vector3d> &centroids = m_centroids;
+		Uint32 *split = std::partition(&m_objects[range.begin], &m_objects[0] + range.end, [&](Uint32 o) {
+			return std::min(SAH_BINS - 1, int((centroids[o][bestAxis] - minCentroid) * scale)) <= bestBin;
+		});
+		mid = Uint32(split - &m_objects[0]);
+	} else {
+		// too deep, or the centroids all coincide: split at the median of
+		// the longest axis
+		int axis = 0;
+		if (extent.y > extent[axis]) axis = 1;
+		if (extent.z > extent[axis]) axis = 2;
+		const std::vector<vector3d> &centroids = m_centroids;
+		std::nth_element(&m_objects[range.begin], &m_objects[mid], &m_objects[0] + range.end, [&](Uint32 a, Uint32 b) {
+			return centroids[a][axis] < centroids[b][axis];
+		});
+	}
+
+	left.begin = range.begin;
+	left.end = mid;
+	right.begin = mid;
+	right.end = range.end;
+	left.bounds = right.bounds = Aabb();
+	for (Uint32 i = left.begin; i < left.end; i++)
+		Grow(left.bounds, bounds[m_objects[i]]);
+	for (Uint32 i = right.begin; i < right.end; i++)
+		Grow(right.bounds, bounds[m_objects[i]]);
+}
+
+bool ObjectTree::Refit(const std::vector<Aabb> &bounds)
+{
+	PROFILE_SCOPED()
+	assert(bounds.size() == m_objects.size());
+	if (m_nodes.empty()) return true;
+
+	// children always come after their parent, so walking backwards
+	// updates them first
+	for (size_t n = m_nodes.size(); n-- > 0;) {
+		Node &node = m_nodes[n];
+		for (Uint32 i = 0; i < node.numChildren; i++) {
+			Aabb box;
+			if (node.count[i]) {
+				for (Uint32 o = node.first[i]; o < node.first[i] + node.count[i]; o++)
+					Grow(box, bounds[m_objects[o]]);
+			} else {
+				box = GetNodeBounds(m_nodes[node.first[i]]);
+			}
+			SetChildBounds(node, i, box);
+		}
+	}
+
+	return GetCost() <= m_buildCost * REBUILD_COST_RATIO;
+}
+
+void ObjectTree::SetChildBounds(Node &node, Uint32 child, const Aabb &box)
+{
+	node.minX[child] = box.min.x;
+	node.minY[child] = box.min.y;
+	node.minZ[child] = box.min.z;
+	node.maxX[child] = box.max.x;
+	node.maxY[child] = box.max.y;
+	node.maxZ[child] = box.max.z;
+}
+
+Aabb ObjectTree::GetNodeBounds(const Node &node)
+{
+	Aabb box;
+	for (Uint32 i = 0; i < node.numChildren; i++) {
+		box.min.x = std::min(box.min.x, node.minX[i]);
+		box.min.y = std::min(box.min.y, node.minY[i]);
+		box.min.z = std::min(box.min.z, node.minZ[i]);
+		box.max.x = std::max(box.max.x, node.maxX[i]);
+		box.max.y = std::max(box.max.y, node.maxY[i]);
+		box.max.z = std::max(box.max.z, node.maxZ[i]);
+	}
+	return box;
+}
+
+// expected cost of a query relative to testing the root: the area of every
+// node visited plus the area of every object tested, over the root's area
+double ObjectTree::GetCost() const
+{
+	const double rootArea = SurfaceArea(GetNodeBounds(m_nodes[0]));
+	if (!(rootArea > 0.0)) return 0.0;
+
+	double cost = 0.0;
+	for (const Node &node : m_nodes) {
+		for (Uint32 i = 0; i < node.numChildren; i++) {
+			Aabb box;
+			box.min = vector3d(node.minX[i], node.minY[i], node.minZ[i]);
+			box.max = vector3d(node.maxX[i], node.maxY[i], node.maxZ[i]);
+			cost += SurfaceArea(box) * (node.count[i] ? node.count[i] : 1);
+		}
+	}
+	return cost / rootArea;
+}
@@ -0,0 +1,184 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _OBJECTTREE_H
+#define _OBJECTTREE_H
+
+#include "../Aabb.h"
+#include "../vector3.h"
+#include <algorithm>
+#include <vector>
+
+/*
+ * Bounding volume hierarchy over the objects (geoms) in a collision space.
+ *
+ * The tree is built top-down with a binned surface area heuristic into a
+ * flat array of nodes. Each node holds the bounds of up to four children
+ * side by side, so all four are tested together in one branch-free loop.
+ * Objects are referred to by their index in the bounds passed to Build().
+ *
+ * While the set of objects stays the same, Refit() updates the bounds in
+ * place instead of rebuilding.
+ */
+class ObjectTree {
+public:
+	ObjectTree();
+
+	void Build(const std::vector<Aabb> &bounds);
+	// bounds must be for the same objects, in the same order, as the last
+	// Build(). returns false once refitting has degraded the tree enough
+	// that it's worth rebuilding
+	bool Refit(const std::vector<Aabb> &bounds);
+
+	bool IsEmpty() const { return m_nodes.empty(); }
+	size_t GetNumNodes() const { return m_nodes.size(); }
+
+	// call fn(objectIndex) for each object whose bounds overlap box
+	template <typename Fn>
+	void QueryAabb(const Aabb &box, Fn fn) const;
+
+	// call fn(objectIndex, maxDist) for each object whose bounds are hit by
+	// the ray closer than maxDist, nearer children first. invDir is 1/dir.
+	// fn may lower maxDist to cull anything further away
+	template <typename Fn>
+	void QueryRay(const vector3d &start, const vector3d &invDir, double maxDist, Fn fn) const;
+
+private:
+	struct Node {
+		double minX[4], minY[4], minZ[4];
+		double maxX[4], maxY[4], maxZ[4];
+		// inner child: index of its node. leaf: its first entry in m_objects
+		Uint32 first[4];
+		// number of objects in a leaf child, zero for an inner child
+		Uint32 count[4];
+		Uint32 numChildren;
+	};
+
+	struct Range {
+		Uint32 begin, end;
+		Aabb bounds;
+	};
+
+	Uint32 BuildNode(const std::vector<Aabb> &bounds, const Range &range, int depth);
+	void SplitRange(const std::vector<Aabb> &bounds, const Range &range, int depth, Range &left, Range &right);
+	static void SetChildBounds(Node &node, Uint32 child, const Aabb &box);
+	static Aabb GetNodeBounds(const Node &node);
+	double GetCost() const;
+
+	// deep enough for a tree of 2^32 objects once the builder falls back
+	// to median splits
+	static const int MAX_STACK = 256;
+
+	std::vector<Node> m_nodes;
+	std::vector<Uint32> m_objects;
+	std::vector<vector3d> m_centroids; // scratch, used while building
+	double m_buildCost;
+};
+
+template <typename Fn>
+void ObjectTree::QueryAabb(const Aabb &box, Fn fn) const
+{
+	if (m_nodes.empty()) return;
+
+	Uint32 stack[MAX_STACK];
+	int stackPos = 0;
+	stack[0] = 0;
+
+	while (stackPos >= 0) {
+		const Node &node = m_nodes[stack[stackPos--]];
+
+		int hit[4];
+		for (int i = 0; i < 4; i++) {
+			hit[i] = (node.minX[i] < box.max.x) & (node.maxX[i] > box.min.x) &
+				(node.minY[i] < box.max.y) & (node.maxY[i] > box.min.y) &
+				(node.minZ[i] < box.max.z) & (node.maxZ[i] > box.min.z);
+		}
+
+		for (Uint32 i = 0; i < node.numChildren; i++) {
+			if (!hit[i]) continue;
+			if (node.count[i]) {
+				for (Uint32 o = node.first[i]; o < node.first[i] + node.count[i]; o++)
+					fn(m_objects[o]);
+			} else {
+				assert(stackPos + 1 < MAX_STACK);
+				stack[++stackPos] = node.first[i];
+			}
+		}
+	}
+}
+
+template <typename Fn>
+void ObjectTree::QueryRay(const vector3d &start, const vector3d &invDir, double maxDist, Fn fn) const
+{
+	if (m_nodes.empty()) return;
+
+	struct Entry {
+		Uint32 node;
+		double dist;
+	};
+	Entry stack[MAX_STACK];
+	int stackPos = 0;
+	stack[0].node = 0;
+	stack[0].dist = 0.0;
+
+	while (stackPos >= 0) {
+		const Entry entry = stack[stackPos--];
+		// maxDist may have come down since this node was pushed
+		if (entry.dist >= maxDist) continue;
+		const Node &node = m_nodes[entry.node];
+
+		double tNear[4];
+		int hit[4];
+		for (int i = 0; i < 4; i++) {
+			double l1 = (node.minX[i] - start.x) * invDir.x;
+			double l2 = (node.maxX[i] - start.x) * invDir.x;
+			double lmin = std::min(l1, l2);
+			double lmax = std::max(l1, l2);
+
+			l1 = (node.minY[i] - start.y) * invDir.y;
+			l2 = (node.maxY[i] - start.y) * invDir.y;
+			lmin = std::max(std::min(l1, l2), lmin);
+			lmax = std::min(std::max(l1, l2), lmax);
+
+			l1 = (node.minZ[i] - start.z) * invDir.z;
+			l2 = (node.maxZ[i] - start.z) * invDir.z;
+			lmin = std::max(std::min(l1, l2), lmin);
+			lmax = std::min(std::max(l1, l2), lmax);
+
+			hit[i] = (lmax >= 0.0) & (lmax >= lmin) & (lmin < maxDist);
+			tNear[i] = lmin;
+		}
+
+		// visit the children nearest first
+		Uint32 order[4];
+		Uint32 numHits = 0;
+		for (Uint32 i = 0; i < node.numChildren; i++) {
+			if (!hit[i]) continue;
+			Uint32 j = numHits++;
+			for (; j > 0 && tNear[order[j - 1]] > tNear[i]; j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+		}
+
+		for (Uint32 h = 0; h < numHits; h++) {
+			const Uint32 i = order[h];
+			if (node.count[i]) {
+				if (tNear[i] >= maxDist) continue;
+				for (Uint32 o = node.first[i]; o < node.first[i] + node.count[i]; o++)
+					fn(m_objects[o], maxDist);
+			}
+		}
+		// push far to near, so the nearest inner child is popped first
+		for (Uint32 h = numHits; h-- > 0;) {
+			const Uint32 i = order[h];
+			if (!node.count[i]) {
+				assert(stackPos + 1 < MAX_STACK);
+				stackPos++;
+				stack[stackPos].node = node.first[i];
+				stack[stackPos].dist = tNear[i];
+			}
+		}
+	}
+}
+
+#endif /* _OBJECTTREE_H */
@@ -0,0 +1,275 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+// Microbenchmark for the collision space broadphase. Compares ObjectTree
+// against the midpoint-split tree CollisionSpace used before it, on
+// synthetic scenes of ships clustered around a few stations.
+
+#include "collider/ObjectTree.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <random>
+
+namespace {
+	struct Object {
+		vector3d pos;
+		double radius;
+	};
+
+	// the previous tree: split at the midpoint of the longest axis, copying
+	// std::lists at every level, rebuilt from scratch every time
+	class MidpointTree {
+	public:
+		explicit MidpointTree(const std::vector<Object> &objects) :
+			m_objects(objects)
+		{
+			std::list<int> all;
+			for (int i = 0; i < int(objects.size()); i++)
+				all.push_back(i);
+			m_nodes.reserve(objects.size() * 2);
+			m_indices.reserve(objects.size());
+			if (!all.empty()) BuildNode(all);
+		}
+
+		template <typename Fn>
+		void QueryAabb(const Aabb &box, Fn fn) const
+		{
+			if (m_nodes.empty()) return;
+			std::vector<int> stack(1, 0);
+			while (!stack.empty()) {
+				const Node &node = m_nodes[stack.back()];
+				stack.pop_back();
+				if (!box.Intersects(node.aabb)) continue;
+				if (node.kids[0] < 0) {
+					for (int i = 0; i < node.numObjects; i++)
+						fn(m_indices[node.firstObject + i]);
+				} else {
+					stack.push_back(node.kids[0]);
+					stack.push_back(node.kids[1]);
+				}
+			}
+		}
+
+		template <typename Fn>
+		void QueryRay(const vector3d &start, const vector3d &invDir, double maxDist, Fn fn) const
+		{
+			if (m_nodes.empty()) return;
+			std::vector<int> stack(1, 0);
+			while (!stack.empty()) {
+				const Node &node = m_nodes[stack.back()];
+				stack.pop_back();
+				if (!RayHits(node.aabb, start, invDir, maxDist)) continue;
+				if (node.kids[0] < 0) {
+					for (int i = 0; i < node.numObjects; i++)
+						fn(m_indices[node.firstObject + i]);
+				} else {
+					stack.push_back(node.kids[0]);
+					stack.push_back(node.kids[1]);
+				}
+			}
+		}
+
+	private:
+		struct Node {
+			Aabb aabb;
+			int kids[2];
+			int firstObject, numObjects;
+		};
+
+		int BuildNode(const std::list<int> &objs)
+		{
+			const int nodeIndex = int(m_nodes.size());
+			m_nodes.push_back(Node());
+
+			Aabb aabb;
+			for (int i : objs) {
+				const Object &o = m_objects[i];
+				aabb.Update(o.pos + vector3d(o.radius));
+				aabb.Update(o.pos - vector3d(o.radius));
+			}
+
+			int axis;
+			const vector3d axislen = aabb.max - aabb.min;
+			if ((axislen.x > axislen.y) && (axislen.x > axislen.z))
+				axis = 0;
+			else if (axislen.y > axislen.z)
+				axis = 1;
+			else
+				axis = 2;
+			const double pivot = 0.5 * (aabb.max[axis] + aabb.min[axis]);
+
+			std::list<int> side[2];
+			for (int i : objs)
+				side[m_objects[i].pos[axis] < pivot ? 0 : 1].push_back(i);
+
+			m_nodes[nodeIndex].aabb = aabb;
+			m_nodes[nodeIndex].numObjects = int(objs.size());
+			if (side[0].empty() || side[1].empty()) {
+				m_nodes[nodeIndex].kids[0] = m_nodes[nodeIndex].kids[1] = -1;
+				m_nodes[nodeIndex].firstObject = int(m_indices.size());
+				m_indices.insert(m_indices.end(), objs.begin(), objs.end());
+			} else {
+				const int kid0 = BuildNode(side[0]);
+				const int kid1 = BuildNode(side[1]);
+				m_nodes[nodeIndex].kids[0] = kid0;
+				m_nodes[nodeIndex].kids[1] = kid1;
+			}
+			return nodeIndex;
+		}
+
+		static bool RayHits(const Aabb &aabb, const vector3d &start, const vector3d &invDir, double maxDist)
+		{
+			double l1 = (aabb.min.x - start.x) * invDir.x, l2 = (aabb.max.x - start.x) * invDir.x;
+			double lmin = std::min(l1, l2), lmax = std::max(l1, l2);
+			l1 = (aabb.min.y - start.y) * invDir.y;
+			l2 = (aabb.max.y - start.y) * invDir.y;
+			lmin = std::max(std::min(l1, l2), lmin);
+			lmax = std::min(std::max(l1, l2), lmax);
+			l1 = (aabb.min.z - start.z) * invDir.z;
+			l2 = (aabb.max.z - start.z) * invDir.z;
+			lmin = std::max(std::min(l1, l2), lmin);
+			lmax = std::min(std::max(l1, l2), lmax);
+			return (lmax >= 0.0) & (lmax >= lmin) & (lmin < maxDist);
+		}
+
+		const std::vector<Object> &m_objects;
+		std::vector<Node> m_nodes;
+		std::vector<int> m_indices;
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	double ElapsedMs(const Clock::time_point &start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	Aabb ObjectBounds(const Object &o)
+	{
+		Aabb box;
+		box.min = o.pos - vector3d(o.radius);
+		box.max = o.pos + vector3d(o.radius);
+		return box;
+	}
+
+	// ships within a few tens of km of a handful of stations
+	std::vector<Object> MakeScene(std::mt19937 &rng, int count)
+	{
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		std::uniform_real_distribution<double> radius(10.0, 300.0);
+		std::vector<vector3d> clusters;
+		for (int i = 0; i < 8; i++)
+			clusters.push_back(vector3d(unit(rng), unit(rng), unit(rng)) * 1e7);
+
+		std::vector<Object> objects(count);
+		for (Object &o : objects) {
+			const vector3d &centre = clusters[rng() % clusters.size()];
+			o.pos = centre + vector3d(unit(rng), unit(rng), unit(rng)) * 3e4;
+			o.radius = radius(rng);
+		}
+		return objects;
+	}
+
+	void RunScene(std::mt19937 &rng, int count, int reps)
+	{
+		std::vector<Object> objects = MakeScene(rng, count);
+		std::vector<Aabb> bounds(count);
+		for (int i = 0; i < count; i++)
+			bounds[i] = ObjectBounds(objects[i]);
+
+		// build
+		Clock::time_point t = Clock::now();
+		for (int r = 0; r < reps; r++)
+			MidpointTree tree(objects);
+		const double oldBuild = ElapsedMs(t) / reps;
+
+		ObjectTree newTree;
+		t = Clock::now();
+		for (int r = 0; r < reps; r++)
+			newTree.Build(bounds);
+		const double newBuild = ElapsedMs(t) / reps;
+
+		// one frame of CollisionSpace::Collide: every object against the tree
+		MidpointTree oldTree(objects);
+		size_t oldPairs = 0, newPairs = 0;
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (const Aabb &box : bounds)
+				oldTree.QueryAabb(box, [&](int i) { oldPairs += box.Intersects(bounds[i]); });
+		}
+		const double oldQuery = ElapsedMs(t) / reps;
+
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (const Aabb &box : bounds)
+				newTree.QueryAabb(box, [&](Uint32 i) { newPairs += box.Intersects(bounds[i]); });
+		}
+		const double newQuery = ElapsedMs(t) / reps;
+
+		// rays as fired by lasers: from an object, 10km in a random direction
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		std::vector<vector3d> rayStart(count), rayInvDir(count);
+		for (int i = 0; i < count; i++) {
+			const vector3d dir = vector3d(unit(rng), unit(rng), unit(rng)).NormalizedSafe();
+			rayStart[i] = objects[i].pos;
+			rayInvDir[i] = vector3d(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+		}
+		size_t oldRayHits = 0, newRayHits = 0;
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (int i = 0; i < count; i++)
+				oldTree.QueryRay(rayStart[i], rayInvDir[i], 1e4, [&](int) { oldRayHits++; });
+		}
+		const double oldRay = ElapsedMs(t) / reps;
+
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (int i = 0; i < count; i++)
+				newTree.QueryRay(rayStart[i], rayInvDir[i], 1e4, [&](Uint32, double &) { newRayHits++; });
+		}
+		const double newRay = ElapsedMs(t) / reps;
+
+		// a frame's worth of movement: the old tree rebuilds, the new one refits
+		std::uniform_real_distribution<double> step(-50.0, 50.0);
+		for (int i = 0; i < count; i++) {
+			objects[i].pos += vector3d(step(rng), step(rng), step(rng));
+			bounds[i] = ObjectBounds(objects[i]);
+		}
+		t = Clock::now();
+		for (int r = 0; r < reps; r++)
+			MidpointTree tree(objects);
+		const double oldUpdate = ElapsedMs(t) / reps;
+
+		int rebuilds = 0;
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			if (!newTree.Refit(bounds)) {
+				newTree.Build(bounds);
+				rebuilds++;
+			}
+		}
+		const double newUpdate = ElapsedMs(t) / reps;
+
+		printf("%6d objects        midpoint      sah/bvh4\n", count);
+		printf("  build (ms)       %10.4f    %10.4f\n", oldBuild, newBuild);
+		printf("  update (ms)      %10.4f    %10.4f  (refit, %d rebuilds)\n", oldUpdate, newUpdate, rebuilds);
+		printf("  collide (ms)     %10.4f    %10.4f\n", oldQuery, newQuery);
+		printf("  rays (ms)        %10.4f    %10.4f\n", oldRay, newRay);
+		if (oldPairs != newPairs)
+			printf("  MISMATCH: %zu overlapping pairs vs %zu\n", oldPairs / reps, newPairs / reps);
+		printf("  %zu overlapping pairs, %zu ray candidates vs %zu\n\n", newPairs / reps, oldRayHits / reps, newRayHits / reps);
+	}
+} // namespace
+
+extern "C" int main(int argc, char **argv)
+{
+	const int reps = argc > 1 ? std::max(1, atoi(argv[1])) : 20;
+
+	std::mt19937 rng(1234);
+	for (int count : { 100, 1000, 10000 })
+		RunScene(rng, count, reps);
+
+	return 0;
+}
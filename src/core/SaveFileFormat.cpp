@@ -0,0 +1,295 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "SaveFileFormat.h"
+#include "LZ4Format.h"
+#include "lz4/lz4frame.h"
+#include "profiler/Profiler.h"
+#include <SDL_endian.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+
+namespace {
+	const char MAGIC[8] = { 'P', 'I', 'O', 'N', 'S', 'A', 'V', 'E' };
+	const Uint32 FORMAT_VERSION = 1;
+	const size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(Uint32);
+	const size_t FOOTER_SIZE = sizeof(Uint64);
+
+	// the compressor's input buffer, and the LZ4 frame block size
+	const size_t STREAM_BUFFER_SIZE = 1 << 16;
+
+	// compresses everything written to it into one LZ4 frame, handing the
+	// compressed blocks to the writer as they fill
+	class LZ4StreamBuf : public std::streambuf {
+	public:
+		typedef std::function<void(const char *, size_t)> WriteFn;
+
+		explicit LZ4StreamBuf(WriteFn write) :
+			m_write(write),
+			m_in(new char[STREAM_BUFFER_SIZE]),
+			m_ctx(nullptr)
+		{
+			m_prefs = LZ4F_INIT_PREFERENCES;
+			m_prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+			m_prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+			m_outSize = std::max<size_t>(LZ4F_compressBound(STREAM_BUFFER_SIZE, &m_prefs), LZ4F_HEADER_SIZE_MAX);
+			m_out.reset(new char[m_outSize]);
+
+			Check(LZ4F_createCompressionContext(&m_ctx, LZ4F_VERSION));
+			Output(LZ4F_compressBegin(m_ctx, m_out.get(), m_outSize, &m_prefs));
+			setp(m_in.get(), m_in.get() + STREAM_BUFFER_SIZE);
+		}
+
+		~LZ4StreamBuf()
+		{
+			LZ4F_freeCompressionContext(m_ctx);
+		}
+
+		void Finish()
+		{
+			CompressBuffer();
+			Output(LZ4F_compressEnd(m_ctx, m_out.get(), m_outSize, nullptr));
+		}
+
+	protected:
+		int_type overflow(int_type c) override
+		{
+			CompressBuffer();
+			if (!traits_type::eq_int_type(c, traits_type::eof())) {
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+
+	private:
+		void CompressBuffer()
+		{
+			const size_t size = pptr() - pbase();
+			if (size)
+				Output(LZ4F_compressUpdate(m_ctx, m_out.get(), m_outSize, pbase(), size, nullptr));
+			setp(m_in.get(), m_in.get() + STREAM_BUFFER_SIZE);
+		}
+
+		void Output(size_t size)
+		{
+			Check(size);
+			if (size) m_write(m_out.get(), size);
+		}
+
+		static void Check(size_t errorCode)
+		{
+			if (LZ4F_isError(errorCode))
+				throw savefile::WriteFailedException(LZ4F_getErrorName(errorCode));
+		}
+
+		WriteFn m_write;
+		std::unique_ptr<char[]> m_in;
+		std::unique_ptr<char[]> m_out;
+		size_t m_outSize;
+		LZ4F_preferences_t m_prefs;
+		LZ4F_cctx *m_ctx;
+	};
+
+	void AppendLE32(std::string &out, Uint32 v)
+	{
+		v = SDL_SwapLE32(v);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+
+	void AppendLE64(std::string &out, Uint64 v)
+	{
+		v = SDL_SwapLE64(v);
+		out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+	}
+
+	// reads little endian values, checking it stays within the data
+	class ByteReader {
+	public:
+		ByteReader(const char *data, size_t length, size_t pos) :
+			m_data(data),
+			m_length(length),
+			m_pos(pos) {}
+
+		Uint32 LE32()
+		{
+			Uint32 v;
+			Read(&v, sizeof(v));
+			return SDL_SwapLE32(v);
+		}
+
+		Uint64 LE64()
+		{
+			Uint64 v;
+			Read(&v, sizeof(v));
+			return SDL_SwapLE64(v);
+		}
+
+		std::string String(size_t size)
+		{
+			Need(size);
+			std::string s(m_data + m_pos, size);
+			m_pos += size;
+			return s;
+		}
+
+	private:
+		void Need(size_t size)
+		{
+			if (size > m_length - m_pos)
+				throw savefile::FormatError("save file is truncated");
+		}
+
+		void Read(void *out, size_t size)
+		{
+			Need(size);
+			memcpy(out, m_data + m_pos, size);
+			m_pos += size;
+		}
+
+		const char *m_data;
+		size_t m_length;
+		size_t m_pos;
+	};
+} // namespace
+
+bool savefile::IsSaveFileFormat(const char *data, size_t length)
+{
+	return length >= HEADER_SIZE + FOOTER_SIZE && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+savefile::Writer::Writer(FILE *f) :
+	m_file(f),
+	m_offset(0)
+{
+	std::string header(MAGIC, sizeof(MAGIC));
+	AppendLE32(header, FORMAT_VERSION);
+	Write(header.data(), header.size());
+}
+
+savefile::Writer::~Writer()
+{
+}
+
+void savefile::Writer::Write(const void *data, size_t size)
+{
+	if (fwrite(data, size, 1, m_file) != 1)
+		throw WriteFailedException("could not write to save file");
+	m_offset += size;
+}
+
+void savefile::Writer::WriteSection(const std::string &name, const Json &section)
+{
+	PROFILE_SCOPED()
+	Entry entry;
+	entry.name = name;
+	entry.offset = m_offset;
+
+	LZ4StreamBuf buf([this](const char *data, size_t size) { Write(data, size); });
+	std::ostream stream(&buf);
+	// pass on write failures rather than just setting badbit
+	stream.exceptions(std::ostream::badbit);
+	Json::to_cbor(section, stream);
+	buf.Finish();
+
+	entry.size = m_offset - entry.offset;
+	m_sections.push_back(entry);
+}
+
+void savefile::Writer::Finish()
+{
+	const Uint64 tableOffset = m_offset;
+	std::string table;
+	AppendLE32(table, Uint32(m_sections.size()));
+	for (const Entry &entry : m_sections) {
+		AppendLE32(table, Uint32(entry.name.size()));
+		table.append(entry.name);
+		AppendLE64(table, entry.offset);
+		AppendLE64(table, entry.size);
+	}
+	AppendLE64(table, tableOffset);
+	Write(table.data(), table.size());
+}
+
+savefile::Reader::Reader(const char *data, size_t length) :
+	m_data(data),
+	m_length(length)
+{
+	if (!IsSaveFileFormat(data, length))
+		throw FormatError("not a save file");
+
+	ByteReader header(data, length, sizeof(MAGIC));
+	if (header.LE32() != FORMAT_VERSION)
+		throw FormatError("unknown save file format version");
+
+	const Uint64 tableOffset = ByteReader(data, length, length - FOOTER_SIZE).LE64();
+	if (tableOffset < HEADER_SIZE || tableOffset > length - FOOTER_SIZE)
+		throw FormatError("save file section table is corrupt");
+
+	ByteReader table(data, length - FOOTER_SIZE, size_t(tableOffset));
+	const Uint32 numSections = table.LE32();
+	for (Uint32 i = 0; i < numSections; i++) {
+		Entry entry;
+		entry.name = table.String(table.LE32());
+		entry.offset = table.LE64();
+		entry.size = table.LE64();
+		if (entry.offset < HEADER_SIZE || entry.offset > tableOffset || entry.size > tableOffset - entry.offset)
+			throw FormatError("save file section table is corrupt");
+		m_sections.push_back(entry);
+	}
+}
+
+std::vector<std::string> savefile::Reader::GetSectionNames() const
+{
+	std::vector<std::string> names;
+	for (const Entry &entry : m_sections)
+		names.push_back(entry.name);
+	return names;
+}
+
+bool savefile::Reader::HasSection(const std::string &name) const
+{
+	for (const Entry &entry : m_sections) {
+		if (entry.name == name) return true;
+	}
+	return false;
+}
+
+Json savefile::Reader::ReadSection(const std::string &name) const
+{
+	for (const Entry &entry : m_sections) {
+		if (entry.name == name) return DecodeSection(entry);
+	}
+	throw FormatError("save file has no section " + name);
+}
+
+Json savefile::Reader::ReadAll() const
+{
+	PROFILE_SCOPED()
+	Json all = Json::object();
+	for (const Entry &entry : m_sections) {
+		Json section = DecodeSection(entry);
+		for (Json::iterator it = section.begin(); it != section.end(); ++it)
+			all[it.key()] = std::move(it.value());
+	}
+	return all;
+}
+
+Json savefile::Reader::DecodeSection(const Entry &entry) const
+{
+	PROFILE_SCOPED()
+	try {
+		const std::string plain = lz4::DecompressLZ4({ m_data + entry.offset, size_t(entry.size) });
+		Json section = Json::from_cbor(plain);
+		if (!section.is_object())
+			throw FormatError("save file section " + entry.name + " is not an object");
+		return section;
+	} catch (const lz4::DecompressionFailedException &e) {
+		throw FormatError("save file section " + entry.name + ": " + e.what());
+	} catch (const Json::parse_error &e) {
+		throw FormatError("save file section " + entry.name + ": " + e.what());
+	}
+}
@@ -0,0 +1,89 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "Json.h"
+
+#include <SDL_stdinc.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Saved games are a sequence of named sections, one per subsystem. Each
+ * section is a JSON object stored as CBOR in its own LZ4 frame, and a table
+ * of the sections follows them at the end of the file:
+ *
+ *   "PIONSAVE" Uint32 formatVersion
+ *   section data...
+ *   Uint32 numSections { Uint32 nameLength, name, Uint64 offset, Uint64 size }...
+ *   Uint64 tableOffset
+ *
+ * All integers are little endian. The whole game is the union of the keys
+ * of all the sections.
+ */
+namespace savefile {
+	struct FormatError : public std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+	struct WriteFailedException : public std::runtime_error {
+		using std::runtime_error::runtime_error;
+	};
+
+	// Checks for the magic bytes at the start of a save file.
+	bool IsSaveFileFormat(const char *data, size_t length);
+
+	// Writes sections to f one after another. Each one is streamed through
+	// the compressor as it is encoded, so neither its CBOR nor its compressed
+	// form is ever held in memory whole.
+	// Throws WriteFailedException if anything can't be written.
+	class Writer {
+	public:
+		explicit Writer(FILE *f);
+		~Writer();
+
+		void WriteSection(const std::string &name, const Json &section);
+		// writes the table of sections. nothing can be written after
+		void Finish();
+
+	private:
+		struct Entry {
+			std::string name;
+			Uint64 offset, size;
+		};
+
+		void Write(const void *data, size_t size);
+
+		FILE *m_file;
+		Uint64 m_offset;
+		std::vector<Entry> m_sections;
+	};
+
+	// Reads the table of sections from a save file in memory, then decodes
+	// sections only when asked for. data must outlive the reader.
+	// Throws FormatError if the file or a section is corrupt.
+	class Reader {
+	public:
+		Reader(const char *data, size_t length);
+
+		std::vector<std::string> GetSectionNames() const;
+		bool HasSection(const std::string &name) const;
+		Json ReadSection(const std::string &name) const;
+		// every section's keys in one object
+		Json ReadAll() const;
+
+	private:
+		struct Entry {
+			std::string name;
+			Uint64 offset, size;
+		};
+
+		Json DecodeSection(const Entry &entry) const;
+
+		const char *m_data;
+		size_t m_length;
+		std::vector<Entry> m_sections;
+	};
+} // namespace savefile
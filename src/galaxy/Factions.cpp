@@ -15,6 +15,7 @@
 #include "Lang.h"
 #include "Pi.h"
 #include "Polit.h"
+#include "jenkins/lookup3.h"
 #include "lua/LuaConstants.h"
 #include "lua/LuaFixed.h"
 #include "lua/LuaUtils.h"
@@ -598,6 +599,17 @@ bool FactionsDatabase::IsHomeSystem(const SystemPath &sysPath) const
 	return m_homesystems.find(sysPath.SystemOnly()) != m_homesystems.end();
 }
 
+Uint32 FactionsDatabase::GetHomeSystemsHash() const
+{
+	Uint32 hash = Uint32(m_homesystems.size());
+	for (const SystemPath &path : m_homesystems) {
+		char blob[SystemPath::SizeAsBlob];
+		path.SerializeToBlob(blob);
+		hash = lookup3_hashlittle(blob, SystemPath::SizeAsBlob, hash);
+	}
+	return hash;
+}
+
 // ------- Factions proper --------
 
 bool Faction::IsClaimed(SystemPath path) const
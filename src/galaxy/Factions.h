@@ -106,6 +106,8 @@ public:
 	const Faction *GetFaction(const std::string &factionName) const;
 	const Faction *GetNearestClaimant(const Sector::System *sys) const;
 	bool IsHomeSystem(const SystemPath &sysPath) const;
+	// changes whenever the set of home systems does
+	Uint32 GetHomeSystemsHash() const;
 
 	Uint32 GetNumFactions() const;
 
@@ -5,10 +5,13 @@
 
 #include "FileSystem.h"
 #include "GalaxyGenerator.h"
+#include "GameConfig.h"
 #include "GameSaveError.h"
 #include "Json.h"
+#include "Pi.h"
 #include "Sector.h"
 #include "utils.h"
+#include <algorithm>
 
 Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, float sol_offset_x, float sol_offset_y,
 	const std::string &factionsDir, const std::string &customSysDir) :
@@ -24,6 +27,8 @@ Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, flo
 	m_customSystems(this, customSysDir)
 {
 	m_stats.EnableReset(false);
+	m_sectorCache.SetMemoryBudget(size_t(std::max(0, Pi::config->Int("SectorCacheMemoryMB"))) << 20);
+	m_starSystemCache.SetMemoryBudget(size_t(std::max(0, Pi::config->Int("StarSystemCacheMemoryMB"))) << 20);
 }
 
 //static
@@ -14,6 +14,53 @@
 
 //#define DEBUG_CACHE
 
+// cache keys and size estimates, which depend on what's being cached
+
+template <>
+SystemPath GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::MakeKey(const SystemPath &path)
+{
+	return path.SectorOnly();
+}
+
+template <>
+size_t GalaxyObjectCache<Sector, SystemPath::LessSectorOnly>::EstimateSize(const Sector *sector)
+{
+	size_t size = sizeof(Sector);
+	for (const Sector::System &system : sector->m_systems)
+		size += sizeof(Sector::System) + system.GetName().capacity() + system.GetOtherNames().size() * sizeof(std::string);
+	return size;
+}
+
+template <>
+SystemPath GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::MakeKey(const SystemPath &path)
+{
+	return path.SystemOnly();
+}
+
+template <>
+size_t GalaxyObjectCache<StarSystem, SystemPath::LessSystemOnly>::EstimateSize(const StarSystem *system)
+{
+	return sizeof(StarSystem) + system->GetNumBodies() * sizeof(SystemBody) + system->GetNumSpaceStations() * sizeof(SystemBody *);
+}
+
+template <typename T, typename CompareT>
+GalaxyObjectCache<T, CompareT>::GalaxyObjectCache(Galaxy *galaxy) :
+	m_galaxy(galaxy),
+	m_recentBytes(0),
+	m_memoryBudget(0),
+	m_cacheHits(0),
+	m_cacheHitsSlave(0),
+	m_cacheMisses(0),
+	m_statHits(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " hits")),
+	m_statHitsSlave(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " slave hits")),
+	m_statMisses(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " misses")),
+	m_statEvictions(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " evictions")),
+	m_statObjects(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " objects")),
+	m_statRecentKB(galaxy->GetStats().GetOrCreateCounter(CACHE_NAME + " kept KB"))
+{
+	m_lock = SDL_CreateMutex();
+}
+
 //virtual
 
 template <typename T, typename CompareT>
@@ -21,20 +68,76 @@ GalaxyObjectCache<T, CompareT>::~GalaxyObjectCache()
 {
 	for (Slave *s : m_slaves)
 		s->MasterDeleted();
+	SetMemoryBudget(0);
 	assert(m_attic.empty()); // otherwise the objects will deregister at a cache that no longer exists
+	SDL_DestroyMutex(m_lock);
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::SetMemoryBudget(size_t bytes)
+{
+	SDL_LockMutex(m_lock);
+	m_memoryBudget = bytes;
+	Evict();
+	SDL_UnlockMutex(m_lock);
+}
+
+// marks the entry as most recently used, keeping it alive for reuse. with
+// the lock held, as is Evict()
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::Touch(AtticEntry &entry)
+{
+	if (entry.recent) {
+		m_recent.splice(m_recent.begin(), m_recent, entry.recentIt);
+	} else {
+		m_recent.push_front(RefCountedPtr<T>(entry.object));
+		entry.recent = true;
+		entry.recentIt = m_recent.begin();
+		entry.size = EstimateSize(entry.object);
+		m_recentBytes += entry.size;
+	}
+	Evict();
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::Evict()
+{
+	while (m_recentBytes > m_memoryBudget && !m_recent.empty()) {
+		RefCountedPtr<T> &oldest = m_recent.back();
+		AtticEntry &entry = m_attic.find(MakeKey(oldest->GetPath()))->second;
+		entry.recent = false;
+		m_recentBytes -= entry.size;
+		// if nothing else refers to the object this frees it, which removes
+		// its entry from the attic. otherwise it lives on where it's used
+		if (oldest->GetRefCount() == 1)
+			m_galaxy->GetStats().CounterAdd(m_statEvictions);
+		m_recent.pop_back();
+	}
+	UpdateSizeCounters();
+}
+
+template <typename T, typename CompareT>
+void GalaxyObjectCache<T, CompareT>::UpdateSizeCounters()
+{
+	m_galaxy->GetStats().CounterSet(m_statObjects, Uint32(m_attic.size()));
+	m_galaxy->GetStats().CounterSet(m_statRecentKB, Uint32(m_recentBytes / 1024));
 }
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::AddToCache(std::vector<RefCountedPtr<T>> &objects)
 {
+	SDL_LockMutex(m_lock);
 	for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
-		auto inserted = m_attic.insert(std::make_pair(it->Get()->GetPath(), it->Get()));
+		AtticEntry entry = { it->Get(), false, typename RecentList::iterator(), 0 };
+		auto inserted = m_attic.insert(std::make_pair(MakeKey(it->Get()->GetPath()), entry));
 		if (!inserted.second) {
-			it->Reset(inserted.first->second);
+			it->Reset(inserted.first->second.object);
 		} else {
 			(*it)->SetCache(this);
 		}
+		Touch(inserted.first->second);
 	}
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -43,10 +146,13 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetIfCached(const SystemPath &p
 	PROFILE_SCOPED()
 
 	RefCountedPtr<T> s;
-	typename AtticMap::iterator i = m_attic.find(path);
+	SDL_LockMutex(m_lock);
+	typename AtticMap::iterator i = m_attic.find(MakeKey(path));
 	if (i != m_attic.end()) {
-		s.Reset(i->second);
+		s.Reset(i->second.object);
+		Touch(i->second);
 	}
+	SDL_UnlockMutex(m_lock);
 
 	return s;
 }
@@ -56,14 +162,22 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::GetCached(const SystemPath &pat
 {
 	PROFILE_SCOPED()
 
+	// held while a miss is generated, so that two threads asking for the
+	// same object don't both make it. the lock is recursive, so generating
+	// may look up other objects
+	SDL_LockMutex(m_lock);
 	RefCountedPtr<T> s = this->GetIfCached(path);
 	if (!s) {
 		++m_cacheMisses;
+		m_galaxy->GetStats().CounterAdd(m_statMisses);
 		s = m_galaxy->GetGenerator()->Generate<T, GalaxyObjectCache<T, CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
-		m_attic.insert(std::make_pair(path, s.Get()));
+		AtticEntry entry = { s.Get(), false, typename RecentList::iterator(), 0 };
+		Touch(m_attic.insert(std::make_pair(MakeKey(path), entry)).first->second);
 	} else {
 		++m_cacheHits;
+		m_galaxy->GetStats().CounterAdd(m_statHits);
 	}
+	SDL_UnlockMutex(m_lock);
 	return s;
 }
 
@@ -72,13 +186,19 @@ bool GalaxyObjectCache<T, CompareT>::HasCached(const SystemPath &path) const
 {
 	PROFILE_SCOPED()
 
-	return (m_attic.find(path) != m_attic.end());
+	SDL_LockMutex(m_lock);
+	const bool cached = m_attic.find(MakeKey(path)) != m_attic.end();
+	SDL_UnlockMutex(m_lock);
+	return cached;
 }
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::RemoveFromAttic(const SystemPath &path)
 {
-	m_attic.erase(path);
+	SDL_LockMutex(m_lock);
+	m_attic.erase(MakeKey(path));
+	UpdateSizeCounters();
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -86,14 +206,24 @@ void GalaxyObjectCache<T, CompareT>::ClearCache()
 {
 	for (auto it = m_slaves.begin(), itEnd = m_slaves.end(); it != itEnd; ++it)
 		(*it)->ClearCache();
+
+	// drop everything kept for reuse, without forgetting the budget
+	SDL_LockMutex(m_lock);
+	const size_t budget = m_memoryBudget;
+	SetMemoryBudget(0);
+	m_memoryBudget = budget;
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::OutputCacheStatistics(bool reset)
 {
-	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits);
+	SDL_LockMutex(m_lock);
+	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu, " SIZET_FMT " objects, " SIZET_FMT " kept (" SIZET_FMT " KB)\n", CACHE_NAME.c_str(),
+		m_cacheMisses, m_cacheHitsSlave, m_cacheHits, m_attic.size(), m_recent.size(), m_recentBytes / 1024);
 	if (reset)
 		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = 0;
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -122,7 +252,7 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetIfCached(const System
 {
 	PROFILE_SCOPED()
 
-	typename CacheMap::iterator i = m_cache.find(path);
+	typename CacheMap::iterator i = m_cache.find(MakeKey(path));
 	if (i != m_cache.end())
 		return (*i).second;
 	return RefCountedPtr<T>();
@@ -133,15 +263,17 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetCached(const SystemPa
 {
 	PROFILE_SCOPED()
 
-	typename CacheMap::iterator i = m_cache.find(path);
+	typename CacheMap::iterator i = m_cache.find(MakeKey(path));
 	if (i != m_cache.end()) {
-		if (m_master)
+		if (m_master) {
 			++m_master->m_cacheHitsSlave;
+			m_galaxy->GetStats().CounterAdd(m_master->m_statHitsSlave);
+		}
 		return (*i).second;
 	}
 
 	if (m_master) {
-		auto inserted = m_cache.insert(std::make_pair(path, m_master->GetCached(path)));
+		auto inserted = m_cache.insert(std::make_pair(MakeKey(path), m_master->GetCached(path)));
 		return inserted.first->second;
 	} else {
 		return RefCountedPtr<T>();
@@ -149,7 +281,7 @@ RefCountedPtr<T> GalaxyObjectCache<T, CompareT>::Slave::GetCached(const SystemPa
 }
 
 template <typename T, typename CompareT>
-void GalaxyObjectCache<T, CompareT>::Slave::Erase(const SystemPath &path) { m_cache.erase(path); }
+void GalaxyObjectCache<T, CompareT>::Slave::Erase(const SystemPath &path) { m_cache.erase(MakeKey(path)); }
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T, CompareT>::Slave::Erase(const typename CacheMap::const_iterator &it) { m_cache.erase(it); }
@@ -177,7 +309,7 @@ void GalaxyObjectCache<T, CompareT>::Slave::AddToCache(std::vector<RefCountedPtr
 	if (m_master) {
 		m_master->AddToCache(objects); // This modifies the vector to the sectors already in the master cache
 		for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
-			m_cache.insert(std::make_pair(it->Get()->GetPath(), *it));
+			m_cache.insert(std::make_pair(MakeKey(it->Get()->GetPath()), *it));
 		}
 	}
 }
@@ -200,7 +332,7 @@ void GalaxyObjectCache<T, CompareT>::Slave::FillCache(const typename GalaxyObjec
 	for (auto it = paths.begin(), itEnd = paths.end(); it != itEnd; ++it) {
 		RefCountedPtr<T> s = m_master->GetIfCached(*it);
 		if (s) {
-			m_cache[*it] = s;
+			m_cache[MakeKey(*it)] = s;
 #ifdef DEBUG_CACHE
 			++masterCached;
 #endif
@@ -251,6 +383,8 @@ GalaxyObjectCache<T, CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<S
 	m_callback(callback)
 {
 	m_objects.reserve(m_paths->size());
+	// cache fills are mostly speculative, so let more urgent work (e.g. terrain) go first
+	SetPriority(PRIORITY_LOW);
 }
 
 //virtual
@@ -5,10 +5,12 @@
 #define SECTORCACHE_H
 
 #include "JobQueue.h"
+#include "PerfStats.h"
 #include "RefCounted.h"
 #include "galaxy/SystemPath.h"
+#include "galaxy/SystemPathMap.h"
 #include <functional>
-#include <map>
+#include <list>
 #include <memory>
 #include <set>
 #include <vector>
@@ -23,24 +25,27 @@ class GalaxyObjectCache {
 public:
 	static const std::string CACHE_NAME;
 
-	GalaxyObjectCache(Galaxy *galaxy) :
-		m_galaxy(galaxy),
-		m_cacheHits(0),
-		m_cacheHitsSlave(0),
-		m_cacheMisses(0) {}
+	explicit GalaxyObjectCache(Galaxy *galaxy);
 	~GalaxyObjectCache();
 
+	// thread safe, as star system generation looks sectors up from the job
+	// runners. slaves aren't: each belongs to whatever made it
 	RefCountedPtr<T> GetCached(const SystemPath &path);
 	RefCountedPtr<T> GetIfCached(const SystemPath &path);
 
-	void ClearCache(); // Completely clear slave caches
+	void ClearCache(); // Completely clear slave caches, and everything kept for reuse
 	bool IsEmpty() { return m_attic.empty(); }
 
+	// Objects nothing else refers to any more are kept around for reuse,
+	// least recently used first out, until their estimated size adds up to
+	// this many bytes. Objects still in use elsewhere are never freed
+	void SetMemoryBudget(size_t bytes);
+
 	void OutputCacheStatistics(bool reset = true);
 
 	typedef std::vector<SystemPath> PathVector;
-	typedef std::map<SystemPath, RefCountedPtr<T>, CompareT> CacheMap;
-	typedef std::map<SystemPath, T *, CompareT> AtticMap;
+	// keyed by MakeKey(path)
+	typedef SystemPathMap<RefCountedPtr<T>> CacheMap;
 	typedef std::function<void()> CacheFilledCallback;
 
 	class Slave : public RefCounted {
@@ -75,9 +80,27 @@ public:
 private:
 	static const unsigned CACHE_JOB_SIZE = 100;
 
+	typedef std::list<RefCountedPtr<T>> RecentList;
+
+	struct AtticEntry {
+		T *object;
+		// the reference keeping the object alive for reuse, if there is one
+		bool recent;
+		typename RecentList::iterator recentIt;
+		size_t size;
+	};
+	typedef SystemPathMap<AtticEntry> AtticMap;
+
+	// the path with only the parts that CompareT looks at
+	static SystemPath MakeKey(const SystemPath &path);
+	static size_t EstimateSize(const T *object);
+
 	void AddToCache(std::vector<RefCountedPtr<T>> &objects);
 	bool HasCached(const SystemPath &path) const;
 	void RemoveFromAttic(const SystemPath &path);
+	void Touch(AtticEntry &entry);
+	void Evict();
+	void UpdateSizeCounters();
 
 	// ********************************************************************************
 	// Overloaded Job class to handle generating a collection of sectors
@@ -105,9 +128,29 @@ private:
 		// or elsewhere. The Sector destructor ensures that it is removed from here.
 		// This ensures, that there is only ever one object for each Sector.
 
+	// star system generation looks sectors up from the job runners, and a
+	// hit moves the object to the front of m_recent (and may evict), so the
+	// attic and the recent list are only touched with this held. recursive,
+	// as SDL mutexes are
+	SDL_mutex *m_lock;
+
+	RecentList m_recent; // most recently used first
+	size_t m_recentBytes;
+	size_t m_memoryBudget;
+
 	unsigned long long m_cacheHits;
 	unsigned long long m_cacheHitsSlave;
 	unsigned long long m_cacheMisses;
+
+	// live copies of the above for the performance display, along with the
+	// number of objects evicted, the number alive and the kilobytes kept
+	// for reuse
+	Perf::Stats::CounterRef m_statHits;
+	Perf::Stats::CounterRef m_statHitsSlave;
+	Perf::Stats::CounterRef m_statMisses;
+	Perf::Stats::CounterRef m_statEvictions;
+	Perf::Stats::CounterRef m_statObjects;
+	Perf::Stats::CounterRef m_statRecentKB;
 };
 
 class Sector;
@@ -3,8 +3,10 @@
 
 #include "GalaxyGenerator.h"
 
+#include "GameConfig.h"
 #include "GameSaveError.h"
 #include "Json.h"
+#include "Pi.h"
 #include "SectorGenerator.h"
 #include "galaxy/Galaxy.h"
 #include "galaxy/StarSystemGenerator.h"
@@ -51,9 +53,14 @@ RefCountedPtr<Galaxy> GalaxyGenerator::Create(const std::string &name, Version v
 	if (name == "legacy") {
 		Output("Creating new galaxy generator '%s' version %d\n", name.c_str(), version);
 		if (version == 0 || version == 1) {
+			SectorGeneratorStage *randomSystems = new SectorRandomSystemsGenerator;
+			if (Pi::config->Int("SectorDiskCache")) {
+				const std::string id = name + "-" + std::to_string(version);
+				randomSystems = new SectorDiskCacheGenerator(randomSystems, "sectors-" + id + ".bin", id);
+			}
 			galgen.Reset((new GalaxyGenerator(name, version))
 							 ->AddSectorStage(new SectorCustomSystemsGenerator(CustomSystem::CUSTOM_ONLY_RADIUS))
-							 ->AddSectorStage(new SectorRandomSystemsGenerator)
+							 ->AddSectorStage(randomSystems)
 							 ->AddSectorStage(new SectorPersistenceGenerator(version))
 							 ->AddStarSystemStage(new StarSystemFromSectorGenerator)
 							 ->AddStarSystemStage(new StarSystemCustomGenerator)
@@ -70,6 +77,10 @@ RefCountedPtr<Galaxy> GalaxyGenerator::Create(const std::string &name, Version v
 			return s_galaxy;
 		}
 
+		// the objects kept for reuse in the old galaxy's caches hold on to it
+		if (s_galaxy)
+			s_galaxy->FlushCaches();
+
 		assert(name == "legacy"); // Once whe have have more, this will become an if switch
 		// NB : The galaxy density image MUST be in BMP format due to OSX failing to load pngs the same as Linux/Windows
 		s_galaxy = RefCountedPtr<Galaxy>(new DensityMapGalaxy(galgen, "galaxy_dense.bmp", 50000.0, 25000.0, 0.0, "factions", "systems"));
@@ -0,0 +1,149 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "GalaxyPrefetcher.h"
+
+#include "galaxy/Galaxy.h"
+#include "profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+GalaxyPrefetcher::GalaxyPrefetcher(RefCountedPtr<Galaxy> galaxy) :
+	m_sectorCache(galaxy->NewSectorSlaveCache()),
+	m_systemCache(galaxy->NewStarSystemSlaveCache())
+{
+}
+
+bool GalaxyPrefetcher::Region::Contains(const SystemPath &sec) const
+{
+	const int dx = sec.sectorX - x;
+	const int dy = sec.sectorY - y;
+	const int dz = sec.sectorZ - z;
+	return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+bool GalaxyPrefetcher::InAnyRegion(const std::vector<Region> &regions, const SystemPath &sec)
+{
+	for (const Region &r : regions) {
+		if (r.Contains(sec)) return true;
+	}
+	return false;
+}
+
+void GalaxyPrefetcher::WantSectors(const vector3f &centre, float radius)
+{
+	Region r;
+	r.x = int(std::floor(centre.x));
+	r.y = int(std::floor(centre.y));
+	r.z = int(std::floor(centre.z));
+	r.radius = int(std::ceil(radius));
+	if (std::find(m_regions.begin(), m_regions.end(), r) == m_regions.end())
+		m_regions.push_back(r);
+}
+
+void GalaxyPrefetcher::WantSystem(const SystemPath &path)
+{
+	const SystemPath system = path.SystemOnly();
+	if (std::find(m_systems.begin(), m_systems.end(), system) == m_systems.end())
+		m_systems.push_back(system);
+}
+
+template <typename CacheT>
+void GalaxyPrefetcher::ForgetArrived(SystemPathMap<bool> &pending, CacheT *cache)
+{
+	auto it = pending.begin();
+	while (it != pending.end()) {
+		if (cache->GetIfCached(it->first))
+			pending.erase(it++);
+		else
+			++it;
+	}
+}
+
+void GalaxyPrefetcher::Update()
+{
+	PROFILE_SCOPED()
+	UpdateSectors();
+	UpdateSystems();
+}
+
+void GalaxyPrefetcher::UpdateSectors()
+{
+	if (m_regions == m_lastRegions) {
+		m_regions.clear();
+		return;
+	}
+
+	// forget about requests that have arrived, then let go of what nothing
+	// wants any more
+	ForgetArrived(m_pendingSectors, m_sectorCache.Get());
+	auto it = m_sectorCache->Begin();
+	while (it != m_sectorCache->End()) {
+		if (!InAnyRegion(m_regions, it->first))
+			m_sectorCache->Erase(it++);
+		else
+			++it;
+	}
+
+	// ask for the rest, most urgent region first and nearest its centre
+	// first. anything that was in the last regions has been asked for
+	// already, so usually only the edge the regions moved towards is new
+	SectorCache::PathVector paths;
+	for (const Region &r : m_regions) {
+		const size_t first = paths.size();
+		for (int x = r.x - r.radius; x <= r.x + r.radius; x++) {
+			for (int y = r.y - r.radius; y <= r.y + r.radius; y++) {
+				for (int z = r.z - r.radius; z <= r.z + r.radius; z++) {
+					const SystemPath sec(x, y, z);
+					if (!r.Contains(sec) || InAnyRegion(m_lastRegions, sec))
+						continue;
+					if (m_sectorCache->GetIfCached(sec) || m_pendingSectors.find(sec) != m_pendingSectors.end())
+						continue;
+					m_pendingSectors[sec] = true;
+					paths.push_back(sec);
+				}
+			}
+		}
+		const vector3f centre(r.x, r.y, r.z);
+		std::sort(paths.begin() + first, paths.end(), [&centre](const SystemPath &a, const SystemPath &b) {
+			return (vector3f(a.sectorX, a.sectorY, a.sectorZ) - centre).LengthSqr() < (vector3f(b.sectorX, b.sectorY, b.sectorZ) - centre).LengthSqr();
+		});
+	}
+
+	m_lastRegions.swap(m_regions);
+	m_regions.clear();
+
+	if (!paths.empty())
+		m_sectorCache->FillCache(paths);
+}
+
+void GalaxyPrefetcher::UpdateSystems()
+{
+	if (m_systems == m_lastSystems) {
+		m_systems.clear();
+		return;
+	}
+
+	ForgetArrived(m_pendingSystems, m_systemCache.Get());
+	auto it = m_systemCache->Begin();
+	while (it != m_systemCache->End()) {
+		if (std::find(m_systems.begin(), m_systems.end(), it->first) == m_systems.end())
+			m_systemCache->Erase(it++);
+		else
+			++it;
+	}
+
+	StarSystemCache::PathVector paths;
+	for (const SystemPath &path : m_systems) {
+		if (m_systemCache->GetIfCached(path) || m_pendingSystems.find(path) != m_pendingSystems.end())
+			continue;
+		m_pendingSystems[path] = true;
+		paths.push_back(path);
+	}
+
+	m_lastSystems.swap(m_systems);
+	m_systems.clear();
+
+	if (!paths.empty())
+		m_systemCache->FillCache(paths);
+}
@@ -0,0 +1,62 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GALAXYPREFETCHER_H
+#define _GALAXYPREFETCHER_H
+
+#include "RefCounted.h"
+#include "galaxy/GalaxyCache.h"
+#include "galaxy/SystemPath.h"
+#include "galaxy/SystemPathMap.h"
+#include "vector3.h"
+#include <vector>
+
+class Galaxy;
+
+// Generates sectors and star systems before they are needed, on the job
+// queue at low priority, so that whoever looks them up later finds them
+// cached instead of generating them on the spot.
+//
+// Each frame the owner says what it expects to want soon, then calls
+// Update(). Whatever is wanted is kept, and whatever no longer is is let go
+// (though the galaxy may keep it for a while yet).
+class GalaxyPrefetcher {
+public:
+	explicit GalaxyPrefetcher(RefCountedPtr<Galaxy> galaxy);
+
+	// every sector within radius sectors of centre, which is in sectors
+	// (as SectorView::GetPosition())
+	void WantSectors(const vector3f &centre, float radius);
+	// star systems, most urgent first
+	void WantSystem(const SystemPath &path);
+
+	void Update();
+
+private:
+	struct Region {
+		int x, y, z;
+		int radius;
+		bool operator==(const Region &o) const { return x == o.x && y == o.y && z == o.z && radius == o.radius; }
+		bool Contains(const SystemPath &sec) const;
+	};
+
+	static bool InAnyRegion(const std::vector<Region> &regions, const SystemPath &sec);
+	template <typename CacheT>
+	static void ForgetArrived(SystemPathMap<bool> &pending, CacheT *cache);
+	void UpdateSectors();
+	void UpdateSystems();
+
+	RefCountedPtr<SectorCache::Slave> m_sectorCache;
+	RefCountedPtr<StarSystemCache::Slave> m_systemCache;
+
+	// what is wanted this frame, and what was wanted last time it changed
+	std::vector<Region> m_regions, m_lastRegions;
+	std::vector<SystemPath> m_systems, m_lastSystems;
+
+	// asked for but not arrived (as far as we know), so not to be asked
+	// for again
+	SystemPathMap<bool> m_pendingSectors;
+	SystemPathMap<bool> m_pendingSystems;
+};
+
+#endif /* _GALAXYPREFETCHER_H */
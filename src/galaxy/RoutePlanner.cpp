@@ -0,0 +1,149 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RoutePlanner.h"
+
+#include "profiler/Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+RoutePlanner::RoutePlanner(std::vector<Node> &&nodes, size_t start, size_t target, float maxRange, float costScale) :
+	m_nodes(std::move(nodes)),
+	m_start(start),
+	m_target(target),
+	m_maxRange(maxRange),
+	m_costScale(costScale),
+	m_shortestJump(0.0f),
+	m_numVisited(0)
+{
+	assert(start < m_nodes.size() && target < m_nodes.size());
+}
+
+bool RoutePlanner::Cell::operator<(const Cell &o) const
+{
+	if (x != o.x) return x < o.x;
+	if (y != o.y) return y < o.y;
+	return z < o.z;
+}
+
+RoutePlanner::Cell RoutePlanner::CellAt(const vector3f &pos) const
+{
+	Cell c;
+	c.x = int(std::floor(pos.x / m_maxRange));
+	c.y = int(std::floor(pos.y / m_maxRange));
+	c.z = int(std::floor(pos.z / m_maxRange));
+	return c;
+}
+
+void RoutePlanner::BuildNeighbours()
+{
+	PROFILE_SCOPED()
+	// every node sorted by its cell, so a cell's nodes are a run
+	std::vector<std::pair<Cell, Uint32>> cells;
+	cells.reserve(m_nodes.size());
+	for (size_t i = 0; i < m_nodes.size(); i++)
+		cells.push_back(std::make_pair(CellAt(m_nodes[i].pos), Uint32(i)));
+	std::sort(cells.begin(), cells.end(), [](const std::pair<Cell, Uint32> &a, const std::pair<Cell, Uint32> &b) {
+		return a.first < b.first;
+	});
+
+	const float maxRangeSqr = m_maxRange * m_maxRange;
+	float shortestSqr = std::numeric_limits<float>::max();
+	m_firstNeighbour.assign(1, 0);
+	m_neighbours.clear();
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		const vector3f &pos = m_nodes[i].pos;
+		const Cell home = CellAt(pos);
+		// anything in range is in this cell or one next to it
+		Cell c;
+		for (c.x = home.x - 1; c.x <= home.x + 1; c.x++) {
+			for (c.y = home.y - 1; c.y <= home.y + 1; c.y++) {
+				for (c.z = home.z - 1; c.z <= home.z + 1; c.z++) {
+					auto it = std::lower_bound(cells.begin(), cells.end(), c, [](const std::pair<Cell, Uint32> &a, const Cell &b) {
+						return a.first < b;
+					});
+					for (; it != cells.end() && it->first == c; ++it) {
+						if (it->second == i) continue;
+						const float distSqr = (m_nodes[it->second].pos - pos).LengthSqr();
+						if (distSqr > maxRangeSqr) continue;
+						m_neighbours.push_back(std::make_pair(it->second, distSqr));
+						shortestSqr = std::min(shortestSqr, distSqr);
+					}
+				}
+			}
+		}
+		m_firstNeighbour.push_back(m_neighbours.size());
+	}
+	m_shortestJump = m_neighbours.empty() ? 0.0f : std::sqrt(shortestSqr);
+}
+
+bool RoutePlanner::FindRoute(std::vector<SystemPath> &route)
+{
+	PROFILE_SCOPED()
+	route.clear();
+	m_numVisited = 0;
+	if (!(m_maxRange > 0.0f))
+		return false;
+
+	BuildNeighbours();
+
+	// every jump is at least m_shortestJump long, so it costs at least
+	// costScale * m_shortestJump for each light year it covers, and the
+	// route can't cover less than the straight line. that never overestimates
+	// (and is consistent), so the first time the target comes off the heap
+	// is along the quickest route
+	const vector3f targetPos = m_nodes[m_target].pos;
+	const double costPerLy = double(m_costScale) * m_shortestJump;
+	auto heuristic = [&](Uint32 i) {
+		return costPerLy * (m_nodes[i].pos - targetPos).Length();
+	};
+
+	const size_t numNodes = m_nodes.size();
+	std::vector<double> cost(numNodes, std::numeric_limits<double>::infinity());
+	std::vector<Uint32> prev(numNodes, Uint32(m_start));
+	std::vector<bool> visited(numNodes, false);
+
+	// estimated total cost and node. nodes are pushed again rather than
+	// having their entries updated, and the stale entries skipped
+	typedef std::pair<double, Uint32> OpenEntry;
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+	cost[m_start] = 0.0;
+	open.push(std::make_pair(heuristic(Uint32(m_start)), Uint32(m_start)));
+
+	bool found = false;
+	while (!open.empty()) {
+		const Uint32 u = open.top().second;
+		open.pop();
+		if (visited[u]) continue;
+		visited[u] = true;
+		m_numVisited++;
+
+		if (u == m_target) {
+			found = true;
+			break;
+		}
+
+		for (size_t n = m_firstNeighbour[u]; n < m_firstNeighbour[u + 1]; n++) {
+			const Uint32 v = m_neighbours[n].first;
+			if (visited[v]) continue;
+			const double c = cost[u] + double(m_costScale) * m_neighbours[n].second;
+			if (c < cost[v]) {
+				cost[v] = c;
+				prev[v] = u;
+				open.push(std::make_pair(c + heuristic(v), v));
+			}
+		}
+	}
+
+	if (!found)
+		return false;
+
+	for (size_t u = m_target; u != m_start; u = prev[u])
+		route.push_back(m_nodes[u].path);
+	std::reverse(route.begin(), route.end());
+	return true;
+}
@@ -0,0 +1,63 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ROUTEPLANNER_H
+#define _ROUTEPLANNER_H
+
+#include "galaxy/SystemPath.h"
+#include "vector3.h"
+#include <vector>
+
+// Finds the quickest chain of hyperspace jumps between two systems, out of a
+// set of candidate systems gathered beforehand. It only deals in positions,
+// so it can run on a job thread while the galaxy stays on the main thread.
+//
+// A jump of d light years takes costScale * d^2 seconds (as in
+// HyperdriveType:GetDuration) and can be at most maxRange long. The search is
+// A*, over a grid of maxRange sized cells so that only systems in range are
+// looked at as neighbours.
+class RoutePlanner {
+public:
+	struct Node {
+		Node(const SystemPath &p, const vector3f &fullPos) :
+			path(p),
+			pos(fullPos) {}
+		SystemPath path;
+		vector3f pos; // in light years, from the galactic origin
+	};
+
+	RoutePlanner(std::vector<Node> &&nodes, size_t start, size_t target, float maxRange, float costScale);
+
+	// fills route with the systems to jump to in order, ending with the
+	// target. returns false if the target can't be reached
+	bool FindRoute(std::vector<SystemPath> &route);
+
+	size_t GetNumVisited() const { return m_numVisited; }
+
+private:
+	struct Cell {
+		int x, y, z;
+		bool operator<(const Cell &o) const;
+		bool operator==(const Cell &o) const { return x == o.x && y == o.y && z == o.z; }
+	};
+
+	Cell CellAt(const vector3f &pos) const;
+	void BuildNeighbours();
+
+	std::vector<Node> m_nodes;
+	const size_t m_start, m_target;
+	const float m_maxRange;
+	const float m_costScale;
+
+	// the systems in range of node i are m_neighbours[m_firstNeighbour[i]]
+	// up to m_firstNeighbour[i + 1], with the square of their distance
+	std::vector<size_t> m_firstNeighbour;
+	std::vector<std::pair<Uint32, float>> m_neighbours;
+	// no jump is shorter than this, which bounds the cost of the rest of
+	// the route from below
+	float m_shortestJump;
+
+	size_t m_numVisited;
+};
+
+#endif /* _ROUTEPLANNER_H */
@@ -97,6 +97,7 @@ public:
 		friend class SectorCustomSystemsGenerator;
 		friend class SectorRandomSystemsGenerator;
 		friend class SectorPersistenceGenerator;
+		friend class SectorDiskCacheGenerator;
 
 		void AssignFaction() const;
 
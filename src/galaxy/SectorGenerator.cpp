@@ -9,7 +9,11 @@
 #include "Galaxy.h"
 #include "GameSaveError.h"
 #include "Json.h"
+#include "jenkins/lookup3.h"
 #include "utils.h"
+#include <SDL_endian.h>
+#include <SDL_mutex.h>
+#include <cstring>
 
 #define Square(x) ((x) * (x))
 
@@ -493,6 +497,331 @@ bool SectorRandomSystemsGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> gala
 	return true;
 }
 
+namespace {
+	const char DISK_CACHE_MAGIC[8] = { 'P', 'I', 'O', 'N', 'S', 'E', 'C', 'T' };
+	const Uint32 DISK_CACHE_FORMAT_VERSION = 1;
+	const size_t DISK_CACHE_HEADER_SIZE = sizeof(DISK_CACHE_MAGIC) + 2 * sizeof(Uint32);
+	// each record is Uint32 payloadSize, Uint32 checksum, payload
+	const size_t DISK_CACHE_RECORD_HEADER_SIZE = 2 * sizeof(Uint32);
+	// new records are appended to the file once there are this many bytes
+	const size_t DISK_CACHE_FLUSH_SIZE = 64 * 1024;
+	const std::string DISK_CACHE_DIR_NAME = "cache";
+
+	void AppendLE32(std::vector<char> &out, Uint32 v)
+	{
+		v = SDL_SwapLE32(v);
+		out.insert(out.end(), reinterpret_cast<const char *>(&v), reinterpret_cast<const char *>(&v) + sizeof(v));
+	}
+
+	void AppendLE16(std::vector<char> &out, Uint16 v)
+	{
+		v = SDL_SwapLE16(v);
+		out.insert(out.end(), reinterpret_cast<const char *>(&v), reinterpret_cast<const char *>(&v) + sizeof(v));
+	}
+
+	void AppendFloat(std::vector<char> &out, float f)
+	{
+		Uint32 v;
+		memcpy(&v, &f, sizeof(v));
+		AppendLE32(out, v);
+	}
+
+	void SetLE32(std::vector<char> &out, size_t pos, Uint32 v)
+	{
+		v = SDL_SwapLE32(v);
+		memcpy(&out[pos], &v, sizeof(v));
+	}
+
+	// reads little endian values, failing rather than reading past the end
+	class RecordReader {
+	public:
+		RecordReader(const char *data, size_t length) :
+			m_data(data),
+			m_length(length),
+			m_pos(0),
+			m_ok(true) {}
+
+		bool Ok() const { return m_ok; }
+		bool AtEnd() const { return m_pos == m_length; }
+
+		Uint8 U8()
+		{
+			Uint8 v = 0;
+			Read(&v, sizeof(v));
+			return v;
+		}
+
+		Uint16 LE16()
+		{
+			Uint16 v = 0;
+			Read(&v, sizeof(v));
+			return SDL_SwapLE16(v);
+		}
+
+		Uint32 LE32()
+		{
+			Uint32 v = 0;
+			Read(&v, sizeof(v));
+			return SDL_SwapLE32(v);
+		}
+
+		float Float()
+		{
+			const Uint32 v = LE32();
+			float f;
+			memcpy(&f, &v, sizeof(f));
+			return f;
+		}
+
+		std::string String(size_t size)
+		{
+			if (!Need(size)) return std::string();
+			std::string s(m_data + m_pos, size);
+			m_pos += size;
+			return s;
+		}
+
+	private:
+		bool Need(size_t size)
+		{
+			if (size > m_length - m_pos) m_ok = false;
+			return m_ok;
+		}
+
+		void Read(void *out, size_t size)
+		{
+			if (!Need(size)) return;
+			memcpy(out, m_data + m_pos, size);
+			m_pos += size;
+		}
+
+		const char *m_data;
+		size_t m_length;
+		size_t m_pos;
+		bool m_ok;
+	};
+
+	Uint32 RecordPayloadSize(const std::vector<char> &records, size_t offset)
+	{
+		return RecordReader(&records[offset], DISK_CACHE_RECORD_HEADER_SIZE).LE32();
+	}
+} // namespace
+
+SectorDiskCacheGenerator::SectorDiskCacheGenerator(SectorGeneratorStage *stage, const std::string &fileName, const std::string &generatorId) :
+	m_stage(stage),
+	m_fileName(FileSystem::JoinPathBelow(DISK_CACHE_DIR_NAME, fileName)),
+	m_generatorId(generatorId),
+	m_lock(SDL_CreateMutex()),
+	m_opened(false),
+	m_fingerprint(0),
+	m_recordsOnDisk(0),
+	m_rewrite(false)
+{
+}
+
+SectorDiskCacheGenerator::~SectorDiskCacheGenerator()
+{
+	if (m_opened)
+		Flush();
+	SDL_DestroyMutex(m_lock);
+}
+
+bool SectorDiskCacheGenerator::Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig *config)
+{
+	// nothing is generated in the core, and until the factions are loaded
+	// the home systems (and so what is explored at start) aren't known
+	if (config->isCustomOnly || !galaxy->IsInitialized())
+		return m_stage->Apply(rng, galaxy, sector, config);
+
+	const Uint32 firstSystem = Uint32(sector->m_systems.size());
+	const Uint8 density = galaxy->GetSectorDensity(sector->sx, sector->sy, sector->sz);
+
+	SDL_LockMutex(m_lock);
+	if (!m_opened)
+		Open(galaxy);
+	const bool found = ReadSector(sector.Get(), firstSystem, density);
+	SDL_UnlockMutex(m_lock);
+	if (found)
+		return true;
+
+	// generate outside the lock, so the cache jobs can still run side by side
+	const bool result = m_stage->Apply(rng, galaxy, sector, config);
+
+	SDL_LockMutex(m_lock);
+	AddSector(sector.Get(), firstSystem, density);
+	if (m_records.size() - m_recordsOnDisk >= DISK_CACHE_FLUSH_SIZE)
+		Flush();
+	SDL_UnlockMutex(m_lock);
+	return result;
+}
+
+void SectorDiskCacheGenerator::Open(RefCountedPtr<Galaxy> galaxy)
+{
+	m_opened = true;
+
+	std::vector<char> id(m_generatorId.begin(), m_generatorId.end());
+	AppendLE32(id, DISK_CACHE_FORMAT_VERSION);
+	AppendLE32(id, galaxy->GetFactions()->GetHomeSystemsHash());
+	m_fingerprint = lookup3_hashlittle(id.data(), id.size(), 0);
+
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(m_fileName);
+	if (!file) {
+		m_rewrite = true;
+		return;
+	}
+
+	const char *data = file->GetData();
+	const size_t size = file->GetSize();
+	RecordReader header(data, size);
+	const std::string magic = header.String(sizeof(DISK_CACHE_MAGIC));
+	const Uint32 version = header.LE32();
+	const Uint32 fingerprint = header.LE32();
+	if (!header.Ok() || memcmp(magic.data(), DISK_CACHE_MAGIC, sizeof(DISK_CACHE_MAGIC)) != 0 ||
+		version != DISK_CACHE_FORMAT_VERSION || fingerprint != m_fingerprint) {
+		// another format, or generated for other factions: start over
+		m_rewrite = true;
+		return;
+	}
+
+	size_t pos = DISK_CACHE_HEADER_SIZE;
+	while (pos < size) {
+		RecordReader record(data + pos, size - pos);
+		const Uint32 payloadSize = record.LE32();
+		const Uint32 checksum = record.LE32();
+		if (!record.Ok() || payloadSize > size - pos - DISK_CACHE_RECORD_HEADER_SIZE)
+			break;
+		const char *payload = data + pos + DISK_CACHE_RECORD_HEADER_SIZE;
+		if (lookup3_hashlittle(payload, payloadSize, 0) != checksum)
+			break;
+
+		RecordReader path(payload, payloadSize);
+		const Sint32 sx = Sint32(path.LE32());
+		const Sint32 sy = Sint32(path.LE32());
+		const Sint32 sz = Sint32(path.LE32());
+		if (!path.Ok())
+			break;
+
+		const size_t recordSize = DISK_CACHE_RECORD_HEADER_SIZE + payloadSize;
+		m_index[SystemPath(sx, sy, sz)] = m_records.size();
+		m_records.insert(m_records.end(), data + pos, data + pos + recordSize);
+		pos += recordSize;
+	}
+	m_recordsOnDisk = m_records.size();
+
+	// a write was cut short: drop the damaged tail
+	if (pos != size)
+		m_rewrite = true;
+}
+
+bool SectorDiskCacheGenerator::ReadSector(Sector *sector, Uint32 firstSystem, Uint8 density)
+{
+	SystemPathMap<size_t>::const_iterator it = m_index.find(SystemPath(sector->sx, sector->sy, sector->sz));
+	if (it == m_index.end())
+		return false;
+
+	const size_t offset = it->second;
+	RecordReader record(&m_records[offset + DISK_CACHE_RECORD_HEADER_SIZE], RecordPayloadSize(m_records, offset));
+	record.LE32(); // sector coordinates, already matched
+	record.LE32();
+	record.LE32();
+	// generated after different custom systems, or from a different map
+	if (record.LE32() != firstSystem || record.U8() != density)
+		return false;
+
+	std::vector<Sector::System> systems;
+	const Uint32 numSystems = record.LE32();
+	for (Uint32 i = 0; i < numSystems && record.Ok(); i++) {
+		Sector::System s(sector, sector->sx, sector->sy, sector->sz, firstSystem + i);
+		s.m_pos.x = record.Float();
+		s.m_pos.y = record.Float();
+		s.m_pos.z = record.Float();
+		s.m_numStars = std::min<Uint8>(record.U8(), 4);
+		for (int star = 0; star < 4; star++)
+			s.m_starType[star] = SystemBody::BodyType(record.U8());
+		s.m_explored = StarSystem::ExplorationState(record.U8());
+		s.m_name = record.String(record.LE16());
+		systems.push_back(s);
+	}
+	if (!record.Ok() || !record.AtEnd())
+		return false;
+
+	sector->m_systems.reserve(firstSystem + systems.size());
+	for (const Sector::System &s : systems)
+		sector->m_systems.push_back(s);
+	return true;
+}
+
+void SectorDiskCacheGenerator::AddSector(const Sector *sector, Uint32 firstSystem, Uint8 density)
+{
+	const size_t offset = m_records.size();
+	AppendLE32(m_records, 0); // payload size and checksum, set below
+	AppendLE32(m_records, 0);
+
+	AppendLE32(m_records, Uint32(sector->sx));
+	AppendLE32(m_records, Uint32(sector->sy));
+	AppendLE32(m_records, Uint32(sector->sz));
+	AppendLE32(m_records, firstSystem);
+	m_records.push_back(char(density));
+	AppendLE32(m_records, Uint32(sector->m_systems.size() - firstSystem));
+	for (size_t i = firstSystem; i < sector->m_systems.size(); i++) {
+		const Sector::System &s = sector->m_systems[i];
+		AppendFloat(m_records, s.m_pos.x);
+		AppendFloat(m_records, s.m_pos.y);
+		AppendFloat(m_records, s.m_pos.z);
+		m_records.push_back(char(s.m_numStars));
+		for (int star = 0; star < 4; star++)
+			m_records.push_back(char(star < int(s.m_numStars) ? s.m_starType[star] : 0));
+		m_records.push_back(char(s.m_explored));
+		const size_t nameLength = std::min<size_t>(s.m_name.size(), 0xffff);
+		AppendLE16(m_records, Uint16(nameLength));
+		m_records.insert(m_records.end(), s.m_name.begin(), s.m_name.begin() + nameLength);
+	}
+
+	const size_t payloadSize = m_records.size() - offset - DISK_CACHE_RECORD_HEADER_SIZE;
+	SetLE32(m_records, offset, Uint32(payloadSize));
+	SetLE32(m_records, offset + sizeof(Uint32), lookup3_hashlittle(&m_records[offset + DISK_CACHE_RECORD_HEADER_SIZE], payloadSize, 0));
+
+	// a sector generated twice (after a cache flush, say) replaces the old
+	// record, which stays in the file unused until it is next rewritten
+	m_index[SystemPath(sector->sx, sector->sy, sector->sz)] = offset;
+}
+
+void SectorDiskCacheGenerator::Flush()
+{
+	if (!m_rewrite && m_recordsOnDisk == m_records.size())
+		return;
+
+	if (!FileSystem::userFiles.MakeDirectory(DISK_CACHE_DIR_NAME)) {
+		m_recordsOnDisk = m_records.size();
+		return;
+	}
+
+	FILE *f;
+	size_t from;
+	if (m_rewrite) {
+		f = FileSystem::userFiles.OpenWriteStream(m_fileName);
+		if (f) {
+			std::vector<char> header(DISK_CACHE_MAGIC, DISK_CACHE_MAGIC + sizeof(DISK_CACHE_MAGIC));
+			AppendLE32(header, DISK_CACHE_FORMAT_VERSION);
+			AppendLE32(header, m_fingerprint);
+			fwrite(header.data(), header.size(), 1, f);
+		}
+		from = 0;
+	} else {
+		f = FileSystem::userFiles.OpenWriteStream(m_fileName, FileSystem::FileSourceFS::WRITE_APPEND);
+		from = m_recordsOnDisk;
+	}
+
+	// if it can't be written the sectors are just generated again next time
+	if (f) {
+		if (m_records.size() > from)
+			fwrite(&m_records[from], m_records.size() - from, 1, f);
+		fclose(f);
+	}
+	m_recordsOnDisk = m_records.size();
+	m_rewrite = false;
+}
+
 void SectorPersistenceGenerator::SetExplored(Sector::System *sys, StarSystem::ExplorationState e, double time)
 {
 	if (e == StarSystem::eUNEXPLORED) {
@@ -4,11 +4,17 @@
 #ifndef SECTORGENERATOR_H
 #define SECTORGENERATOR_H
 
+#include "FileSystem.h"
 #include "GalaxyGenerator.h"
 #include "Random.h"
 #include "RefCounted.h"
 #include "Sector.h"
 #include "StarSystem.h"
+#include "galaxy/SystemPathMap.h"
+#include <memory>
+#include <vector>
+
+struct SDL_mutex;
 
 class SectorCustomSystemsGenerator : public SectorGeneratorStage {
 public:
@@ -28,6 +34,40 @@ private:
 	const std::string GenName(RefCountedPtr<Galaxy> galaxy, const Sector &sec, Sector::System &sys, int si, Random &rand);
 };
 
+// Remembers the systems another stage adds to each sector, in a file in the
+// cache dir under the user dir, so that sectors generated in earlier runs are read back rather
+// than generated again. Only used once the galaxy is initialized, because
+// the output depends on the factions' home systems; the file starts over
+// whenever those change. Safe to use from the cache jobs' threads.
+class SectorDiskCacheGenerator : public SectorGeneratorStage {
+public:
+	SectorDiskCacheGenerator(SectorGeneratorStage *stage, const std::string &fileName, const std::string &generatorId);
+	virtual ~SectorDiskCacheGenerator();
+	virtual bool Apply(Random &rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig *config);
+	virtual void FromJson(const Json &jsonObj, RefCountedPtr<Galaxy> galaxy) { m_stage->FromJson(jsonObj, galaxy); }
+	virtual void ToJson(Json &jsonObj, RefCountedPtr<Galaxy> galaxy) { m_stage->ToJson(jsonObj, galaxy); }
+
+private:
+	void Open(RefCountedPtr<Galaxy> galaxy);
+	bool ReadSector(Sector *sector, Uint32 firstSystem, Uint8 density);
+	void AddSector(const Sector *sector, Uint32 firstSystem, Uint8 density);
+	void Flush();
+
+	std::unique_ptr<SectorGeneratorStage> m_stage;
+	const std::string m_fileName;
+	const std::string m_generatorId;
+	SDL_mutex *m_lock;
+
+	bool m_opened;
+	Uint32 m_fingerprint;
+	// every record, those from the file followed by new ones. the index
+	// holds the offset of each sector's record
+	std::vector<char> m_records;
+	SystemPathMap<size_t> m_index;
+	size_t m_recordsOnDisk; // bytes of m_records already in the file
+	bool m_rewrite; // the file is stale or damaged, so write it out whole
+};
+
 class SectorPersistenceGenerator : public SectorGeneratorStage {
 public:
 	SectorPersistenceGenerator(GalaxyGenerator::Version version) :
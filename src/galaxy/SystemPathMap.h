@@ -0,0 +1,225 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SYSTEMPATHMAP_H
+#define _SYSTEMPATHMAP_H
+
+#include "galaxy/SystemPath.h"
+#include "jenkins/lookup3.h"
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// Open addressing hash table from SystemPath to V, hashing the packed blob
+// of the path. Paths only match if all of their fields do, so callers that
+// want e.g. sector granularity should strip the path down first.
+//
+// Erasing leaves a tombstone and never moves other entries, so it is safe to
+// erase while iterating (as with std::map, erase(it++)). Inserting may
+// rehash, which invalidates all iterators.
+template <typename V>
+class SystemPathMap {
+public:
+	typedef std::pair<SystemPath, V> value_type;
+
+private:
+	enum SlotState : Uint8 {
+		SLOT_EMPTY,
+		SLOT_FULL,
+		SLOT_ERASED
+	};
+
+	struct Slot {
+		Slot() :
+			state(SLOT_EMPTY) {}
+		SlotState state;
+		value_type value;
+	};
+
+	template <typename MapT, typename ValueT>
+	class Iterator {
+	public:
+		Iterator() :
+			m_map(nullptr),
+			m_index(0) {}
+		// iterator converts to const_iterator
+		template <typename OtherMapT, typename OtherValueT>
+		Iterator(const Iterator<OtherMapT, OtherValueT> &other) :
+			m_map(other.m_map),
+			m_index(other.m_index) {}
+
+		ValueT &operator*() const { return m_map->m_slots[m_index].value; }
+		ValueT *operator->() const { return &m_map->m_slots[m_index].value; }
+
+		Iterator &operator++()
+		{
+			m_index = m_map->NextFull(m_index + 1);
+			return *this;
+		}
+		Iterator operator++(int)
+		{
+			Iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const Iterator &other) const { return m_index == other.m_index; }
+		bool operator!=(const Iterator &other) const { return m_index != other.m_index; }
+
+	private:
+		friend class SystemPathMap;
+		template <typename, typename>
+		friend class Iterator;
+
+		Iterator(MapT *map, size_t index) :
+			m_map(map),
+			m_index(index) {}
+
+		MapT *m_map;
+		size_t m_index;
+	};
+
+public:
+	typedef Iterator<SystemPathMap, value_type> iterator;
+	typedef Iterator<const SystemPathMap, const value_type> const_iterator;
+
+	SystemPathMap() :
+		m_size(0),
+		m_erased(0) {}
+
+	iterator begin() { return iterator(this, NextFull(0)); }
+	iterator end() { return iterator(this, m_slots.size()); }
+	const_iterator begin() const { return const_iterator(this, NextFull(0)); }
+	const_iterator end() const { return const_iterator(this, m_slots.size()); }
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	iterator find(const SystemPath &key)
+	{
+		return iterator(this, FindSlot(key));
+	}
+
+	const_iterator find(const SystemPath &key) const
+	{
+		return const_iterator(this, FindSlot(key));
+	}
+
+	// does nothing if key is already in the map. returns the entry for key
+	// and whether it was inserted
+	std::pair<iterator, bool> insert(const value_type &value)
+	{
+		size_t index = FindSlot(value.first);
+		if (index != m_slots.size())
+			return std::make_pair(iterator(this, index), false);
+
+		if ((m_size + m_erased + 1) * 2 > m_slots.size())
+			Rehash(m_size + 1);
+
+		index = ProbeStart(value.first);
+		while (m_slots[index].state == SLOT_FULL)
+			index = (index + 1) & (m_slots.size() - 1);
+		if (m_slots[index].state == SLOT_ERASED)
+			m_erased--;
+		m_slots[index].state = SLOT_FULL;
+		m_slots[index].value = value;
+		m_size++;
+		return std::make_pair(iterator(this, index), true);
+	}
+
+	V &operator[](const SystemPath &key)
+	{
+		return insert(value_type(key, V())).first->second;
+	}
+
+	size_t erase(const SystemPath &key)
+	{
+		const size_t index = FindSlot(key);
+		if (index == m_slots.size()) return 0;
+		EraseSlot(index);
+		return 1;
+	}
+
+	void erase(const const_iterator &it)
+	{
+		assert(it.m_map == this && m_slots[it.m_index].state == SLOT_FULL);
+		EraseSlot(it.m_index);
+	}
+
+	void clear()
+	{
+		// the values may call back into the map as they are destroyed, so
+		// take them out of it first
+		std::vector<Slot> slots;
+		slots.swap(m_slots);
+		m_size = m_erased = 0;
+	}
+
+private:
+	static size_t Hash(const SystemPath &key)
+	{
+		char blob[SystemPath::SizeAsBlob];
+		key.SerializeToBlob(blob);
+		return lookup3_hashlittle(blob, SystemPath::SizeAsBlob, 0);
+	}
+
+	size_t ProbeStart(const SystemPath &key) const
+	{
+		return Hash(key) & (m_slots.size() - 1);
+	}
+
+	// the slot holding key, or m_slots.size() if it isn't in the map
+	size_t FindSlot(const SystemPath &key) const
+	{
+		if (m_size == 0) return m_slots.size();
+		const size_t mask = m_slots.size() - 1;
+		for (size_t index = ProbeStart(key);; index = (index + 1) & mask) {
+			const Slot &slot = m_slots[index];
+			if (slot.state == SLOT_EMPTY) return m_slots.size();
+			if (slot.state == SLOT_FULL && slot.value.first == key) return index;
+		}
+	}
+
+	size_t NextFull(size_t index) const
+	{
+		while (index < m_slots.size() && m_slots[index].state != SLOT_FULL)
+			index++;
+		return index;
+	}
+
+	void EraseSlot(size_t index)
+	{
+		// release the value now rather than whenever the slot is reused
+		m_slots[index].value.second = V();
+		m_slots[index].state = SLOT_ERASED;
+		m_size--;
+		m_erased++;
+	}
+
+	// keeps the load (including tombstones) at or under a half
+	void Rehash(size_t minSize)
+	{
+		size_t capacity = 16;
+		while (capacity < minSize * 4)
+			capacity *= 2;
+
+		std::vector<Slot> old(capacity);
+		old.swap(m_slots);
+		m_erased = 0;
+		const size_t mask = capacity - 1;
+		for (Slot &slot : old) {
+			if (slot.state != SLOT_FULL) continue;
+			size_t index = ProbeStart(slot.value.first);
+			while (m_slots[index].state == SLOT_FULL)
+				index = (index + 1) & mask;
+			m_slots[index].state = SLOT_FULL;
+			m_slots[index].value = std::move(slot.value);
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size;
+	size_t m_erased;
+};
+
+#endif /* _SYSTEMPATHMAP_H */
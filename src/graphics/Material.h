@@ -103,6 +103,10 @@ namespace Graphics {
 
 		virtual void SetCommonUniforms(const matrix4x4f &mv, const matrix4x4f &proj) = 0;
 
+		// the same for materials drawn with the same shader program, so that
+		// queued draws can be grouped by it
+		virtual Uint32 GetProgramKey() const { return 0; }
+
 		void *specialParameter0; //this can be whatever. Bit of a hack.
 
 		//XXX may not be necessary. Used by newmodel to check if a material uses patterns
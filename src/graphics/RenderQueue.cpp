@@ -0,0 +1,45 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "RenderQueue.h"
+
+#include "profiler/Profiler.h"
+#include <algorithm>
+
+namespace Graphics {
+
+	void RenderQueue::Add(const DrawPacket &packet)
+	{
+		m_packets.push_back(packet);
+		m_packets.back().order = Uint32(m_packets.size() - 1);
+	}
+
+	static bool DrawOrder(const DrawPacket &a, const DrawPacket &b)
+	{
+		if (a.blended != b.blended)
+			return !a.blended;
+
+		if (a.blended) {
+			if (a.depth != b.depth)
+				return a.depth > b.depth;
+			return a.order < b.order;
+		}
+
+		if (a.renderState != b.renderState)
+			return a.renderState < b.renderState;
+		if (a.programKey != b.programKey)
+			return a.programKey < b.programKey;
+		if (a.material != b.material)
+			return a.material < b.material;
+		if (a.depth != b.depth)
+			return a.depth < b.depth;
+		return a.order < b.order;
+	}
+
+	void RenderQueue::Sort()
+	{
+		PROFILE_SCOPED()
+		std::sort(m_packets.begin(), m_packets.end(), DrawOrder);
+	}
+
+} // namespace Graphics
@@ -0,0 +1,59 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_RENDERQUEUE_H
+#define _GRAPHICS_RENDERQUEUE_H
+
+#include "Types.h"
+#include "matrix4x4.h"
+#include <vector>
+
+namespace Graphics {
+
+	class IndexBuffer;
+	class InstanceBuffer;
+	class Material;
+	class RenderState;
+	class VertexBuffer;
+
+	// a draw recorded by Renderer::QueueDraw(), with the transform it was
+	// recorded with
+	struct DrawPacket {
+		VertexBuffer *vertexBuffer;
+		IndexBuffer *indexBuffer; // null to draw the vertices in order
+		InstanceBuffer *instanceBuffer; // null if not instanced
+		RenderState *renderState;
+		Material *material;
+		PrimitiveType primitiveType;
+		matrix4x4f transform;
+		float depth; // distance of the transform's origin from the camera
+		Uint32 order; // recorded order
+		Uint32 programKey; // Material::GetProgramKey()
+		bool blended;
+	};
+
+	/*
+	 * The draws recorded since the queue was last emptied, put in the
+	 * order they're best drawn in:
+	 *  - opaque draws first, grouped by render state, then program, then
+	 *    material, and nearest first within those (so the depth test
+	 *    rejects as much as it can)
+	 *  - then blended draws, farthest first, as they have to be; draws at
+	 *    the same distance (parts of the same model) keep their order
+	 */
+	class RenderQueue {
+	public:
+		void Add(const DrawPacket &packet);
+		void Sort();
+		void Clear() { m_packets.clear(); }
+
+		bool Empty() const { return m_packets.empty(); }
+		const std::vector<DrawPacket> &GetPackets() const { return m_packets; }
+
+	private:
+		std::vector<DrawPacket> m_packets;
+	};
+
+} // namespace Graphics
+
+#endif
@@ -2,7 +2,11 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Renderer.h"
+#include "Material.h"
+#include "RenderState.h"
 #include "Texture.h"
+#include "profiler/Profiler.h"
+#include <cstring>
 
 namespace Graphics {
 
@@ -41,6 +45,80 @@ namespace Graphics {
 		m_textureCache.erase(i);
 	}
 
+	void Renderer::EndQueue()
+	{
+		assert(m_queueDepth > 0);
+		if (--m_queueDepth == 0)
+			FlushQueue();
+	}
+
+	bool Renderer::QueueDraw(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *mat, PrimitiveType pt)
+	{
+		return QueueDrawInstanced(vb, ib, rs, mat, nullptr, pt);
+	}
+
+	bool Renderer::QueueDrawInstanced(VertexBuffer *vb, IndexBuffer *ib, RenderState *rs, Material *mat, InstanceBuffer *instb, PrimitiveType pt)
+	{
+		if (m_queueDepth == 0) {
+			if (instb)
+				return ib ? DrawBufferIndexedInstanced(vb, ib, rs, mat, instb, pt) : DrawBufferInstanced(vb, rs, mat, instb, pt);
+			return ib ? DrawBufferIndexed(vb, ib, rs, mat, pt) : DrawBuffer(vb, rs, mat, pt);
+		}
+
+		DrawPacket packet;
+		packet.vertexBuffer = vb;
+		packet.indexBuffer = ib;
+		packet.instanceBuffer = instb;
+		packet.renderState = rs;
+		packet.material = mat;
+		packet.primitiveType = pt;
+		packet.transform = GetTransform();
+		packet.depth = packet.transform.GetTranslate().Length();
+		packet.programKey = mat->GetProgramKey();
+		packet.blended = rs->GetDesc().blendMode != BLEND_SOLID;
+		m_queue.Add(packet);
+		m_stats.AddToStatCount(Stats::STAT_QUEUED_DRAWCALL, 1);
+		return true;
+	}
+
+	void Renderer::FlushQueue()
+	{
+		PROFILE_SCOPED()
+		if (m_queue.Empty())
+			return;
+		m_queue.Sort();
+
+		// the transform is put back afterwards, for the caller
+		const matrix4x4f callerTransform = GetTransform();
+
+		RenderState *lastState = nullptr;
+		Material *lastMaterial = nullptr;
+		const matrix4x4f *lastTransform = nullptr;
+		Uint32 appliesSaved = 0;
+		for (const DrawPacket &packet : m_queue.GetPackets()) {
+			if (packet.renderState != lastState) {
+				SetRenderState(packet.renderState);
+				lastState = packet.renderState;
+			}
+
+			const bool applyMaterial = packet.material != lastMaterial;
+			const bool newTransform = !lastTransform ||
+				memcmp(&packet.transform[0], &(*lastTransform)[0], 16 * sizeof(float)) != 0;
+			if (newTransform)
+				SetTransform(packet.transform);
+			if (!applyMaterial)
+				appliesSaved++;
+
+			SubmitPacket(packet, applyMaterial, applyMaterial || newTransform);
+			lastMaterial = packet.material;
+			lastTransform = &packet.transform;
+		}
+
+		m_queue.Clear();
+		SetTransform(callerTransform);
+		m_stats.AddToStatCount(Stats::STAT_MATERIAL_APPLIES_SAVED, appliesSaved);
+	}
+
 	void Renderer::RemoveAllCachedTextures()
 	{
 		for (TextureCacheMap::iterator i = m_textureCache.begin(); i != m_textureCache.end(); ++i)
@@ -6,6 +6,7 @@
 
 #include "Graphics.h"
 #include "Light.h"
+#include "RenderQueue.h"
 #include "Stats.h"
 #include "Types.h"
 #include "libs.h"
@@ -126,6 +127,23 @@ namespace Graphics {
 		virtual bool DrawBufferInstanced(VertexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType type = TRIANGLES) = 0;
 		virtual bool DrawBufferIndexedInstanced(VertexBuffer *, IndexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType = TRIANGLES) = 0;
 
+		// Deferred drawing. Between BeginQueue() and EndQueue() (which may be
+		// nested), QueueDraw() records a draw with the current transform
+		// instead of making it. The recorded draws are made, in the order
+		// RenderQueue puts them in and without setting the render state,
+		// material or transform again when it's the same as the last draw's,
+		// at the outermost EndQueue(), or as soon as anything else is drawn
+		// or the lights, projection, viewport, depth range or target change,
+		// so that what's drawn around them stays in the right order.
+		// Whatever a queued draw uses (the material's textures and
+		// parameters too) must be left as it is until then.
+		// Outside of BeginQueue() and EndQueue(), QueueDraw() draws at once.
+		void BeginQueue() { ++m_queueDepth; }
+		void EndQueue();
+		bool QueueDraw(VertexBuffer *, IndexBuffer *, RenderState *, Material *, PrimitiveType = TRIANGLES);
+		bool QueueDrawInstanced(VertexBuffer *, IndexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType = TRIANGLES);
+		void FlushQueue();
+
 		//creates a unique material based on the descriptor. It will not be deleted automatically.
 		virtual Material *CreateMaterial(const MaterialDescriptor &descriptor) = 0;
 		virtual Texture *CreateTexture(const TextureDescriptor &descriptor) = 0;
@@ -221,8 +239,22 @@ namespace Graphics {
 		virtual void PushState() = 0;
 		virtual void PopState() = 0;
 
+		// backends call this before anything that queued draws have to be
+		// made before (see QueueDraw())
+		void QueueBarrier()
+		{
+			if (!m_queue.Empty()) FlushQueue();
+		}
+		// make one queued draw, with its transform already set. the
+		// material needs applying unless it's the same as the last draw's,
+		// and the transform uniforms need setting if either changed
+		virtual void SubmitPacket(const DrawPacket &packet, bool applyMaterial, bool setTransform) = 0;
+
 	private:
 		TextureCacheMap m_textureCache;
+
+		RenderQueue m_queue;
+		int m_queueDepth = 0;
 	};
 
 } // namespace Graphics
@@ -17,6 +17,8 @@ namespace Graphics {
 			GetOrCreateCounter("DrawBuffer Calls"),
 			GetOrCreateCounter("DrawTriangles Calls"),
 			GetOrCreateCounter("DrawPointSprites Calls"),
+			GetOrCreateCounter("Queued Draw Calls"),
+			GetOrCreateCounter("Material Applies Saved"),
 
 			GetOrCreateCounter("Buffers Created"),
 			GetOrCreateCounter("Buffers Destroyed"),
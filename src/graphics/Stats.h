@@ -24,6 +24,8 @@ namespace Graphics {
 			STAT_DRAWCALL = 0,
 			STAT_DRAWTRIS,
 			STAT_DRAWPOINTSPRITES,
+			STAT_QUEUED_DRAWCALL,
+			STAT_MATERIAL_APPLIES_SAVED,
 
 			// buffers
 			STAT_CREATE_BUFFER,
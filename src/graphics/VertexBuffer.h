@@ -139,6 +139,12 @@ namespace Graphics {
 		virtual ~InstanceBuffer();
 		virtual matrix4x4f *Map(BufferMapMode) = 0;
 
+		// per-instance pattern colours for materials that use patterns:
+		// primary, secondary and trim for each of count instances, with the
+		// primary colour's alpha 255 for a smooth pattern (see
+		// SceneGraph::ColorMap)
+		virtual void SetPatternColors(const Color *colors, Uint32 count) = 0;
+
 		Uint32 GetInstanceCount() const { return m_instanceCount; }
 		void SetInstanceCount(const Uint32);
 		BufferUsage GetUsage() const { return m_usage; }
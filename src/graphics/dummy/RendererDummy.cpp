@@ -15,4 +15,47 @@ namespace Graphics {
 		Graphics::RegisterRenderer(Graphics::RENDERER_DUMMY, CreateRenderer);
 	}
 
+	bool RendererDummy::SetRenderState(RenderState *rs)
+	{
+		if (m_activeRenderState != rs) {
+			Record(Command::SET_RENDER_STATE, rs);
+			m_activeRenderState = rs;
+		}
+		return true;
+	}
+
+	bool RendererDummy::Draw(const void *what, RenderState *rs, Material *m)
+	{
+		QueueBarrier();
+		SetRenderState(rs);
+		Record(Command::APPLY_MATERIAL, m);
+		Record(Command::SET_TRANSFORM, m);
+		Record(Command::DRAW, what);
+		return true;
+	}
+
+	void RendererDummy::SubmitPacket(const DrawPacket &packet, bool applyMaterial, bool setTransform)
+	{
+		if (applyMaterial)
+			Record(Command::APPLY_MATERIAL, packet.material);
+		if (setTransform)
+			Record(Command::SET_TRANSFORM, packet.material);
+		Record(Command::DRAW, packet.vertexBuffer);
+	}
+
+	void RendererDummy::Record(Command::Type type, const void *object)
+	{
+		if (m_recording)
+			m_commands.push_back({ type, object });
+	}
+
+	size_t RendererDummy::CountCommands(Command::Type type) const
+	{
+		size_t count = 0;
+		for (const Command &c : m_commands)
+			if (c.type == type)
+				count++;
+		return count;
+	}
+
 } // namespace Graphics
@@ -31,44 +31,53 @@ namespace Graphics {
 		virtual bool GetNearFarRange(float &near_, float &far_) const override final { return true; }
 
 		virtual bool BeginFrame() override final { return true; }
-		virtual bool EndFrame() override final { return true; }
+		virtual bool EndFrame() override final
+		{
+			QueueBarrier();
+			return true;
+		}
 		virtual bool SwapBuffers() override final { return true; }
 
-		virtual bool SetRenderState(RenderState *) override final { return true; }
-		virtual bool SetRenderTarget(RenderTarget *) override final { return true; }
+		virtual bool SetRenderState(RenderState *) override final;
+		virtual bool SetRenderTarget(RenderTarget *) override final { return Barrier(); }
 
-		virtual bool SetDepthRange(double znear, double zfar) override final { return true; }
-		virtual bool ResetDepthRange() override final { return true; }
+		virtual bool SetDepthRange(double znear, double zfar) override final { return Barrier(); }
+		virtual bool ResetDepthRange() override final { return Barrier(); }
 
-		virtual bool ClearScreen() override final { return true; }
-		virtual bool ClearDepthBuffer() override final { return true; }
+		virtual bool ClearScreen() override final { return ClearDepthBuffer(); }
+		virtual bool ClearDepthBuffer() override final
+		{
+			QueueBarrier();
+			m_activeRenderState = nullptr;
+			return true;
+		}
 		virtual bool SetClearColor(const Color &c) override final { return true; }
 
-		virtual bool SetViewport(Viewport v) override final { return true; }
+		virtual bool SetViewport(Viewport v) override final { return Barrier(); }
 		virtual Viewport GetViewport() const override final { return {}; }
 
 		virtual bool SetTransform(const matrix4x4f &m) override final { return true; }
 		virtual matrix4x4f GetTransform() const override final { return matrix4x4f::Identity(); }
-		virtual bool SetPerspectiveProjection(float fov, float aspect, float near_, float far_) override final { return true; }
-		virtual bool SetOrthographicProjection(float xmin, float xmax, float ymin, float ymax, float zmin, float zmax) override final { return true; }
-		virtual bool SetProjection(const matrix4x4f &m) override final { return true; }
+		virtual bool SetPerspectiveProjection(float fov, float aspect, float near_, float far_) override final { return Barrier(); }
+		virtual bool SetOrthographicProjection(float xmin, float xmax, float ymin, float ymax, float zmin, float zmax) override final { return Barrier(); }
+		virtual bool SetProjection(const matrix4x4f &m) override final { return Barrier(); }
 		virtual matrix4x4f GetProjection() const override final { return matrix4x4f::Identity(); }
 
-		virtual bool SetWireFrameMode(bool enabled) override final { return true; }
+		virtual bool SetWireFrameMode(bool enabled) override final { return Barrier(); }
 
-		virtual bool SetLights(Uint32 numlights, const Light *l) override final { return true; }
+		virtual bool SetLights(Uint32 numlights, const Light *l) override final { return Barrier(); }
 		virtual Uint32 GetNumLights() const override final { return 1; }
-		virtual bool SetAmbientColor(const Color &c) override final { return true; }
+		virtual bool SetAmbientColor(const Color &c) override final { return Barrier(); }
 
-		virtual bool SetScissor(bool enabled, const vector2f &pos = vector2f(0.0f), const vector2f &size = vector2f(0.0f)) override final { return true; }
+		virtual bool SetScissor(bool enabled, const vector2f &pos = vector2f(0.0f), const vector2f &size = vector2f(0.0f)) override final { return Barrier(); }
 
-		virtual bool DrawTriangles(const VertexArray *vertices, RenderState *state, Material *material, PrimitiveType type = TRIANGLES) override final { return true; }
-		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, RenderState *rs, Material *material, float size) override final { return true; }
-		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, const vector2f *offsets, const float *sizes, RenderState *rs, Material *material) override final { return true; }
-		virtual bool DrawBuffer(VertexBuffer *, RenderState *, Material *, PrimitiveType) override final { return true; }
-		virtual bool DrawBufferIndexed(VertexBuffer *, IndexBuffer *, RenderState *, Material *, PrimitiveType) override final { return true; }
-		virtual bool DrawBufferInstanced(VertexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType type = TRIANGLES) override final { return true; }
-		virtual bool DrawBufferIndexedInstanced(VertexBuffer *, IndexBuffer *, RenderState *, Material *, InstanceBuffer *, PrimitiveType = TRIANGLES) override final { return true; }
+		virtual bool DrawTriangles(const VertexArray *vertices, RenderState *state, Material *material, PrimitiveType type = TRIANGLES) override final { return Draw(vertices, state, material); }
+		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, RenderState *rs, Material *material, float size) override final { return Draw(positions, rs, material); }
+		virtual bool DrawPointSprites(const Uint32 count, const vector3f *positions, const vector2f *offsets, const float *sizes, RenderState *rs, Material *material) override final { return Draw(positions, rs, material); }
+		virtual bool DrawBuffer(VertexBuffer *vb, RenderState *rs, Material *m, PrimitiveType) override final { return Draw(vb, rs, m); }
+		virtual bool DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *, RenderState *rs, Material *m, PrimitiveType) override final { return Draw(vb, rs, m); }
+		virtual bool DrawBufferInstanced(VertexBuffer *vb, RenderState *rs, Material *m, InstanceBuffer *, PrimitiveType type = TRIANGLES) override final { return Draw(vb, rs, m); }
+		virtual bool DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *, RenderState *rs, Material *m, InstanceBuffer *, PrimitiveType = TRIANGLES) override final { return Draw(vb, rs, m); }
 
 		virtual Material *CreateMaterial(const MaterialDescriptor &d) override final { return new Graphics::Dummy::Material(); }
 		virtual Texture *CreateTexture(const TextureDescriptor &d) override final { return new Graphics::TextureDummy(d); }
@@ -78,14 +87,47 @@ namespace Graphics {
 		virtual IndexBuffer *CreateIndexBuffer(Uint32 size, BufferUsage bu) override final { return new Graphics::Dummy::IndexBuffer(size, bu); }
 		virtual InstanceBuffer *CreateInstanceBuffer(Uint32 size, BufferUsage bu) override final { return new Graphics::Dummy::InstanceBuffer(size, bu); }
 
-		virtual bool ReloadShaders() override final { return true; }
+		virtual bool ReloadShaders() override final { return Barrier(); }
+
+		// What a renderer would send to the GPU: render state changes,
+		// material applies, transform uniform updates and draws, in order.
+		// Only kept while recording, for checking the draw order and what the
+		// render queue saves without a window.
+		struct Command {
+			enum Type {
+				SET_RENDER_STATE,
+				APPLY_MATERIAL,
+				SET_TRANSFORM,
+				DRAW
+			};
+			Type type;
+			const void *object; // the render state, material, or what's drawn
+		};
+
+		void SetRecording(bool recording) { m_recording = recording; }
+		const std::vector<Command> &GetCommands() const { return m_commands; }
+		void ClearCommands() { m_commands.clear(); }
+		size_t CountCommands(Command::Type type) const;
 
 	protected:
 		virtual void PushState() override final {}
 		virtual void PopState() override final {}
+		virtual void SubmitPacket(const DrawPacket &packet, bool applyMaterial, bool setTransform) override final;
 
 	private:
+		bool Barrier()
+		{
+			QueueBarrier();
+			return true;
+		}
+		// an immediate draw: everything is set again, as RendererOGL does
+		bool Draw(const void *what, RenderState *rs, Material *m);
+		void Record(Command::Type type, const void *object);
+
 		const matrix4x4f m_identity;
+		RenderState *m_activeRenderState = nullptr;
+		bool m_recording = false;
+		std::vector<Command> m_commands;
 	};
 
 } // namespace Graphics
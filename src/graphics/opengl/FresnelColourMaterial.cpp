@@ -32,8 +32,6 @@ namespace Graphics {
 		void FresnelColourMaterial::Apply()
 		{
 			OGL::Material::Apply();
-			FresnelColourProgram *p = static_cast<FresnelColourProgram *>(m_program);
-			p->diffuse.Set(this->diffuse);
 		}
 
 	} // namespace OGL
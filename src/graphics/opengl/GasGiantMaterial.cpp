@@ -32,13 +32,6 @@ namespace Graphics {
 			geosphereCenter.Init("geosphereCenter", m_program);
 			geosphereRadius.Init("geosphereRadius", m_program);
 			geosphereInvRadius.Init("geosphereInvRadius", m_program);
-
-			shadowCentreX.Init("shadowCentreX", m_program);
-			shadowCentreY.Init("shadowCentreY", m_program);
-			shadowCentreZ.Init("shadowCentreZ", m_program);
-			srad.Init("srad", m_program);
-			lrad.Init("lrad", m_program);
-			sdivlrad.Init("sdivlrad", m_program);
 		}
 
 		// GasGiantSurfaceMaterial -----------------------------------
@@ -91,8 +84,6 @@ namespace Graphics {
 			const GeoSphere::MaterialParameters params = *static_cast<GeoSphere::MaterialParameters *>(this->specialParameter0);
 			const AtmosphereParameters ap = params.atmosphere;
 
-			p->emission.Set(this->emissive);
-			p->sceneAmbient.Set(m_renderer->GetAmbientColor());
 			p->atmosColor.Set(ap.atmosCol);
 			p->geosphereAtmosFogDensity.Set(ap.atmosDensity);
 			p->geosphereAtmosInvScaleHeight.Set(ap.atmosInvScaleHeight);
@@ -101,43 +92,26 @@ namespace Graphics {
 			p->geosphereRadius.Set(ap.planetRadius);
 			p->geosphereInvRadius.Set(1.0f / ap.planetRadius);
 
-			//Light uniform parameters
-			for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++) {
-				const Light &Light = m_renderer->GetLight(i);
-				p->lights[i].diffuse.Set(Light.GetDiffuse());
-				p->lights[i].specular.Set(Light.GetSpecular());
-				const vector3f &pos = Light.GetPosition();
-				p->lights[i].position.Set(pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-			}
-
-			p->diffuse.Set(this->diffuse);
 			p->texture0.Set(this->texture0, 0);
 
 			// we handle up to three shadows at a time
-			vector3f shadowCentreX;
-			vector3f shadowCentreY;
-			vector3f shadowCentreZ;
-			vector3f srad;
-			vector3f lrad;
-			vector3f sdivlrad;
+			EclipseBlock eclipse = {};
 			std::vector<Camera::Shadow>::const_iterator it = params.shadows.begin(), itEnd = params.shadows.end();
 			int j = 0;
 			while (j < 3 && it != itEnd) {
-				shadowCentreX[j] = it->centre[0];
-				shadowCentreY[j] = it->centre[1];
-				shadowCentreZ[j] = it->centre[2];
-				srad[j] = it->srad;
-				lrad[j] = it->lrad;
-				sdivlrad[j] = it->srad / it->lrad;
+				eclipse.shadowCentreX[j] = it->centre[0];
+				eclipse.shadowCentreY[j] = it->centre[1];
+				eclipse.shadowCentreZ[j] = it->centre[2];
+				eclipse.srad[j] = it->srad;
+				eclipse.lrad[j] = it->lrad;
+				eclipse.sdivlrad[j] = it->srad / it->lrad;
 				++it;
 				++j;
 			}
-			p->shadowCentreX.Set(shadowCentreX);
-			p->shadowCentreY.Set(shadowCentreY);
-			p->shadowCentreZ.Set(shadowCentreZ);
-			p->srad.Set(srad);
-			p->lrad.Set(lrad);
-			p->sdivlrad.Set(sdivlrad);
+			if (!m_eclipseBuffer)
+				m_eclipseBuffer.reset(new UniformBuffer(sizeof(EclipseBlock)));
+			m_eclipseBuffer->Update(&eclipse);
+			m_eclipseBuffer->Bind(UNIFORM_BLOCK_ECLIPSE);
 		}
 
 		void GasGiantSurfaceMaterial::SwitchShadowVariant()
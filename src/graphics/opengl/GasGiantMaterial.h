@@ -24,13 +24,6 @@ namespace Graphics {
 			Uniform geosphereRadius; // planet radius
 			Uniform geosphereInvRadius; // 1.0 / (planet radius)
 
-			Uniform shadowCentreX;
-			Uniform shadowCentreY;
-			Uniform shadowCentreZ;
-			Uniform srad;
-			Uniform lrad;
-			Uniform sdivlrad;
-
 		protected:
 			virtual void InitUniforms();
 		};
@@ -49,6 +42,7 @@ namespace Graphics {
 			void SwitchShadowVariant();
 			Program *m_programs[4]; // 0 to 3 shadows
 			Uint32 m_curNumShadows;
+			std::unique_ptr<UniformBuffer> m_eclipseBuffer;
 		};
 	} // namespace OGL
 } // namespace Graphics
@@ -105,17 +105,6 @@ namespace Graphics {
 			p->frequency.Set(params.frequency);
 			p->hueAdjust.Set(params.hueAdjust);
 
-			//Light uniform parameters
-			for (Uint32 i = 0; i < m_renderer->GetNumLights(); i++) {
-				const Light &Light = m_renderer->GetLight(i);
-				p->lights[i].diffuse.Set(Light.GetDiffuse());
-				p->lights[i].specular.Set(Light.GetSpecular());
-				const vector3f &pos = Light.GetPosition();
-				p->lights[i].position.Set(pos.x, pos.y, pos.z, (Light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f));
-			}
-
-			p->diffuse.Set(this->diffuse);
-
 			if (this->texture2) {
 				p->texture2.Set(this->texture2, 2);
 			}
@@ -27,13 +27,6 @@ namespace Graphics {
 			Uniform detailScaleHi;
 			Uniform detailScaleLo;
 
-			Uniform shadowCentreX;
-			Uniform shadowCentreY;
-			Uniform shadowCentreZ;
-			Uniform srad;
-			Uniform lrad;
-			Uniform sdivlrad;
-
 		protected:
 			virtual void InitUniforms();
 		};
@@ -53,6 +46,7 @@ namespace Graphics {
 			void SwitchShadowVariant();
 			Program *m_programs[4]; // 0 to 3 shadows
 			Uint32 m_curNumShadows;
+			std::unique_ptr<UniformBuffer> m_eclipseBuffer;
 		};
 
 		class GeoSphereSkyMaterial : public GeoSphereSurfaceMaterial {
@@ -12,6 +12,7 @@ namespace Graphics {
 		{
 			m_program->Use();
 			m_program->invLogZfarPlus1.Set(m_renderer->m_invLogZfarPlus1);
+			ApplyMaterialBlock();
 		}
 
 		void Material::Unapply()
@@ -23,6 +24,31 @@ namespace Graphics {
 			return m_program->Loaded();
 		}
 
+		Uint32 Material::GetProgramKey() const
+		{
+			return m_program ? m_program->GetProgramID() : 0;
+		}
+
+		void Material::GetMaterialBlock(MaterialBlock &block) const
+		{
+			UniformBuffer::Fill(block.emission, emissive);
+			UniformBuffer::Fill(block.ambient, Color::BLANK); // unused
+			UniformBuffer::Fill(block.diffuse, diffuse);
+			UniformBuffer::Fill(block.specular, specular);
+			block.shininess = float(shininess);
+			block.padding[0] = block.padding[1] = block.padding[2] = 0.f;
+		}
+
+		void Material::ApplyMaterialBlock()
+		{
+			MaterialBlock block;
+			GetMaterialBlock(block);
+			if (!m_materialBuffer)
+				m_materialBuffer.reset(new UniformBuffer(sizeof(MaterialBlock)));
+			m_materialBuffer->Update(&block);
+			m_materialBuffer->Bind(UNIFORM_BLOCK_MATERIAL);
+		}
+
 		void Material::SetCommonUniforms(const matrix4x4f &mv, const matrix4x4f &proj)
 		{
 			const matrix4x4f ViewProjection = proj * mv;
@@ -13,7 +13,9 @@
  * Programs are owned by the renderer, since they are shared between materials.
  */
 #include "OpenGLLibs.h"
+#include "UniformBuffer.h"
 #include "graphics/Material.h"
+#include <memory>
 
 namespace Graphics {
 
@@ -34,11 +36,18 @@ namespace Graphics {
 			virtual bool IsProgramLoaded() const override final;
 			virtual void SetProgram(Program *p) { m_program = p; }
 			virtual void SetCommonUniforms(const matrix4x4f &mv, const matrix4x4f &proj) override;
+			virtual Uint32 GetProgramKey() const override;
 
 		protected:
 			friend class Graphics::RendererOGL;
+			// the MaterialData block, from the standard parameters
+			virtual void GetMaterialBlock(MaterialBlock &block) const;
+			// upload the MaterialData block if it changed, and bind it
+			void ApplyMaterialBlock();
+
 			Program *m_program;
 			RendererOGL *m_renderer;
+			std::unique_ptr<UniformBuffer> m_materialBuffer;
 		};
 	} // namespace OGL
 } // namespace Graphics
@@ -5,6 +5,7 @@
 #include "FileSystem.h"
 #include "StringF.h"
 #include "StringRange.h"
+#include "UniformBuffer.h"
 #include "graphics/Graphics.h"
 #include "utils.h"
 
@@ -75,6 +76,14 @@ namespace Graphics {
 			return true;
 		}
 
+		// a block the program doesn't use has been optimised away
+		static void BindUniformBlock(GLuint program, const char *name, UniformBlockBinding binding)
+		{
+			const GLuint index = glGetUniformBlockIndex(program, name);
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, index, binding);
+		}
+
 		struct Shader {
 			Shader(GLenum type, const std::string &filename, const std::string &defines)
 			{
@@ -265,7 +274,10 @@ namespace Graphics {
 			glBindAttribLocation(m_program, 5, "a_tangent");
 			glBindAttribLocation(m_program, 6, "a_transform");
 			// a_transform @ 6 shadows (uses) 7, 8, and 9
-			// next available is layout (location = 10)
+			glBindAttribLocation(m_program, 10, "a_patternColor0");
+			glBindAttribLocation(m_program, 11, "a_patternColor1");
+			glBindAttribLocation(m_program, 12, "a_patternColor2");
+			// next available is layout (location = 13)
 
 			glBindFragDataLocation(m_program, 0, "frag_color");
 
@@ -286,21 +298,12 @@ namespace Graphics {
 			uViewProjectionMatrix.Init("uViewProjectionMatrix", m_program);
 			uNormalMatrix.Init("uNormalMatrix", m_program);
 
-			//Light uniform parameters
-			char cLight[64];
-			for (int i = 0; i < 4; i++) {
-				snprintf(cLight, 64, "uLight[%d]", i);
-				const std::string strLight(cLight);
-				lights[i].diffuse.Init((strLight + ".diffuse").c_str(), m_program);
-				lights[i].specular.Init((strLight + ".specular").c_str(), m_program);
-				lights[i].position.Init((strLight + ".position").c_str(), m_program);
-			}
+			//Uniform blocks, filled by UniformBuffers bound to these points
+			BindUniformBlock(m_program, "LightData", UNIFORM_BLOCK_LIGHTS);
+			BindUniformBlock(m_program, "MaterialData", UNIFORM_BLOCK_MATERIAL);
+			BindUniformBlock(m_program, "EclipseData", UNIFORM_BLOCK_ECLIPSE);
 
 			invLogZfarPlus1.Init("invLogZfarPlus1", m_program);
-			diffuse.Init("material.diffuse", m_program);
-			emission.Init("material.emission", m_program);
-			specular.Init("material.specular", m_program);
-			shininess.Init("material.shininess", m_program);
 			texture0.Init("texture0", m_program);
 			texture1.Init("texture1", m_program);
 			texture2.Init("texture2", m_program);
@@ -312,7 +315,6 @@ namespace Graphics {
 			heatingMatrix.Init("heatingMatrix", m_program);
 			heatingNormal.Init("heatingNormal", m_program);
 			heatingAmount.Init("heatingAmount", m_program);
-			sceneAmbient.Init("scene.ambient", m_program);
 		}
 
 	} // namespace OGL
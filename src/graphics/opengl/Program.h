@@ -29,6 +29,7 @@ namespace Graphics {
 			virtual void Use();
 			virtual void Unuse();
 			bool Loaded() const { return success; }
+			GLuint GetProgramID() const { return m_program; }
 
 			// Uniforms.
 			Uniform uProjectionMatrix;
@@ -38,10 +39,6 @@ namespace Graphics {
 			Uniform uNormalMatrix;
 
 			Uniform invLogZfarPlus1;
-			Uniform diffuse;
-			Uniform emission;
-			Uniform specular;
-			Uniform shininess;
 			Uniform texture0;
 			Uniform texture1;
 			Uniform texture2;
@@ -54,15 +51,8 @@ namespace Graphics {
 			Uniform heatingNormal;
 			Uniform heatingAmount;
 
-			Uniform sceneAmbient;
-
-			//Light uniform parameters
-			struct UniformLight {
-				Uniform diffuse;
-				Uniform specular;
-				Uniform position;
-			};
-			UniformLight lights[4];
+			// lights, material colours and eclipses are uniform blocks,
+			// see UniformBuffer.h
 
 		protected:
 			static GLuint s_curProgram;
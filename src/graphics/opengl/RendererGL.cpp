@@ -9,6 +9,7 @@
 #include "RenderTargetGL.h"
 #include "StringF.h"
 #include "TextureGL.h"
+#include "UniformBuffer.h"
 #include "VertexBufferGL.h"
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
@@ -250,6 +251,9 @@ namespace Graphics {
 		if (!m_windowRenderTarget->CheckStatus())
 			Error("Pioneer window render target is invalid.\n"
 				  "Does your graphics driver support multisample anti-aliasing?");
+
+		m_lightBuffer.reset(new OGL::UniformBuffer(sizeof(OGL::LightBlock)));
+		UpdateLightBlock();
 	}
 
 	RendererOGL::~RendererOGL()
@@ -263,6 +267,7 @@ namespace Graphics {
 			m_windowRenderTarget->Unbind();
 		delete m_windowRenderTarget;
 
+		m_lightBuffer.reset();
 		SDL_GL_DeleteContext(m_glContext);
 	}
 
@@ -429,6 +434,7 @@ namespace Graphics {
 	bool RendererOGL::EndFrame()
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		uint32_t used_tex2d = 0;
 		uint32_t used_texCube = 0;
 		uint32_t used_texArray2d = 0;
@@ -556,6 +562,7 @@ namespace Graphics {
 	bool RendererOGL::SetRenderTarget(RenderTarget *rt)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		if (rt) {
 			if (m_activeRenderTarget)
 				m_activeRenderTarget->Unbind();
@@ -578,6 +585,7 @@ namespace Graphics {
 
 	bool RendererOGL::SetDepthRange(double znear, double zfar)
 	{
+		QueueBarrier();
 		// XXX since we're using reverse-Z, flip the inputs to this function to avoid breaking old code.
 		glDepthRange(1.0 - zfar, 1.0 - znear);
 		return true;
@@ -585,6 +593,7 @@ namespace Graphics {
 
 	bool RendererOGL::ResetDepthRange()
 	{
+		QueueBarrier();
 		if (m_useNVDepthRanged)
 			glDepthRangedNV(-1.0, 1.0);
 		else
@@ -595,6 +604,7 @@ namespace Graphics {
 
 	bool RendererOGL::ClearScreen()
 	{
+		QueueBarrier();
 		m_activeRenderState = nullptr;
 		glEnable(GL_DEPTH_TEST);
 		glDepthMask(GL_TRUE);
@@ -606,6 +616,7 @@ namespace Graphics {
 
 	bool RendererOGL::ClearDepthBuffer()
 	{
+		QueueBarrier();
 		m_activeRenderState = nullptr;
 		glEnable(GL_DEPTH_TEST);
 		glDepthMask(GL_TRUE);
@@ -623,6 +634,7 @@ namespace Graphics {
 
 	bool RendererOGL::SetViewport(Viewport v)
 	{
+		QueueBarrier();
 		m_viewport = v;
 		glViewport(v.x, v.y, v.w, v.h);
 		return true;
@@ -648,6 +660,7 @@ namespace Graphics {
 	bool RendererOGL::SetPerspectiveProjection(float fov, float aspect, float near_, float far_)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 
 		// update values for log-z hack
 		m_invLogZfarPlus1 = 1.0f / (log1p(far_) / log(2.0f));
@@ -668,6 +681,7 @@ namespace Graphics {
 	bool RendererOGL::SetProjection(const matrix4x4f &m)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		m_projectionMat = m;
 		return true;
 	}
@@ -679,12 +693,14 @@ namespace Graphics {
 
 	bool RendererOGL::SetWireFrameMode(bool enabled)
 	{
+		QueueBarrier();
 		glPolygonMode(GL_FRONT_AND_BACK, enabled ? GL_LINE : GL_FILL);
 		return true;
 	}
 
 	bool RendererOGL::SetLights(Uint32 numlights, const Light *lights)
 	{
+		QueueBarrier();
 		numlights = std::min(numlights, TOTAL_NUM_LIGHTS);
 		if (numlights < 1) {
 			m_numLights = 0;
@@ -707,17 +723,41 @@ namespace Graphics {
 			assert(m_numDirLights <= TOTAL_NUM_LIGHTS);
 		}
 
+		UpdateLightBlock();
 		return true;
 	}
 
 	bool RendererOGL::SetAmbientColor(const Color &c)
 	{
+		QueueBarrier();
 		m_ambient = c;
+		UpdateLightBlock();
 		return true;
 	}
 
+	void RendererOGL::UpdateLightBlock()
+	{
+		OGL::LightBlock block;
+		for (Uint32 i = 0; i < TOTAL_NUM_LIGHTS; i++) {
+			const Light &light = m_lights[i];
+			OGL::UniformBuffer::Fill(block.lights[i].diffuse, light.GetDiffuse());
+			OGL::UniformBuffer::Fill(block.lights[i].specular, light.GetSpecular());
+			const vector3f &pos = light.GetPosition();
+			block.lights[i].position[0] = pos.x;
+			block.lights[i].position[1] = pos.y;
+			block.lights[i].position[2] = pos.z;
+			block.lights[i].position[3] = (light.GetType() == Light::LIGHT_DIRECTIONAL ? 0.f : 1.f);
+		}
+		OGL::UniformBuffer::Fill(block.ambient, m_ambient);
+
+		// the block is shared by every program, so stays bound
+		m_lightBuffer->Update(&block);
+		m_lightBuffer->Bind(OGL::UNIFORM_BLOCK_LIGHTS);
+	}
+
 	bool RendererOGL::SetScissor(bool enabled, const vector2f &pos, const vector2f &size)
 	{
+		QueueBarrier();
 		if (enabled) {
 			glScissor(pos.x, pos.y, size.x, size.y);
 			glEnable(GL_SCISSOR_TEST);
@@ -908,6 +948,7 @@ namespace Graphics {
 	bool RendererOGL::DrawBuffer(VertexBuffer *vb, RenderState *state, Material *mat, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		SetRenderState(state);
 		mat->Apply();
 
@@ -926,6 +967,7 @@ namespace Graphics {
 	bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		SetRenderState(state);
 		mat->Apply();
 
@@ -946,6 +988,7 @@ namespace Graphics {
 	bool RendererOGL::DrawBufferInstanced(VertexBuffer *vb, RenderState *state, Material *mat, InstanceBuffer *instb, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		SetRenderState(state);
 		mat->Apply();
 
@@ -966,6 +1009,7 @@ namespace Graphics {
 	bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, InstanceBuffer *instb, PrimitiveType pt)
 	{
 		PROFILE_SCOPED()
+		QueueBarrier();
 		SetRenderState(state);
 		mat->Apply();
 
@@ -985,6 +1029,36 @@ namespace Graphics {
 		return true;
 	}
 
+	void RendererOGL::SubmitPacket(const DrawPacket &packet, bool applyMaterial, bool setTransform)
+	{
+		PROFILE_SCOPED()
+		if (applyMaterial)
+			packet.material->Apply();
+		if (setTransform)
+			SetMaterialShaderTransforms(packet.material);
+
+		VertexBuffer *vb = packet.vertexBuffer;
+		IndexBuffer *ib = packet.indexBuffer;
+		InstanceBuffer *instb = packet.instanceBuffer;
+		vb->Bind();
+		if (ib) ib->Bind();
+		if (instb) instb->Bind();
+		if (ib && instb)
+			glDrawElementsInstanced(packet.primitiveType, ib->GetIndexCount(), GL_UNSIGNED_INT, 0, instb->GetInstanceCount());
+		else if (ib)
+			glDrawElements(packet.primitiveType, ib->GetIndexCount(), GL_UNSIGNED_INT, 0);
+		else if (instb)
+			glDrawArraysInstanced(packet.primitiveType, 0, vb->GetSize(), instb->GetInstanceCount());
+		else
+			glDrawArrays(packet.primitiveType, 0, vb->GetSize());
+		if (instb) instb->Release();
+		if (ib) ib->Release();
+		vb->Release();
+		CheckRenderErrors(__FUNCTION__, __LINE__);
+
+		m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+	}
+
 	Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
 	{
 		PROFILE_SCOPED()
@@ -1064,6 +1138,7 @@ namespace Graphics {
 
 	bool RendererOGL::ReloadShaders()
 	{
+		QueueBarrier();
 		Output("Reloading " SIZET_FMT " programs...\n", m_programs.size());
 		for (ProgramIterator it = m_programs.begin(); it != m_programs.end(); ++it) {
 			it->second->Reload();
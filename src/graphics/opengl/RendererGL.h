@@ -15,6 +15,7 @@
  */
 #include "OpenGLLibs.h"
 #include "graphics/Renderer.h"
+#include <memory>
 #include <stack>
 #include <unordered_map>
 
@@ -39,6 +40,7 @@ namespace Graphics {
 		class FresnelColourMaterial;
 		class ShieldMaterial;
 		class UIMaterial;
+		class UniformBuffer;
 		class BillboardMaterial;
 	} // namespace OGL
 
@@ -119,6 +121,7 @@ namespace Graphics {
 	protected:
 		virtual void PushState() override final;
 		virtual void PopState() override final;
+		virtual void SubmitPacket(const DrawPacket &packet, bool applyMaterial, bool setTransform) override final;
 
 		Uint32 m_numLights;
 		Uint32 m_numDirLights;
@@ -130,6 +133,10 @@ namespace Graphics {
 
 		void SetMaterialShaderTransforms(Material *);
 
+		// upload the lights and ambient colour to the LightData block
+		void UpdateLightBlock();
+		std::unique_ptr<OGL::UniformBuffer> m_lightBuffer;
+
 		matrix4x4f &GetCurrentTransform() { return m_currentTransform; }
 		matrix4x4f m_currentTransform;
 
@@ -32,12 +32,20 @@ namespace Graphics {
 				if (texture0) {
 					m_program->texture0.Set(texture0, 0);
 				}
-				const float em = (float(emissive.r) * 0.003921568627451f);
-				m_program->shininess.Set(fSkyboxFactor * em);
+				ApplyMaterialBlock();
 			}
 
 			// Skybox multiplier
 			float fSkyboxFactor;
+
+		protected:
+			// the shader takes the brightness as shininess
+			virtual void GetMaterialBlock(MaterialBlock &block) const override
+			{
+				Material::GetMaterialBlock(block);
+				const float em = (float(emissive.r) * 0.003921568627451f);
+				block.shininess = fSkyboxFactor * em;
+			}
 		};
 	} // namespace OGL
 } // namespace Graphics
@@ -0,0 +1,65 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "UniformBuffer.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Graphics {
+	namespace OGL {
+
+		GLuint UniformBuffer::s_bound[UNIFORM_BLOCK_COUNT] = {};
+
+		UniformBuffer::UniformBuffer(size_t size) :
+			m_data(size),
+			m_written(false)
+		{
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+			glBufferData(GL_UNIFORM_BUFFER, size, 0, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+
+		UniformBuffer::~UniformBuffer()
+		{
+			for (GLuint &bound : s_bound) {
+				if (bound == m_buffer)
+					bound = 0;
+			}
+			glDeleteBuffers(1, &m_buffer);
+		}
+
+		void UniformBuffer::Update(const void *data)
+		{
+			if (m_written && memcmp(&m_data[0], data, m_data.size()) == 0)
+				return;
+
+			memcpy(&m_data[0], data, m_data.size());
+			m_written = true;
+			glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, m_data.size(), &m_data[0]);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+
+		void UniformBuffer::Bind(UniformBlockBinding binding)
+		{
+			assert(m_written);
+			if (s_bound[binding] == m_buffer)
+				return;
+
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_buffer);
+			s_bound[binding] = m_buffer;
+		}
+
+		void UniformBuffer::Fill(float out[4], const Color &c)
+		{
+			const Color4f c4f = c.ToColor4f();
+			out[0] = c4f.r;
+			out[1] = c4f.g;
+			out[2] = c4f.b;
+			out[3] = c4f.a;
+		}
+
+	} // namespace OGL
+} // namespace Graphics
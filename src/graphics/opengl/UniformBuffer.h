@@ -0,0 +1,87 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _OGL_UNIFORMBUFFER_H
+#define _OGL_UNIFORMBUFFER_H
+/*
+ * Uniform blocks shared between programs. Each block has a fixed binding
+ * point (Program links every program's blocks to them), so a buffer bound
+ * there is seen by any program that uses the block without setting the
+ * uniforms one by one.
+ *
+ * The structs below mirror the std140 layout of the blocks in
+ * attributes.glsl and eclipse.glsl: every vec3/vec4 takes 16 bytes and
+ * structs are padded to 16 bytes.
+ */
+#include "OpenGLLibs.h"
+#include "Color.h"
+#include <vector>
+
+namespace Graphics {
+
+	namespace OGL {
+
+		enum UniformBlockBinding {
+			UNIFORM_BLOCK_LIGHTS = 0, // LightData: per-frame lights and ambient
+			UNIFORM_BLOCK_MATERIAL = 1, // MaterialData: the current material's colours
+			UNIFORM_BLOCK_ECLIPSE = 2, // EclipseData: the current planet's shadows
+			UNIFORM_BLOCK_COUNT
+		};
+
+		struct LightBlock {
+			struct {
+				float diffuse[4];
+				float specular[4];
+				float position[4]; // w is 0 for directional lights
+			} lights[4];
+			float ambient[4];
+		};
+
+		struct MaterialBlock {
+			float emission[4];
+			float ambient[4];
+			float diffuse[4];
+			float specular[4];
+			float shininess;
+			float padding[3];
+		};
+
+		// the shadows of up to three bodies, one per component
+		struct EclipseBlock {
+			float shadowCentreX[4];
+			float shadowCentreY[4];
+			float shadowCentreZ[4];
+			float srad[4];
+			float lrad[4];
+			float sdivlrad[4];
+		};
+
+		static_assert(sizeof(LightBlock) == 208, "LightBlock doesn't match the std140 layout of LightData");
+		static_assert(sizeof(MaterialBlock) == 80, "MaterialBlock doesn't match the std140 layout of MaterialData");
+		static_assert(sizeof(EclipseBlock) == 96, "EclipseBlock doesn't match the std140 layout of EclipseData");
+
+		class UniformBuffer {
+		public:
+			explicit UniformBuffer(size_t size);
+			~UniformBuffer();
+
+			// upload the block, if it isn't what was uploaded last
+			void Update(const void *data);
+			// bind to a block's binding point, unless it's already there
+			void Bind(UniformBlockBinding binding);
+
+			static void Fill(float out[4], const Color &c);
+
+		private:
+			GLuint m_buffer;
+			std::vector<Uint8> m_data; // what the buffer holds
+			bool m_written;
+
+			// what's bound at each binding point, so materials sharing a
+			// block don't rebind it
+			static GLuint s_bound[UNIFORM_BLOCK_COUNT];
+		};
+
+	} // namespace OGL
+} // namespace Graphics
+#endif
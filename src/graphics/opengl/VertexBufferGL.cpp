@@ -465,7 +465,8 @@ namespace Graphics {
 
 		// ------------------------------------------------------------
 		InstanceBuffer::InstanceBuffer(Uint32 size, BufferUsage hint) :
-			Graphics::InstanceBuffer(size, hint)
+			Graphics::InstanceBuffer(size, hint),
+			m_colorBuffer(0)
 		{
 			assert(size > 0);
 
@@ -484,6 +485,8 @@ namespace Graphics {
 		InstanceBuffer::~InstanceBuffer()
 		{
 			glDeleteBuffers(1, &m_buffer);
+			if (m_colorBuffer)
+				glDeleteBuffers(1, &m_colorBuffer);
 		}
 
 		matrix4x4f *InstanceBuffer::Map(BufferMapMode mode)
@@ -522,6 +525,21 @@ namespace Graphics {
 			m_written = true;
 		}
 
+		void InstanceBuffer::SetPatternColors(const Color *colors, Uint32 count)
+		{
+			assert(count <= m_size);
+			const GLsizeiptr dataSize = sizeof(Color) * 3 * m_size;
+			if (!m_colorBuffer) {
+				glGenBuffers(1, &m_colorBuffer);
+				glBindBuffer(GL_ARRAY_BUFFER, m_colorBuffer);
+				glBufferData(GL_ARRAY_BUFFER, dataSize, 0, GL_DYNAMIC_DRAW);
+			} else {
+				glBindBuffer(GL_ARRAY_BUFFER, m_colorBuffer);
+			}
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Color) * 3 * count, colors);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
 		void InstanceBuffer::Bind()
 		{
 			assert(m_written);
@@ -542,6 +560,22 @@ namespace Graphics {
 			glVertexAttribDivisor(INSTOFFS_MAT1, 1);
 			glVertexAttribDivisor(INSTOFFS_MAT2, 1);
 			glVertexAttribDivisor(INSTOFFS_MAT3, 1);
+
+			if (m_colorBuffer) {
+				// three colours per instance, as normalised bytes
+				glBindBuffer(GL_ARRAY_BUFFER, m_colorBuffer);
+				const size_t sizeColor = sizeof(Color);
+				glEnableVertexAttribArray(INSTOFFS_COL0);
+				glVertexAttribPointer(INSTOFFS_COL0, 4, GL_UNSIGNED_BYTE, GL_TRUE, 3 * sizeColor, reinterpret_cast<const GLvoid *>(0));
+				glEnableVertexAttribArray(INSTOFFS_COL1);
+				glVertexAttribPointer(INSTOFFS_COL1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 3 * sizeColor, reinterpret_cast<const GLvoid *>(sizeColor));
+				glEnableVertexAttribArray(INSTOFFS_COL2);
+				glVertexAttribPointer(INSTOFFS_COL2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 3 * sizeColor, reinterpret_cast<const GLvoid *>(2 * sizeColor));
+
+				glVertexAttribDivisor(INSTOFFS_COL0, 1);
+				glVertexAttribDivisor(INSTOFFS_COL1, 1);
+				glVertexAttribDivisor(INSTOFFS_COL2, 1);
+			}
 		}
 
 		void InstanceBuffer::Release()
@@ -551,6 +585,11 @@ namespace Graphics {
 			glDisableVertexAttribArray(INSTOFFS_MAT1);
 			glDisableVertexAttribArray(INSTOFFS_MAT2);
 			glDisableVertexAttribArray(INSTOFFS_MAT3);
+			if (m_colorBuffer) {
+				glDisableVertexAttribArray(INSTOFFS_COL0);
+				glDisableVertexAttribArray(INSTOFFS_COL1);
+				glDisableVertexAttribArray(INSTOFFS_COL2);
+			}
 
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
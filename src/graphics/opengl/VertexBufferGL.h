@@ -69,6 +69,7 @@ namespace Graphics {
 			virtual ~InstanceBuffer() override final;
 			virtual matrix4x4f *Map(BufferMapMode) override final;
 			virtual void Unmap() override final;
+			virtual void SetPatternColors(const Color *colors, Uint32 count) override final;
 
 			virtual void Bind() override final;
 			virtual void Release() override final;
@@ -78,9 +79,13 @@ namespace Graphics {
 				INSTOFFS_MAT0 = 6, // these value must match those of a_transform within data/shaders/opengl/attributes.glsl
 				INSTOFFS_MAT1 = 7,
 				INSTOFFS_MAT2 = 8,
-				INSTOFFS_MAT3 = 9
+				INSTOFFS_MAT3 = 9,
+				INSTOFFS_COL0 = 10, // and a_patternColor0-2
+				INSTOFFS_COL1 = 11,
+				INSTOFFS_COL2 = 12
 			};
 			std::unique_ptr<matrix4x4f[]> m_data;
+			GLuint m_colorBuffer; // 0 until pattern colours are set
 		};
 
 	} // namespace OGL
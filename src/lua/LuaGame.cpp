@@ -101,7 +101,7 @@ static int l_game_savegame_stats(lua_State *l)
 	std::string filename = LuaPull<std::string>(l, 1);
 
 	try {
-		Json rootNode = Game::LoadGameToJson(filename);
+		Json rootNode = Game::LoadGameInfoToJson(filename);
 
 		LuaTable t(l, 0, 3);
 
@@ -266,6 +266,55 @@ static int l_game_save_game(lua_State *l)
 	}
 }
 
+/*
+ * Function: SaveGameAsync
+ *
+ * Save the current game without waiting for it to be written.
+ *
+ * > Game.SaveGameAsync(filename)
+ *
+ * Only a snapshot of the game is taken before this returns. It is then
+ * encoded and written in the background, and either onGameSaved or
+ * onGameSaveFailed is triggered once that's done. The save replaces the
+ * previous file all at once, so an interrupted save never leaves a broken
+ * file behind.
+ *
+ * Parameters:
+ *
+ *   filename - Filename to save to. The file will be placed the 'savefiles'
+ *              directory in the user's game directory.
+ *
+ * Availability:
+ *
+ *   October 2026
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_game_save_game_async(lua_State *l)
+{
+	if (!Pi::game) {
+		return luaL_error(l, "can't save when no game is running");
+	}
+
+	const std::string filename(luaL_checkstring(l, 1));
+	const std::string path = FileSystem::JoinPathBelow(Pi::GetSaveDir(), filename);
+
+	try {
+		Game::SaveGameAsync(filename, Pi::game);
+		return 0;
+	} catch (CannotSaveInHyperspace) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_IN_HYPERSPACE);
+	} catch (CannotSaveDeadPlayer) {
+		return luaL_error(l, "%s", Lang::CANT_SAVE_DEAD_PLAYER);
+	} catch (CouldNotOpenFileException) {
+		const std::string message = stringf(Lang::COULD_NOT_OPEN_FILENAME, formatarg("path", path));
+		lua_pushlstring(l, message.c_str(), message.size());
+		return lua_error(l);
+	}
+}
+
 /*
  * Function: EndGame
  *
@@ -658,6 +707,7 @@ void LuaGame::Register()
 		{ "LoadGame", l_game_load_game },
 		{ "CanLoadGame", l_game_can_load_game },
 		{ "SaveGame", l_game_save_game },
+		{ "SaveGameAsync", l_game_save_game_async },
 		{ "EndGame", l_game_end_game },
 		{ "InHyperspace", l_game_in_hyperspace },
 		{ "SaveGameStats", l_game_savegame_stats },
@@ -23,6 +23,7 @@
 #include "pigui/LuaFlags.h"
 #include "pigui/LuaPiGui.h"
 #include "pigui/PiGui.h"
+#include "pigui/ProjectedBodyGroups.h"
 #include "ship/PlayerShipController.h"
 #include "sound/Sound.h"
 
@@ -1871,6 +1872,9 @@ bool PiGui::first_body_is_more_important_than(Body *body, Body *other)
  *   multiple - true if group consists of more than one body
  *   bodies - array of all <Body> objects in the group, sorted by importance
  *
+ * The same tables are filled in again by the next call, so copy anything
+ * that has to be kept past the current frame.
+ *
  * Availability:
  *
  *   2019-12
@@ -1899,92 +1903,63 @@ static int l_pigui_get_projected_bodies_grouped(lua_State *l)
 		filtered.back()._body = body;
 	}
 
-	struct GroupInfo {
-		Body *m_mainBody;
-		vector2d m_screenCoords; // screen coords of group
-		std::vector<Body *> m_bodies;
-		bool m_hasNavTarget;
-		bool m_hasSetSpeedTarget;
-
-		GroupInfo(Body *b, const vector2d &coords, bool isNavTarget,
-			bool isSetSpeedTarget) :
-			m_mainBody(b),
-			m_screenCoords(coords),
-			m_hasNavTarget(isNavTarget),
-			m_hasSetSpeedTarget(isSetSpeedTarget)
-		{
-			m_bodies.push_back(b);
-		}
-	};
-	std::vector<GroupInfo> groups;
-	groups.reserve(filtered.size());
 	const Body *nav_target = Pi::game->GetPlayer()->GetNavTarget();
 	const Body *combat_target = Pi::game->GetPlayer()->GetCombatTarget();
 	const Body *setspeed_target = Pi::game->GetPlayer()->GetSetSpeedTarget();
 
-	for (PiGui::TScreenSpace &obj : filtered) {
-		bool inserted = false;
-
-		// never collapse combat target
-		if (obj._body != combat_target) {
-			for (GroupInfo &group : groups) {
-				if ((group.m_screenCoords - obj._screenPosition).Length() <= cluster_size) {
-					// body inside group boundaries: insert into group
-					group.m_bodies.push_back(obj._body);
-
-					// make the more important body the new main body;
-					// but nav target is always most important
-					if (obj._body == nav_target) {
-						group.m_hasNavTarget = true;
-						group.m_mainBody = obj._body;
-						group.m_screenCoords = obj._screenPosition;
-					} else if (!group.m_hasNavTarget && PiGui::first_body_is_more_important_than(obj._body, group.m_mainBody)) {
-						group.m_mainBody = obj._body;
-						group.m_screenCoords = obj._screenPosition;
-					}
-					if (obj._body == setspeed_target)
-						group.m_hasSetSpeedTarget = true;
-					inserted = true;
-					break;
-				}
-			}
+	static PiGui::ProjectedBodyGroups s_groups;
+	const std::vector<PiGui::ProjectedBodyGroups::Group> &groups =
+		s_groups.Update(filtered, cluster_size, nav_target, combat_target, setspeed_target);
+
+	// fill in last time's tables, rather than making new ones every frame
+	luaL_getsubtable(l, LUA_REGISTRYINDEX, "PiGuiProjectedBodyGroups");
+	const int result = lua_gettop(l);
+	const int old_count = lua_rawlen(l, result);
+
+	for (size_t i = 0; i < groups.size(); i++) {
+		const PiGui::ProjectedBodyGroups::Group &group = groups[i];
+		lua_rawgeti(l, result, i + 1);
+		if (!lua_istable(l, -1)) {
+			lua_pop(l, 1);
+			lua_createtable(l, 0, 6);
+			lua_pushvalue(l, -1);
+			lua_rawseti(l, result, i + 1);
 		}
-		if (!inserted) {
-			// create new group
-			GroupInfo newgroup(obj._body, obj._screenPosition,
-				obj._body == nav_target ? true : false,
-				obj._body == setspeed_target ? true : false);
-			groups.push_back(std::move(newgroup));
+		const int info = lua_gettop(l);
+
+		LuaPush(l, group.screenCoords);
+		lua_setfield(l, info, "screenCoordinates");
+		LuaPush(l, group.mainBody);
+		lua_setfield(l, info, "mainBody");
+		LuaPush(l, group.bodies.size() > 1);
+		lua_setfield(l, info, "multiple");
+		LuaPush(l, group.hasNavTarget);
+		lua_setfield(l, info, "hasNavTarget");
+		LuaPush(l, group.hasSetSpeedTarget);
+		lua_setfield(l, info, "hasSetSpeedTarget");
+
+		lua_getfield(l, info, "bodies");
+		if (!lua_istable(l, -1)) {
+			lua_pop(l, 1);
+			lua_createtable(l, group.bodies.size(), 0);
+			lua_pushvalue(l, -1);
+			lua_setfield(l, info, "bodies");
 		}
+		const int old_bodies = lua_rawlen(l, -1);
+		for (size_t j = 0; j < group.bodies.size(); j++) {
+			LuaPush(l, group.bodies[j]);
+			lua_rawseti(l, -2, j + 1);
+		}
+		for (int j = group.bodies.size() + 1; j <= old_bodies; j++) {
+			lua_pushnil(l);
+			lua_rawseti(l, -2, j);
+		}
+		lua_pop(l, 2);
 	}
-
-	// Sort each groups bodies according to importance
-	for (GroupInfo &group : groups) {
-		std::sort(begin(group.m_bodies), end(group.m_bodies),
-			[](Body *a, Body *b) {
-				return PiGui::first_body_is_more_important_than(a, b);
-			});
-	}
-
-	LuaTable result(l, groups.size(), 0);
-	int index = 1;
-
-	for (GroupInfo &group : groups) {
-		LuaTable info_table(l, 0, 5);
-		LuaTable bodies_table(l, group.m_bodies.size(), 0);
-
-		info_table.Set("screenCoordinates", group.m_screenCoords);
-		info_table.Set("mainBody", group.m_mainBody);
-		bodies_table.LoadVector(group.m_bodies.begin(), group.m_bodies.end());
-		info_table.Set("bodies", bodies_table);
-		lua_pop(l, 1);
-		info_table.Set("multiple", group.m_bodies.size() > 1 ? true : false);
-		info_table.Set("hasNavTarget", group.m_hasNavTarget);
-		info_table.Set("hasSetSpeedTarget", group.m_hasSetSpeedTarget);
-		result.Set(index++, info_table);
-		lua_pop(l, 1);
+	for (int i = groups.size() + 1; i <= old_count; i++) {
+		lua_pushnil(l);
+		lua_rawseti(l, result, i);
 	}
-	LuaPush(l, result);
 	return 1;
 }
 
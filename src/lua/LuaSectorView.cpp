@@ -110,17 +110,19 @@ void LuaObject<SectorView>::RegisterClass()
 		.AddFunction("AutoRoute", [](lua_State *l, SectorView *sv) {
 			SystemPath current_path = sv->GetCurrent();
 			SystemPath target_path = sv->GetSelected();
-			std::vector<SystemPath> route;
-			const std::string result = sv->AutoRoute(current_path, target_path, route);
-			if (result == "OKAY") {
-				sv->ClearRoute();
-				for (auto it = route.begin(); it != route.end(); it++) {
-					sv->AddToRoute(*it);
-				}
-			}
+			const std::string result = sv->AutoRoute(current_path, target_path);
 			LuaPush<std::string>(l, result);
 			return 1;
 		})
+		.AddFunction("IsAutoRouting", &SectorView::IsAutoRouting)
+		.AddFunction("GetAutoRouteResult", [](lua_State *l, SectorView *sv) {
+			const std::string result = sv->TakeAutoRouteResult();
+			if (result.empty())
+				lua_pushnil(l);
+			else
+				LuaPush<std::string>(l, result);
+			return 1;
+		})
 		.AddFunction("GetRoute", [](lua_State *l, SectorView *sv) {
 			std::vector<SystemPath> route = sv->GetRoute();
 			lua_newtable(l);
@@ -756,6 +756,27 @@ static int l_space_get_body(lua_State *l)
 	return 1;
 }
 
+// call the filter function at stack index idx for the body, true if it
+// should be included
+static bool _filter_body(lua_State *l, int idx, Body *b)
+{
+	lua_pushvalue(l, idx);
+	LuaObject<Body>::PushToLua(b);
+	if (int ret = lua_pcall(l, 1, 1, 0)) {
+		const char *errmsg("Unknown error");
+		if (ret == LUA_ERRRUN)
+			errmsg = lua_tostring(l, -1);
+		else if (ret == LUA_ERRMEM)
+			errmsg = "memory allocation failure";
+		else if (ret == LUA_ERRERR)
+			errmsg = "error in error handler function";
+		luaL_error(l, "Error in filter function: %s", errmsg);
+	}
+	const bool keep = lua_toboolean(l, -1);
+	lua_pop(l, 1);
+	return keep;
+}
+
 /*
  * Function: GetBodies
  *
@@ -810,25 +831,8 @@ static int l_space_get_bodies(lua_State *l)
 	lua_newtable(l);
 
 	for (Body *b : Pi::game->GetSpace()->GetBodies()) {
-		if (filter) {
-			lua_pushvalue(l, 1);
-			LuaObject<Body>::PushToLua(b);
-			if (int ret = lua_pcall(l, 1, 1, 0)) {
-				const char *errmsg("Unknown error");
-				if (ret == LUA_ERRRUN)
-					errmsg = lua_tostring(l, -1);
-				else if (ret == LUA_ERRMEM)
-					errmsg = "memory allocation failure";
-				else if (ret == LUA_ERRERR)
-					errmsg = "error in error handler function";
-				luaL_error(l, "Error in filter function: %s", errmsg);
-			}
-			if (!lua_toboolean(l, -1)) {
-				lua_pop(l, 1);
-				continue;
-			}
-			lua_pop(l, 1);
-		}
+		if (filter && !_filter_body(l, 1, b))
+			continue;
 
 		lua_pushinteger(l, lua_rawlen(l, -1) + 1);
 		LuaObject<Body>::PushToLua(b);
@@ -840,6 +844,134 @@ static int l_space_get_bodies(lua_State *l)
 	return 1;
 }
 
+/*
+ * Function: GetBodiesNear
+ *
+ * Get the <Body> objects within a distance of a body, nearest first
+ *
+ * bodies = Space.GetBodiesNear(body, distance, filter)
+ *
+ * Parameters:
+ *
+ *   body - the <Body> to search around. It is not included in the results
+ *
+ *   distance - the search radius, in metres
+ *
+ *   filter - an optional function, called the same way as for <GetBodies>
+ *
+ * Return:
+ *
+ *   bodies - an array containing zero or more <Body> objects within the
+ *            distance that matched the filter
+ *
+ * Example:
+ *
+ * > -- find the ships within 50km of the player
+ * > local ships = Space.GetBodiesNear(Game.player, 50000, function (body)
+ * >     return body:isa("Ship")
+ * > end)
+ *
+ * Availability:
+ *
+ *   2021
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_get_bodies_near(lua_State *l)
+{
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	Body *body = LuaObject<Body>::CheckFromLua(1);
+	const double dist = luaL_checknumber(l, 2);
+
+	bool filter = false;
+	if (lua_gettop(l) >= 3) {
+		luaL_checktype(l, 3, LUA_TFUNCTION); // any type of function
+		filter = true;
+	}
+
+	Space *space = Pi::game->GetSpace();
+	Space::BodyNearList nearby = space->GetNearestBodies(body, space->GetNumBodies(), dist);
+
+	lua_newtable(l);
+
+	for (Body *b : nearby) {
+		if (filter && !_filter_body(l, 3, b))
+			continue;
+
+		lua_pushinteger(l, lua_rawlen(l, -1) + 1);
+		LuaObject<Body>::PushToLua(b);
+		lua_rawset(l, -3);
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
+/*
+ * Function: GetNearestBodies
+ *
+ * Get the bodies nearest to a body
+ *
+ * bodies = Space.GetNearestBodies(body, count, distance)
+ *
+ * Parameters:
+ *
+ *   body - the <Body> to search around. It is not included in the results
+ *
+ *   count - the maximum number of bodies to return
+ *
+ *   distance - optional, only return bodies within this many metres
+ *
+ * Return:
+ *
+ *   bodies - an array of up to count <Body> objects, nearest first
+ *
+ * Availability:
+ *
+ *   2021
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_space_get_nearest_bodies(lua_State *l)
+{
+	if (!Pi::game) {
+		luaL_error(l, "Game is not started");
+		return 0;
+	}
+
+	LUA_DEBUG_START(l);
+
+	Body *body = LuaObject<Body>::CheckFromLua(1);
+	const int count = luaL_checkinteger(l, 2);
+	const double dist = luaL_optnumber(l, 3, DBL_MAX);
+
+	lua_newtable(l);
+
+	if (count > 0) {
+		Space::BodyNearList nearest = Pi::game->GetSpace()->GetNearestBodies(body, size_t(count), dist);
+		for (Body *b : nearest) {
+			lua_pushinteger(l, lua_rawlen(l, -1) + 1);
+			LuaObject<Body>::PushToLua(b);
+			lua_rawset(l, -3);
+		}
+	}
+
+	LUA_DEBUG_END(l, 1);
+
+	return 1;
+}
+
 static int l_space_dump_frames(lua_State *l)
 {
 	if (!Pi::game) {
@@ -888,6 +1020,8 @@ void LuaSpace::Register()
 
 		{ "GetBody", l_space_get_body },
 		{ "GetBodies", l_space_get_bodies },
+		{ "GetBodiesNear", l_space_get_bodies_near },
+		{ "GetNearestBodies", l_space_get_nearest_bodies },
 
 		{ "DbgDumpFrames", l_space_dump_frames },
 		{ 0, 0 }
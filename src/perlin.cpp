@@ -2,8 +2,15 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "perlin.h"
+#include "perlin_simd.h"
+#include "SDL_cpuinfo.h"
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PERLIN_SSE2
+#include <emmintrin.h>
+#endif
+
 /* Simplex.cpp
  *
  * Copyright 2007 Eliot Eshelman
@@ -59,15 +66,17 @@ inline int fastfloor(const double x) { return int(x > 0 ? x : x - 1); }
 inline double dot(const double *g, const double x, const double y, const double z) { return g[0] * x + g[1] * y + g[2] * z; }
 //static double dot( const int* g, const double x, const double y, const double z, const double w ) { return g[0]*x + g[1]*y + g[2]*z + g[3]*w; }
 
+namespace Perlin {
+
 // The gradients are the midpoints of the vertices of a cube.
-static const double grad3[12][3] = {
+const double grad3[12][3] = {
 	{ 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
 	{ 1, 0, 1 }, { -1, 0, 1 }, { 1, 0, -1 }, { -1, 0, -1 },
 	{ 0, 1, 1 }, { 0, -1, 1 }, { 0, 1, -1 }, { 0, -1, -1 }
 };
 
 // Permutation table.  The same list is repeated twice.
-static const unsigned char perm[512] = {
+const unsigned char perm[512] = {
 	151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142,
 	8, 99, 37, 240, 21, 10, 23, 190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117,
 	35, 11, 32, 57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71,
@@ -95,7 +104,7 @@ static const unsigned char perm[512] = {
 	138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
 };
 
-static const unsigned char mod12[] = {
+const unsigned char mod12[256] = {
 	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
 	11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
 	10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3, 4, 5, 6, 7, 8,
@@ -106,6 +115,12 @@ static const unsigned char mod12[] = {
 	5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3
 };
 
+} // namespace Perlin
+
+using Perlin::grad3;
+using Perlin::mod12;
+using Perlin::perm;
+
 const double F3 = 1.0 / 3.0;
 const double G3 = 1.0 / 6.0; // Very nice and simple unskew factor, too
 const double G3mul2 = 0.3333333333333333;
@@ -248,6 +263,65 @@ double noise(const vector3d &p)
 	return 32.0 * (n0 + n1 + n2 + n3);
 }
 
+#ifdef PERLIN_SSE2
+namespace {
+	struct SSE2Ops {
+		typedef __m128d Type;
+		enum { LANES = 2 };
+		static Type Load(const double *p) { return _mm_loadu_pd(p); }
+		static void Store(double *p, Type v) { _mm_storeu_pd(p, v); }
+		static Type Set(double v) { return _mm_set1_pd(v); }
+		// component i of each lane's vector
+		static Type Gather(const double *const *v, int i) { return _mm_set_pd(v[1][i], v[0][i]); }
+		static Type Add(Type a, Type b) { return _mm_add_pd(a, b); }
+		static Type Sub(Type a, Type b) { return _mm_sub_pd(a, b); }
+		static Type Mul(Type a, Type b) { return _mm_mul_pd(a, b); }
+		static Type LessThanZero(Type a) { return _mm_cmplt_pd(a, _mm_setzero_pd()); }
+		static Type GreaterEqual(Type a, Type b) { return _mm_cmpge_pd(a, b); }
+		static Type True() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+		static Type And(Type a, Type b) { return _mm_and_pd(a, b); }
+		static Type Or(Type a, Type b) { return _mm_or_pd(a, b); }
+		static Type AndNot(Type mask, Type v) { return _mm_andnot_pd(mask, v); }
+		static int MoveMask(Type a) { return _mm_movemask_pd(a); }
+
+		// the lanes' ints, in the low half
+		typedef __m128i IntType;
+		static IntType AddInt(IntType a, IntType b) { return _mm_add_epi32(a, b); }
+		static Type ToDouble(IntType a) { return _mm_cvtepi32_pd(a); }
+		static void StoreInt(int *p, IntType a) { _mm_storel_epi64(reinterpret_cast<__m128i *>(p), a); }
+		// as fastfloor()
+		static IntType FastFloor(Type a)
+		{
+			const Type notPositive = _mm_cmple_pd(a, _mm_setzero_pd());
+			return _mm_cvttpd_epi32(_mm_sub_pd(a, _mm_and_pd(notPositive, _mm_set1_pd(1.0))));
+		}
+	};
+} // namespace
+#endif
+
+static void noise_batch_scalar(const vector3d *p, double *out, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = noise(p[i]);
+}
+
+static Perlin::NoiseBatchFn choose_noise_batch()
+{
+	if (Perlin::noiseBatchAVX && SDL_HasAVX())
+		return Perlin::noiseBatchAVX;
+#ifdef PERLIN_SSE2
+	if (SDL_HasSSE2())
+		return noise_batch<SSE2Ops>;
+#endif
+	return noise_batch_scalar;
+}
+
+void noise(const vector3d *p, double *out, size_t count)
+{
+	static const Perlin::NoiseBatchFn batch = choose_noise_batch();
+	batch(p, out, count);
+}
+
 #ifdef UNIT_TEST
 #include <stdio.h>
 #include <stdlib.h>
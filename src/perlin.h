@@ -5,7 +5,11 @@
 #define _PERLIN_H
 
 #include "vector3.h"
+#include <cstddef>
 
 double noise(const vector3d &p);
+// noise() for each of count points, using the widest vector instructions
+// the CPU has. gives exactly the same values as calling it one at a time
+void noise(const vector3d *p, double *out, size_t count);
 
 #endif /* _PERLIN_H */
@@ -0,0 +1,48 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+// The AVX version of the batched noise(). This file alone is compiled with
+// AVX enabled (see CMakeLists.txt), and perlin.cpp only calls into it once
+// it has checked that the CPU supports it.
+
+#include "perlin_simd.h"
+
+#ifdef __AVX__
+#include <immintrin.h>
+
+namespace {
+	struct AVXOps {
+		typedef __m256d Type;
+		enum { LANES = 4 };
+		static Type Load(const double *p) { return _mm256_loadu_pd(p); }
+		static void Store(double *p, Type v) { _mm256_storeu_pd(p, v); }
+		static Type Set(double v) { return _mm256_set1_pd(v); }
+		static Type Gather(const double *const *v, int i) { return _mm256_set_pd(v[3][i], v[2][i], v[1][i], v[0][i]); }
+		static Type Add(Type a, Type b) { return _mm256_add_pd(a, b); }
+		static Type Sub(Type a, Type b) { return _mm256_sub_pd(a, b); }
+		static Type Mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+		static Type LessThanZero(Type a) { return _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_LT_OQ); }
+		static Type GreaterEqual(Type a, Type b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+		static Type True() { return _mm256_castsi256_pd(_mm256_set1_epi32(-1)); }
+		static Type And(Type a, Type b) { return _mm256_and_pd(a, b); }
+		static Type Or(Type a, Type b) { return _mm256_or_pd(a, b); }
+		static Type AndNot(Type mask, Type v) { return _mm256_andnot_pd(mask, v); }
+		static int MoveMask(Type a) { return _mm256_movemask_pd(a); }
+
+		typedef __m128i IntType;
+		static IntType AddInt(IntType a, IntType b) { return _mm_add_epi32(a, b); }
+		static Type ToDouble(IntType a) { return _mm256_cvtepi32_pd(a); }
+		static void StoreInt(int *p, IntType a) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), a); }
+		// as fastfloor() in perlin.cpp
+		static IntType FastFloor(Type a)
+		{
+			const Type notPositive = _mm256_cmp_pd(a, _mm256_setzero_pd(), _CMP_LE_OQ);
+			return _mm256_cvttpd_epi32(_mm256_sub_pd(a, _mm256_and_pd(notPositive, _mm256_set1_pd(1.0))));
+		}
+	};
+} // namespace
+
+const Perlin::NoiseBatchFn Perlin::noiseBatchAVX = noise_batch<AVXOps>;
+#else
+const Perlin::NoiseBatchFn Perlin::noiseBatchAVX = nullptr;
+#endif
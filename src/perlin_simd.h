@@ -0,0 +1,160 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _PERLIN_SIMD_H
+#define _PERLIN_SIMD_H
+
+// Internal to perlin.cpp and perlin_avx.cpp: the batched noise() evaluated a
+// few points at a time with SSE2 or AVX. Each lane does exactly the same
+// arithmetic as the scalar noise(), in the same order, so the results are
+// identical to it rather than just close.
+
+#include "vector3.h"
+#include <cstddef>
+
+double noise(const vector3d &p);
+
+namespace Perlin {
+	extern const double grad3[12][3];
+	extern const unsigned char perm[512];
+	extern const unsigned char mod12[256];
+
+	typedef void (*NoiseBatchFn)(const vector3d *p, double *out, size_t count);
+
+	// set by perlin_avx.cpp, or null if it wasn't built with AVX
+	extern const NoiseBatchFn noiseBatchAVX;
+} // namespace Perlin
+
+// everything below is compiled separately, with different instruction sets,
+// into each file that includes it, so it must not be shared between them
+namespace {
+
+	const double SIMD_F3 = 1.0 / 3.0;
+	const double SIMD_G3 = 1.0 / 6.0;
+	const double SIMD_G3mul2 = 0.3333333333333333;
+	const double SIMD_G3mul3 = 0.5;
+
+	// the part of noise() that hashes the corners of the simplex, which has
+	// to be done one lane at a time. a, b and c are x0 >= y0, y0 >= z0 and
+	// x0 >= z0, which pick the simplex (as the branches in noise() do)
+	inline void simplex_lane(int i, int j, int k, int a, int b, int c, const double **grad)
+	{
+		const int i1 = a & (b | c);
+		const int j1 = (a ^ 1) & b;
+		const int k1 = (b ^ 1) & ((a ^ 1) | (c ^ 1));
+		const int i2 = a | (b & c);
+		const int j2 = (a ^ 1) | b;
+		const int k2 = (b ^ 1) | ((a ^ 1) & (c ^ 1));
+
+		using Perlin::grad3;
+		using Perlin::mod12;
+		using Perlin::perm;
+		const int ii = i & 255;
+		const int jj = j & 255;
+		const int kk = k & 255;
+		grad[0] = grad3[mod12[perm[ii + perm[jj + perm[kk]]]]];
+		grad[1] = grad3[mod12[perm[ii + i1 + perm[jj + j1 + perm[kk + k1]]]]];
+		grad[2] = grad3[mod12[perm[ii + i2 + perm[jj + j2 + perm[kk + k2]]]]];
+		grad[3] = grad3[mod12[perm[ii + 1 + perm[jj + 1 + perm[kk + 1]]]]];
+	}
+
+	// the contribution of one corner, in every lane
+	template <typename Ops>
+	inline typename Ops::Type simplex_corner(typename Ops::Type x, typename Ops::Type y, typename Ops::Type z,
+		const double *const *grad)
+	{
+		typedef typename Ops::Type T;
+		T t = Ops::Sub(Ops::Sub(Ops::Sub(Ops::Set(0.6), Ops::Mul(x, x)), Ops::Mul(y, y)), Ops::Mul(z, z));
+		const T negative = Ops::LessThanZero(t);
+		t = Ops::Mul(t, t);
+		const T dot = Ops::Add(Ops::Add(Ops::Mul(Ops::Gather(grad, 0), x), Ops::Mul(Ops::Gather(grad, 1), y)), Ops::Mul(Ops::Gather(grad, 2), z));
+		return Ops::AndNot(negative, Ops::Mul(Ops::Mul(t, t), dot));
+	}
+
+	// noise() for Ops::LANES points. Ops wraps the vector type and the few
+	// operations needed on it
+	template <typename Ops>
+	inline void noise_lanes(const vector3d *p, double *out)
+	{
+		typedef typename Ops::Type T;
+		enum { N = Ops::LANES };
+
+		const double *pp[N];
+		for (int l = 0; l < N; l++)
+			pp[l] = &p[l].x;
+		const T x = Ops::Gather(pp, 0), y = Ops::Gather(pp, 1), z = Ops::Gather(pp, 2);
+
+		// skew to find the cell, unskew its origin
+		const T s = Ops::Mul(Ops::Add(Ops::Add(x, y), z), Ops::Set(SIMD_F3));
+		const typename Ops::IntType i = Ops::FastFloor(Ops::Add(x, s));
+		const typename Ops::IntType j = Ops::FastFloor(Ops::Add(y, s));
+		const typename Ops::IntType k = Ops::FastFloor(Ops::Add(z, s));
+		const T t = Ops::Mul(Ops::ToDouble(Ops::AddInt(Ops::AddInt(i, j), k)), Ops::Set(SIMD_G3));
+		const T x0 = Ops::Sub(x, Ops::Sub(Ops::ToDouble(i), t));
+		const T y0 = Ops::Sub(y, Ops::Sub(Ops::ToDouble(j), t));
+		const T z0 = Ops::Sub(z, Ops::Sub(Ops::ToDouble(k), t));
+
+		// which simplex, and the gradients at its corners
+		const T a = Ops::GreaterEqual(x0, y0);
+		const T b = Ops::GreaterEqual(y0, z0);
+		const T c = Ops::GreaterEqual(x0, z0);
+		const int am = Ops::MoveMask(a), bm = Ops::MoveMask(b), cm = Ops::MoveMask(c);
+		int ci[N], cj[N], ck[N];
+		Ops::StoreInt(ci, i);
+		Ops::StoreInt(cj, j);
+		Ops::StoreInt(ck, k);
+		const double *grad[4][N];
+		for (int l = 0; l < N; l++) {
+			const double *g[4];
+			simplex_lane(ci[l], cj[l], ck[l], (am >> l) & 1, (bm >> l) & 1, (cm >> l) & 1, g);
+			for (int n = 0; n < 4; n++)
+				grad[n][l] = g[n];
+		}
+
+		// the corner offsets, as in simplex_lane
+		const T na = Ops::AndNot(a, Ops::True()), nb = Ops::AndNot(b, Ops::True()), nc = Ops::AndNot(c, Ops::True());
+		const T one = Ops::Set(1.0);
+		const T i1 = Ops::And(Ops::And(a, Ops::Or(b, c)), one);
+		const T j1 = Ops::And(Ops::And(na, b), one);
+		const T k1 = Ops::And(Ops::And(nb, Ops::Or(na, nc)), one);
+		const T i2 = Ops::And(Ops::Or(a, Ops::And(b, c)), one);
+		const T j2 = Ops::And(Ops::Or(na, b), one);
+		const T k2 = Ops::And(Ops::Or(nb, Ops::And(na, nc)), one);
+
+		const T G3 = Ops::Set(SIMD_G3);
+		const T G3mul2 = Ops::Set(SIMD_G3mul2);
+		const T G3mul3 = Ops::Set(SIMD_G3mul3);
+		const T x1 = Ops::Add(Ops::Sub(x0, i1), G3);
+		const T y1 = Ops::Add(Ops::Sub(y0, j1), G3);
+		const T z1 = Ops::Add(Ops::Sub(z0, k1), G3);
+		const T x2 = Ops::Add(Ops::Sub(x0, i2), G3mul2);
+		const T y2 = Ops::Add(Ops::Sub(y0, j2), G3mul2);
+		const T z2 = Ops::Add(Ops::Sub(z0, k2), G3mul2);
+		const T x3 = Ops::Add(Ops::Sub(x0, one), G3mul3);
+		const T y3 = Ops::Add(Ops::Sub(y0, one), G3mul3);
+		const T z3 = Ops::Add(Ops::Sub(z0, one), G3mul3);
+
+		const T n0 = simplex_corner<Ops>(x0, y0, z0, grad[0]);
+		const T n1 = simplex_corner<Ops>(x1, y1, z1, grad[1]);
+		const T n2 = simplex_corner<Ops>(x2, y2, z2, grad[2]);
+		const T n3 = simplex_corner<Ops>(x3, y3, z3, grad[3]);
+
+		double result[N];
+		Ops::Store(result, Ops::Mul(Ops::Set(32.0), Ops::Add(Ops::Add(Ops::Add(n0, n1), n2), n3)));
+		for (int l = 0; l < N; l++)
+			out[l] = result[l];
+	}
+
+	template <typename Ops>
+	void noise_batch(const vector3d *p, double *out, size_t count)
+	{
+		size_t i = 0;
+		for (; i + Ops::LANES <= count; i += Ops::LANES)
+			noise_lanes<Ops>(p + i, out + i);
+		for (; i < count; i++)
+			out[i] = noise(p[i]);
+	}
+
+} // namespace
+
+#endif /* _PERLIN_SIMD_H */
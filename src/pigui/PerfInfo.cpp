@@ -4,16 +4,20 @@
 #include "PerfInfo.h"
 #include "Frame.h"
 #include "Game.h"
+#include "GeoPatchContext.h"
+#include "GeoPatchDiskCache.h"
 #include "LuaPiGui.h"
 #include "Pi.h"
 #include "Player.h"
 #include "Space.h"
+#include "galaxy/Galaxy.h"
 #include "graphics/Renderer.h"
 #include "graphics/Stats.h"
 #include "graphics/Texture.h"
 #include "lua/Lua.h"
 #include "lua/LuaManager.h"
 #include "scenegraph/Model.h"
+#include "terrain/TerrainHeightCache.h"
 #include "text/TextureFont.h"
 
 #include <imgui/imgui.h>
@@ -216,6 +220,21 @@ void PerfInfo::DrawPerfWindow()
 				ImGui::EndTabItem();
 			}
 
+			if (ImGui::BeginTabItem("Jobs")) {
+				DrawJobStats();
+				ImGui::EndTabItem();
+			}
+
+			if (Pi::game && ImGui::BeginTabItem("Galaxy")) {
+				DrawGalaxyStats();
+				ImGui::EndTabItem();
+			}
+
+			if (ImGui::BeginTabItem("Terrain")) {
+				DrawTerrainStats();
+				ImGui::EndTabItem();
+			}
+
 			if (false && ImGui::BeginTabItem("Input")) {
 				DrawInputDebug();
 				ImGui::EndTabItem();
@@ -247,6 +266,8 @@ void PerfInfo::DrawRendererStats()
 	const Uint32 numBuffersInUse = stats.m_stats[Graphics::Stats::STAT_BUFFER_INUSE];
 	const Uint32 numDrawTris = stats.m_stats[Graphics::Stats::STAT_DRAWTRIS];
 	const Uint32 numDrawPointSprites = stats.m_stats[Graphics::Stats::STAT_DRAWPOINTSPRITES];
+	const Uint32 numQueuedDrawCalls = stats.m_stats[Graphics::Stats::STAT_QUEUED_DRAWCALL];
+	const Uint32 numMaterialAppliesSaved = stats.m_stats[Graphics::Stats::STAT_MATERIAL_APPLIES_SAVED];
 	const Uint32 numDrawBuildings = stats.m_stats[Graphics::Stats::STAT_BUILDINGS];
 	const Uint32 numDrawCities = stats.m_stats[Graphics::Stats::STAT_CITIES];
 	const Uint32 numDrawGroundStations = stats.m_stats[Graphics::Stats::STAT_GROUNDSTATIONS];
@@ -272,6 +293,8 @@ void PerfInfo::DrawRendererStats()
 		Pi::statSceneTris, Pi::statSceneTris * framesThisSecond * 1e-6, Pi::statNumPatches, Text::TextureFont::GetGlyphCount());
 	ImGui::Text("%u draw calls (%u tris, %u point sprites, %u billboards)",
 		numDrawCalls, numDrawTris, numDrawPointSprites, numDrawBillBoards);
+	ImGui::Text("%u queued draw calls (%u material changes saved)",
+		numQueuedDrawCalls, numMaterialAppliesSaved);
 	ImGui::Text("%u Buildings, %u Cities, %u Gd.Stations, %u Sp.Stations",
 		numDrawBuildings, numDrawCities, numDrawGroundStations, numDrawSpaceStations);
 	ImGui::Text("%u Atmospheres, %u Planets, %u Gas Giants, %u Stars, %u Ships",
@@ -425,6 +448,32 @@ void PerfInfo::DrawImGuiStats()
 	}
 }
 
+void PerfInfo::DrawJobStats()
+{
+	ImGui::Text("Async job queue:");
+	DrawStatList(Pi::GetAsyncJobQueue()->GetStats().GetFrameStats());
+}
+
+void PerfInfo::DrawGalaxyStats()
+{
+	ImGui::Text("Galaxy caches (since the galaxy was created):");
+	DrawStatList(Pi::game->GetGalaxy()->GetStats().GetFrameStats());
+}
+
+void PerfInfo::DrawTerrainStats()
+{
+	// the caches' counters are all named "Disk cache ..." and "Height
+	// cache ..." so they can share a list
+	Perf::Stats::FrameInfo fi = GeoPatchContext::GetBufferPool().GetStats().GetFrameStats();
+	const Perf::Stats::FrameInfo &diskCache = GeoPatchDiskCache::GetStats().GetFrameStats();
+	fi.insert(diskCache.begin(), diskCache.end());
+	const Perf::Stats::FrameInfo &heightCache = TerrainHeightCache::GetStats().GetFrameStats();
+	fi.insert(heightCache.begin(), heightCache.end());
+
+	ImGui::Text("GeoPatch buffer pool, disk cache and terrain height cache:");
+	DrawStatList(fi);
+}
+
 void PerfInfo::DrawStatList(const Perf::Stats::FrameInfo &fi)
 {
 	ImGui::BeginChild("FrameInfo");
@@ -39,6 +39,9 @@ namespace PiGui {
 		void DrawRendererStats();
 		void DrawWorldViewStats();
 		void DrawImGuiStats();
+		void DrawJobStats();
+		void DrawGalaxyStats();
+		void DrawTerrainStats();
 		void DrawInputDebug();
 		void DrawStatList(const Perf::Stats::FrameInfo &fi);
 
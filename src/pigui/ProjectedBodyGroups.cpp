@@ -0,0 +1,162 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "ProjectedBodyGroups.h"
+
+#include "profiler/Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace PiGui;
+
+const std::vector<ProjectedBodyGroups::Group> &ProjectedBodyGroups::Update(const TSS_vector &bodies, double clusterSize,
+	const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget)
+{
+	PROFILE_SCOPED()
+	if (SameAsLast(bodies, clusterSize, navTarget, combatTarget, setSpeedTarget))
+		return m_groups;
+
+	m_lastBodies.clear();
+	for (const TScreenSpace &obj : bodies)
+		m_lastBodies.emplace_back(obj._body, obj._screenPosition);
+	m_lastClusterSize = clusterSize;
+	m_lastNavTarget = navTarget;
+	m_lastCombatTarget = combatTarget;
+	m_lastSetSpeedTarget = setSpeedTarget;
+
+	Cluster(bodies, clusterSize, navTarget, combatTarget, setSpeedTarget);
+	return m_groups;
+}
+
+bool ProjectedBodyGroups::SameAsLast(const TSS_vector &bodies, double clusterSize,
+	const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget) const
+{
+	if (bodies.size() != m_lastBodies.size() || clusterSize != m_lastClusterSize ||
+		navTarget != m_lastNavTarget || combatTarget != m_lastCombatTarget || setSpeedTarget != m_lastSetSpeedTarget)
+		return false;
+	for (size_t i = 0; i < bodies.size(); i++) {
+		if (bodies[i]._body != m_lastBodies[i].first || !(bodies[i]._screenPosition == m_lastBodies[i].second))
+			return false;
+	}
+	return true;
+}
+
+int ProjectedBodyGroups::CellIndex(const vector2d &pos) const
+{
+	const int x = std::min(int((pos.x - m_gridOrigin.x) / m_cellSize), m_gridWidth - 1);
+	const int y = std::min(int((pos.y - m_gridOrigin.y) / m_cellSize), m_gridHeight - 1);
+	return y * m_gridWidth + x;
+}
+
+void ProjectedBodyGroups::MoveGroup(int group, const vector2d &from, const vector2d &to)
+{
+	const int fromCell = CellIndex(from);
+	const int toCell = CellIndex(to);
+	if (fromCell == toCell)
+		return;
+	std::vector<int> &cell = m_cells[fromCell];
+	cell.erase(std::find(cell.begin(), cell.end(), group));
+	if (m_cells[toCell].empty())
+		m_usedCells.push_back(toCell);
+	m_cells[toCell].push_back(group);
+}
+
+void ProjectedBodyGroups::Cluster(const TSS_vector &bodies, double clusterSize,
+	const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget)
+{
+	PROFILE_SCOPED()
+	if (bodies.empty()) {
+		m_groups.clear();
+		return;
+	}
+
+	// a group's position is always one of its bodies', so the grid only
+	// needs to cover the bodies. a group within clusterSize of a body is
+	// in the body's cell or one next to it, as long as the cells are at
+	// least that big; they're made bigger when there would be too many
+	vector2d lo = bodies[0]._screenPosition, hi = lo;
+	for (const TScreenSpace &obj : bodies) {
+		lo.x = std::min(lo.x, obj._screenPosition.x);
+		lo.y = std::min(lo.y, obj._screenPosition.y);
+		hi.x = std::max(hi.x, obj._screenPosition.x);
+		hi.y = std::max(hi.y, obj._screenPosition.y);
+	}
+	const double maxCells = std::max(64.0, 4.0 * bodies.size());
+	m_cellSize = std::max(clusterSize, std::sqrt((hi.x - lo.x) * (hi.y - lo.y) / maxCells));
+	m_cellSize = std::max(m_cellSize, std::max(hi.x - lo.x, hi.y - lo.y) / maxCells);
+	if (!(m_cellSize > 0.0))
+		m_cellSize = 1.0;
+	m_gridOrigin = lo;
+	m_gridWidth = int((hi.x - lo.x) / m_cellSize) + 1;
+	m_gridHeight = int((hi.y - lo.y) / m_cellSize) + 1;
+	if (m_cells.size() < size_t(m_gridWidth * m_gridHeight))
+		m_cells.resize(m_gridWidth * m_gridHeight);
+
+	size_t numGroups = 0;
+	for (const TScreenSpace &obj : bodies) {
+		const int cell = CellIndex(obj._screenPosition);
+
+		// never collapse combat target
+		int found = -1;
+		if (obj._body != combatTarget) {
+			const int cx = cell % m_gridWidth, cy = cell / m_gridWidth;
+			for (int y = std::max(0, cy - 1); y <= std::min(m_gridHeight - 1, cy + 1); y++) {
+				for (int x = std::max(0, cx - 1); x <= std::min(m_gridWidth - 1, cx + 1); x++) {
+					for (int g : m_cells[y * m_gridWidth + x]) {
+						if ((found < 0 || g < found) && (m_groups[g].screenCoords - obj._screenPosition).Length() <= clusterSize)
+							found = g;
+					}
+				}
+			}
+		}
+
+		if (found >= 0) {
+			// body inside group boundaries: insert into group
+			Group &group = m_groups[found];
+			group.bodies.push_back(obj._body);
+
+			// make the more important body the new main body;
+			// but nav target is always most important
+			const vector2d oldCoords = group.screenCoords;
+			if (obj._body == navTarget) {
+				group.hasNavTarget = true;
+				group.mainBody = obj._body;
+				group.screenCoords = obj._screenPosition;
+			} else if (!group.hasNavTarget && first_body_is_more_important_than(obj._body, group.mainBody)) {
+				group.mainBody = obj._body;
+				group.screenCoords = obj._screenPosition;
+			}
+			if (obj._body == setSpeedTarget)
+				group.hasSetSpeedTarget = true;
+			MoveGroup(found, oldCoords, group.screenCoords);
+		} else {
+			// create new group, reusing last time's vectors
+			if (numGroups == m_groups.size())
+				m_groups.emplace_back();
+			Group &group = m_groups[numGroups];
+			group.mainBody = obj._body;
+			group.screenCoords = obj._screenPosition;
+			group.bodies.clear();
+			group.bodies.push_back(obj._body);
+			group.hasNavTarget = obj._body == navTarget;
+			group.hasSetSpeedTarget = obj._body == setSpeedTarget;
+			if (m_cells[cell].empty())
+				m_usedCells.push_back(cell);
+			m_cells[cell].push_back(int(numGroups));
+			numGroups++;
+		}
+	}
+	m_groups.resize(numGroups);
+
+	for (int cell : m_usedCells)
+		m_cells[cell].clear();
+	m_usedCells.clear();
+
+	// Sort each groups bodies according to importance
+	for (Group &group : m_groups) {
+		std::sort(begin(group.bodies), end(group.bodies),
+			[](Body *a, Body *b) {
+				return first_body_is_more_important_than(a, b);
+			});
+	}
+}
@@ -0,0 +1,63 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#pragma once
+
+#include "lua/LuaPiGuiInternal.h"
+#include "vector2.h"
+#include <vector>
+
+class Body;
+
+namespace PiGui {
+	// Groups the bodies on screen that are within clusterSize of each
+	// other, for the HUD to draw a group as one icon. A body joins the first
+	// group (in the order they were made) whose main body is within
+	// clusterSize of it, or makes a new group; the main body of a group is
+	// its most important body. The groups are found with a grid of
+	// clusterSize cells, so only the groups in the cells around a body are
+	// looked at.
+	//
+	// The groups are kept, and given back as they are while the bodies
+	// haven't moved on screen (the camera is still and so is everything in
+	// view).
+	class ProjectedBodyGroups {
+	public:
+		struct Group {
+			Body *mainBody;
+			vector2d screenCoords; // of the main body
+			std::vector<Body *> bodies; // the most important first
+			bool hasNavTarget;
+			bool hasSetSpeedTarget;
+		};
+
+		// the combat target always has a group of its own
+		const std::vector<Group> &Update(const TSS_vector &bodies, double clusterSize,
+			const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget);
+
+	private:
+		bool SameAsLast(const TSS_vector &bodies, double clusterSize,
+			const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget) const;
+		void Cluster(const TSS_vector &bodies, double clusterSize,
+			const Body *navTarget, const Body *combatTarget, const Body *setSpeedTarget);
+
+		int CellIndex(const vector2d &pos) const;
+		void MoveGroup(int group, const vector2d &from, const vector2d &to);
+
+		std::vector<Group> m_groups;
+
+		// the groups in each cell, and the cells with any in them
+		std::vector<std::vector<int>> m_cells;
+		std::vector<int> m_usedCells;
+		vector2d m_gridOrigin;
+		double m_cellSize = 0.0;
+		int m_gridWidth = 0, m_gridHeight = 0;
+
+		// what the groups were made from
+		std::vector<std::pair<Body *, vector2d>> m_lastBodies;
+		double m_lastClusterSize = 0.0;
+		const Body *m_lastNavTarget = nullptr;
+		const Body *m_lastCombatTarget = nullptr;
+		const Body *m_lastSetSpeedTarget = nullptr;
+	};
+} // namespace PiGui
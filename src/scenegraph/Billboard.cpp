@@ -3,6 +3,7 @@
 
 #include "Billboard.h"
 
+#include "InstanceBatch.h"
 #include "Model.h"
 #include "NodeVisitor.h"
 #include "graphics/Graphics.h"
@@ -42,6 +43,8 @@ namespace SceneGraph {
 	void Billboard::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
+		if (rd->batch && rd->batch->IsCollecting())
+			return;
 
 		//some hand-tweaked scaling, to make the lights seem larger from distance (final size is in pixels)
 		const float pixrad = Clamp(Graphics::GetScreenHeight() / trans.GetTranslate().Length(), 1.0f, 15.0f);
@@ -10,6 +10,7 @@ namespace SceneGraph {
 	ColorMap::ColorMap() :
 		m_smooth(true)
 	{
+		m_colors[0] = m_colors[1] = m_colors[2] = Color::WHITE;
 	}
 
 	Graphics::Texture *ColorMap::GetTexture()
@@ -29,6 +30,10 @@ namespace SceneGraph {
 
 	void ColorMap::Generate(Graphics::Renderer *r, const Color &a, const Color &b, const Color &c)
 	{
+		m_colors[0] = a;
+		m_colors[1] = b;
+		m_colors[2] = c;
+
 		std::vector<Uint8> colors;
 		const int w = 4;
 		AddColor(w, Color(255, 255, 255), colors);
@@ -55,4 +60,13 @@ namespace SceneGraph {
 		}
 	}
 
+	void ColorMap::GetPatternColors(Color out[3]) const
+	{
+		for (int i = 0; i < 3; i++) {
+			out[i] = m_colors[i];
+			out[i].a = 255;
+		}
+		out[0].a = m_smooth ? 255 : 0;
+	}
+
 } // namespace SceneGraph
@@ -23,10 +23,15 @@ namespace SceneGraph {
 		void Generate(Graphics::Renderer *r, const Color &a, const Color &b, const Color &c);
 		void SetSmooth(bool);
 
+		// the three colours, for drawing instanced without the texture,
+		// with the first colour's alpha 255 if the map is smooth
+		void GetPatternColors(Color out[3]) const;
+
 	private:
 		void AddColor(int width, const Color &c, std::vector<Uint8> &out);
 
 		bool m_smooth;
+		Color m_colors[3];
 		RefCountedPtr<Graphics::Texture> m_texture;
 	};
 
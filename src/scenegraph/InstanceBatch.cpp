@@ -0,0 +1,58 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "InstanceBatch.h"
+
+#include "StaticGeometry.h"
+#include "profiler/Profiler.h"
+
+namespace SceneGraph {
+
+	InstanceBatch::InstanceBatch() :
+		m_numGeometries(0),
+		m_collecting(false)
+	{
+	}
+
+	void InstanceBatch::Begin()
+	{
+		for (size_t i = 0; i < m_numGeometries; i++) {
+			m_instances[i].transforms.clear();
+			m_instances[i].patternColors.clear();
+		}
+		m_numGeometries = 0;
+		m_collecting = true;
+	}
+
+	void InstanceBatch::AddGeometry(StaticGeometry *sg, const matrix4x4f &trans, const Color patternColors[3])
+	{
+		assert(m_collecting);
+
+		// a model has a handful of geometries, a search is fine
+		size_t i = 0;
+		while (i < m_numGeometries && m_instances[i].geometry != sg)
+			i++;
+		if (i == m_numGeometries) {
+			if (m_numGeometries == m_instances.size())
+				m_instances.emplace_back();
+			m_instances[i].geometry = sg;
+			m_numGeometries++;
+		}
+
+		Instances &inst = m_instances[i];
+		inst.transforms.push_back(trans);
+		inst.patternColors.insert(inst.patternColors.end(), patternColors, patternColors + 3);
+	}
+
+	void InstanceBatch::Draw()
+	{
+		PROFILE_SCOPED()
+		assert(m_collecting);
+		m_collecting = false;
+
+		// in the order the model first drew them
+		for (size_t i = 0; i < m_numGeometries; i++)
+			m_instances[i].geometry->RenderInstances(m_instances[i].transforms, m_instances[i].patternColors);
+	}
+
+} // namespace SceneGraph
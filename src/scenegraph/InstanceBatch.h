@@ -0,0 +1,52 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_INSTANCEBATCH_H
+#define _SCENEGRAPH_INSTANCEBATCH_H
+/*
+ * Draws the geometry of several instances of a model (made with
+ * Model::MakeInstance, so sharing their StaticGeometry) with one instanced
+ * draw per mesh. Each instance is rendered through Model::RenderBatched
+ * twice per pass:
+ *  - while collecting, StaticGeometry records its transform and the
+ *    instance's pattern colours and nothing else is drawn
+ *  - after Draw(), the rest of the nodes (labels, thrusters, submodels)
+ *    are drawn as usual and StaticGeometry is skipped
+ */
+#include "Color.h"
+#include "matrix4x4.h"
+#include <vector>
+
+namespace SceneGraph {
+
+	class StaticGeometry;
+
+	class InstanceBatch {
+	public:
+		InstanceBatch();
+
+		// start collecting (again)
+		void Begin();
+		bool IsCollecting() const { return m_collecting; }
+
+		void AddGeometry(StaticGeometry *sg, const matrix4x4f &trans, const Color patternColors[3]);
+
+		// draw what was collected, and stop collecting
+		void Draw();
+
+	private:
+		struct Instances {
+			StaticGeometry *geometry;
+			std::vector<matrix4x4f> transforms;
+			std::vector<Color> patternColors; // three per transform
+		};
+
+		// kept between batches so the vectors are reused
+		std::vector<Instances> m_instances;
+		size_t m_numGeometries;
+		bool m_collecting;
+	};
+
+} // namespace SceneGraph
+
+#endif
@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Label3D.h"
+#include "InstanceBatch.h"
 #include "NodeVisitor.h"
 #include "graphics/Renderer.h"
 #include "graphics/RenderState.h"
@@ -77,6 +78,8 @@ namespace SceneGraph {
 	void Label3D::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
+		if (rd->batch && rd->batch->IsCollecting())
+			return;
 		if (m_vbuffer.get()) {
 			Graphics::Renderer *r = GetRenderer();
 			r->SetTransform(trans);
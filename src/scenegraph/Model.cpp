@@ -107,23 +107,11 @@ namespace SceneGraph {
 	void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
-		//update color parameters (materials are shared by model instances)
-		if (m_curPattern) {
-			for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
-				if ((*it).second->GetDescriptor().usePatterns) {
-					(*it).second->texture5 = m_colorMap.GetTexture();
-					(*it).second->texture4 = m_curPattern;
-				}
-			}
-		}
-
-		//update decals (materials and geometries are shared)
-		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
-			if (m_decalMaterials[i])
-				m_decalMaterials[i]->texture0 = m_curDecals[i];
+		UpdateMaterials();
 
 		//Override renderdata if this model is called from ModelNode
 		RenderData params = (rd != 0) ? (*rd) : m_renderData;
+		m_colorMap.GetPatternColors(params.patternColors);
 
 		m_renderer->SetTransform(trans);
 
@@ -135,6 +123,10 @@ namespace SceneGraph {
 		if (m_debugFlags & DEBUG_WIREFRAME)
 			m_renderer->SetWireFrameMode(true);
 
+		// the meshes are queued, to be drawn grouped by material once the
+		// whole model has been gone through (the materials stay as set above
+		// until then)
+		m_renderer->BeginQueue();
 		if (params.nodemask & MASK_IGNORE) {
 			m_root->Render(trans, &params);
 		} else {
@@ -143,6 +135,7 @@ namespace SceneGraph {
 			params.nodemask = NODE_TRANSPARENT;
 			m_root->Render(trans, &params);
 		}
+		m_renderer->EndQueue();
 
 		if (!m_debugFlags)
 			return;
@@ -175,23 +168,11 @@ namespace SceneGraph {
 	{
 		PROFILE_SCOPED();
 
-		//update color parameters (materials are shared by model instances)
-		if (m_curPattern) {
-			for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
-				if ((*it).second->GetDescriptor().usePatterns) {
-					(*it).second->texture5 = m_colorMap.GetTexture();
-					(*it).second->texture4 = m_curPattern;
-				}
-			}
-		}
-
-		//update decals (materials and geometries are shared)
-		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
-			if (m_decalMaterials[i])
-				m_decalMaterials[i]->texture0 = m_curDecals[i];
+		UpdateMaterials();
 
 		//Override renderdata if this model is called from ModelNode
 		RenderData params = (rd != 0) ? (*rd) : m_renderData;
+		m_colorMap.GetPatternColors(params.patternColors);
 
 		//using the entire model bounding radius for all nodes at the moment.
 		//BR could also be a property of Node.
@@ -211,6 +192,54 @@ namespace SceneGraph {
 		}
 	}
 
+	void Model::RenderBatched(const matrix4x4f &trans, unsigned int nodemask, InstanceBatch *batch)
+	{
+		PROFILE_SCOPED()
+		assert(!(nodemask & MASK_IGNORE));
+		UpdateMaterials();
+
+		RenderData params = m_renderData;
+		m_colorMap.GetPatternColors(params.patternColors);
+		params.boundingRadius = GetDrawClipRadius();
+		params.nodemask = nodemask;
+		params.batch = batch;
+		m_root->Render(trans, &params);
+	}
+
+	bool Model::CanBatchWith(const Model *other) const
+	{
+		// instances of the same model share their geometry and materials;
+		// the pattern and decals are textures, so they have to match too
+		if (m_name != other->m_name || m_debugFlags || other->m_debugFlags)
+			return false;
+		if (m_materials.size() != other->m_materials.size() || (!m_materials.empty() && m_materials[0].second != other->m_materials[0].second))
+			return false;
+		if (m_curPattern != other->m_curPattern)
+			return false;
+		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
+			if (m_curDecals[i] != other->m_curDecals[i])
+				return false;
+		return true;
+	}
+
+	void Model::UpdateMaterials()
+	{
+		//update color parameters (materials are shared by model instances)
+		if (m_curPattern) {
+			for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
+				if ((*it).second->GetDescriptor().usePatterns) {
+					(*it).second->texture5 = m_colorMap.GetTexture();
+					(*it).second->texture4 = m_curPattern;
+				}
+			}
+		}
+
+		//update decals (materials and geometries are shared)
+		for (unsigned int i = 0; i < MAX_DECAL_MATERIALS; i++)
+			if (m_decalMaterials[i])
+				m_decalMaterials[i]->texture0 = m_curDecals[i];
+	}
+
 	void Model::CreateAabbVB()
 	{
 		PROFILE_SCOPED()
@@ -79,6 +79,7 @@ namespace SceneGraph {
 	class Animation;
 	class BaseLoader;
 	class BinaryConverter;
+	class InstanceBatch;
 	class MatrixTransform;
 	class ModelBinarizer;
 
@@ -110,6 +111,12 @@ namespace SceneGraph {
 		void Render(const matrix4x4f &trans, const RenderData *rd = 0); //ModelNode can override RD
 		void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd = 0); //ModelNode can override RD
 
+		// one pass (NODE_SOLID or NODE_TRANSPARENT) as an instance in a batch
+		// (see InstanceBatch); only models that CanBatchWith each other can
+		// share one
+		void RenderBatched(const matrix4x4f &trans, unsigned int nodemask, InstanceBatch *batch);
+		bool CanBatchWith(const Model *other) const;
+
 		RefCountedPtr<CollMesh> CreateCollisionMesh();
 		RefCountedPtr<CollMesh> GetCollisionMesh() const { return m_collMesh; }
 		void SetCollisionMesh(RefCountedPtr<CollMesh> collMesh) { m_collMesh.Reset(collMesh.Get()); }
@@ -174,6 +181,8 @@ namespace SceneGraph {
 	private:
 		Model(const Model &);
 
+		void UpdateMaterials();
+
 		static const unsigned int MAX_DECAL_MATERIALS = 4;
 		ColorMap m_colorMap;
 		float m_boundingRadius;
@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "ModelNode.h"
+#include "InstanceBatch.h"
 #include "Model.h"
 
 namespace SceneGraph {
@@ -26,9 +27,13 @@ namespace SceneGraph {
 	void ModelNode::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
+		//submodels aren't batched, they're drawn after the batch
+		if (rd->batch && rd->batch->IsCollecting())
+			return;
 		//slight hack here
 		RenderData newrd = *rd;
 		newrd.nodemask |= MASK_IGNORE;
+		newrd.batch = nullptr;
 		m_model->Render(trans, &newrd);
 	}
 
@@ -24,6 +24,7 @@ namespace SceneGraph {
 	class BaseLoader;
 	class NodeVisitor;
 	class NodeCopyCache;
+	class InstanceBatch;
 	class Model;
 
 	//Node traversal mask - for other
@@ -49,11 +50,15 @@ namespace SceneGraph {
 		float boundingRadius; //updated by model and passed to submodels
 		unsigned int nodemask;
 
+		Color patternColors[3]; //updated by model, for instanced geometry (see ColorMap)
+		InstanceBatch *batch; //set when the model is drawn as one of a batch
+
 		RenderData() :
 			linthrust(),
 			angthrust(),
 			boundingRadius(0.f),
-			nodemask(NODE_SOLID) //draw solids
+			nodemask(NODE_SOLID), //draw solids
+			batch(nullptr)
 		{
 		}
 	};
@@ -4,6 +4,7 @@
 #include "StaticGeometry.h"
 
 #include "BaseLoader.h"
+#include "InstanceBatch.h"
 #include "Model.h"
 #include "NodeVisitor.h"
 #include "Serializer.h"
@@ -49,18 +50,37 @@ namespace SceneGraph {
 	{
 		PROFILE_SCOPED()
 		SDL_assert(m_renderState);
+		if (rd->batch) {
+			// drawn with the rest of the batch
+			if (rd->batch->IsCollecting())
+				rd->batch->AddGeometry(this, trans, rd->patternColors);
+			return;
+		}
+
 		Graphics::Renderer *r = GetRenderer();
 		r->SetTransform(trans);
 		for (auto &it : m_meshes)
-			r->DrawBufferIndexed(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get());
+			r->QueueDraw(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get());
 
 		//DrawBoundingBox(m_boundingBox);
 	}
 
 	void StaticGeometry::Render(const std::vector<matrix4x4f> &trans, const RenderData *rd)
+	{
+		PROFILE_SCOPED()
+		// every instance has the model's colours
+		std::vector<Color> patternColors;
+		patternColors.reserve(trans.size() * 3);
+		for (size_t i = 0; i < trans.size(); i++)
+			patternColors.insert(patternColors.end(), rd->patternColors, rd->patternColors + 3);
+		RenderInstances(trans, patternColors);
+	}
+
+	void StaticGeometry::RenderInstances(const std::vector<matrix4x4f> &trans, const std::vector<Color> &patternColors)
 	{
 		PROFILE_SCOPED()
 		SDL_assert(m_renderState);
+		assert(patternColors.size() == trans.size() * 3);
 		Graphics::Renderer *r = GetRenderer();
 
 		const size_t numTrans = trans.size();
@@ -81,6 +101,7 @@ namespace SceneGraph {
 			ib->Unmap();
 			ib->SetInstanceCount(numTrans);
 		}
+		ib->SetPatternColors(&patternColors[0], numTrans);
 
 		// we'll set the transformation within the vertex shader so identity the global one
 		r->SetTransform(matrix4x4f::Identity());
@@ -94,13 +115,6 @@ namespace SceneGraph {
 				// create the "new" material with the instanced description
 				RefCountedPtr<Graphics::Material> mat(r->CreateMaterial(mdesc));
 				// copy over all of the other details
-				mat->texture0 = it.material->texture0;
-				mat->texture1 = it.material->texture1;
-				mat->texture2 = it.material->texture2;
-				mat->texture3 = it.material->texture3;
-				mat->texture4 = it.material->texture4;
-				mat->texture5 = it.material->texture5;
-				mat->texture6 = it.material->texture5;
 				mat->heatGradient = it.material->heatGradient;
 				mat->diffuse = it.material->diffuse;
 				mat->specular = it.material->specular;
@@ -114,8 +128,18 @@ namespace SceneGraph {
 		// process each mesh
 		int i = 0;
 		for (auto &it : m_meshes) {
+			// the textures are per model instance (patterns, decals), so
+			// they're whatever the model last set
+			Graphics::Material *mat = m_instanceMaterials[i].Get();
+			mat->texture0 = it.material->texture0;
+			mat->texture1 = it.material->texture1;
+			mat->texture2 = it.material->texture2;
+			mat->texture3 = it.material->texture3;
+			mat->texture4 = it.material->texture4;
+			mat->texture5 = it.material->texture5;
+			mat->texture6 = it.material->texture6;
 			// finally render using the instance material
-			r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, m_instanceMaterials[i].Get(), m_instBuffer.Get());
+			r->DrawBufferIndexedInstanced(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, mat, m_instBuffer.Get());
 			++i;
 		}
 	}
@@ -30,6 +30,8 @@ namespace SceneGraph {
 		virtual void Accept(NodeVisitor &nv) override;
 		virtual void Render(const matrix4x4f &trans, const RenderData *rd) override;
 		virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd) override;
+		// instanced, with three pattern colours per transform
+		void RenderInstances(const std::vector<matrix4x4f> &trans, const std::vector<Color> &patternColors);
 
 		virtual void Save(NodeDatabase &) override;
 		static StaticGeometry *Load(NodeDatabase &);
@@ -4,6 +4,7 @@
 #include "Thruster.h"
 #include "BaseLoader.h"
 #include "Easing.h"
+#include "InstanceBatch.h"
 #include "NodeVisitor.h"
 #include "Serializer.h"
 #include "graphics/Material.h"
@@ -68,6 +69,8 @@ namespace SceneGraph {
 	void Thruster::Render(const matrix4x4f &trans, const RenderData *rd)
 	{
 		PROFILE_SCOPED()
+		if (rd->batch && rd->batch->IsCollecting())
+			return;
 		float power = -dir.Dot(vector3f(rd->linthrust));
 
 		if (!linearOnly) {
@@ -108,6 +108,12 @@ PlayerShipController::~PlayerShipController()
 	Pi::input->RemoveInputFrame(&InputBindings);
 	m_connRotationDampingToggleKey.disconnect();
 	m_fireMissileKey.disconnect();
+
+	if (m_ship) {
+		m_ship->RemoveBodyRef(m_combatTarget);
+		m_ship->RemoveBodyRef(m_navTarget);
+		m_ship->RemoveBodyRef(m_setSpeedTarget);
+	}
 }
 
 void PlayerShipController::SaveToJson(Json &jsonObj, Space *space)
@@ -143,9 +149,9 @@ void PlayerShipController::LoadFromJson(const Json &jsonObj)
 
 void PlayerShipController::PostLoadFixup(Space *space)
 {
-	m_combatTarget = space->GetBodyByIndex(m_combatTargetIndex);
-	m_navTarget = space->GetBodyByIndex(m_navTargetIndex);
-	m_setSpeedTarget = space->GetBodyByIndex(m_setSpeedTargetIndex);
+	SetTargetRef(m_combatTarget, space->GetBodyByIndex(m_combatTargetIndex));
+	SetTargetRef(m_navTarget, space->GetBodyByIndex(m_navTargetIndex));
+	SetTargetRef(m_setSpeedTarget, space->GetBodyByIndex(m_setSpeedTargetIndex));
 }
 
 void PlayerShipController::StaticUpdate(const float timeStep)
@@ -456,20 +462,26 @@ Body *PlayerShipController::GetSetSpeedTarget() const
 void PlayerShipController::SetCombatTarget(Body *const target, bool setSpeedTo)
 {
 	if (setSpeedTo)
-		m_setSpeedTarget = target;
-	m_combatTarget = target;
+		SetTargetRef(m_setSpeedTarget, target);
+	SetTargetRef(m_combatTarget, target);
 	onChangeTarget.emit();
 }
 
 void PlayerShipController::SetNavTarget(Body *const target)
 {
-	m_navTarget = target;
+	SetTargetRef(m_navTarget, target);
 	onChangeTarget.emit();
 }
 
 void PlayerShipController::SetSetSpeedTarget(Body *const target)
 {
-	m_setSpeedTarget = target;
+	SetTargetRef(m_setSpeedTarget, target);
 	// TODO: not sure, do we actually need this? we are only changing the set speed target
 	onChangeTarget.emit();
 }
+
+void PlayerShipController::SetTargetRef(Body *&ref, Body *target)
+{
+	m_ship->ReplaceBodyRef(ref, target);
+	ref = target;
+}
@@ -88,6 +88,8 @@ private:
 	bool IsAnyLinearThrusterKeyDown();
 	//do a variety of checks to see if input is allowed
 	void CheckControlsLock();
+	// point a target at a new body, keeping the ship's body references in step
+	void SetTargetRef(Body *&ref, Body *target);
 	Body *m_combatTarget;
 	Body *m_navTarget;
 	Body *m_setSpeedTarget;
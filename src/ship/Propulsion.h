@@ -101,7 +101,9 @@ public:
 	void UpdateFuel(const float timeStep);
 	inline bool IsFuelStateChanged() { return m_fuelStateChange; }
 
-	void Render(Graphics::Renderer *r, const Camera *camera, const vector3d &viewCoords, const matrix4x4d &viewTransform);
+	// points the model's thruster flames the way the thrusters are firing.
+	// before the model is drawn, batched or not
+	void SetModelThrust();
 
 	// AI on Propulsion
 	void AIModelCoordsMatchAngVel(const vector3d &desiredAngVel, double softness);
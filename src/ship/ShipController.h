@@ -36,7 +36,8 @@ public:
 		AI = 0,
 		PLAYER = 1
 	};
-	ShipController() {}
+	ShipController() :
+		m_ship(nullptr) {}
 	virtual ~ShipController() {}
 	virtual Type GetType() { return AI; }
 	virtual void SaveToJson(Json &jsonObj, Space *s) {}
@@ -6,9 +6,14 @@
 #include "FileSystem.h"
 #include "FloatComparison.h"
 #include "GameConfig.h"
+#include "TerrainHeightCache.h"
+#include "TerrainNoise.h"
 #include "perlin.h"
 #include "../utils.h"
 #include "../galaxy/SystemBody.h"
+#include "jenkins/lookup3.h"
+#include <cstring>
+#include <vector>
 
 // static instancer. selects the best height and color classes for the body
 Terrain *Terrain::InstanceTerrain(const SystemBody *body)
@@ -488,6 +493,7 @@ Terrain::Terrain(const SystemBody *body) :
 	m_planetRadius = rad;
 	m_invPlanetRadius = 1.0 / rad;
 	m_planetEarthRadii = rad / EARTH_RADIUS;
+	m_heightCache.reset(new TerrainHeightCache(rad));
 
 	// Pick some colors, mainly reds and greens
 	for (int i = 0; i < int(COUNTOF(m_entropy)); i++)
@@ -628,10 +634,69 @@ Terrain::~Terrain()
 {
 }
 
+Uint32 Terrain::GetFingerprint() const
+{
+	// the fractals, and everything they are built from
+	std::vector<char> id;
+	auto add = [&id](const void *data, size_t size) {
+		id.insert(id.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+	};
+	const Uint32 version = TERRAIN_VERSION;
+	add(&version, sizeof(version));
+	add(GetHeightFractalName(), strlen(GetHeightFractalName()) + 1);
+	add(GetColorFractalName(), strlen(GetColorFractalName()) + 1);
+	add(&m_seed, sizeof(m_seed));
+	add(&m_sealevel, sizeof(m_sealevel));
+	add(&m_icyness, sizeof(m_icyness));
+	add(&m_volcanic, sizeof(m_volcanic));
+	add(&m_surfaceEffects, sizeof(m_surfaceEffects));
+	add(&m_maxHeight, sizeof(m_maxHeight));
+	add(&m_planetRadius, sizeof(m_planetRadius));
+	add(m_entropy, sizeof(m_entropy));
+	for (const fracdef_t &fd : m_fracdef) {
+		add(&fd.amplitude, sizeof(fd.amplitude));
+		add(&fd.frequency, sizeof(fd.frequency));
+		add(&fd.lacunarity, sizeof(fd.lacunarity));
+		add(&fd.octaves, sizeof(fd.octaves));
+	}
+	const vector3d *colors[] = { m_rockColor, m_darkrockColor, m_greyrockColor, m_plantColor, m_darkplantColor,
+		m_sandColor, m_darksandColor, m_dirtColor, m_darkdirtColor, m_gglightColor, m_ggdarkColor };
+	for (const vector3d *c : colors)
+		add(c, 8 * sizeof(vector3d));
+
+	Uint32 hash = lookup3_hashlittle(id.data(), id.size(), 0);
+	if (m_heightMap) {
+		add(&m_heightMapSizeX, sizeof(m_heightMapSizeX));
+		add(&m_heightMapSizeY, sizeof(m_heightMapSizeY));
+		add(&m_heightScaling, sizeof(m_heightScaling));
+		add(&m_minh, sizeof(m_minh));
+		hash = lookup3_hashlittle(id.data(), id.size(), hash);
+		hash = lookup3_hashlittle(m_heightMap.get(), size_t(m_heightMapSizeX) * m_heightMapSizeY * sizeof(double), hash);
+	}
+	return hash;
+}
+
 /**
  * Feature width means roughly one perlin noise blob or grain.
  * This will end up being one hill, mountain or continent, roughly.
  */
+void Terrain::GetHeights(const vector3d *p, double *heights, size_t count) const
+{
+	for (size_t first = 0; first < count; first += TerrainNoise::BATCH_SIZE)
+		GetHeightBatch(p + first, heights + first, std::min(TerrainNoise::BATCH_SIZE, count - first));
+}
+
+void Terrain::GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	for (size_t first = 0; first < count; first += TerrainNoise::BATCH_SIZE)
+		GetColorBatch(p + first, heights + first, norms + first, colors + first, std::min(TerrainNoise::BATCH_SIZE, count - first));
+}
+
+void Terrain::GetCachedHeights(const vector3d *p, double *heights, size_t count) const
+{
+	m_heightCache->GetHeights(this, p, heights, count);
+}
+
 void Terrain::SetFracDef(const unsigned int index, const double featureHeightMeters, const double featureWidthMeters, const double smallestOctaveMeters)
 {
 	assert(index < MAX_FRACDEFS);
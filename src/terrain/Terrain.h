@@ -18,6 +18,7 @@
 #endif
 
 class SystemBody;
+class TerrainHeightCache;
 
 template <typename, typename>
 class TerrainGenerator;
@@ -46,6 +47,19 @@ public:
 	virtual double GetHeight(const vector3d &p) const = 0;
 	virtual vector3d GetColor(const vector3d &p, double height, const vector3d &norm) const = 0;
 
+	// GetHeight() and GetColor() for count points at once, which is how the
+	// patch jobs fill a patch. fractals that have batched versions work on
+	// several points at a time with the vector noise(); the rest go a point
+	// at a time. the results are the same either way
+	void GetHeights(const vector3d *p, double *heights, size_t count) const;
+	void GetColors(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
+
+	// GetHeights() interpolated from heights kept on a grid of about 10m
+	// (see TerrainHeightCache), for the collision code that asks for the
+	// same few places every step. close to, but not quite, what GetHeight()
+	// gives, so not for placing things or one-off probes
+	void GetCachedHeights(const vector3d *p, double *heights, size_t count) const;
+
 	virtual const char *GetHeightFractalName() const = 0;
 	virtual const char *GetColorFractalName() const = 0;
 
@@ -53,6 +67,12 @@ public:
 
 	Uint32 GetSurfaceEffects() const { return m_surfaceEffects; }
 
+	// changes whenever anything the terrain would generate does, so that what
+	// it generated can be kept between runs. bump TERRAIN_VERSION after
+	// changing what a fractal does
+	Uint32 GetFingerprint() const;
+	static const Uint32 TERRAIN_VERSION = 1;
+
 	double BiCubicInterpolation(const vector3d &p) const;
 
 	void DebugDump() const;
@@ -66,6 +86,10 @@ private:
 protected:
 	Terrain(const SystemBody *body);
 
+	// GetHeights() and GetColors(), for at most TerrainNoise::BATCH_SIZE points
+	virtual void GetHeightBatch(const vector3d *p, double *heights, size_t count) const = 0;
+	virtual void GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const = 0;
+
 	Uint32 m_seed;
 	Random m_rand;
 
@@ -118,6 +142,8 @@ protected:
 		std::string m_name;
 	};
 	MinBodyData m_minBody;
+
+	std::unique_ptr<TerrainHeightCache> m_heightCache;
 };
 
 template <typename HeightFractal>
@@ -129,6 +155,7 @@ public:
 
 protected:
 	TerrainHeightFractal(const SystemBody *body);
+	virtual void GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
 
 private:
 };
@@ -142,10 +169,27 @@ public:
 
 protected:
 	TerrainColorFractal(const SystemBody *body);
+	virtual void GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
 
 private:
 };
 
+// unless the fractal has its own batched version (declared at the end of
+// this file), a point at a time
+template <typename HeightFractal>
+void TerrainHeightFractal<HeightFractal>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		heights[i] = TerrainHeightFractal<HeightFractal>::GetHeight(p[i]);
+}
+
+template <typename ColorFractal>
+void TerrainColorFractal<ColorFractal>::GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		colors[i] = TerrainColorFractal<ColorFractal>::GetColor(p[i], heights[i], norms[i]);
+}
+
 template <typename HeightFractal, typename ColorFractal>
 class TerrainGenerator : public TerrainHeightFractal<HeightFractal>, public TerrainColorFractal<ColorFractal> {
 public:
@@ -253,6 +297,28 @@ class TerrainColorTFGood;
 class TerrainColorTFPoor;
 class TerrainColorVolcanic;
 
+// the fractals with batched versions
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid3>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightBarrenRock>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightBarrenRock2>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightBarrenRock3>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightHillsRidged>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainHeightFractal<TerrainHeightHillsRivers>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const;
+template <>
+void TerrainColorFractal<TerrainColorAsteroid>::GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
+template <>
+void TerrainColorFractal<TerrainColorBandedRock>::GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const;
+
 #ifdef _MSC_VER
 #pragma warning(default : 4250)
 #endif
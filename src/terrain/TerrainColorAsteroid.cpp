@@ -46,3 +46,34 @@ vector3d TerrainColorFractal<TerrainColorAsteroid>::GetColor(const vector3d &p,
 		return col;
 	}
 }
+
+template <>
+void TerrainColorFractal<TerrainColorAsteroid>::GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	double n[BATCH_SIZE], desert[BATCH_SIZE];
+	vector3d scaled[BATCH_SIZE];
+	for (size_t i = 0; i < count; i++) {
+		n[i] = m_invMaxHeight * heights[i] / 2;
+		scaled[i] = (n[i] * 2.0) * p[i];
+	}
+	octavenoise(12, 0.5, 2.0, scaled, desert, count);
+
+	// as GetColor()
+	for (size_t i = 0; i < count; i++) {
+		const double flatness = pow(p[i].Dot(norms[i]), 6.0);
+		const double equatorial_desert = (2.0) * (-1.0 + 2.0 * desert[i]) *
+			1.0 * (2.0) * (1.0 - p[i].y * p[i].y);
+
+		vector3d col;
+		if (n[i] <= 0.02) {
+			col = interpolate_color(equatorial_desert, m_rockColor[0], m_greyrockColor[3]);
+			col = interpolate_color(n[i], col, vector3d(1.5, 1.35, 1.3));
+			col = interpolate_color(flatness, m_rockColor[1], col);
+		} else {
+			col = interpolate_color(equatorial_desert, m_greyrockColor[0], m_greyrockColor[2]);
+			col = interpolate_color(n[i], col, m_rockColor[3]);
+			col = interpolate_color(flatness, m_greyrockColor[1], col);
+		}
+		colors[i] = col;
+	}
+}
@@ -23,3 +23,18 @@ vector3d TerrainColorFractal<TerrainColorBandedRock>::GetColor(const vector3d &p
 	vector3d col = interpolate_color(n, m_rockColor[0], m_rockColor[1]);
 	return interpolate_color(flatness, col, m_rockColor[2]);
 }
+
+template <>
+void TerrainColorFractal<TerrainColorBandedRock>::GetColorBatch(const vector3d *p, const double *heights, const vector3d *norms, vector3d *colors, size_t count) const
+{
+	vector3d bands[BATCH_SIZE];
+	double n[BATCH_SIZE];
+	for (size_t i = 0; i < count; i++)
+		bands[i] = vector3d(heights[i] * 10000.0, 0.0, 0.0);
+	noise(bands, n, count);
+	for (size_t i = 0; i < count; i++) {
+		const double flatness = pow(p[i].Dot(norms[i]), 6.0);
+		const vector3d col = interpolate_color(fabs(n[i]), m_rockColor[0], m_rockColor[1]);
+		colors[i] = interpolate_color(flatness, col, m_rockColor[2]);
+	}
+}
@@ -29,3 +29,15 @@ double TerrainHeightFractal<TerrainHeightAsteroid3>::GetHeight(const vector3d &p
 
 	return (n > 0.0 ? m_maxHeight * n : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightAsteroid3>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	double a[BATCH_SIZE], b[BATCH_SIZE];
+	octavenoise(GetFracDef(0), 0.5, p, a, count);
+	ridged_octavenoise(GetFracDef(1), 0.5, p, b, count);
+	for (size_t i = 0; i < count; i++) {
+		const double n = a[i] * b[i];
+		heights[i] = (n > 0.0 ? m_maxHeight * n : 0.0);
+	}
+}
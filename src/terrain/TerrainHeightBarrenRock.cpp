@@ -32,3 +32,18 @@ double TerrainHeightFractal<TerrainHeightBarrenRock>::GetHeight(const vector3d &
 
 	return (n > 0.0 ? m_maxHeight * n : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightBarrenRock>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	double persistence[BATCH_SIZE], lacunarity[BATCH_SIZE], n[BATCH_SIZE];
+	octavenoise(8, 0.4, 2.5, p, persistence, count);
+	octavenoise(8, 0.257, 4.0, p, lacunarity, count);
+	for (size_t i = 0; i < count; i++) {
+		persistence[i] = 0.5 * persistence[i];
+		lacunarity[i] = Clamp(5.0 * lacunarity[i], 1.0, 5.0);
+	}
+	ridged_octavenoise(16, persistence, lacunarity, p, n, count);
+	for (size_t i = 0; i < count; i++)
+		heights[i] = (n[i] > 0.0 ? m_maxHeight * n[i] : 0.0);
+}
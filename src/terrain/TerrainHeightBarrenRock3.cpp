@@ -27,3 +27,20 @@ double TerrainHeightFractal<TerrainHeightBarrenRock3>::GetHeight(const vector3d
 
 	return (n > 0.0 ? m_maxHeight * n : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightBarrenRock3>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	double persistence[BATCH_SIZE], lacunarity[BATCH_SIZE], v[BATCH_SIZE];
+	river_octavenoise(12, 0.4, 2.5, p, persistence, count);
+	billow_octavenoise(12, 0.37, 4.0, p, lacunarity, count);
+	for (size_t i = 0; i < count; i++) {
+		persistence[i] = Clamp(fabs(0.165 - (0.38 * persistence[i])), 0.15, 0.5);
+		lacunarity[i] = Clamp(8.0 * lacunarity[i], 0.5, 9.0);
+	}
+	voronoiscam_octavenoise(12, persistence, lacunarity, p, v, count);
+	for (size_t i = 0; i < count; i++) {
+		const float n = 0.07 * v[i];
+		heights[i] = (n > 0.0 ? m_maxHeight * n : 0.0);
+	}
+}
@@ -0,0 +1,213 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TerrainHeightCache.h"
+
+#include "Terrain.h"
+#include "../profiler/Profiler.h"
+#include <SDL_mutex.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+	// half the smallest octave the fractals are usually given (see
+	// Terrain::SetFracDef()), and a tenth of the patches drawn closest in
+	const double GRID_SPACING_METRES = 10.0;
+	const int TILE_SHIFT = 3; // log2(TILE_CELLS)
+	// so that a tile's coordinates fit in 28 bits each
+	const int MAX_LEVEL = 28;
+
+	struct HeightCacheStats {
+		HeightCacheStats() :
+			queries(stats.GetOrCreateCounter("Height cache queries", false)),
+			generated(stats.GetOrCreateCounter("Height cache tiles generated", false)),
+			dropped(stats.GetOrCreateCounter("Height cache tiles dropped", false))
+		{
+			stats.EnableReset(false);
+		}
+
+		Perf::Stats stats;
+		Perf::Stats::CounterRef queries, generated, dropped;
+	};
+
+	HeightCacheStats &Stats()
+	{
+		static HeightCacheStats s;
+		return s;
+	}
+
+	// faces are numbered +x, -x, +y, -y, +z, -z, and u and v are the
+	// other two coordinates over the main one, so -1 to 1 across the face
+	void ToFace(const vector3d &p, int &face, double &u, double &v)
+	{
+		const double ax = fabs(p.x), ay = fabs(p.y), az = fabs(p.z);
+		if (ax >= ay && ax >= az) {
+			face = p.x > 0.0 ? 0 : 1;
+			u = p.y / ax;
+			v = p.z / ax;
+		} else if (ay >= az) {
+			face = p.y > 0.0 ? 2 : 3;
+			u = p.z / ay;
+			v = p.x / ay;
+		} else {
+			face = p.z > 0.0 ? 4 : 5;
+			u = p.x / az;
+			v = p.y / az;
+		}
+	}
+
+	vector3d FromFace(int face, double u, double v)
+	{
+		const double s = (face & 1) ? -1.0 : 1.0;
+		switch (face >> 1) {
+		case 0: return vector3d(s, u, v).Normalized();
+		case 1: return vector3d(v, s, u).Normalized();
+		default: return vector3d(u, v, s).Normalized();
+		}
+	}
+
+	// the grid is even in angle rather than in u and v, so that the cells at
+	// the edges of a face are as big as those in the middle
+	inline double ToGrid(double u, int cells) { return (atan(u) * (4.0 / M_PI) + 1.0) * 0.5 * cells; }
+	inline double FromGrid(int g, int cells) { return tan((double(g) / cells * 2.0 - 1.0) * (M_PI / 4.0)); }
+
+	inline Uint64 MakeKey(int face, Uint32 tx, Uint32 ty) { return Uint64(face) | (Uint64(tx) << 3) | (Uint64(ty) << 31); }
+} // namespace
+
+TerrainHeightCache::TerrainHeightCache(double radius) :
+	m_level(TILE_SHIFT),
+	m_lock(SDL_CreateMutex())
+{
+	static_assert(TILE_CELLS == 1 << TILE_SHIFT, "tile size and shift must agree");
+	// a face is a quarter of the way round
+	const double faceMetres = radius * M_PI * 0.5;
+	while (faceMetres / double(1 << m_level) > GRID_SPACING_METRES && m_level < MAX_LEVEL)
+		++m_level;
+}
+
+TerrainHeightCache::~TerrainHeightCache()
+{
+	SDL_DestroyMutex(m_lock);
+}
+
+// static
+Perf::Stats &TerrainHeightCache::GetStats()
+{
+	return Stats().stats;
+}
+
+TerrainHeightCache::Cell TerrainHeightCache::FindCell(const vector3d &p) const
+{
+	const int cells = 1 << m_level;
+	int face;
+	double u, v;
+	ToFace(p, face, u, v);
+	const double gx = std::max(0.0, std::min(ToGrid(u, cells), double(cells)));
+	const double gy = std::max(0.0, std::min(ToGrid(v, cells), double(cells)));
+	const int ix = std::min(int(gx), cells - 1);
+	const int iy = std::min(int(gy), cells - 1);
+
+	Cell cell;
+	cell.key = MakeKey(face, Uint32(ix) >> TILE_SHIFT, Uint32(iy) >> TILE_SHIFT);
+	cell.x = ix & (TILE_CELLS - 1);
+	cell.y = iy & (TILE_CELLS - 1);
+	cell.fx = gx - ix;
+	cell.fy = gy - iy;
+	return cell;
+}
+
+// static
+double TerrainHeightCache::Interpolate(const double *tileHeights, const Cell &cell)
+{
+	const double *row0 = tileHeights + cell.y * TILE_SAMPLES + cell.x;
+	const double *row1 = row0 + TILE_SAMPLES;
+	const double h0 = row0[0] + (row0[1] - row0[0]) * cell.fx;
+	const double h1 = row1[0] + (row1[1] - row1[0]) * cell.fx;
+	return h0 + (h1 - h0) * cell.fy;
+}
+
+// all of the tiles' samples in one go, so the fractals get whole batches
+void TerrainHeightCache::GenerateTiles(const Terrain *terrain, const Uint64 *keys, size_t count, double *heights) const
+{
+	PROFILE_SCOPED()
+	const int cells = 1 << m_level;
+	const size_t tileSamples = TILE_SAMPLES * TILE_SAMPLES;
+	std::vector<vector3d> points;
+	points.reserve(count * tileSamples);
+	for (size_t t = 0; t < count; t++) {
+		const int face = int(keys[t] & 7);
+		const int gx0 = int((keys[t] >> 3) & 0xfffffff) << TILE_SHIFT;
+		const int gy0 = int((keys[t] >> 31) & 0xfffffff) << TILE_SHIFT;
+		for (int y = 0; y < TILE_SAMPLES; y++) {
+			const double v = FromGrid(gy0 + y, cells);
+			for (int x = 0; x < TILE_SAMPLES; x++)
+				points.push_back(FromFace(face, FromGrid(gx0 + x, cells), v));
+		}
+	}
+	terrain->GetHeights(points.data(), heights, points.size());
+}
+
+void TerrainHeightCache::GetHeights(const Terrain *terrain, const vector3d *p, double *heights, size_t count)
+{
+	PROFILE_SCOPED()
+	Stats().stats.CounterAdd(Stats().queries, Uint32(count));
+
+	std::vector<Cell> cells(count);
+	for (size_t i = 0; i < count; i++)
+		cells[i] = FindCell(p[i]);
+
+	// the points in tiles that are here
+	std::vector<size_t> missing;
+	SDL_LockMutex(m_lock);
+	for (size_t i = 0; i < count; i++) {
+		auto it = m_tiles.find(cells[i].key);
+		if (it == m_tiles.end()) {
+			missing.push_back(i);
+			continue;
+		}
+		m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+		heights[i] = Interpolate(it->second.heights, cells[i]);
+	}
+	SDL_UnlockMutex(m_lock);
+	if (missing.empty())
+		return;
+
+	// the rest are generated without holding up the other threads
+	std::vector<Uint64> keys;
+	keys.reserve(missing.size());
+	for (size_t i : missing)
+		keys.push_back(cells[i].key);
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+	const size_t tileSamples = TILE_SAMPLES * TILE_SAMPLES;
+	std::vector<double> generated(keys.size() * tileSamples);
+	GenerateTiles(terrain, keys.data(), keys.size(), generated.data());
+	Stats().stats.CounterAdd(Stats().generated, Uint32(keys.size()));
+
+	for (size_t i : missing) {
+		const size_t t = std::lower_bound(keys.begin(), keys.end(), cells[i].key) - keys.begin();
+		heights[i] = Interpolate(&generated[t * tileSamples], cells[i]);
+	}
+
+	// and kept, unless another thread got there first
+	Uint32 dropped = 0;
+	SDL_LockMutex(m_lock);
+	for (size_t t = 0; t < keys.size(); t++) {
+		if (m_tiles.count(keys[t]))
+			continue;
+		Tile &tile = m_tiles[keys[t]];
+		std::copy(generated.begin() + t * tileSamples, generated.begin() + (t + 1) * tileSamples, tile.heights);
+		m_lru.push_front(keys[t]);
+		tile.lru = m_lru.begin();
+	}
+	while (m_tiles.size() > MAX_TILES) {
+		m_tiles.erase(m_lru.back());
+		m_lru.pop_back();
+		dropped++;
+	}
+	SDL_UnlockMutex(m_lock);
+	if (dropped)
+		Stats().stats.CounterAdd(Stats().dropped, dropped);
+}
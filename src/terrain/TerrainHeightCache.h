@@ -0,0 +1,68 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TERRAINHEIGHTCACHE_H
+#define _TERRAINHEIGHTCACHE_H
+
+#include "../PerfStats.h"
+#include "../vector3.h"
+#include <SDL_stdinc.h>
+#include <list>
+#include <unordered_map>
+
+struct SDL_mutex;
+class Terrain;
+
+// Heights of a terrain on a fine grid, for the collision and flight code
+// that asks for the height under a ship (or shot) every physics step.
+// Each face of the cube the sphere is projected from is divided into cells
+// of about GRID_SPACING_METRES, and the heights at the corners of the cells
+// are generated a tile of cells at a time (with the batched fractals) and
+// kept, the tiles used least recently being dropped first. A height is
+// interpolated from the four corners of the cell it's in, which puts it
+// well within what the patches that are drawn (which are much coarser) are
+// off by.
+//
+// Only depends on where the point is, so the same point always gets the
+// same height whatever else has been asked for. Thread safe.
+class TerrainHeightCache {
+public:
+	// radius of the planet in metres
+	explicit TerrainHeightCache(double radius);
+	~TerrainHeightCache();
+
+	// heights (in planet radii, like Terrain::GetHeight()) of points on the
+	// unit sphere
+	void GetHeights(const Terrain *terrain, const vector3d *p, double *heights, size_t count);
+
+	// queries and tiles generated and dropped, of every terrain
+	static Perf::Stats &GetStats();
+
+	static const int TILE_CELLS = 8; // along each side
+	static const int TILE_SAMPLES = TILE_CELLS + 1;
+	static const size_t MAX_TILES = 2048;
+
+private:
+	struct Tile {
+		std::list<Uint64>::iterator lru;
+		double heights[TILE_SAMPLES * TILE_SAMPLES];
+	};
+
+	// where a point is: which tile, and where in it
+	struct Cell {
+		Uint64 key;
+		int x, y; // of the cell in the tile
+		double fx, fy; // across the cell, 0 to 1
+	};
+
+	Cell FindCell(const vector3d &p) const;
+	void GenerateTiles(const Terrain *terrain, const Uint64 *keys, size_t count, double *heights) const;
+	static double Interpolate(const double *tileHeights, const Cell &cell);
+
+	int m_level; // the faces are 2^level cells along each side
+	SDL_mutex *m_lock;
+	std::unordered_map<Uint64, Tile> m_tiles;
+	std::list<Uint64> m_lru; // most recently used first
+};
+
+#endif /* _TERRAINHEIGHTCACHE_H */
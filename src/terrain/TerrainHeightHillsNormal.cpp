@@ -50,3 +50,48 @@ double TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeight(const vector3d
 	if (n > 0.0) return n * m_maxHeight;
 	return 0.0;
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightHillsNormal>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	// everything is worked out for every point, and the points under the
+	// sea thrown away at the end
+	double continents[BATCH_SIZE], distrib[BATCH_SIZE], persistence[BATCH_SIZE];
+	double m[BATCH_SIZE], a[BATCH_SIZE];
+	octavenoise(GetFracDef(3), 0.65, p, continents, count);
+	octavenoise(GetFracDef(4), 0.5, p, distrib, count);
+	for (size_t i = 0; i < count; i++) {
+		continents[i] = continents[i] * (1.0 - m_sealevel) - (m_sealevel * 0.1);
+		distrib[i] *= distrib[i];
+		persistence[i] = 0.55 * distrib[i];
+	}
+	octavenoise(GetFracDef(4), persistence, p, m, count);
+	billow_octavenoise(GetFracDef(5), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] = 0.5 * GetFracDef(3).amplitude * m[i] * GetFracDef(5).amplitude;
+		m[i] += 0.25 * a[i];
+		persistence[i] = 0.6 * (1.0 - distrib[i]);
+	}
+	//hill footings
+	octavenoise(GetFracDef(2), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] -= a[i] * Clamp(0.05 - m[i], 0.0, 0.05) * Clamp(0.05 - m[i], 0.0, 0.05);
+		persistence[i] = 0.765 * distrib[i];
+	}
+	//hill footings
+	voronoiscam_octavenoise(GetFracDef(6), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		if (continents[i] < 0) {
+			heights[i] = 0;
+			continue;
+		}
+		m[i] += a[i] * Clamp(0.025 - m[i], 0.0, 0.025) * Clamp(0.025 - m[i], 0.0, 0.025);
+		double n = continents[i];
+		// cliffs at shore
+		if (continents[i] < 0.01)
+			n += m[i] * continents[i] * 100.0f;
+		else
+			n += m[i];
+		heights[i] = (n > 0.0 ? n * m_maxHeight : 0.0);
+	}
+}
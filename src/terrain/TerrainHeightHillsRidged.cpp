@@ -47,3 +47,43 @@ double TerrainHeightFractal<TerrainHeightHillsRidged>::GetHeight(const vector3d
 	//n += 0.001*ridged_octavenoise(GetFracDef(6), 0.55*distrib*m, p);
 	return (n > 0.0 ? n * m_maxHeight : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightHillsRidged>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	// everything is worked out for every point, and the points under the
+	// sea thrown away at the end
+	double continents[BATCH_SIZE], distrib[BATCH_SIZE], persistence[BATCH_SIZE];
+	double m[BATCH_SIZE], a[BATCH_SIZE];
+	ridged_octavenoise(GetFracDef(3), 0.65, p, continents, count);
+	river_octavenoise(GetFracDef(4), 0.5, p, distrib, count);
+	for (size_t i = 0; i < count; i++) {
+		continents[i] = continents[i] * (1.0 - m_sealevel) - (m_sealevel * 0.1);
+		persistence[i] = 0.55 * distrib[i];
+	}
+	ridged_octavenoise(GetFracDef(4), persistence, p, m, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] = 0.5 * m[i];
+		persistence[i] = 0.58 * distrib[i];
+	}
+	ridged_octavenoise(GetFracDef(5), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] += continents[i] * 0.25 * a[i];
+		persistence[i] = 0.55 * distrib[i] * m[i];
+	}
+	ridged_octavenoise(GetFracDef(6), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		if (continents[i] < 0) {
+			heights[i] = 0;
+			continue;
+		}
+		m[i] += 0.001 * a[i];
+		double n = continents[i];
+		// cliffs at shore
+		if (continents[i] < 0.01)
+			n += m[i] * continents[i] * 100.0f;
+		else
+			n += m[i];
+		heights[i] = (n > 0.0 ? n * m_maxHeight : 0.0);
+	}
+}
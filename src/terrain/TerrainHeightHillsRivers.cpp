@@ -51,3 +51,59 @@ double TerrainHeightFractal<TerrainHeightHillsRivers>::GetHeight(const vector3d
 	n *= m_maxHeight;
 	return (n > 0.0 ? n : 0.0);
 }
+
+template <>
+void TerrainHeightFractal<TerrainHeightHillsRivers>::GetHeightBatch(const vector3d *p, double *heights, size_t count) const
+{
+	// everything is worked out for every point, and the points under the
+	// sea thrown away at the end
+	double continents[BATCH_SIZE], distrib[BATCH_SIZE], persistence[BATCH_SIZE];
+	double m[BATCH_SIZE], mountains[BATCH_SIZE], n[BATCH_SIZE], a[BATCH_SIZE];
+	river_octavenoise(GetFracDef(3), 0.65, p, continents, count);
+	voronoiscam_octavenoise(GetFracDef(4), 0.5 * GetFracDef(5).amplitude, p, distrib, count);
+	for (size_t i = 0; i < count; i++) {
+		continents[i] = continents[i] * (1.0 - m_sealevel) - (m_sealevel * 0.1);
+		persistence[i] = 0.5 * distrib[i];
+	}
+	river_octavenoise(GetFracDef(5), persistence, p, m, count);
+	ridged_octavenoise(GetFracDef(5), persistence, p, mountains, count);
+	billow_octavenoise(GetFracDef(5), 0.5, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] = 0.1 * GetFracDef(4).amplitude * m[i];
+		mountains[i] *= a[i];
+	}
+	voronoiscam_octavenoise(GetFracDef(4), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		mountains[i] = mountains[i] * a[i] * distrib[i];
+		m[i] += mountains[i];
+		persistence[i] = 0.6 * mountains[i] * mountains[i] * distrib[i];
+	}
+	//detail for mountains, stops them looking smooth.
+	ridged_octavenoise(GetFracDef(2), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		m[i] += mountains[i] * mountains[i] * 0.02 * a[i];
+		m[i] *= m[i] * m[i] * m[i] * 10.0;
+		// smooth cliffs at shore
+		n[i] = continents[i];
+		if (continents[i] < 0.01)
+			n[i] += m[i] * continents[i] * 100.0f;
+		else
+			n[i] += m[i];
+		persistence[i] = 0.6 * distrib[i];
+	}
+	river_octavenoise(GetFracDef(6), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		n[i] += continents[i] * Clamp(0.5 - m[i], 0.0, 0.5) * 0.2 * a[i];
+		persistence[i] = Clamp(0.5 - n[i], 0.0, 0.5);
+	}
+	dunes_octavenoise(GetFracDef(2), persistence, p, a, count);
+	for (size_t i = 0; i < count; i++) {
+		if (continents[i] < 0) {
+			heights[i] = 0;
+			continue;
+		}
+		n[i] += continents[i] * Clamp(0.05 - n[i], 0.0, 0.01) * 0.2 * a[i];
+		n[i] *= m_maxHeight;
+		heights[i] = (n[i] > 0.0 ? n[i] : 0.0);
+	}
+}
@@ -169,6 +169,134 @@ namespace TerrainNoise {
 		return sqrt(10.0 * fabs(n));
 	}
 
+	// Batched versions of the octave functions above, for evaluating the same
+	// fractal over many points at once (see Terrain::GetHeights). The noise
+	// is done by the vector noise(), and everything around it exactly as the
+	// functions above do it, so the results are the same. The parameters
+	// that vary across the points (persistence, lacunarity) can be given as
+	// a double for all of them or as an array with one for each. At most
+	// BATCH_SIZE points at a time.
+	static const size_t BATCH_SIZE = 64;
+
+	inline double batch_param(const double v, size_t) { return v; }
+	inline double batch_param(const double *v, size_t i) { return v[i]; }
+
+	// out[i] is the sum over the octaves of amplitude * noise, or of
+	// amplitude * |noise| if absolute is set
+	template <typename Persistence, typename Lacunarity>
+	inline void octave_sum(int octaves, const double frequency, const Persistence &persistence, const Lacunarity &lacunarity,
+		const bool absolute, const vector3d *p, double *out, const size_t count)
+	{
+		assert(count <= BATCH_SIZE);
+		double amplitude[BATCH_SIZE], freq[BATCH_SIZE], n[BATCH_SIZE];
+		vector3d scaled[BATCH_SIZE];
+		for (size_t i = 0; i < count; i++) {
+			out[i] = 0;
+			amplitude[i] = batch_param(persistence, i);
+			freq[i] = frequency;
+		}
+		while (octaves--) {
+			for (size_t i = 0; i < count; i++)
+				scaled[i] = freq[i] * p[i];
+			noise(scaled, n, count);
+			for (size_t i = 0; i < count; i++) {
+				out[i] += amplitude[i] * (absolute ? fabs(n[i]) : n[i]);
+				amplitude[i] *= batch_param(persistence, i);
+				freq[i] *= batch_param(lacunarity, i);
+			}
+		}
+	}
+
+	template <typename Persistence>
+	inline void octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def.octaves, def.frequency, persistence, def.lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (out[i] + 1.0) * 0.5;
+	}
+
+	template <typename Persistence>
+	inline void river_octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def.octaves, def.frequency, persistence, def.lacunarity, true, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = fabs(out[i]);
+	}
+
+	template <typename Persistence>
+	inline void ridged_octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def.octaves, def.frequency, persistence, def.lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++) {
+			out[i] = 1.0 - fabs(out[i]);
+			out[i] *= out[i];
+		}
+	}
+
+	template <typename Persistence>
+	inline void billow_octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def.octaves, def.frequency, persistence, def.lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (2.0 * fabs(out[i]) - 1.0) + 1.0;
+	}
+
+	template <typename Persistence>
+	inline void voronoiscam_octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(def.octaves, def.frequency, persistence, def.lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = sqrt(10.0 * fabs(out[i]));
+	}
+
+	template <typename Persistence>
+	inline void dunes_octavenoise(const fracdef_t &def, const Persistence &persistence, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(3, def.frequency, persistence, def.lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = 1.0 - fabs(out[i]);
+	}
+
+	template <typename Persistence, typename Lacunarity>
+	inline void octavenoise(int octaves, const Persistence &persistence, const Lacunarity &lacunarity, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(octaves, 1.0, persistence, lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (out[i] + 1.0) * 0.5;
+	}
+
+	template <typename Persistence, typename Lacunarity>
+	inline void river_octavenoise(int octaves, const Persistence &persistence, const Lacunarity &lacunarity, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(octaves, 1.0, persistence, lacunarity, true, p, out, count);
+	}
+
+	template <typename Persistence, typename Lacunarity>
+	inline void ridged_octavenoise(int octaves, const Persistence &persistence, const Lacunarity &lacunarity, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(octaves, 1.0, persistence, lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++) {
+			out[i] = 1.0 - fabs(out[i]);
+			out[i] *= out[i];
+		}
+	}
+
+	template <typename Persistence, typename Lacunarity>
+	inline void billow_octavenoise(int octaves, const Persistence &persistence, const Lacunarity &lacunarity, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(octaves, 1.0, persistence, lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = (2.0 * fabs(out[i]) - 1.0) + 1.0;
+	}
+
+	template <typename Persistence, typename Lacunarity>
+	inline void voronoiscam_octavenoise(int octaves, const Persistence &persistence, const Lacunarity &lacunarity, const vector3d *p, double *out, const size_t count)
+	{
+		octave_sum(octaves, 1.0, persistence, lacunarity, false, p, out, count);
+		for (size_t i = 0; i < count; i++)
+			out[i] = sqrt(10.0 * fabs(out[i]));
+	}
+
 	// not really a noise function but no better place for it
 	inline vector3d interpolate_color(const double n, const vector3d &start, const vector3d &end)
 	{
@@ -0,0 +1,217 @@
+// Copyright © 2008-2021 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+// Microbenchmark for the batched terrain API. For every height and color
+// fractal pair that Terrain::InstanceTerrain hands out, times GetHeight() and
+// GetColor() a point at a time against GetHeights() and GetColors() over the
+// same patch-like grids of points, and checks they give the same results.
+
+#include "galaxy/SystemBody.h"
+#include "terrain/Terrain.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+
+// SystemBody's fields are only set by the system generators, which are its
+// friends. the benchmark gets at the ones it needs without being added to
+// them: access isn't checked for the names in an explicit instantiation, so
+// one can hand out a pointer to a private member
+template <typename Tag, typename Tag::type Member>
+struct SystemBodyFieldAccess {
+	friend typename Tag::type FieldPtr(Tag) { return Member; }
+};
+
+#define SYSTEMBODY_FIELD(name, T)                  \
+	struct Field_##name {                          \
+		typedef T SystemBody::*type;               \
+		friend type FieldPtr(Field_##name);        \
+	};                                             \
+	template struct SystemBodyFieldAccess<Field_##name, &SystemBody::name>
+
+SYSTEMBODY_FIELD(m_type, SystemBody::BodyType);
+SYSTEMBODY_FIELD(m_seed, Uint32);
+SYSTEMBODY_FIELD(m_radius, fixed);
+SYSTEMBODY_FIELD(m_mass, fixed);
+SYSTEMBODY_FIELD(m_life, fixed);
+SYSTEMBODY_FIELD(m_volatileGas, fixed);
+SYSTEMBODY_FIELD(m_volatileLiquid, fixed);
+SYSTEMBODY_FIELD(m_volatileIces, fixed);
+SYSTEMBODY_FIELD(m_volcanicity, fixed);
+SYSTEMBODY_FIELD(m_averageTemp, int);
+SYSTEMBODY_FIELD(m_metallicity, fixed);
+SYSTEMBODY_FIELD(m_atmosOxidizing, fixed);
+
+#undef SYSTEMBODY_FIELD
+
+// builds bodies for the terrain to be made for
+class TerrainBench {
+public:
+	struct Params {
+		SystemBody::BodyType type;
+		Uint32 seed;
+		fixed radius, mass;
+		fixed life, gas, liquid, ices, volcanicity;
+		int temp;
+	};
+
+	static RefCountedPtr<SystemBody> MakeBody(const Params &params)
+	{
+		RefCountedPtr<SystemBody> body(new SystemBody(SystemPath(0, 0, 0, 0, 0), nullptr));
+		SystemBody &b = *body.Get();
+		b.*FieldPtr(Field_m_type()) = params.type;
+		b.*FieldPtr(Field_m_seed()) = params.seed;
+		b.*FieldPtr(Field_m_radius()) = params.radius;
+		b.*FieldPtr(Field_m_mass()) = params.mass;
+		b.*FieldPtr(Field_m_life()) = params.life;
+		b.*FieldPtr(Field_m_volatileGas()) = params.gas;
+		b.*FieldPtr(Field_m_volatileLiquid()) = params.liquid;
+		b.*FieldPtr(Field_m_volatileIces()) = params.ices;
+		b.*FieldPtr(Field_m_volcanicity()) = params.volcanicity;
+		b.*FieldPtr(Field_m_averageTemp()) = params.temp;
+		b.*FieldPtr(Field_m_metallicity()) = fixed(1, 2);
+		b.*FieldPtr(Field_m_atmosOxidizing()) = fixed(1, 2);
+		return body;
+	}
+};
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	double ElapsedMs(const Clock::time_point &start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// one terrain for every pair of fractals, found by trying bodies of every
+	// type and a range of compositions until nothing new turns up
+	std::map<std::string, RefCountedPtr<Terrain>> FindFractalPairs()
+	{
+		std::map<std::string, RefCountedPtr<Terrain>> pairs;
+		auto tryBody = [&pairs](const TerrainBench::Params &params) {
+			RefCountedPtr<SystemBody> body = TerrainBench::MakeBody(params);
+			RefCountedPtr<Terrain> terrain(Terrain::InstanceTerrain(body.Get()));
+			const std::string name = std::string(terrain->GetHeightFractalName()) + " / " + terrain->GetColorFractalName();
+			if (pairs.find(name) == pairs.end())
+				pairs[name] = terrain;
+		};
+
+		const SystemBody::BodyType stars[] = {
+			SystemBody::TYPE_BROWN_DWARF, SystemBody::TYPE_WHITE_DWARF, SystemBody::TYPE_STAR_M,
+			SystemBody::TYPE_STAR_K, SystemBody::TYPE_STAR_G, SystemBody::TYPE_STAR_F, SystemBody::TYPE_STAR_S_BH
+		};
+		for (SystemBody::BodyType type : stars) {
+			for (Uint32 seed = 0; seed < 16; seed++)
+				tryBody({ type, seed, fixed(1, 1), fixed(1, 1), 0, 0, 0, 0, 0, 3000 });
+		}
+		for (Uint32 seed = 0; seed < 32; seed++) {
+			tryBody({ SystemBody::TYPE_PLANET_GAS_GIANT, seed, fixed(10, 1), fixed(300, 1), 0, fixed(1, 1), 0, 0, 0, 100 });
+			tryBody({ SystemBody::TYPE_PLANET_ASTEROID, seed, fixed(1, 1000), fixed(1, 1000000), 0, 0, 0, 0, 0, 200 });
+		}
+
+		const fixed life[] = { fixed(0), fixed(15, 100), fixed(3, 10), fixed(45, 100), fixed(6, 10), fixed(8, 10) };
+		const fixed gas[] = { fixed(0), fixed(15, 100), fixed(3, 10) };
+		const fixed liquid[] = { fixed(0), fixed(1, 2) };
+		const fixed ices[] = { fixed(0), fixed(9, 10) };
+		const fixed volcanicity[] = { fixed(0), fixed(8, 10) };
+		const int temps[] = { 200, 300 };
+		for (const fixed &l : life)
+			for (const fixed &g : gas)
+				for (const fixed &w : liquid)
+					for (const fixed &i : ices)
+						for (const fixed &v : volcanicity)
+							for (int t : temps)
+								for (Uint32 seed = 0; seed < 12; seed++)
+									tryBody({ SystemBody::TYPE_PLANET_TERRESTRIAL, seed, fixed(1, 1), fixed(1, 1), l, g, w, i, v, t });
+		return pairs;
+	}
+
+	// square grids of points on the unit sphere, as a patch job would ask for
+	std::vector<vector3d> MakePatches(std::mt19937 &rng, int patches, int edgeLen, double size)
+	{
+		std::uniform_real_distribution<double> unit(-1.0, 1.0);
+		std::vector<vector3d> points;
+		points.reserve(patches * edgeLen * edgeLen);
+		for (int i = 0; i < patches; i++) {
+			const vector3d centre = vector3d(unit(rng), unit(rng), unit(rng)).NormalizedSafe();
+			const vector3d u = centre.Cross(vector3d(0.0, 1.0, 0.0)).NormalizedSafe() * size;
+			const vector3d v = centre.Cross(u).NormalizedSafe() * size;
+			for (int y = 0; y < edgeLen; y++) {
+				for (int x = 0; x < edgeLen; x++) {
+					const double fx = double(x) / (edgeLen - 1) - 0.5;
+					const double fy = double(y) / (edgeLen - 1) - 0.5;
+					points.push_back((centre + fx * u + fy * v).Normalized());
+				}
+			}
+		}
+		return points;
+	}
+
+	bool RunPair(const std::string &name, const Terrain *terrain, const std::vector<vector3d> &points, int reps)
+	{
+		const size_t count = points.size();
+		std::vector<double> scalarHeights(count), batchHeights(count);
+		std::vector<vector3d> scalarColors(count), batchColors(count);
+
+		Clock::time_point t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (size_t i = 0; i < count; i++)
+				scalarHeights[i] = terrain->GetHeight(points[i]);
+		}
+		const double scalarHeight = ElapsedMs(t) / reps;
+
+		t = Clock::now();
+		for (int r = 0; r < reps; r++)
+			terrain->GetHeights(points.data(), batchHeights.data(), count);
+		const double batchHeight = ElapsedMs(t) / reps;
+
+		// the sphere's normal will do, only the same inputs matter
+		t = Clock::now();
+		for (int r = 0; r < reps; r++) {
+			for (size_t i = 0; i < count; i++)
+				scalarColors[i] = terrain->GetColor(points[i], scalarHeights[i], points[i]);
+		}
+		const double scalarColor = ElapsedMs(t) / reps;
+
+		t = Clock::now();
+		for (int r = 0; r < reps; r++)
+			terrain->GetColors(points.data(), scalarHeights.data(), points.data(), batchColors.data(), count);
+		const double batchColor = ElapsedMs(t) / reps;
+
+		size_t heightMismatches = 0, colorMismatches = 0;
+		for (size_t i = 0; i < count; i++) {
+			heightMismatches += scalarHeights[i] != batchHeights[i];
+			colorMismatches += !scalarColors[i].ExactlyEqual(batchColors[i]);
+		}
+
+		printf("%-40s %9.3f %9.3f %5.2fx %9.3f %9.3f %5.2fx\n", name.c_str(),
+			scalarHeight, batchHeight, scalarHeight / batchHeight,
+			scalarColor, batchColor, scalarColor / batchColor);
+		if (heightMismatches || colorMismatches)
+			printf("  MISMATCH: %zu heights, %zu colors of %zu differ\n", heightMismatches, colorMismatches, count);
+		return !heightMismatches && !colorMismatches;
+	}
+} // namespace
+
+extern "C" int main(int argc, char **argv)
+{
+	const int reps = argc > 1 ? std::max(1, atoi(argv[1])) : 5;
+
+	std::mt19937 rng(1234);
+	// a few patches near the surface and a few seen from orbit
+	std::vector<vector3d> points = MakePatches(rng, 8, 65, 1e-4);
+	const std::vector<vector3d> wide = MakePatches(rng, 8, 65, 0.1);
+	points.insert(points.end(), wide.begin(), wide.end());
+
+	const std::map<std::string, RefCountedPtr<Terrain>> pairs = FindFractalPairs();
+	printf("%zu fractal pairs, %zu points\n\n", pairs.size(), points.size());
+	printf("%-40s %9s %9s %6s %9s %9s %6s\n", "height / color", "height ms", "batch ms", "", "color ms", "batch ms", "");
+
+	bool same = true;
+	for (const auto &pair : pairs)
+		same = RunPair(pair.first, pair.second.Get(), points, reps) && same;
+
+	return same ? 0 : 1;
+}
@@ -288,6 +288,22 @@ namespace FileSystem {
 	FILE *FileSourceFS::OpenWriteStream(const std::string &path, int flags)
 	{
 		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		if (flags & WRITE_APPEND)
+			return open_file_raw(fullpath, (flags & WRITE_TEXT) ? L"a" : L"ab");
 		return open_file_raw(fullpath, (flags & WRITE_TEXT) ? L"w" : L"wb");
 	}
+
+	bool FileSourceFS::RenameFile(const std::string &from, const std::string &to)
+	{
+		const std::wstring wfrom = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), from));
+		const std::wstring wto = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), to));
+		// unlike rename(), this replaces an existing file
+		return MoveFileExW(wfrom.c_str(), wto.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+
+	bool FileSourceFS::RemoveFile(const std::string &path)
+	{
+		const std::wstring wfullpath = transcode_utf8_to_utf16(JoinPathBelow(GetRoot(), path));
+		return DeleteFileW(wfullpath.c_str()) != 0;
+	}
 } // namespace FileSystem